@@ -35,12 +35,14 @@ private:
     KoColor m_color;
     KisPaintDeviceSP m_device;        
     
+    KisFilterConfigurationSP loadBrightnessContrastConfiguration(KisFilterSP filter);
     
 private Q_SLOTS:
     void initTestCase();
     void cleanupTestCase();
     
     void benchmarkFilter();
+    void benchmarkPerChannelFilter();
     
 };
 
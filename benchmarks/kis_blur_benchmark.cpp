@@ -36,6 +36,7 @@
 
 #include "kis_selection.h"
 #include <kis_iterator_ng.h>
+#include <kis_gaussian_kernel.h>
 
 void KisBlurBenchmark::initTestCase()
 {
@@ -88,5 +89,32 @@ void KisBlurBenchmark::benchmarkFilter()
 }
 
 
+void KisBlurBenchmark::benchmarkGaussian_data()
+{
+    QTest::addColumn<qreal>("radius");
+    QTest::addColumn<bool>("allowRecursive");
+
+    const qreal radii[] = {1, 5, 10, 25, 50, 100, 250, 500};
+
+    for (qreal radius : radii) {
+        QTest::newRow(QString("exact, %1").arg(radius).toLatin1()) << radius << false;
+        QTest::newRow(QString("recursive, %1").arg(radius).toLatin1()) << radius << true;
+    }
+}
+
+void KisBlurBenchmark::benchmarkGaussian()
+{
+    QFETCH(qreal, radius);
+    QFETCH(bool, allowRecursive);
+
+    const QRect rc(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+    const QBitArray channelFlags(m_colorSpace->channelCount(), true);
+
+    QBENCHMARK{
+        KisPaintDeviceSP dev = new KisPaintDevice(*m_device);
+        KisGaussianKernel::applyGaussian(dev, rc, radius, radius,
+                                         channelFlags, 0, allowRecursive);
+    }
+}
 
 QTEST_MAIN(KisBlurBenchmark)
@@ -0,0 +1,147 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_hairy_brush_benchmark.h"
+
+#include <QTest>
+#include <QElapsedTimer>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_debug.h>
+#include <kis_paint_device.h>
+#include <kis_fixed_paint_device.h>
+#include <brushengine/kis_paint_information.h>
+
+#include "hairy_brush.h"
+
+/**
+ * Paints a horizontal stroke of short segments with a round hairy brush
+ * of every bristle of a \p radius disk and reports the number of
+ * bristle segments simulated per second
+ */
+void KisHairyBrushBenchmark::benchmarkBristles(int radius, bool antialias, bool inkDepletion)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const KoColor color(Qt::black, cs);
+
+    KisFixedPaintDeviceSP shape = new KisFixedPaintDevice(cs);
+    shape->setRect(QRect(0, 0, 2 * radius, 2 * radius));
+    shape->initialize();
+
+    quint8 *pixel = shape->data();
+    for (int y = 0; y < 2 * radius; y++) {
+        for (int x = 0; x < 2 * radius; x++) {
+            const int dx = x - radius;
+            const int dy = y - radius;
+
+            if (dx * dx + dy * dy <= radius * radius) {
+                memcpy(pixel, color.data(), cs->pixelSize());
+            }
+            pixel += cs->pixelSize();
+        }
+    }
+
+    KisHairyProperties properties;
+    properties.radius = radius;
+    properties.inkAmount = 256;
+    properties.sigma = 0.5;
+    properties.inkDepletionEnabled = inkDepletion;
+    properties.isbrushDimension1D = false;
+    properties.useMousePressure = false;
+    properties.useSaturation = false;
+    properties.useOpacity = true;
+    properties.useWeights = false;
+    properties.useSoakInk = false;
+    properties.connectedPath = true;
+    properties.antialias = antialias;
+    properties.useCompositing = true;
+    properties.pressureWeight = 50;
+    properties.bristleLengthWeight = 50;
+    properties.bristleInkAmountWeight = 50;
+    properties.inkDepletionWeight = 50;
+    properties.shearFactor = 0.0;
+    properties.randomFactor = 2.0;
+    properties.scaleFactor = 1.0;
+    properties.threshold = 0.0;
+
+    for (int i = 0; i < properties.inkAmount; i++) {
+        properties.inkDepletionCurve.append(qreal(i) / (properties.inkAmount - 1));
+    }
+
+    const int numSegments = 100;
+    const qreal segmentLength = 10.0;
+
+    qint64 numBristleSegments = 0;
+    qint64 elapsed = 0;
+
+    QBENCHMARK {
+        HairyBrush brush;
+        brush.fromDabWithDensity(shape, 1.0);
+        brush.setInkColor(color);
+        brush.setProperties(&properties);
+
+        KisPaintDeviceSP dab = new KisPaintDevice(cs);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int i = 0; i < numSegments; i++) {
+            const KisPaintInformation pi1(QPointF(radius + i * segmentLength, 2 * radius), 0.5);
+            const KisPaintInformation pi2(QPointF(radius + (i + 1) * segmentLength, 2 * radius), 0.5);
+
+            brush.paintLine(dab, 0, pi1, pi2, 1.0, 0.0);
+        }
+
+        elapsed += timer.nsecsElapsed();
+        numBristleSegments += qint64(numSegments) * brush.bristleCount();
+    }
+
+    if (elapsed > 0) {
+        dbgKrita << "radius" << radius << "bristle segments per second:" << qint64(1e9 * numBristleSegments / elapsed);
+    }
+}
+
+void KisHairyBrushBenchmark::benchmark30px()
+{
+    benchmarkBristles(30, false, false);
+}
+
+void KisHairyBrushBenchmark::benchmark30pxAntiAlias()
+{
+    benchmarkBristles(30, true, false);
+}
+
+void KisHairyBrushBenchmark::benchmark30pxInkDepletion()
+{
+    benchmarkBristles(30, false, true);
+}
+
+void KisHairyBrushBenchmark::benchmark100px()
+{
+    benchmarkBristles(100, false, false);
+}
+
+void KisHairyBrushBenchmark::benchmark100pxAntiAlias()
+{
+    benchmarkBristles(100, true, false);
+}
+
+QTEST_MAIN(KisHairyBrushBenchmark)
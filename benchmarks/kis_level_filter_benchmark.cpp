@@ -102,5 +102,41 @@ void KisLevelFilterBenchmark::benchmarkFilter()
 }
 
 
+void KisLevelFilterBenchmark::benchmarkPerChannelFilter()
+{
+    KisFilterSP filter = KisFilterRegistry::instance()->value("perchannel");
+    KisFilterConfigurationSP kfc = filter->defaultConfiguration();
+
+    /**
+     * The curves of the color channels stretch the same range as the
+     * levels above, while the "all colors", alpha and lightness ones
+     * are left untouched. The result is applied as a plain lookup
+     * table, so it can be compared against the LCMS based levels.
+     */
+    const QString levelCurve = "0,0;0.294,0;0.906,1;1,1;";
+    const QString identityCurve = "0,0;1,1;";
+
+    kfc->fromXML(QString(
+        "<params version=\"1\">"
+        "<param name=\"nTransfers\">6</param>"
+        "<param name=\"curve0\">%2</param>"
+        "<param name=\"curve1\">%1</param>"
+        "<param name=\"curve2\">%1</param>"
+        "<param name=\"curve3\">%1</param>"
+        "<param name=\"curve4\">%2</param>"
+        "<param name=\"curve5\">%2</param>"
+        "</params>").arg(levelCurve).arg(identityCurve));
+
+    QSize size = KritaUtils::optimalPatchSize();
+    QVector<QRect> rects = KritaUtils::splitRectIntoPatches(QRect(0, 0, GMP_IMAGE_WIDTH,GMP_IMAGE_HEIGHT), size);
+
+    QBENCHMARK{
+        Q_FOREACH (const QRect &rc, rects) {
+            filter->process(m_device, rc, kfc);
+        }
+    }
+}
+
+
 
 QTEST_MAIN(KisLevelFilterBenchmark)
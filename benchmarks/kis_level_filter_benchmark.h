@@ -40,6 +40,7 @@ private Q_SLOTS:
     void cleanupTestCase();
 
     void benchmarkFilter();
+    void benchmarkPerChannelFilter();
 };
 
 #endif // KIS_LEVEL_FILTER_BENCHMARK_H
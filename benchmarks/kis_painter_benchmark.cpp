@@ -191,6 +191,42 @@ void KisPainterBenchmark::benchmarkFixedBitBltSelection()
 
 }
 
+void KisPainterBenchmark::benchmarkFixedBitBltDabSizes_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("100px") << 100;
+    QTest::newRow("500px") << 500;
+    QTest::newRow("1000px") << 1000;
+    QTest::newRow("2000px") << 2000;
+    QTest::newRow("5000px") << 5000;
+}
+
+void KisPainterBenchmark::benchmarkFixedBitBltDabSizes()
+{
+    QFETCH(int, size);
+
+    const QRect rc(0, 0, size, size);
+
+    KisFixedPaintDeviceSP fdev = new KisFixedPaintDevice(m_colorSpace);
+    fdev->setRect(rc);
+    fdev->initialize();
+    fdev->fill(0, 0, size, size, m_color.data());
+
+    KisPaintDeviceSP dst = new KisPaintDevice(m_colorSpace);
+    KisPainter gc(dst);
+    gc.setOpacity(128);
+
+    // the same number of pixels for every size
+    const int numDabs = qMax(1, 5000 * 5000 / (size * size));
+
+    QBENCHMARK{
+        for (int i = 0; i < numDabs; i++) {
+            gc.bltFixed(QPoint(i % 7, i % 5), fdev, rc);
+        }
+    }
+}
+
 void KisPainterBenchmark::benchmarkDrawThickLine()
 {
     KisPaintDeviceSP dev = new KisPaintDevice(m_colorSpace);
@@ -44,6 +44,9 @@ private Q_SLOTS:
     void benchmarkBitBltSelection();
     void benchmarkFixedBitBlt();
     void benchmarkFixedBitBltSelection();
+
+    void benchmarkFixedBitBltDabSizes_data();
+    void benchmarkFixedBitBltDabSizes();
     
     void benchmarkDrawThickLine();
     void benchmarkDrawQtLine();
@@ -43,17 +43,42 @@ inline double drand48()
 
 #include <brushengine/kis_paint_information.h>
 #include <brushengine/kis_paintop_preset.h>
+#include <brushengine/kis_paintop_settings.h>
 
 #define GMP_IMAGE_WIDTH 3274
 #define GMP_IMAGE_HEIGHT 2067
 #include <kis_painter.h>
 #include <brushengine/kis_paintop_registry.h>
+#include <kis_aligned_buffer_pool.h>
 
 //#define SAVE_OUTPUT
 
 static const int LINES = 20;
 const QString OUTPUT_FORMAT = ".png";
 
+/**
+ * Prints how many pixel buffers were requested from KisAlignedBufferPool
+ * while the object existed and how many of them had to be allocated
+ * from the system. Only the first dabs of a stroke should allocate.
+ */
+struct BufferAllocationReport {
+    BufferAllocationReport(const QString &name)
+        : m_name(name),
+          m_requests(KisAlignedBufferPool::numRequests()),
+          m_allocations(KisAlignedBufferPool::numSystemAllocations())
+    {
+    }
+
+    ~BufferAllocationReport() {
+        dbgKrita << m_name << "buffer requests:" << KisAlignedBufferPool::numRequests() - m_requests
+                 << "system allocations:" << KisAlignedBufferPool::numSystemAllocations() - m_allocations;
+    }
+
+    QString m_name;
+    qint64 m_requests;
+    qint64 m_allocations;
+};
+
 void KisStrokeBenchmark::initTestCase()
 {
     m_dataPath = QString(FILES_DATA_DIR) + QDir::separator();
@@ -144,6 +169,35 @@ void KisStrokeBenchmark::pixelbrush300pxRL()
     benchmarkRandomLines(presetFileName);
 }
 
+void KisStrokeBenchmark::pixelbrush2000pxLine()
+{
+    /**
+     * The brush op batches the dabs of a line, but a dab this big is
+     * still composited in parallel bands, see KisPainter::bltFixed()
+     */
+    KisPaintOpPresetSP preset = new KisPaintOpPreset(m_dataPath + "autobrush_300px.kpp");
+    preset->load();
+    preset->settings()->setPaintOpSize(2000);
+    m_painter->setPaintOpPreset(preset, m_layer, m_image);
+
+    QPointF startPoint(0.10 * TEST_IMAGE_WIDTH, 0.5 * TEST_IMAGE_HEIGHT);
+    QPointF endPoint(0.90 * TEST_IMAGE_WIDTH, 0.5 * TEST_IMAGE_HEIGHT);
+
+    KisDistanceInformation currentDistance;
+    KisPaintInformation pi1(startPoint, 0.0);
+    KisPaintInformation pi2(endPoint, 1.0);
+
+    BufferAllocationReport report("autobrush_2000px.kpp");
+
+    QBENCHMARK{
+        m_painter->paintLine(pi1, pi2, &currentDistance);
+    }
+
+#ifdef SAVE_OUTPUT
+    m_layer->paintDevice()->convertToQImage(0).save(m_outputPath + "autobrush_2000px.kpp" + "_line" + OUTPUT_FORMAT);
+#endif
+}
+
 
 void KisStrokeBenchmark::sprayPixels()
 {
@@ -372,6 +426,8 @@ inline void KisStrokeBenchmark::benchmarkLine(QString presetFileName)
     KisPaintInformation pi1(startPoint, 0.0);
     KisPaintInformation pi2(endPoint, 1.0);
 
+    BufferAllocationReport report(presetFileName);
+
     QBENCHMARK{
         m_painter->paintLine(pi1, pi2, &currentDistance);
     }
@@ -394,6 +450,8 @@ void KisStrokeBenchmark::benchmarkCircle(QString presetFileName)
 
     m_painter->setPaintOpPreset(preset, m_layer, m_image);
 
+    BufferAllocationReport report(presetFileName);
+
 QBENCHMARK{
 
     qreal radius = 300;
@@ -448,6 +506,8 @@ void KisStrokeBenchmark::benchmarkRandomLines(QString presetFileName)
 
     m_painter->setPaintOpPreset(preset, m_layer, m_image);
 
+    BufferAllocationReport report(presetFileName);
+
     QBENCHMARK{
         KisDistanceInformation currentDistance;
         for (int i = 0; i < LINES; i++){
@@ -475,6 +535,8 @@ void KisStrokeBenchmark::benchmarkStroke(QString presetFileName)
 
     m_painter->setPaintOpPreset(preset, m_layer, m_image);
 
+    BufferAllocationReport report(presetFileName);
+
     QBENCHMARK{
         KisDistanceInformation currentDistance;
         m_painter->paintBezierCurve(m_pi1, m_c1, m_c1, m_pi2, &currentDistance);
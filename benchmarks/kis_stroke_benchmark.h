@@ -72,6 +72,7 @@ private Q_SLOTS:
     // AutoBrush
     void pixelbrush300px();
     void pixelbrush300pxRL();
+    void pixelbrush2000pxLine();
 
     // Soft brush benchmarks
     void softbrushDefault30();
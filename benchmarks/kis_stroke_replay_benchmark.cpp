@@ -0,0 +1,180 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_stroke_replay_benchmark.h"
+
+#include <algorithm>
+
+#include <QTest>
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_debug.h>
+#include <kis_image.h>
+#include <kis_paint_layer.h>
+#include <kis_paint_device.h>
+#include <kis_painter.h>
+#include <kis_distance_information.h>
+#include <kis_aligned_buffer_pool.h>
+#include <brushengine/kis_paint_information.h>
+#include <brushengine/kis_paintop_preset.h>
+#include <recorder/kis_recorded_stroke.h>
+#include <tiles3/kis_tile_data.h>
+#include <tiles3/kis_tile_data_store.h>
+
+namespace {
+
+/**
+ * Statistics of the replayed strokes. The time of every segment
+ * between two events is split evenly between the dabs painted in it.
+ */
+struct ReplayStatistics {
+    qint64 numDabs = 0;
+    qint64 totalTime = 0;
+    QVector<qreal> dabTimes;
+
+    void addSegment(qint64 time, int numDabs) {
+        totalTime += time;
+        this->numDabs += numDabs;
+
+        for (int i = 0; i < numDabs; i++) {
+            dabTimes.append(qreal(time) / numDabs);
+        }
+    }
+
+    qreal percentile(int percent) {
+        if (dabTimes.isEmpty()) return 0.0;
+
+        std::sort(dabTimes.begin(), dabTimes.end());
+        return dabTimes[(dabTimes.size() - 1) * percent / 100];
+    }
+};
+
+qint64 tileMemory()
+{
+    return KisTileDataStore::instance()->memoryMetric() *
+        KisTileData::WIDTH * KisTileData::HEIGHT;
+}
+
+}
+
+void KisStrokeReplayBenchmark::benchmarkReplay_data()
+{
+    QTest::addColumn<QString>("presetFileName");
+    QTest::addColumn<QString>("strokesFileName");
+
+    const QDir dataDir(QString(FILES_DATA_DIR));
+
+    Q_FOREACH (const QString &strokes, dataDir.entryList(QStringList() << "*.kstroke", QDir::Files)) {
+        Q_FOREACH (const QString &preset, dataDir.entryList(QStringList() << "*.kpp", QDir::Files)) {
+            const QString name = QString("%1/%2").arg(preset).arg(QFileInfo(strokes).baseName());
+
+            QTest::newRow(name.toLatin1()) << dataDir.filePath(preset) << dataDir.filePath(strokes);
+        }
+    }
+}
+
+void KisStrokeReplayBenchmark::benchmarkReplay()
+{
+    QFETCH(QString, presetFileName);
+    QFETCH(QString, strokesFileName);
+
+    bool ok = false;
+    const QVector<KisRecordedStroke> strokes = KisRecordedStroke::load(strokesFileName, &ok);
+    QVERIFY(ok);
+
+    KisPaintOpPresetSP preset = new KisPaintOpPreset(presetFileName);
+    if (!preset->load()) {
+        QSKIP("The preset could not be loaded");
+    }
+
+    QRectF bounds;
+    qreal recordedTime = 0.0;
+
+    Q_FOREACH (const KisRecordedStroke &stroke, strokes) {
+        Q_FOREACH (const KisPaintInformation &pi, stroke.events()) {
+            bounds |= QRectF(pi.pos(), QSizeF(1, 1));
+        }
+        recordedTime += stroke.duration();
+    }
+
+    const QRect imageRect = bounds.toAlignedRect().adjusted(-200, -200, 200, 200) | QRect(0, 0, 1, 1);
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, imageRect.right() + 1, imageRect.bottom() + 1, cs, "stroke replay image");
+    KisPaintLayerSP layer = new KisPaintLayer(image, "replay", OPACITY_OPAQUE_U8, cs);
+
+    ReplayStatistics stats;
+
+    const qint64 initialMemory = tileMemory();
+    const qint64 initialRequests = KisAlignedBufferPool::numRequests();
+    const qint64 initialAllocations = KisAlignedBufferPool::numSystemAllocations();
+    int numReplays = 0;
+
+    QBENCHMARK {
+        layer->paintDevice()->clear();
+
+        KisPainter painter(layer->paintDevice());
+        painter.setPaintColor(KoColor(Qt::black, cs));
+        painter.setPaintOpPreset(preset, layer, image);
+
+        QElapsedTimer timer;
+
+        Q_FOREACH (const KisRecordedStroke &stroke, strokes) {
+            const QVector<KisPaintInformation> &events = stroke.events();
+            if (events.isEmpty()) continue;
+
+            KisDistanceInformation distance(events.first().pos(), events.first().currentTime());
+
+            timer.start();
+            painter.paintAt(events.first(), &distance);
+            stats.addSegment(timer.nsecsElapsed(), distance.currentDabSeqNo());
+
+            for (int i = 1; i < events.size(); i++) {
+                const int dabsBefore = distance.currentDabSeqNo();
+
+                timer.start();
+                painter.paintLine(events[i - 1], events[i], &distance);
+                stats.addSegment(timer.nsecsElapsed(), distance.currentDabSeqNo() - dabsBefore);
+            }
+        }
+
+        numReplays++;
+    }
+
+    const qreal seconds = qMax(qreal(1e-9), qreal(stats.totalTime) / 1e9);
+
+    dbgKrita << QFileInfo(presetFileName).fileName() << "on" << QFileInfo(strokesFileName).fileName();
+    dbgKrita << "    dabs:" << stats.numDabs / qMax(1, numReplays)
+             << "dabs/sec:" << qRound(stats.numDabs / seconds)
+             << "real time factor:" << recordedTime * numReplays / (1000.0 * seconds);
+    dbgKrita << "    time per dab (us): 50%:" << stats.percentile(50) / 1000.0
+             << "90%:" << stats.percentile(90) / 1000.0
+             << "99%:" << stats.percentile(99) / 1000.0
+             << "max:" << stats.percentile(100) / 1000.0;
+    dbgKrita << "    buffer requests:" << KisAlignedBufferPool::numRequests() - initialRequests
+             << "system allocations:" << KisAlignedBufferPool::numSystemAllocations() - initialAllocations
+             << "tile memory (KiB):" << (tileMemory() - initialMemory) / 1024;
+}
+
+QTEST_MAIN(KisStrokeReplayBenchmark)
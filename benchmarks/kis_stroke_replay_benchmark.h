@@ -0,0 +1,44 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_STROKE_REPLAY_BENCHMARK_H
+#define KIS_STROKE_REPLAY_BENCHMARK_H
+
+#include <QtTest>
+
+/**
+ * Replays the recorded tablet strokes (*.kstroke) of the data folder
+ * through every preset (*.kpp) of the data folder and reports the dabs
+ * per second, the percentiles of the time per dab, the pixel buffer
+ * allocations and the tile memory of the layer.
+ *
+ * The strokes are recorded by the freehand tools into the "log" folder
+ * when the performance log is enabled. A single pair can be run with
+ *
+ *     KisStrokeReplayBenchmark benchmarkReplay:<preset>/<strokes>
+ */
+class KisStrokeReplayBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkReplay_data();
+    void benchmarkReplay();
+};
+
+#endif
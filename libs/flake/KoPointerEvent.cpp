@@ -278,6 +278,12 @@ bool KoPointerEvent::isTabletEvent()
     return dynamic_cast<QTabletEvent*>(m_event) != 0;
 }
 
+ulong KoPointerEvent::time() const
+{
+    QInputEvent *inputEvent = dynamic_cast<QInputEvent*>(m_event);
+    return inputEvent ? inputEvent->timestamp() : 0;
+}
+
 void KoPointerEvent::setTabletButton(Qt::MouseButton button)
 {
     d->tabletButton = button;
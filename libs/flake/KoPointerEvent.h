@@ -233,6 +233,12 @@ public:
      */
     bool isTabletEvent();
 
+    /**
+     * Returns the timestamp of the underlying input event in
+     * milliseconds, or 0 if the event has no timestamp
+     */
+    ulong time() const;
+
 protected:
     friend class KoToolProxy;
     friend class KisToolProxy;
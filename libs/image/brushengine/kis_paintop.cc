@@ -52,7 +52,8 @@ struct Q_DECL_HIDDEN KisPaintOp::Private {
     Private(KisPaintOp *_q)
         : q(_q), dab(0),
           fanCornersEnabled(false),
-          fanCornersStep(1.0) {}
+          fanCornersStep(1.0),
+          dabBatchingEnabled(false) {}
 
     KisPaintOp *q;
 
@@ -61,6 +62,7 @@ struct Q_DECL_HIDDEN KisPaintOp::Private {
 
     bool fanCornersEnabled;
     qreal fanCornersStep;
+    bool dabBatchingEnabled;
 };
 
 
@@ -94,6 +96,11 @@ void KisPaintOp::setFanCornersInfo(bool fanCornersEnabled, qreal fanCornersStep)
     d->fanCornersStep = fanCornersStep;
 }
 
+void KisPaintOp::setDabBatchingEnabled(bool value)
+{
+    d->dabBatchingEnabled = value;
+}
+
 void KisPaintOp::splitCoordinate(qreal coordinate, qint32 *whole, qreal *fraction)
 {
     const qint32 i = std::floor(coordinate);
@@ -147,9 +154,19 @@ void KisPaintOp::paintLine(const KisPaintInformation &pi1,
                            const KisPaintInformation &pi2,
                            KisDistanceInformation *currentDistance)
 {
+    const bool batchDabs = d->dabBatchingEnabled && d->painter;
+
+    if (batchDabs) {
+        d->painter->beginDabBatch();
+    }
+
     KisPaintOpUtils::paintLine(*this, pi1, pi2, currentDistance,
                                d->fanCornersEnabled,
                                d->fanCornersStep);
+
+    if (batchDabs) {
+        d->painter->endDabBatch();
+    }
 }
 
 void KisPaintOp::paintAt(const KisPaintInformation& info, KisDistanceInformation *currentDistance)
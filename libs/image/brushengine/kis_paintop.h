@@ -117,6 +117,14 @@ protected:
      */
     KisPaintDeviceSP source() const;
 
+    /**
+     * Makes paintLine() collect the dabs of the line and composite
+     * them together, see KisPainter::beginDabBatch(). Enable it only
+     * if the paintop paints its dabs with bltFixed() and does not read
+     * the painted device while painting a line.
+     */
+    void setDabBatchingEnabled(bool value);
+
 private:
     friend class KisPressureRotationOption;
     void setFanCornersInfo(bool fanCornersEnabled, qreal fanCornersStep);
@@ -0,0 +1,207 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_aligned_buffer_pool.h"
+
+#include <QVector>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicInteger>
+#include <QThreadStorage>
+
+#include "kis_assert.h"
+
+namespace {
+
+/**
+ * Smaller blocks are rounded up to this size, so that a pool does not
+ * keep many tiny free lists
+ */
+const int MIN_BLOCK_SIZE_LOG2 = 8;
+const int MAX_BLOCK_SIZE_LOG2 = 30;
+const int MAX_BLOCK_SIZE = 1 << MAX_BLOCK_SIZE_LOG2;
+const int NUM_SIZE_CLASSES = MAX_BLOCK_SIZE_LOG2 - MIN_BLOCK_SIZE_LOG2 + 1;
+
+/**
+ * Every block is preceded by a header of this size that keeps the
+ * pool the block was allocated from. The size keeps the data aligned.
+ */
+const int HEADER_SIZE = KisAlignedBufferPool::ALIGNMENT;
+
+QAtomicInteger<qint64> s_numRequests;
+QAtomicInteger<qint64> s_numSystemAllocations;
+
+/**
+ * The memory kept in the free lists of all the pools
+ */
+QAtomicInt s_pooledMemory;
+
+inline int sizeClass(int size)
+{
+    int sizeLog2 = MIN_BLOCK_SIZE_LOG2;
+    while ((1 << sizeLog2) < size) {
+        sizeLog2++;
+    }
+    return sizeLog2 - MIN_BLOCK_SIZE_LOG2;
+}
+
+struct Pool;
+
+inline Pool*& blockOwner(quint8 *ptr)
+{
+    return *reinterpret_cast<Pool**>(ptr - HEADER_SIZE);
+}
+
+inline void freeBlock(quint8 *ptr)
+{
+    qFreeAligned(ptr - HEADER_SIZE);
+}
+
+/**
+ * The pools are never deleted, since a block may be released after its
+ * thread has finished. The pool of a finished thread is emptied and
+ * given to the next new thread.
+ */
+struct Pool {
+    Pool() : freeLists(NUM_SIZE_CLASSES) {}
+
+    void trim() {
+        QMutexLocker l(&lock);
+
+        for (int i = 0; i < freeLists.size(); i++) {
+            const int capacity = 1 << (i + MIN_BLOCK_SIZE_LOG2);
+
+            Q_FOREACH (quint8 *ptr, freeLists[i]) {
+                freeBlock(ptr);
+                s_pooledMemory.fetchAndAddRelaxed(-capacity);
+            }
+            freeLists[i].clear();
+        }
+    }
+
+    /**
+     * Usually the pool is used by its own thread only, so the lock is
+     * taken without waiting. Other threads take it when they release
+     * the blocks of this pool.
+     */
+    QMutex lock;
+    QVector<QVector<quint8*>> freeLists;
+};
+
+QMutex s_unusedPoolsLock;
+QVector<Pool*> s_unusedPools;
+
+struct PoolHandle {
+    PoolHandle() {
+        QMutexLocker l(&s_unusedPoolsLock);
+        pool = !s_unusedPools.isEmpty() ? s_unusedPools.takeLast() : new Pool();
+    }
+
+    ~PoolHandle() {
+        pool->trim();
+
+        QMutexLocker l(&s_unusedPoolsLock);
+        s_unusedPools.append(pool);
+    }
+
+    Pool *pool;
+};
+
+QThreadStorage<PoolHandle*> s_pools;
+
+inline Pool* currentPool()
+{
+    if (!s_pools.hasLocalData()) {
+        s_pools.setLocalData(new PoolHandle());
+    }
+    return s_pools.localData()->pool;
+}
+
+}
+
+quint8* KisAlignedBufferPool::allocate(int size, int *capacity)
+{
+    KIS_ASSERT_RECOVER_NOOP(size >= 0);
+
+    s_numRequests.ref();
+
+    if (size > MAX_BLOCK_SIZE) {
+        *capacity = 0;
+        return 0;
+    }
+
+    const int sizeIndex = sizeClass(size);
+
+    *capacity = 1 << (sizeIndex + MIN_BLOCK_SIZE_LOG2);
+
+    Pool *pool = currentPool();
+
+    {
+        QMutexLocker l(&pool->lock);
+        QVector<quint8*> &freeList = pool->freeLists[sizeIndex];
+
+        if (!freeList.isEmpty()) {
+            s_pooledMemory.fetchAndAddRelaxed(-*capacity);
+            return freeList.takeLast();
+        }
+    }
+
+    s_numSystemAllocations.ref();
+
+    quint8 *block = static_cast<quint8*>(qMallocAligned(HEADER_SIZE + *capacity, ALIGNMENT));
+    if (!block) {
+        *capacity = 0;
+        return 0;
+    }
+
+    quint8 *ptr = block + HEADER_SIZE;
+    blockOwner(ptr) = pool;
+
+    return ptr;
+}
+
+void KisAlignedBufferPool::release(quint8 *ptr, int capacity)
+{
+    if (!ptr) return;
+
+    if (s_pooledMemory.fetchAndAddRelaxed(capacity) + capacity > MAX_POOLED_MEMORY) {
+        s_pooledMemory.fetchAndAddRelaxed(-capacity);
+        freeBlock(ptr);
+        return;
+    }
+
+    Pool *pool = blockOwner(ptr);
+
+    QMutexLocker l(&pool->lock);
+    pool->freeLists[sizeClass(capacity)].append(ptr);
+}
+
+qint64 KisAlignedBufferPool::pooledMemory()
+{
+    return s_pooledMemory.load();
+}
+
+qint64 KisAlignedBufferPool::numRequests()
+{
+    return s_numRequests.load();
+}
+
+qint64 KisAlignedBufferPool::numSystemAllocations()
+{
+    return s_numSystemAllocations.load();
+}
@@ -0,0 +1,98 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_ALIGNED_BUFFER_POOL_H
+#define __KIS_ALIGNED_BUFFER_POOL_H
+
+#include <QtGlobal>
+
+#include "kritaimage_export.h"
+
+
+/**
+ * A per-thread pool of aligned memory blocks for the short-living pixel
+ * buffers of the paintops: dabs, masks and the intermediate buffers of
+ * KisPainter::bltFixed().
+ *
+ * The sizes are rounded up to powers of two and every thread keeps the
+ * released blocks in free lists, one list per size. A stroke therefore
+ * allocates its buffers during the first few dabs and reuses them for
+ * the rest of it. The blocks may be released by any thread, they go
+ * back to the pool they were allocated from. All the pools together
+ * keep at most MAX_POOLED_MEMORY bytes, the rest goes back to the
+ * system, and the pool of a finished thread is emptied.
+ *
+ * The blocks are aligned to ALIGNMENT bytes, which suits any vector
+ * instruction set the composite ops are built for.
+ */
+class KRITAIMAGE_EXPORT KisAlignedBufferPool
+{
+public:
+    static const int ALIGNMENT = 64;
+    static const int MAX_POOLED_MEMORY = 16 * 1024 * 1024;
+
+    /**
+     * Returns a block of at least \p size bytes and writes its real size
+     * into \p capacity. Returns 0 if the system is out of memory.
+     */
+    static quint8* allocate(int size, int *capacity);
+
+    /**
+     * Gives the block back, \p capacity is the value returned by
+     * allocate()
+     */
+    static void release(quint8 *ptr, int capacity);
+
+    /**
+     * The number of allocate() calls and the number of them that had to
+     * allocate the memory from the system, for all the threads since
+     * the program has started
+     */
+    static qint64 numRequests();
+    static qint64 numSystemAllocations();
+
+    /**
+     * The size of the blocks kept in all the pools
+     */
+    static qint64 pooledMemory();
+
+    /**
+     * A block that is given back when the object goes out of scope
+     */
+    class Buffer
+    {
+    public:
+        Buffer(int size)
+            : m_capacity(0),
+              m_data(size > 0 ? allocate(size, &m_capacity) : 0)
+        {
+        }
+
+        ~Buffer() { release(m_data, m_capacity); }
+
+        quint8* data() const { return m_data; }
+
+    private:
+        Q_DISABLE_COPY(Buffer)
+
+        int m_capacity;
+        quint8 *m_data;
+    };
+};
+
+#endif /* __KIS_ALIGNED_BUFFER_POOL_H */
@@ -24,6 +24,7 @@
 
 #include <KoChannelInfo.h>
 #include <KoCompositeOpRegistry.h>
+#include <KoColorTransformation.h>
 
 #include "kis_node_visitor.h"
 #include "kis_painter.h"
@@ -36,16 +37,21 @@
 #include "filter/kis_filter.h"
 #include "filter/kis_filter_configuration.h"
 #include "filter/kis_filter_registry.h"
+#include "filter/kis_color_transformation_filter.h"
+#include "filter/kis_color_transformation_configuration.h"
 #include "kis_selection.h"
 #include "kis_clone_layer.h"
 #include "kis_processing_information.h"
 #include "kis_busy_progress_indicator.h"
+#include "kis_filter_result_cache.h"
 
 
 #include "kis_merge_walker.h"
 #include "kis_refresh_subtree_walker.h"
 
 #include "kis_abstract_projection_plane.h"
+#include "kis_psd_layer_style.h"
+#include "tiles3/kis_tile_data.h"
 
 
 //#define DEBUG_MERGER
@@ -121,7 +127,7 @@ public:
             layer->busyProgressIndicator()->update();
 
             // We do not create a transaction here, as srcDevice != dstDevice
-            filter->process(m_projection, dstDevice, 0, filterRect, filterConfig.data(), 0);
+            layer->filterResultCache()->process(filter, m_projection, dstDevice, filterRect, filterConfig.data());
         }
 
         if (selection) {
@@ -203,6 +209,171 @@ private:
 };
 
 
+/*********************************************************************/
+/*                Fusing of the adjustment layers                    */
+/*********************************************************************/
+
+namespace {
+
+/**
+ * Returns the adjustment layer of \p leaf if it is a pure point-wise
+ * color adjustment, which fully overwrites the projection below it.
+ * That is, it is a visible layer with a color transformation filter,
+ * no selection, no masks and no layer style, which is composed with
+ * a fully opaque COPY op on all the channels.
+ */
+KisAdjustmentLayer* fusableAdjustmentLayer(KisProjectionLeafSP leaf, KisPaintDeviceSP projection)
+{
+    KisAdjustmentLayer *layer = dynamic_cast<KisAdjustmentLayer*>(leaf->node().data());
+    if (!layer || !projection || !leaf->visible()) return 0;
+
+    if (layer->hasEffectMasks() ||
+        layer->layerStyle() ||
+        layer->internalSelection() ||
+        layer->compositeOpId() != COMPOSITE_COPY ||
+        leaf->opacity() != OPACITY_OPAQUE_U8) {
+
+        return 0;
+    }
+
+    const QBitArray channelFlags = leaf->channelFlags();
+    if (channelFlags.count(true) != channelFlags.size()) return 0;
+
+    KisPaintDeviceSP original = layer->original();
+    if (original->colorSpace() != projection->colorSpace() ||
+        original->colorSpace() != original->compositionSourceColorSpace()) {
+
+        return 0;
+    }
+
+    KisFilterConfigurationSP filterConfig = layer->filter();
+    if (!filterConfig) return 0;
+
+    KisFilterSP filter = KisFilterRegistry::instance()->value(filterConfig->name());
+    if (!dynamic_cast<const KisColorTransformationFilter*>(filter.data())) return 0;
+
+    return layer;
+}
+
+/**
+ * Pops the items of the adjustment layers lying directly above \p
+ * item from \p leafStack, as long as they can be fused with it. The
+ * resulting run starts with \p item itself.
+ */
+QVector<KisMergeWalker::JobItem> collectFusableRun(const KisMergeWalker::JobItem &item,
+                                                   KisMergeWalker::LeafStack &leafStack,
+                                                   KisPaintDeviceSP projection)
+{
+    QVector<KisMergeWalker::JobItem> run;
+
+    if (!(item.m_position & (KisMergeWalker::N_FILTHY | KisMergeWalker::N_ABOVE_FILTHY)) ||
+        !fusableAdjustmentLayer(item.m_leaf, projection)) {
+
+        return run;
+    }
+
+    run.append(item);
+
+    while (!leafStack.isEmpty() &&
+           !(run.last().m_position & KisMergeWalker::N_TOPMOST)) {
+
+        const KisMergeWalker::JobItem &next = leafStack.top();
+
+        if (next.m_leaf != run.last().m_leaf->nextSibling() ||
+            !(next.m_position & KisMergeWalker::N_ABOVE_FILTHY) ||
+            next.m_applyRect != item.m_applyRect ||
+            !fusableAdjustmentLayer(next.m_leaf, projection)) {
+
+            break;
+        }
+
+        run.append(leafStack.pop());
+    }
+
+    return run;
+}
+
+/**
+ * Updates the originals of a run of fusable adjustment layers in a
+ * single pass. The projection is read only once, every transformation
+ * is applied to the same buffer in place and only the originals are
+ * written. Since every layer of the run overwrites the projection
+ * completely, only the last one should be composed afterwards.
+ */
+void applyFusedAdjustmentLayers(const QVector<KisMergeWalker::JobItem> &run,
+                                const QRect &updateRect,
+                                KisPaintDeviceSP projection)
+{
+    const KoColorSpace *cs = projection->colorSpace();
+
+    QVector<KisPaintDeviceSP> originals;
+    QVector<KoColorTransformation*> transformations;
+    QVector<KoColorTransformation*> ownedTransformations;
+
+    Q_FOREACH (const KisMergeWalker::JobItem &item, run) {
+        KisAdjustmentLayer *layer = dynamic_cast<KisAdjustmentLayer*>(item.m_leaf->node().data());
+        KisFilterConfigurationSP filterConfig = layer->filter();
+        const KisColorTransformationFilter *filter =
+            dynamic_cast<const KisColorTransformationFilter*>(
+                KisFilterRegistry::instance()->value(filterConfig->name()).data());
+
+        KoColorTransformation *transformation = 0;
+
+        // the same way as KisColorTransformationFilter::processImpl() does
+        KisColorTransformationConfiguration *colorTransformationConfiguration =
+            dynamic_cast<KisColorTransformationConfiguration*>(filterConfig.data());
+
+        if (colorTransformationConfiguration) {
+            transformation = colorTransformationConfiguration->colorTransformation(cs, filter);
+        } else {
+            transformation = filter->createTransformation(cs, filterConfig);
+            ownedTransformations.append(transformation);
+        }
+
+        KisPaintDeviceSP original = layer->original();
+        original->clear(updateRect);
+
+        KIS_ASSERT_RECOVER_NOOP(layer->busyProgressIndicator());
+        layer->busyProgressIndicator()->update();
+
+        originals.append(original);
+        transformations.append(transformation);
+    }
+
+    const QRect applyRect = updateRect & projection->extent();
+
+    if (!applyRect.isEmpty()) {
+        const int pixelSize = cs->pixelSize();
+        const int bandHeight = KisTileData::HEIGHT;
+        QByteArray buffer(applyRect.width() * qMin(bandHeight, applyRect.height()) * pixelSize, 0);
+        quint8 *data = reinterpret_cast<quint8*>(buffer.data());
+
+        for (int y = applyRect.top(); y <= applyRect.bottom(); y += bandHeight) {
+            const QRect band(applyRect.left(), y,
+                             applyRect.width(), qMin(bandHeight, applyRect.bottom() - y + 1));
+            const int numPixels = band.width() * band.height();
+
+            projection->readBytes(data, band);
+
+            for (int i = 0; i < transformations.size(); i++) {
+                /**
+                 * A filter that couldn't create its transformation
+                 * passes the projection through unchanged, the same
+                 * way KisFilter::process() does for unfused layers
+                 */
+                if (transformations[i]) {
+                    transformations[i]->transform(data, data, numPixels);
+                }
+                originals[i]->writeBytes(data, band);
+            }
+        }
+    }
+
+    qDeleteAll(ownedTransformations);
+}
+
+}
+
 /*********************************************************************/
 /*                     KisAsyncMerger                                */
 /*********************************************************************/
@@ -240,6 +411,30 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
         if(!m_currentProjection)
             setupProjection(currentLeaf, applyRect, useTempProjections);
 
+        const QVector<KisMergeWalker::JobItem> fusedRun =
+            collectFusableRun(item, leafStack, m_currentProjection);
+
+        if(fusedRun.size() > 1) {
+            DEBUG_NODE_ACTION("Updating fused", fusedRun.size(), currentLeaf, applyRect);
+            applyFusedAdjustmentLayers(fusedRun, applyRect, m_currentProjection);
+
+            Q_FOREACH (const KisMergeWalker::JobItem &fusedItem, fusedRun) {
+                fusedItem.m_leaf->projectionPlane()->recalculate(applyRect,
+                    fusedItem.m_position & KisMergeWalker::N_FILTHY ?
+                        walker.startNode() : fusedItem.m_leaf->node());
+            }
+
+            const KisMergeWalker::JobItem &lastItem = fusedRun.last();
+            compositeWithProjection(lastItem.m_leaf, applyRect);
+
+            if(lastItem.m_position & KisMergeWalker::N_TOPMOST) {
+                writeProjection(lastItem.m_leaf, useTempProjections, applyRect);
+                resetProjection();
+            }
+
+            continue;
+        }
+
         KisUpdateOriginalVisitor originalVisitor(applyRect,
                                                  m_currentProjection,
                                                  walker.cropRect());
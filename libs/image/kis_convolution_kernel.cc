@@ -83,6 +83,143 @@ const Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic>* KisConvolutionKernel
     return &(d->data);
 }
 
+namespace {
+
+typedef Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+typedef Eigen::Matrix<qreal, Eigen::Dynamic, 1> ColumnVector;
+typedef Eigen::Matrix<qreal, 1, Eigen::Dynamic> RowVector;
+
+template <class MatrixType>
+bool isIntegral(const MatrixType &m)
+{
+    for (int r = 0; r < m.rows(); r++) {
+        for (int c = 0; c < m.cols(); c++) {
+            const qreal value = m(r, c);
+            if (qAbs(value) >= 1e9 || value != floor(value)) return false;
+        }
+    }
+
+    return true;
+}
+
+template <class VectorType>
+int numNonZero(const VectorType &v)
+{
+    int result = 0;
+    for (int i = 0; i < v.size(); i++) {
+        if (v(i) != 0.0) result++;
+    }
+    return result;
+}
+
+qint64 gcd(qint64 a, qint64 b)
+{
+    while (b) {
+        const qint64 t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+}
+
+bool KisConvolutionKernel::separate(QVector<qreal> *columnCoeffs, QVector<qreal> *rowCoeffs, bool *exact) const
+{
+    const Matrix &m = d->data;
+
+    if (exact) {
+        *exact = false;
+    }
+
+    if (!m.size()) return false;
+
+    Matrix::Index pivotRow = 0;
+    Matrix::Index pivotCol = 0;
+    const qreal pivot = m.cwiseAbs().maxCoeff(&pivotRow, &pivotCol);
+
+    if (pivot == 0.0) return false;
+
+    /**
+     * If the kernel has rank 1, then every row is a multiple of the
+     * pivot row and the multipliers form the pivot column
+     */
+    ColumnVector column = m.col(pivotCol);
+    RowVector row = m.row(pivotRow) / m(pivotRow, pivotCol);
+
+    const qreal tolerance = 1e-9 * pivot;
+    if ((m - column * row).cwiseAbs().maxCoeff() > tolerance) {
+        return false;
+    }
+
+    /**
+     * Prefer the vectors whose products are computed without rounding,
+     * then the two passes sum up exactly the same values in the same
+     * order as the 2D convolution does. That is the case when one of
+     * the vectors has a single non-zero coefficient, which is 1, or
+     * when both of them are integral.
+     */
+    bool isExact = false;
+
+    if (numNonZero(column) == 1) {
+        column = ColumnVector::Zero(m.rows());
+        column(pivotRow) = 1.0;
+        row = m.row(pivotRow);
+        isExact = true;
+    } else if (numNonZero(row) == 1) {
+        row = RowVector::Zero(m.cols());
+        row(pivotCol) = 1.0;
+        column = m.col(pivotCol);
+        isExact = true;
+    } else if (isIntegral(m)) {
+        qint64 divisor = 0;
+        for (int c = 0; c < m.cols(); c++) {
+            divisor = gcd(qint64(qAbs(m(pivotRow, c))), divisor);
+        }
+
+        const RowVector integralRow = m.row(pivotRow) / qreal(divisor);
+        const ColumnVector integralColumn = m.col(pivotCol) / integralRow(pivotCol);
+        const Matrix product = integralColumn * integralRow;
+
+        if (isIntegral(integralColumn) && product == m) {
+            row = integralRow;
+            column = integralColumn;
+            isExact = true;
+        }
+    }
+
+    if (columnCoeffs) {
+        columnCoeffs->resize(column.size());
+        for (int i = 0; i < column.size(); i++) {
+            (*columnCoeffs)[i] = column(i);
+        }
+    }
+
+    if (rowCoeffs) {
+        rowCoeffs->resize(row.size());
+        for (int i = 0; i < row.size(); i++) {
+            (*rowCoeffs)[i] = row(i);
+        }
+    }
+
+    if (exact) {
+        *exact = isExact;
+    }
+
+    return true;
+}
+
+bool KisConvolutionKernel::isSeparable() const
+{
+    return separate(0, 0);
+}
+
+bool KisConvolutionKernel::isExactlySeparable() const
+{
+    bool exact = false;
+    return separate(0, 0, &exact) && exact;
+}
+
 KisConvolutionKernelSP KisConvolutionKernel::fromQImage(const QImage& image)
 {
     KisConvolutionKernelSP kernel = new KisConvolutionKernel(image.width(), image.height(), 0, 0);
@@ -21,6 +21,7 @@
 
 #include <cstddef>
 #include <Eigen/Core>
+#include <QVector>
 #include "kis_shared.h"
 #include "kritaimage_export.h"
 #include "kis_types.h"
@@ -47,6 +48,24 @@ public:
     Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic>& data();
     const Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> * data() const;
 
+    /**
+     * Checks whether the kernel is a product of a column and a row
+     * vector (that is, its rank is 1), like the Gaussian or the box
+     * kernels are. Such kernels can be applied with two 1D passes.
+     *
+     * If the kernel is separable and the pointers are non-null, the
+     * vectors are written into \p columnCoeffs and \p rowCoeffs, so
+     * that data(r, c) == columnCoeffs[r] * rowCoeffs[c]
+     *
+     * \p exact is set to true if the two passes give exactly the same
+     * result as the 2D convolution, not only up to rounding: when the
+     * kernel has a single non-zero row or column, or when all its
+     * coefficients are integers
+     */
+    bool separate(QVector<qreal> *columnCoeffs, QVector<qreal> *rowCoeffs, bool *exact = 0) const;
+    bool isSeparable() const;
+    bool isExactlySeparable() const;
+
     static KisConvolutionKernelSP fromQImage(const QImage& image);
     static KisConvolutionKernelSP fromMaskGenerator(KisMaskGenerator *, qreal angle = 0.0);
     static KisConvolutionKernelSP fromMatrix(Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix, qreal offset, qreal factor);
@@ -50,6 +50,7 @@
 
 #include "kis_convolution_worker.h"
 #include "kis_convolution_worker_spatial.h"
+#include "kis_convolution_worker_separable.h"
 
 #include "config_convolution.h"
 
@@ -65,10 +66,31 @@ KisConvolutionWorker<factory>* KisConvolutionPainter::createWorker(const KisConv
 {
     KisConvolutionWorker<factory> *worker;
 
+    /**
+     * Separable kernels cost (width + height) operations per pixel
+     * when applied in two passes, which beats the FFT for moderate
+     * kernel sizes. For the smallest kernels the spatial worker is
+     * still cheaper than the intermediate buffers and the threads.
+     * Only the kernels that give exactly the same result in two
+     * passes are separated, so the choice never changes the output.
+     */
+    #define SEPARABLE_THRESHOLD_SIZE 64
+    #define SEPARABLE_MIN_KERNEL_AREA 25
+
+    const bool useSeparable =
+        m_enginePreference == SEPARABLE ||
+        (m_enginePreference == NONE &&
+         kernel->width() + kernel->height() <= SEPARABLE_THRESHOLD_SIZE &&
+         kernel->width() * kernel->height() >= SEPARABLE_MIN_KERNEL_AREA &&
+         kernel->isExactlySeparable());
+
 #ifdef HAVE_FFTW3
     #define THRESHOLD_SIZE 5
 
-    if(m_enginePreference == SPATIAL ||
+    if (useSeparable) {
+        worker = new KisConvolutionWorkerSeparable<factory>(painter, progress);
+    }
+    else if(m_enginePreference == SPATIAL ||
        (m_enginePreference != FFTW &&
         kernel->width() <= THRESHOLD_SIZE &&
         kernel->height() <= THRESHOLD_SIZE)) {
@@ -79,8 +101,11 @@ KisConvolutionWorker<factory>* KisConvolutionPainter::createWorker(const KisConv
         worker = new KisConvolutionWorkerFFT<factory>(painter, progress);
     }
 #else
-    Q_UNUSED(kernel);
-    worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
+    if (useSeparable) {
+        worker = new KisConvolutionWorkerSeparable<factory>(painter, progress);
+    } else {
+        worker = new KisConvolutionWorkerSpatial<factory>(painter, progress);
+    }
 #endif
 
     return worker;
@@ -72,7 +72,8 @@ protected:
     enum TestingEnginePreference {
         NONE,
         SPATIAL,
-        FFTW
+        FFTW,
+        SEPARABLE
     };
 
 
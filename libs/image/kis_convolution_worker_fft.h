@@ -26,12 +26,18 @@
 
 #include "kis_convolution_worker.h"
 #include "kis_math_toolbox.h"
+#include "tiles3/kis_tile_data.h"
 
 #include <QMutex>
+#include <QMutexLocker>
 #include <QVector>
+#include <QHash>
+#include <QSharedPointer>
 #include <QTextStream>
 #include <QFile>
 #include <QDir>
+#include <QtConcurrent>
+#include <QAtomicInt>
 
 #include <fftw3.h>
 
@@ -45,15 +51,96 @@ private:
 
 QMutex KisConvolutionWorkerFFTLock::fftwMutex;
 
+/**
+ * Keeps the spectra of the recently used kernels. Filter masks and
+ * adjustment layers apply the same kernel again and again while the
+ * image is being edited, so there is no reason to transform it on
+ * every update.
+ *
+ * The spectra are identified by the coefficients of the kernel and
+ * by the size of the transform, so equal kernels share the entry even
+ * if they are different objects.
+ */
+class KisConvolutionKernelSpectrumCache
+{
+public:
+    typedef QSharedPointer<fftw_complex> SpectrumSP;
+
+    static KisConvolutionKernelSpectrumCache* instance() {
+        static KisConvolutionKernelSpectrumCache cache;
+        return &cache;
+    }
+
+    static QByteArray key(const KisConvolutionKernelSP kernel, quint32 fftWidth, quint32 fftHeight) {
+        const quint32 header[] = {fftWidth, fftHeight, kernel->width(), kernel->height()};
+
+        QByteArray result(reinterpret_cast<const char*>(header), sizeof(header));
+        result.append(reinterpret_cast<const char*>(kernel->data()->data()),
+                      kernel->width() * kernel->height() * sizeof(qreal));
+        return result;
+    }
+
+    SpectrumSP fetch(const QByteArray &key) {
+        QMutexLocker l(&m_mutex);
+
+        SpectrumSP spectrum = m_spectra.value(key);
+        if (spectrum) {
+            m_lru.removeOne(key);
+            m_lru.append(key);
+        }
+
+        return spectrum;
+    }
+
+    void store(const QByteArray &key, SpectrumSP spectrum, int size) {
+        QMutexLocker l(&m_mutex);
+
+        if (m_spectra.contains(key)) return;
 
+        m_spectra.insert(key, spectrum);
+        m_sizes.insert(key, size);
+        m_lru.append(key);
+        m_totalSize += size;
+
+        while (m_totalSize > maxCacheSize && m_lru.size() > 1) {
+            const QByteArray oldKey = m_lru.takeFirst();
+            m_totalSize -= m_sizes.take(oldKey);
+            m_spectra.remove(oldKey);
+        }
+    }
+
+private:
+    KisConvolutionKernelSpectrumCache() : m_totalSize(0) {}
+
+    static const qint64 maxCacheSize = 64 * 1024 * 1024;
+
+    QMutex m_mutex;
+    QHash<QByteArray, SpectrumSP> m_spectra;
+    QHash<QByteArray, int> m_sizes;
+    QList<QByteArray> m_lru;
+    qint64 m_totalSize;
+};
+
+
+/**
+ * The area is convolved in blocks (overlap-save): every block of the
+ * destination is transformed together with the margins it needs, the
+ * margins are dropped after the inverse transform. The blocks are
+ * independent, so they are processed on the global thread pool and
+ * written to the destination as soon as they are ready. Only the
+ * blocks being processed are kept in memory, so the memory used for
+ * the transforms doesn't depend on the size of the area.
+ *
+ * The blocks of the same size share the kernel spectrum, which is
+ * also cached between the calls.
+ */
 template<class _IteratorFactory_>
 class KisConvolutionWorkerFFT : public KisConvolutionWorker<_IteratorFactory_>
 {
 public:
     KisConvolutionWorkerFFT(KisPainter *painter, KoUpdater *progress)
         : KisConvolutionWorker<_IteratorFactory_>(painter, progress),
-          m_currentProgress(0),
-          m_kernelFFT(0)
+          m_currentProgress(0)
     {
     }
 
@@ -61,6 +148,45 @@ public:
     {
     }
 
+    /**
+     * Size and memory layout of the transform of one block
+     */
+    struct FFTGeometry {
+        FFTGeometry(quint32 areaWidth, quint32 areaHeight,
+                    quint32 halfKernelWidth, quint32 halfKernelHeight)
+        {
+            width = areaWidth + 4 * halfKernelWidth;
+            height = areaHeight + 2 * halfKernelHeight;
+
+            /**
+             * FIXME: check whether this "optimization" is needed to
+             * be uncommented. My tests showed about 30% better performance
+             * when the line is commented out (DK).
+             */
+            //optimumDimensions(width, height);
+
+            length = height * (width / 2 + 1);
+            extraMem = (width % 2) ? 1 : 2;
+        }
+
+        inline int rowStride() const {
+            return width + extraMem;
+        }
+
+        quint32 width, height, length, extraMem;
+    };
+
+    /**
+     * FFTW plans and the kernel spectrum, shared by all the blocks
+     * of the same size
+     */
+    struct BlockTransform {
+        BlockTransform() : forwardPlan(0), backwardPlan(0) {}
+
+        fftw_plan forwardPlan;
+        fftw_plan backwardPlan;
+        KisConvolutionKernelSpectrumCache::SpectrumSP kernelSpectrum;
+    };
 
     virtual void execute(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect)
     {
@@ -82,97 +208,86 @@ public:
         const quint32 halfKernelWidth = (kernel->width() - 1) / 2;
         const quint32 halfKernelHeight = (kernel->height() - 1) / 2;
 
-        m_fftWidth = areaSize.width() + 4 * halfKernelWidth;
-        m_fftHeight = areaSize.height() + 2 * halfKernelHeight;
-
-        /**
-         * FIXME: check whether this "optimization" is needed to
-         * be uncommented. My tests showed about 30% better performance
-         * when the line is commented out (DK).
-         */
-        //optimumDimensions(m_fftWidth, m_fftHeight);
-
-        m_fftLength = m_fftHeight * (m_fftWidth / 2 + 1);
-        m_extraMem = (m_fftWidth % 2) ? 1 : 2;
-
-        // create and fill kernel
-        m_kernelFFT = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
-        memset(m_kernelFFT, 0, sizeof(fftw_complex) * m_fftLength);
-        fftFillKernelMatrix(kernel, m_kernelFFT);
-
         // find out which channels need convolving
         QList<KoChannelInfo*> convChannelList = this->convolvableChannelList(src);
 
-        m_channelFFT.resize(convChannelList.count());
-        for (auto i = m_channelFFT.begin(); i != m_channelFFT.end(); ++i) {
-            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
-        }
+        KisPaintDeviceSP dst = this->m_painter->device();
+        FFTInfo info (kernel->factor() ? kernel->factor() : 1, convChannelList, kernel, dst->colorSpace());
 
-        const double kernelFactor = kernel->factor() ? kernel->factor() : 1;
-        const double fftScale = 1.0 / (m_fftHeight * m_fftWidth) / kernelFactor;
+        const QVector<QRect> blocks =
+            splitIntoBlocks(QRect(dstPos, areaSize), dst->x(), dst->y(),
+                            blockSize(kernel->width()), blockSize(kernel->height()));
 
-        FFTInfo info (fftScale, convChannelList, kernel, this->m_painter->device()->colorSpace());
-        int cacheRowStride = m_fftWidth + m_extraMem;
+        // prepare the plans and the kernel spectra for all the block sizes
+        QHash<QPair<int, int>, BlockTransform> transforms;
 
-        fillCacheFromDevice(src,
-                            QRect(srcPos.x() - halfKernelWidth,
-                                  srcPos.y() - halfKernelHeight,
-                                  m_fftWidth,
-                                  m_fftHeight),
-                            cacheRowStride,
-                            info, dataRect);
+        Q_FOREACH (const QRect &block, blocks) {
+            const QPair<int, int> size(block.width(), block.height());
+            if (transforms.contains(size)) continue;
+
+            FFTGeometry geometry(block.width(), block.height(), halfKernelWidth, halfKernelHeight);
+            transforms.insert(size, createBlockTransform(kernel, geometry));
+        }
 
         addToProgress(10);
-        if (isInterrupted()) return;
+        if (isInterrupted()) {
+            destroyBlockTransforms(transforms);
+            return;
+        }
 
-        // calculate number off fft operations required for progress reporting
-        const float progressPerFFT = (100 - 30) / (double)(convChannelList.count() * 2 + 1);
+        const QPoint srcOffset = srcPos - dstPos;
 
-        // perform FFT
-        fftw_plan fftwPlanForward, fftwPlanBackward;
+        /**
+         * Every block is written to the destination as soon as it is
+         * ready, so when convolving in place, the margins of the
+         * blocks are read from a copy-on-write copy of the device
+         */
+        KisPaintDeviceSP source = src;
+        if (source == dst) {
+            source = new KisPaintDevice(*src);
+        }
 
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftwPlanForward = fftw_plan_dft_r2c_2d(m_fftHeight, m_fftWidth, (double*)m_kernelFFT, m_kernelFFT, FFTW_ESTIMATE);
-        fftwPlanBackward = fftw_plan_dft_c2r_2d(m_fftHeight, m_fftWidth, m_kernelFFT, (double*)m_kernelFFT, FFTW_ESTIMATE);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+        QVector<QFuture<void>> jobs;
+        QAtomicInt cancelled(0);
 
-        fftw_execute(fftwPlanForward);
-        addToProgress(progressPerFFT);
-        if (isInterrupted()) return;
+        for (int i = 0; i < blocks.size(); i++) {
+            const QRect block = blocks[i];
+            const BlockTransform transform = transforms.value(qMakePair(block.width(), block.height()));
 
-        for (auto k = m_channelFFT.begin(); k != m_channelFFT.end(); ++k)
-        {
-            fftw_execute_dft_r2c(fftwPlanForward, (double*)(*k), *k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
+            jobs.append(QtConcurrent::run([&, block, transform] () {
+                if (cancelled.load()) return;
 
-            fftMultiply(*k, m_kernelFFT);
+                FFTGeometry geometry(block.width(), block.height(), halfKernelWidth, halfKernelHeight);
+                const QByteArray result =
+                    convolveBlock(source, dst, block, srcOffset,
+                                  halfKernelWidth, halfKernelHeight,
+                                  geometry, transform, info, dataRect);
 
-            fftw_execute_dft_c2r(fftwPlanBackward, *k, (double*)*k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
+                // the blocks never share a tile, so they can be written concurrently
+                dst->writeBytes(reinterpret_cast<const quint8*>(result.constData()), block);
+            }));
         }
 
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftw_destroy_plan(fftwPlanForward);
-        fftw_destroy_plan(fftwPlanBackward);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+        const float progressPerBlock = (100 - 10) / float(blocks.size());
 
+        for (int i = 0; i < jobs.size(); i++) {
+            jobs[i].waitForFinished();
 
-        writeResultToDevice(QRect(dstPos.x(), dstPos.y(), areaSize.width(), areaSize.height()),
-                            cacheRowStride, halfKernelWidth, halfKernelHeight,
-                            info, dataRect);
+            addToProgress(progressPerBlock);
+            if (this->m_progress && this->m_progress->interrupted()) {
+                cancelled.store(1);
+            }
+        }
 
-        addToProgress(20);
-        cleanUp();
+        destroyBlockTransforms(transforms);
     }
 
     struct FFTInfo {
-        FFTInfo(qreal _fftScale,
+        FFTInfo(qreal _kernelFactor,
                 const QList<KoChannelInfo*> &_convChannelList,
                 const KisConvolutionKernelSP kernel,
                 const KoColorSpace */*colorSpace*/)
-            : fftScale(_fftScale),
+            : kernelFactor(_kernelFactor),
               convChannelList(_convChannelList),
               alphaCachePos(-1),
               alphaRealPos(-1)
@@ -208,7 +323,7 @@ public:
         QVector<qreal> maxClamp;
         QVector<qreal> absoluteOffset;
 
-        qreal fftScale;
+        qreal kernelFactor;
         QList<KoChannelInfo*> convChannelList;
 
         QVector<PtrToDouble> toDoubleFuncPtr;
@@ -222,7 +337,8 @@ public:
                              const QRect &rect,
                              const int cacheRowStride,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<fftw_complex*> &channelFFT) {
 
         typename _IteratorFactory_::HLineConstIterator hitSrc =
             _IteratorFactory_::createHLineConstIterator(src,
@@ -234,7 +350,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt;
         }
@@ -278,7 +394,7 @@ public:
 
     }
 
-    inline void limitValue(qreal *value, qreal lowBound, qreal highBound) {
+    static inline void limitValue(qreal *value, qreal lowBound, qreal highBound) {
         if (*value > highBound) {
             *value = highBound;
         } else if (!(*value >= lowBound)) {  // value < lowBound or value == NaN
@@ -288,17 +404,18 @@ public:
     }
 
     template <bool additionalMultiplierActive>
-    inline qreal writeOneChannelFromCache(quint8* dstPtr,
-                                          const quint32 channel,
-                                          const FFTInfo &info,
-                                          double* channelValuePtr,
-                                          const qreal additionalMultiplier = 0.0) {
+    static inline qreal writeOneChannelFromCache(quint8* dstPtr,
+                                                 const quint32 channel,
+                                                 const FFTInfo &info,
+                                                 const qreal fftScale,
+                                                 double* channelValuePtr,
+                                                 const qreal additionalMultiplier = 0.0) {
         qreal channelPixelValue;
 
         if (additionalMultiplierActive) {
-            channelPixelValue = (*channelValuePtr * info.fftScale + info.absoluteOffset[channel]) * additionalMultiplier;
+            channelPixelValue = (*channelValuePtr * fftScale + info.absoluteOffset[channel]) * additionalMultiplier;
         } else {
-            channelPixelValue = *channelValuePtr * info.fftScale + info.absoluteOffset[channel];
+            channelPixelValue = *channelValuePtr * fftScale + info.absoluteOffset[channel];
         }
 
         limitValue(&channelPixelValue, info.minClamp[channel], info.maxClamp[channel]);
@@ -308,17 +425,19 @@ public:
         return channelPixelValue;
     }
 
-    void writeResultToDevice(const QRect &rect,
+    /**
+     * Writes the convolved channels into \p dstData, which contains
+     * \p size pixels of the destination device
+     */
+    void writeResultToBuffer(quint8 *dstData,
+                             const QSize &size,
+                             const int pixelSize,
                              const int cacheRowStride,
                              const int halfKernelWidth,
                              const int halfKernelHeight,
+                             const qreal fftScale,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
-
-        typename _IteratorFactory_::HLineIterator hitDst =
-            _IteratorFactory_::createHLineIterator(this->m_painter->device(),
-                                                   rect.x(), rect.y(), rect.width(),
-                                                   dataRect);
+                             const QVector<fftw_complex*> &channelFFT) {
 
         int initialOffset = cacheRowStride * halfKernelHeight + halfKernelWidth;
 
@@ -327,7 +446,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt + initialOffset;
         }
@@ -336,18 +455,19 @@ public:
         QVector<double*> cacheRowStart(channelCount);
         const auto cacheRowStartBegin = cacheRowStart.begin();
 
-        for (int y = 0; y < rect.height(); ++y) {
+        for (int y = 0; y < size.height(); ++y) {
             // cache current channelPtr in cacheRowStart
             memcpy(cacheRowStart.data(), channelPtr.data(), channelCount * sizeof(double*));
 
-            for (int x = 0; x < rect.width(); ++x) {
-                quint8 *dstPtr = hitDst->rawData();
+            for (int x = 0; x < size.width(); ++x) {
+                quint8 *dstPtr = dstData;
 
                 if (info.alphaCachePos >= 0) {
                     qreal alphaValue =
                         writeOneChannelFromCache<false>(dstPtr,
                                                         info.alphaCachePos,
                                                         info,
+                                                        fftScale,
                                                         channelPtr.at(info.alphaCachePos));
 
                     if (alphaValue > std::numeric_limits<qreal>::epsilon()) {
@@ -359,6 +479,7 @@ public:
                                 writeOneChannelFromCache<true>(dstPtr,
                                                                k,
                                                                info,
+                                                               fftScale,
                                                                *i,
                                                                alphaValueInv);
                             }
@@ -381,61 +502,209 @@ public:
                         writeOneChannelFromCache<false>(dstPtr,
                                                         k,
                                                         info,
+                                                        fftScale,
                                                         *i);
                        ++(*i);
                     }
                 }
 
-                hitDst->nextPixel();
+                dstData += pixelSize;
             }
 
             auto iRowStart = cacheRowStartBegin;
             for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iRowStart) {
                 *i = *iRowStart + cacheRowStride;
             }
-
-            hitDst->nextRow();
         }
 
     }
 
 private:
-    void fftFillKernelMatrix(const KisConvolutionKernelSP kernel, fftw_complex *m_kernelFFT)
+    /**
+     * The blocks should be much bigger than the kernel, otherwise
+     * most of the transform is spent on the margins
+     */
+    static int blockSize(int kernelSize) {
+        const int minBlockSize = 512;
+        const int size = qMax(minBlockSize, 4 * kernelSize);
+
+        // keep the blocks aligned to the tiles
+        return (size + KisTileData::WIDTH - 1) / KisTileData::WIDTH * KisTileData::WIDTH;
+    }
+
+    /**
+     * Splits \p rect into blocks aligned to a grid with origin in
+     * (\p originX, \p originY), so that different blocks never share
+     * a tile of the destination device
+     */
+    static QVector<QRect> splitIntoBlocks(const QRect &rect, int originX, int originY,
+                                          int blockWidth, int blockHeight) {
+
+        /**
+         * Small areas are transformed as a whole, which is also the
+         * fastest way to do that
+         */
+        if (rect.width() <= blockWidth && rect.height() <= blockHeight) {
+            return QVector<QRect>() << rect;
+        }
+
+        auto splitRange = [] (int start, int length, int origin, int step) {
+            QVector<QPair<int, int>> ranges;
+
+            const int end = start + length;
+            while (start < end) {
+                const int offset = ((start - origin) % step + step) % step;
+                const int size = qMin(end - start, step - offset);
+                ranges.append(qMakePair(start, size));
+                start += size;
+            }
+
+            return ranges;
+        };
+
+        QVector<QRect> blocks;
+
+        const auto rows = splitRange(rect.y(), rect.height(), originY, blockHeight);
+        const auto cols = splitRange(rect.x(), rect.width(), originX, blockWidth);
+
+        for (auto row = rows.begin(); row != rows.end(); ++row) {
+            for (auto col = cols.begin(); col != cols.end(); ++col) {
+                blocks.append(QRect(col->first, row->first, col->second, row->second));
+            }
+        }
+
+        return blocks;
+    }
+
+    BlockTransform createBlockTransform(const KisConvolutionKernelSP kernel, const FFTGeometry &geometry)
+    {
+        BlockTransform transform;
+
+        fftw_complex *buffer = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * geometry.length);
+
+        KisConvolutionWorkerFFTLock::fftwMutex.lock();
+        transform.forwardPlan = fftw_plan_dft_r2c_2d(geometry.height, geometry.width, (double*)buffer, buffer, FFTW_ESTIMATE);
+        transform.backwardPlan = fftw_plan_dft_c2r_2d(geometry.height, geometry.width, buffer, (double*)buffer, FFTW_ESTIMATE);
+        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+
+        const QByteArray key = KisConvolutionKernelSpectrumCache::key(kernel, geometry.width, geometry.height);
+        transform.kernelSpectrum = KisConvolutionKernelSpectrumCache::instance()->fetch(key);
+
+        if (transform.kernelSpectrum) {
+            fftw_free(buffer);
+        } else {
+            memset(buffer, 0, sizeof(fftw_complex) * geometry.length);
+            fftFillKernelMatrix(kernel, buffer, geometry);
+            fftw_execute(transform.forwardPlan);
+
+            transform.kernelSpectrum =
+                KisConvolutionKernelSpectrumCache::SpectrumSP(buffer, fftw_free);
+
+            KisConvolutionKernelSpectrumCache::instance()->store(key, transform.kernelSpectrum,
+                                                                 sizeof(fftw_complex) * geometry.length);
+        }
+
+        return transform;
+    }
+
+    void destroyBlockTransforms(QHash<QPair<int, int>, BlockTransform> &transforms)
+    {
+        KisConvolutionWorkerFFTLock::fftwMutex.lock();
+        Q_FOREACH (const BlockTransform &transform, transforms) {
+            fftw_destroy_plan(transform.forwardPlan);
+            fftw_destroy_plan(transform.backwardPlan);
+        }
+        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+
+        transforms.clear();
+    }
+
+    /**
+     * Convolves a single block of the destination and returns it as
+     * a buffer of pixels of the destination device
+     */
+    QByteArray convolveBlock(KisPaintDeviceSP src, KisPaintDeviceSP dst,
+                             const QRect &block, const QPoint &srcOffset,
+                             quint32 halfKernelWidth, quint32 halfKernelHeight,
+                             const FFTGeometry &geometry,
+                             const BlockTransform &transform,
+                             const FFTInfo &info,
+                             const QRect &dataRect)
+    {
+        QVector<fftw_complex*> channelFFT(info.numChannels());
+        for (auto i = channelFFT.begin(); i != channelFFT.end(); ++i) {
+            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * geometry.length);
+        }
+
+        const double fftScale = 1.0 / (geometry.height * geometry.width) / info.kernelFactor;
+
+        fillCacheFromDevice(src,
+                            QRect(block.x() + srcOffset.x() - halfKernelWidth,
+                                  block.y() + srcOffset.y() - halfKernelHeight,
+                                  geometry.width,
+                                  geometry.height),
+                            geometry.rowStride(),
+                            info, dataRect, channelFFT);
+
+        for (auto k = channelFFT.begin(); k != channelFFT.end(); ++k) {
+            fftw_execute_dft_r2c(transform.forwardPlan, (double*)(*k), *k);
+            fftMultiply(*k, transform.kernelSpectrum.data(), geometry);
+            fftw_execute_dft_c2r(transform.backwardPlan, *k, (double*)*k);
+        }
+
+        // the channels that are not convolved are left untouched
+        const int pixelSize = dst->pixelSize();
+        QByteArray result(block.width() * block.height() * pixelSize, 0);
+        quint8 *resultPtr = reinterpret_cast<quint8*>(result.data());
+        dst->readBytes(resultPtr, block);
+
+        writeResultToBuffer(resultPtr, block.size(), pixelSize,
+                            geometry.rowStride(), halfKernelWidth, halfKernelHeight,
+                            fftScale, info, channelFFT);
+
+        Q_FOREACH (fftw_complex *channel, channelFFT) {
+            fftw_free(channel);
+        }
+
+        return result;
+    }
+
+    static void fftFillKernelMatrix(const KisConvolutionKernelSP kernel, fftw_complex *kernelFFT, const FFTGeometry &geometry)
     {
         // find central item
         QPoint offset((kernel->width() - 1) / 2, (kernel->height() - 1) / 2);
 
-        qint32 xShift = m_fftWidth - offset.x();
-        qint32 yShift = m_fftHeight - offset.y();
+        qint32 xShift = geometry.width - offset.x();
+        qint32 yShift = geometry.height - offset.y();
 
         quint32 absXpos, absYpos;
 
         for (quint32 y = 0; y < kernel->height(); y++)
         {
             absYpos = y + yShift;
-            if (absYpos >= m_fftHeight)
-                absYpos -= m_fftHeight;
+            if (absYpos >= geometry.height)
+                absYpos -= geometry.height;
 
             for (quint32 x = 0; x < kernel->width(); x++)
             {
                 absXpos = x + xShift;
-                if (absXpos >= m_fftWidth)
-                    absXpos -= m_fftWidth;
+                if (absXpos >= geometry.width)
+                    absXpos -= geometry.width;
 
-                ((double*)m_kernelFFT)[(m_fftWidth + m_extraMem) * absYpos + absXpos] = kernel->data()->coeff(y, x);
+                ((double*)kernelFFT)[geometry.rowStride() * absYpos + absXpos] = kernel->data()->coeff(y, x);
             }
         }
     }
 
-    void fftMultiply(fftw_complex* channel, fftw_complex* kernel)
+    static void fftMultiply(fftw_complex* channel, const fftw_complex* kernel, const FFTGeometry &geometry)
     {
         // perform complex multiplication
         fftw_complex *channelPtr = channel;
-        fftw_complex *kernelPtr = kernel;
+        const fftw_complex *kernelPtr = kernel;
 
         fftw_complex tmp;
 
-        for (quint32 pixelPos = 0; pixelPos < m_fftLength; ++pixelPos)
+        for (quint32 pixelPos = 0; pixelPos < geometry.length; ++pixelPos)
         {
             tmp[0] = ((*channelPtr)[0] * (*kernelPtr)[0]) - ((*channelPtr)[1] * (*kernelPtr)[1]);
             tmp[1] = ((*channelPtr)[0] * (*kernelPtr)[1]) + ((*channelPtr)[1] * (*kernelPtr)[0]);
@@ -470,7 +739,7 @@ private:
         }
     }
 
-    void fftLogMatrix(double* channel, const QString &f)
+    void fftLogMatrix(double* channel, const FFTGeometry &geometry, const QString &f)
     {
         KisConvolutionWorkerFFTLock::fftwMutex.lock();
         QString filename(QDir::homePath() + "/log_" + f + ".txt");
@@ -484,11 +753,11 @@ private:
         }
 
         QTextStream in(&file);
-        for (quint32 y = 0; y < m_fftHeight; y++)
+        for (quint32 y = 0; y < geometry.height; y++)
         {
-            for (quint32 x = 0; x < m_fftWidth; x++)
+            for (quint32 x = 0; x < geometry.width; x++)
             {
-                QString num = QString::number(channel[y * m_fftWidth + x]);
+                QString num = QString::number(channel[y * geometry.width + x]);
                 while (num.length() < 15)
                     num += " ";
 
@@ -510,32 +779,11 @@ private:
 
     bool isInterrupted()
     {
-        if (this->m_progress && this->m_progress->interrupted()) {
-            cleanUp();
-            return true;
-        }
-
-        return false;
+        return this->m_progress && this->m_progress->interrupted();
     }
 
-    void cleanUp()
-    {
-        // free kernel fft data
-        if (m_kernelFFT) {
-            fftw_free(m_kernelFFT);
-        }
-
-        Q_FOREACH (fftw_complex *channel, m_channelFFT) {
-            fftw_free(channel);
-        }
-        m_channelFFT.clear();
-    }
 private:
-    quint32 m_fftWidth, m_fftHeight, m_fftLength, m_extraMem;
     float m_currentProgress;
-
-    fftw_complex* m_kernelFFT;
-    QVector<fftw_complex*> m_channelFFT;
 };
 
 #endif
@@ -0,0 +1,380 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_CONVOLUTION_WORKER_SEPARABLE_H
+#define KIS_CONVOLUTION_WORKER_SEPARABLE_H
+
+#include <QtConcurrent>
+#include <QAtomicInt>
+
+#include "kis_assert.h"
+#include "kis_convolution_worker.h"
+#include "kis_convolution_kernel.h"
+#include "kis_math_toolbox.h"
+#include "tiles3/kis_tile_data.h"
+
+/**
+ * Applies a separable (rank 1) kernel as two 1D passes: every source
+ * row is convolved with the row vector of the kernel, then the
+ * intermediate rows are combined with the column vector. That costs
+ * (kw + kh) multiplications per channel instead of (kw * kh).
+ *
+ * The channels are stored planar in the intermediate buffers, so the
+ * inner loops run over contiguous rows of numbers and can be
+ * vectorized by the compiler.
+ *
+ * The area is split into stripes aligned to the tile rows of the
+ * destination device, which are processed on the global thread
+ * pool. Every stripe is written into the device as soon as it is
+ * ready, so only the stripes being processed are kept in memory.
+ * When convolving in place, the source is read from a copy-on-write
+ * copy of the device.
+ *
+ * The painter uses this worker only for the kernels that
+ * KisConvolutionKernel::isExactlySeparable(), so the result is
+ * exactly the same as the one of the spatial worker.
+ */
+template <class _IteratorFactory_>
+class KisConvolutionWorkerSeparable : public KisConvolutionWorker<_IteratorFactory_>
+{
+public:
+    KisConvolutionWorkerSeparable(KisPainter *painter, KoUpdater *progress)
+        : KisConvolutionWorker<_IteratorFactory_>(painter, progress)
+        ,  m_alphaCachePos(-1)
+        ,  m_alphaRealPos(-1)
+    {
+    }
+
+    ~KisConvolutionWorkerSeparable() {
+    }
+
+    virtual void execute(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect) {
+        QVector<qreal> columnCoeffs;
+        QVector<qreal> rowCoeffs;
+
+        if (!kernel->separate(&columnCoeffs, &rowCoeffs)) {
+            KIS_ASSERT_RECOVER_NOOP(0 && "the kernel is not separable");
+            return;
+        }
+
+        m_kw = kernel->width();
+        m_kh = kernel->height();
+        m_khalfWidth = (m_kw - 1) / 2;
+        m_khalfHeight = (m_kh - 1) / 2;
+        m_pixelSize = src->colorSpace()->pixelSize();
+
+        /**
+         * The kernel is mirrored on convolution, so store the
+         * coefficients in the reversed order to be able to walk
+         * the source pixels forward
+         */
+        m_rowCoeffs.resize(m_kw);
+        for (int i = 0; i < m_kw; i++) {
+            m_rowCoeffs[i] = rowCoeffs[m_kw - i - 1];
+        }
+
+        m_columnCoeffs.resize(m_kh);
+        for (int i = 0; i < m_kh; i++) {
+            m_columnCoeffs[i] = columnCoeffs[m_kh - i - 1];
+        }
+
+        // Make the area we cover as small as possible
+        if (this->m_painter->selection()) {
+            QRect r = this->m_painter->selection()->selectedRect().intersect(QRect(srcPos, areaSize));
+            dstPos += r.topLeft() - srcPos;
+            srcPos = r.topLeft();
+            areaSize = r.size();
+        }
+
+        if (areaSize.width() == 0 || areaSize.height() == 0)
+            return;
+
+        m_convChannelList = this->convolvableChannelList(src);
+        m_convolveChannelsNo = m_convChannelList.count();
+
+        for (int i = 0; i < m_convChannelList.size(); i++) {
+            if (m_convChannelList[i]->channelType() == KoChannelInfo::ALPHA) {
+                m_alphaCachePos = i;
+                m_alphaRealPos = m_convChannelList[i]->pos();
+            }
+        }
+
+        KisMathToolbox mathToolbox;
+        m_toDoubleFuncPtr = QVector<PtrToDouble>(m_convolveChannelsNo);
+        if (!mathToolbox.getToDoubleChannelPtr(m_convChannelList, m_toDoubleFuncPtr))
+            return;
+
+        m_fromDoubleFuncPtr = QVector<PtrFromDouble>(m_convolveChannelsNo);
+        if (!mathToolbox.getFromDoubleChannelPtr(m_convChannelList, m_fromDoubleFuncPtr))
+            return;
+
+        m_kernelFactor = kernel->factor() ? 1.0 / kernel->factor() : 1;
+        m_minClamp.resize(m_convolveChannelsNo);
+        m_maxClamp.resize(m_convolveChannelsNo);
+        m_absoluteOffset.resize(m_convolveChannelsNo);
+        for (int i = 0; i < m_convolveChannelsNo; ++i) {
+            m_minClamp[i] = mathToolbox.minChannelValue(m_convChannelList[i]);
+            m_maxClamp[i] = mathToolbox.maxChannelValue(m_convChannelList[i]);
+            m_absoluteOffset[i] = (m_maxClamp[i] - m_minClamp[i]) * kernel->offset();
+        }
+
+        bool hasProgressUpdater = this->m_progress;
+        if (hasProgressUpdater) {
+            this->m_progress->setProgress(0);
+            this->m_progress->setRange(0, areaSize.height());
+        }
+
+        KisPaintDeviceSP dst = this->m_painter->device();
+
+        QVector<QRect> stripes;
+        const int tileOrigin = dst->y();
+
+        int stripeStart = 0;
+        while (stripeStart < areaSize.height()) {
+            const int dstRow = dstPos.y() + stripeStart;
+            const int stripeHeight =
+                qMin(areaSize.height() - stripeStart,
+                     KisTileData::HEIGHT -
+                     ((dstRow - tileOrigin) % KisTileData::HEIGHT + KisTileData::HEIGHT) % KisTileData::HEIGHT);
+
+            stripes.append(QRect(0, stripeStart, areaSize.width(), stripeHeight));
+            stripeStart += stripeHeight;
+        }
+
+        /**
+         * Every stripe is written to the destination as soon as it is
+         * ready, so when convolving in place, the rows around the
+         * stripes are read from a copy-on-write copy of the device
+         */
+        KisPaintDeviceSP source = src;
+        if (source == dst) {
+            source = new KisPaintDevice(*src);
+        }
+
+        QVector<QFuture<void>> jobs;
+        QAtomicInt cancelled(0);
+
+        for (int i = 0; i < stripes.size(); i++) {
+            const QRect stripe = stripes[i];
+
+            jobs.append(QtConcurrent::run([&, stripe] () {
+                if (cancelled.load()) return;
+
+                const QByteArray result = convolveStripe(source, srcPos, stripe, dataRect);
+
+                // the stripes never share a tile, so they can be written concurrently
+                dst->writeBytes(reinterpret_cast<const quint8*>(result.constData()),
+                                stripe.translated(dstPos));
+            }));
+        }
+
+        for (int i = 0; i < jobs.size(); i++) {
+            jobs[i].waitForFinished();
+
+            if (hasProgressUpdater) {
+                this->m_progress->setValue(stripes[i].bottom());
+
+                if (this->m_progress->interrupted()) {
+                    cancelled.store(1);
+                }
+            }
+        }
+
+    }
+
+private:
+
+    /**
+     * Convolves \p stripe (in the coordinates of the area) and returns
+     * the result as packed pixels of the source color space
+     */
+    QByteArray convolveStripe(KisPaintDeviceSP src, const QPoint &srcPos, const QRect &stripe, const QRect &dataRect) const {
+        const int numChannels = m_convolveChannelsNo;
+        const int width = stripe.width();
+        const int lineWidth = width + m_kw - 1;
+        const int numSrcRows = stripe.height() + m_kh - 1;
+        const int planeSize = numChannels * width;
+
+        QVector<qreal> line(numChannels * lineWidth);
+        QVector<qreal> interm(numSrcRows * planeSize);
+        QVector<qreal> accumulator(planeSize);
+
+        // first pass: convolve the source rows with the row vector
+        for (int i = 0; i < numSrcRows; i++) {
+            typename _IteratorFactory_::HLineConstIterator srcIt =
+                _IteratorFactory_::createHLineConstIterator(src,
+                                                            srcPos.x() - m_khalfWidth,
+                                                            srcPos.y() + stripe.y() - m_khalfHeight + i,
+                                                            lineWidth, dataRect);
+
+            loadLine(srcIt, line.data(), lineWidth);
+
+            qreal *dstRow = interm.data() + i * planeSize;
+
+            for (int k = 0; k < numChannels; k++) {
+                qreal *dstPtr = dstRow + k * width;
+                const qreal *linePtr = line.constData() + k * lineWidth;
+
+                convolveRow(dstPtr, linePtr, m_rowCoeffs.constData(), m_kw, width);
+            }
+        }
+
+        // second pass: combine the intermediate rows with the column vector
+        QByteArray result(stripe.height() * width * m_pixelSize, 0);
+        quint8 *resultPtr = reinterpret_cast<quint8*>(result.data());
+
+        for (int row = 0; row < stripe.height(); row++) {
+            convolveRow(accumulator.data(), interm.constData() + row * planeSize,
+                        m_columnCoeffs.constData(), m_kh, planeSize, planeSize);
+
+            // keep the channels that are not convolved
+            typename _IteratorFactory_::HLineConstIterator srcIt =
+                _IteratorFactory_::createHLineConstIterator(src,
+                                                            srcPos.x(),
+                                                            srcPos.y() + stripe.y() + row,
+                                                            width, dataRect);
+
+            for (int x = 0; x < width; x++) {
+                memcpy(resultPtr, srcIt->oldRawData(), m_pixelSize);
+                storePixel(resultPtr, accumulator.constData() + x, width);
+
+                resultPtr += m_pixelSize;
+                srcIt->nextPixel();
+            }
+        }
+
+        return result;
+    }
+
+    /**
+     * dst[x] = sum(coeffs[i] * src[x + i * step]), the inner loop
+     * walks over contiguous memory, so it is easily vectorized
+     */
+    static inline void convolveRow(qreal *dst, const qreal *src,
+                                   const qreal *coeffs, int numCoeffs,
+                                   int length, int step = 1) {
+
+        for (int x = 0; x < length; x++) {
+            dst[x] = 0.0;
+        }
+
+        for (int i = 0; i < numCoeffs; i++) {
+            const qreal coeff = coeffs[i];
+            if (coeff == 0.0) continue;
+
+            const qreal *srcPtr = src + i * step;
+
+            for (int x = 0; x < length; x++) {
+                dst[x] += coeff * srcPtr[x];
+            }
+        }
+    }
+
+    template <class IteratorSP>
+    inline void loadLine(IteratorSP it, qreal *line, int lineWidth) const {
+        for (int x = 0; x < lineWidth; x++) {
+            const quint8 *data = it->oldRawData();
+
+            // no alpha is rare case, so just multiply by 1.0 in that case
+            qreal alphaValue = m_alphaRealPos >= 0 ?
+                m_toDoubleFuncPtr[m_alphaCachePos](data, m_alphaRealPos) : 1.0;
+
+            for (int k = 0; k < m_convolveChannelsNo; ++k) {
+                if (k != m_alphaCachePos) {
+                    const quint32 channelPos = m_convChannelList[k]->pos();
+                    line[k * lineWidth + x] = m_toDoubleFuncPtr[k](data, channelPos) * alphaValue;
+                } else {
+                    line[k * lineWidth + x] = alphaValue;
+                }
+            }
+
+            it->nextPixel();
+        }
+    }
+
+    inline qreal storeChannel(quint8 *dstPtr, int channel, qreal value) const {
+        if (value > m_maxClamp[channel]) {
+            value = m_maxClamp[channel];
+        } else if (!(value >= m_minClamp[channel])) {  // value < lowBound or value == NaN
+            value = m_minClamp[channel];
+        }
+
+        m_fromDoubleFuncPtr[channel](dstPtr, m_convChannelList[channel]->pos(), value);
+        return value;
+    }
+
+    /**
+     * Writes the convolved pixel, \p values are the sums of the
+     * channels placed \p stride values apart
+     */
+    inline void storePixel(quint8 *dstPtr, const qreal *values, int stride) const {
+        if (m_alphaCachePos >= 0) {
+            qreal alphaValue =
+                storeChannel(dstPtr, m_alphaCachePos,
+                             values[m_alphaCachePos * stride] * m_kernelFactor +
+                             m_absoluteOffset[m_alphaCachePos]);
+
+            if (alphaValue != 0.0) {
+                qreal alphaValueInv = 1.0 / alphaValue;
+
+                for (int k = 0; k < m_convolveChannelsNo; ++k) {
+                    if (k == m_alphaCachePos) continue;
+                    storeChannel(dstPtr, k,
+                                 (values[k * stride] * m_kernelFactor) * alphaValueInv +
+                                 m_absoluteOffset[k]);
+                }
+            } else {
+                for (int k = 0; k < m_convolveChannelsNo; ++k) {
+                    if (k == m_alphaCachePos) continue;
+
+                    const qreal zeroValue = 0.0;
+                    const quint32 channelPos = m_convChannelList[k]->pos();
+                    m_fromDoubleFuncPtr[k](dstPtr, channelPos, zeroValue);
+                }
+            }
+        } else {
+            for (int k = 0; k < m_convolveChannelsNo; ++k) {
+                storeChannel(dstPtr, k, values[k * stride] * m_kernelFactor + m_absoluteOffset[k]);
+            }
+        }
+    }
+
+private:
+    int m_kw, m_kh;
+    int m_khalfWidth, m_khalfHeight;
+    int m_convolveChannelsNo;
+    int m_pixelSize;
+
+    int m_alphaCachePos;
+    int m_alphaRealPos;
+
+    QVector<qreal> m_rowCoeffs;
+    QVector<qreal> m_columnCoeffs;
+
+    QVector<qreal> m_minClamp;
+    QVector<qreal> m_maxClamp;
+    QVector<qreal> m_absoluteOffset;
+
+    qreal m_kernelFactor;
+    QList<KoChannelInfo *> m_convChannelList;
+    QVector<PtrToDouble> m_toDoubleFuncPtr;
+    QVector<PtrFromDouble> m_fromDoubleFuncPtr;
+};
+
+
+#endif
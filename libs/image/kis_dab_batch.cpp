@@ -0,0 +1,195 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_dab_batch.h"
+
+#include <QPoint>
+#include <QRect>
+#include <QHash>
+#include <QPair>
+
+#include <KoColorSpace.h>
+
+#include "kis_assert.h"
+#include "kis_paint_device.h"
+#include "kis_fixed_paint_device.h"
+#include "tiles3/kis_tile_data.h"
+
+namespace {
+
+typedef QPair<int, int> Cell;
+
+inline int cellIndex(int coordinate, int size)
+{
+    return coordinate >= 0 ? coordinate / size : -((size - 1 - coordinate) / size);
+}
+
+inline QRect cellRect(const Cell &cell)
+{
+    const int w = KisTileData::WIDTH;
+    const int h = KisTileData::HEIGHT;
+    return QRect(cell.first * w, cell.second * h, w, h);
+}
+
+}
+
+struct KisDabBatch::Private
+{
+    struct Dab {
+        QRect dstRect;
+        int offset;
+        const KoColorSpace *colorSpace;
+        const KoCompositeOp *compositeOp;
+        KoCompositeOp::ParameterInfo params;
+    };
+
+    QVector<Dab> dabs;
+    QByteArray arena;
+};
+
+KisDabBatch::KisDabBatch()
+    : m_d(new Private)
+{
+}
+
+KisDabBatch::~KisDabBatch()
+{
+}
+
+void KisDabBatch::add(const QPoint &dstPos,
+                      const KisFixedPaintDeviceSP srcDev,
+                      const QRect &srcRect,
+                      const KoCompositeOp *compositeOp,
+                      const KoCompositeOp::ParameterInfo &params)
+{
+    const QRect srcBounds = srcDev->bounds();
+    KIS_ASSERT_RECOVER_RETURN(srcBounds.contains(srcRect));
+
+    const int pixelSize = srcDev->pixelSize();
+    const int rowSize = srcRect.width() * pixelSize;
+    const int srcRowStride = srcBounds.width() * pixelSize;
+
+    Private::Dab dab;
+    dab.dstRect = QRect(dstPos, srcRect.size());
+    dab.offset = m_d->arena.size();
+    dab.colorSpace = srcDev->colorSpace();
+    dab.compositeOp = compositeOp;
+    dab.params = params;
+
+    m_d->arena.resize(dab.offset + rowSize * srcRect.height());
+
+    const quint8 *srcPtr = srcDev->data() +
+        (srcRect.y() - srcBounds.y()) * srcRowStride +
+        (srcRect.x() - srcBounds.x()) * pixelSize;
+    quint8 *dstPtr = reinterpret_cast<quint8*>(m_d->arena.data()) + dab.offset;
+
+    for (int row = 0; row < srcRect.height(); row++) {
+        memcpy(dstPtr, srcPtr, rowSize);
+        srcPtr += srcRowStride;
+        dstPtr += rowSize;
+    }
+
+    m_d->dabs.append(dab);
+}
+
+bool KisDabBatch::isEmpty() const
+{
+    return m_d->dabs.isEmpty();
+}
+
+int KisDabBatch::memoryUsage() const
+{
+    return m_d->arena.size();
+}
+
+QVector<QRect> KisDabBatch::flush(KisPaintDeviceSP dst,
+                                  KoColorConversionTransformation::Intent renderingIntent,
+                                  KoColorConversionTransformation::ConversionFlags conversionFlags)
+{
+    QVector<QRect> rects;
+    if (m_d->dabs.isEmpty()) return rects;
+
+    // the dabs touching every cell, in the order they were added
+    QVector<Cell> cells;
+    QHash<Cell, QVector<int>> cellDabs;
+
+    for (int i = 0; i < m_d->dabs.size(); i++) {
+        const QRect &rc = m_d->dabs[i].dstRect;
+        rects.append(rc);
+
+        for (int y = cellIndex(rc.top(), KisTileData::HEIGHT); y <= cellIndex(rc.bottom(), KisTileData::HEIGHT); y++) {
+            for (int x = cellIndex(rc.left(), KisTileData::WIDTH); x <= cellIndex(rc.right(), KisTileData::WIDTH); x++) {
+                const Cell cell(x, y);
+
+                QVector<int> &indexes = cellDabs[cell];
+                if (indexes.isEmpty()) {
+                    cells.append(cell);
+                }
+                indexes.append(i);
+            }
+        }
+    }
+
+    const KoColorSpace *dstColorSpace = dst->colorSpace();
+    const int dstPixelSize = dst->pixelSize();
+    const quint8 *arena = reinterpret_cast<const quint8*>(m_d->arena.constData());
+    QByteArray buffer;
+
+    Q_FOREACH (const Cell &cell, cells) {
+        const QVector<int> &indexes = cellDabs[cell];
+
+        QRect area;
+        Q_FOREACH (int i, indexes) {
+            area |= m_d->dabs[i].dstRect;
+        }
+        area &= cellRect(cell);
+
+        buffer.resize(area.width() * area.height() * dstPixelSize);
+        quint8 *dstBytes = reinterpret_cast<quint8*>(buffer.data());
+        dst->readBytes(dstBytes, area);
+
+        Q_FOREACH (int i, indexes) {
+            const Private::Dab &dab = m_d->dabs[i];
+            const QRect rc = dab.dstRect & area;
+            const int srcPixelSize = dab.colorSpace->pixelSize();
+
+            KoCompositeOp::ParameterInfo params = dab.params;
+
+            params.dstRowStart = dstBytes +
+                ((rc.y() - area.y()) * area.width() + rc.x() - area.x()) * dstPixelSize;
+            params.dstRowStride = area.width() * dstPixelSize;
+            params.srcRowStart = arena + dab.offset +
+                ((rc.y() - dab.dstRect.y()) * dab.dstRect.width() + rc.x() - dab.dstRect.x()) * srcPixelSize;
+            params.srcRowStride = dab.dstRect.width() * srcPixelSize;
+            params.maskRowStart = 0;
+            params.maskRowStride = 0;
+            params.rows = rc.height();
+            params.cols = rc.width();
+
+            dstColorSpace->bitBlt(dab.colorSpace, params, dab.compositeOp,
+                                  renderingIntent, conversionFlags);
+        }
+
+        dst->writeBytes(dstBytes, area);
+    }
+
+    m_d->dabs.clear();
+    m_d->arena.clear();
+
+    return rects;
+}
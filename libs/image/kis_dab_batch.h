@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_DAB_BATCH_H
+#define __KIS_DAB_BATCH_H
+
+#include <QScopedPointer>
+#include <QVector>
+
+#include <KoCompositeOp.h>
+#include <KoColorConversionTransformation.h>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+class QPoint;
+class QRect;
+
+
+/**
+ * Collects the dabs blitted by a paintop and composites them onto the
+ * device later, tile by tile.
+ *
+ * Every dab is copied into a contiguous arena together with the
+ * composite op and the parameters (opacity, flow, channel flags) it was
+ * blitted with, so the paintop may reuse its dab device right away.
+ * flush() reads every touched tile once, composites all the dabs
+ * intersecting it in the order they were added and writes it back,
+ * instead of reading and writing the whole dab area for every dab.
+ * The result is the same as blitting the dabs one by one.
+ *
+ * Used by KisPainter between beginDabBatch() and endDabBatch().
+ */
+class KRITAIMAGE_EXPORT KisDabBatch
+{
+public:
+    KisDabBatch();
+    ~KisDabBatch();
+
+    /**
+     * Adds \p srcRect of \p srcDev to be composited at \p dstPos
+     */
+    void add(const QPoint &dstPos,
+             const KisFixedPaintDeviceSP srcDev,
+             const QRect &srcRect,
+             const KoCompositeOp *compositeOp,
+             const KoCompositeOp::ParameterInfo &params);
+
+    bool isEmpty() const;
+
+    /**
+     * The size of the pixels kept in the arena in bytes
+     */
+    int memoryUsage() const;
+
+    /**
+     * Composites all the collected dabs onto \p dst and empties the
+     * batch. Returns the rects of the dabs.
+     */
+    QVector<QRect> flush(KisPaintDeviceSP dst,
+                         KoColorConversionTransformation::Intent renderingIntent,
+                         KoColorConversionTransformation::ConversionFlags conversionFlags);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_DAB_BATCH_H */
@@ -129,6 +129,17 @@ public:
         return ACTUAL_DATAMGR::read(io);
     }
 
+    /**
+     * Reads and writes only the tiles that differ from \p baseDM
+     */
+    inline bool writeDelta(KisPaintDeviceWriter &writer, KisDataManager *baseDM) {
+        return ACTUAL_DATAMGR::writeDelta(writer, baseDM);
+    }
+
+    inline bool readDelta(QIODevice *io, KisDataManager *baseDM) {
+        return ACTUAL_DATAMGR::readDelta(io, baseDM);
+    }
+
     inline void purge(const QRect& area) {
         ACTUAL_DATAMGR::purge(area);
     }
@@ -167,6 +178,10 @@ public:
         return ACTUAL_DATAMGR::region();
     }
 
+    QVector<quint64> tileVersions(const QRect &rect) const {
+        return ACTUAL_DATAMGR::tileVersions(rect);
+    }
+
 public:
 
     /**
@@ -33,7 +33,8 @@ struct Q_DECL_HIDDEN KisDistanceInformation::Private {
         lastPaintInfoValid(false),
         lockedDrawingAngle(0.0),
         hasLockedDrawingAngle(false),
-        totalDistance(0.0) {}
+        totalDistance(0.0),
+        currentDabSeqNo(0) {}
 
     QPointF distance;
     KisSpacingInformation spacing;
@@ -48,6 +49,7 @@ struct Q_DECL_HIDDEN KisDistanceInformation::Private {
     qreal lockedDrawingAngle;
     bool hasLockedDrawingAngle;
     qreal totalDistance;
+    int currentDabSeqNo;
 };
 
 KisDistanceInformation::KisDistanceInformation()
@@ -156,6 +158,12 @@ void KisDistanceInformation::registerPaintedDab(const KisPaintInformation &info,
     m_d->lastDabInfoValid = true;
 
     m_d->spacing = spacing;
+    m_d->currentDabSeqNo++;
+}
+
+int KisDistanceInformation::currentDabSeqNo() const
+{
+    return m_d->currentDabSeqNo;
 }
 
 qreal KisDistanceInformation::getNextPointPosition(const QPointF &start,
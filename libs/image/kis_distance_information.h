@@ -121,6 +121,11 @@ public:
 
     qreal scalarDistanceApprox() const;
 
+    /**
+     * \return the number of dabs painted with this distance information
+     */
+    int currentDabSeqNo() const;
+
     void overrideLastValues(const QPointF &lastPosition, qreal lastTime);
 
 private:
@@ -34,6 +34,7 @@
 #include "kis_busy_progress_indicator.h"
 #include "kis_transaction.h"
 #include "kis_painter.h"
+#include "kis_filter_result_cache.h"
 
 KisFilterMask::KisFilterMask()
     : KisEffectMask(),
@@ -94,7 +95,7 @@ QRect KisFilterMask::decorateRect(KisPaintDeviceSP &src,
     KIS_ASSERT_RECOVER_NOOP(this->busyProgressIndicator());
     this->busyProgressIndicator()->update();
 
-    filter->process(src, dst, 0, rc, filterConfig.data(), 0);
+    filterResultCache()->process(filter, src, dst, rc, filterConfig.data());
 
     QRect r = filter->changedRect(rc, filterConfig.data(), dst->defaultBounds()->currentLevelOfDetail());
     return r;
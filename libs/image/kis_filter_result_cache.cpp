@@ -0,0 +1,298 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_filter_result_cache.h"
+
+#include <QRect>
+#include <QRegion>
+#include <QBitArray>
+#include <QCache>
+#include <QPair>
+#include <QVector>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicInt>
+#include <QGlobalStatic>
+#include <QCryptographicHash>
+
+#include <KoColorSpace.h>
+#include <KoColorProfile.h>
+
+#include "kis_assert.h"
+#include "kis_image_config.h"
+#include "kis_paint_device.h"
+#include "kis_default_bounds_base.h"
+#include "filter/kis_filter.h"
+#include "filter/kis_filter_configuration.h"
+#include "tiles3/kis_tile_data.h"
+
+namespace {
+
+typedef QPair<int, int> Cell;
+
+inline int cellIndex(int coordinate, int size)
+{
+    return coordinate >= 0 ? coordinate / size : -((size - 1 - coordinate) / size);
+}
+
+inline QRect cellRect(int column, int row)
+{
+    const int w = KisTileData::WIDTH;
+    const int h = KisTileData::HEIGHT;
+    return QRect(column * w, row * h, w, h);
+}
+
+void addColorSpace(QCryptographicHash &hash, const KoColorSpace *cs)
+{
+    hash.addData(cs->id().toLatin1());
+    if (cs->profile()) {
+        hash.addData(cs->profile()->name().toUtf8());
+    }
+}
+
+struct Entry {
+    QRect rect;
+    QByteArray fingerprint;
+    QByteArray pixels;
+};
+
+/**
+ * The cell of a particular cache
+ */
+typedef QPair<int, Cell> Key;
+
+/**
+ * All the caches of all the images share the same memory budget,
+ * which is a part of the memory allowed for the tiles. The costs
+ * are counted in KiB, since the budget may not fit into an int.
+ */
+struct SharedStorage
+{
+    SharedStorage()
+        : entries(qMax(1, KisImageConfig(true).filterResultCacheLimit()) * 1024)
+    {
+    }
+
+    static int cost(const Entry *entry) {
+        return entry->pixels.size() / 1024 + 1;
+    }
+
+    QMutex lock;
+    QCache<Key, Entry> entries;
+};
+
+Q_GLOBAL_STATIC(SharedStorage, s_storage)
+
+QAtomicInt s_lastCacheId;
+
+}
+
+struct KisFilterResultCache::Private
+{
+    Private() : id(s_lastCacheId.fetchAndAddRelaxed(1) + 1) {}
+
+    /**
+     * Never reused, so the entries of a destroyed cache cannot be
+     * mistaken for the ones of a new cache
+     */
+    const int id;
+
+    QAtomicInt hitCount;
+    QAtomicInt missCount;
+
+    void dropEntries();
+};
+
+KisFilterResultCache::KisFilterResultCache()
+    : m_d(new Private())
+{
+}
+
+KisFilterResultCache::~KisFilterResultCache()
+{
+    m_d->dropEntries();
+}
+
+void KisFilterResultCache::Private::dropEntries()
+{
+    SharedStorage *storage = s_storage;
+    if (!storage) return;
+
+    QMutexLocker l(&storage->lock);
+
+    Q_FOREACH (const Key &key, storage->entries.keys()) {
+        if (key.first == id) {
+            storage->entries.remove(key);
+        }
+    }
+}
+
+void KisFilterResultCache::process(KisFilterSP filter,
+                                   KisPaintDeviceSP src,
+                                   KisPaintDeviceSP dst,
+                                   const QRect &rect,
+                                   const KisFilterConfigurationSP config)
+{
+    if (rect.isEmpty()) return;
+
+    const int lod = src->defaultBounds()->currentLevelOfDetail();
+    const QRect needRect = filter->neededRect(rect, config, lod);
+
+    if (src == dst || !filter->supportsThreading() || needRect == rect) {
+        filter->process(src, dst, 0, rect, config, 0);
+        return;
+    }
+
+    QByteArray commonFingerprint;
+
+    {
+        QCryptographicHash hash(QCryptographicHash::Md5);
+        hash.addData(filter->id().toUtf8());
+        if (config) {
+            hash.addData(config->toXML().toUtf8());
+
+            // the channel flags are not saved into XML
+            const QBitArray channelFlags = config->channelFlags();
+            QByteArray flags(channelFlags.size(), '0');
+            for (int i = 0; i < channelFlags.size(); i++) {
+                if (channelFlags.testBit(i)) flags[i] = '1';
+            }
+            hash.addData(flags);
+        }
+        hash.addData(QByteArray::number(lod));
+        addColorSpace(hash, src->colorSpace());
+        addColorSpace(hash, dst->colorSpace());
+        commonFingerprint = hash.result();
+    }
+
+    // the part of the rect in every cell and its fingerprint
+    QVector<Cell> cells;
+    QVector<QRect> parts;
+    QVector<QRect> partNeedRects;
+    QVector<QVector<quint64>> partVersions;
+    QVector<QByteArray> fingerprints;
+
+    for (int row = cellIndex(rect.top(), KisTileData::HEIGHT); row <= cellIndex(rect.bottom(), KisTileData::HEIGHT); row++) {
+        for (int column = cellIndex(rect.left(), KisTileData::WIDTH); column <= cellIndex(rect.right(), KisTileData::WIDTH); column++) {
+            const QRect part = cellRect(column, row) & rect;
+            const QRect partNeedRect = filter->neededRect(part, config, lod);
+            KIS_ASSERT_RECOVER(needRect.contains(partNeedRect)) {
+                filter->process(src, dst, 0, rect, config, 0);
+                return;
+            }
+
+            QCryptographicHash hash(QCryptographicHash::Md5);
+            hash.addData(commonFingerprint);
+
+            const QByteArray geometry = QString("%1 %2 %3 %4 %5 %6")
+                .arg(part.x()).arg(part.y()).arg(part.width()).arg(part.height())
+                .arg(src->x()).arg(src->y()).toLatin1();
+            hash.addData(geometry);
+
+            /**
+             * The tile versions change whenever the pixels do, so
+             * the source is never read for fingerprinting. A tile is
+             * stamped again when a write to it completes, so a write
+             * that is still in progress never leaves a valid key.
+             */
+            const QVector<quint64> versions = src->tileVersions(partNeedRect);
+            hash.addData(reinterpret_cast<const char*>(versions.constData()),
+                         versions.size() * sizeof(quint64));
+
+            cells.append(Cell(column, row));
+            parts.append(part);
+            partNeedRects.append(partNeedRect);
+            partVersions.append(versions);
+            fingerprints.append(hash.result());
+        }
+    }
+
+    QVector<QByteArray> cachedPixels(cells.size());
+    QRegion missedRegion;
+
+    SharedStorage *storage = s_storage;
+
+    {
+        QMutexLocker l(&storage->lock);
+
+        for (int i = 0; i < cells.size(); i++) {
+            const Entry *entry = storage->entries.object(Key(m_d->id, cells[i]));
+
+            if (entry && entry->rect == parts[i] && entry->fingerprint == fingerprints[i]) {
+                cachedPixels[i] = entry->pixels;
+                m_d->hitCount.ref();
+            } else {
+                missedRegion += parts[i];
+                m_d->missCount.ref();
+            }
+        }
+    }
+
+    /**
+     * The missed cells are filtered in as few rects as possible, since
+     * every rect reads its own needed rect
+     */
+    Q_FOREACH (const QRect &rc, missedRegion.rects()) {
+        filter->process(src, dst, 0, rc, config, 0);
+    }
+
+    const int pixelSize = dst->pixelSize();
+
+    for (int i = 0; i < cells.size(); i++) {
+        if (!cachedPixels[i].isNull()) {
+            dst->writeBytes(reinterpret_cast<const quint8*>(cachedPixels[i].constData()), parts[i]);
+        } else {
+            /**
+             * If the source has been written while we were filtering,
+             * the result may not match the fingerprint anymore
+             */
+            if (src->tileVersions(partNeedRects[i]) != partVersions[i]) continue;
+
+            Entry *entry = new Entry;
+            entry->rect = parts[i];
+            entry->fingerprint = fingerprints[i];
+            entry->pixels.resize(parts[i].width() * parts[i].height() * pixelSize);
+            dst->readBytes(reinterpret_cast<quint8*>(entry->pixels.data()), parts[i]);
+
+            QMutexLocker l(&storage->lock);
+            storage->entries.insert(Key(m_d->id, cells[i]), entry, SharedStorage::cost(entry));
+        }
+    }
+}
+
+void KisFilterResultCache::clear()
+{
+    m_d->dropEntries();
+}
+
+int KisFilterResultCache::hitCount() const
+{
+    return m_d->hitCount.load();
+}
+
+int KisFilterResultCache::missCount() const
+{
+    return m_d->missCount.load();
+}
+
+qint64 KisFilterResultCache::totalMemory()
+{
+    SharedStorage *storage = s_storage;
+    QMutexLocker l(&storage->lock);
+    return qint64(storage->entries.totalCost()) * 1024;
+}
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_FILTER_RESULT_CACHE_H
+#define __KIS_FILTER_RESULT_CACHE_H
+
+#include <QScopedPointer>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+class QRect;
+
+
+/**
+ * Remembers the results of a filter per tile-sized cell together with
+ * a fingerprint of the input they were calculated from, so that the
+ * cells whose input has not changed are not filtered again.
+ *
+ * The fingerprint of a cell covers the filter, its configuration, the
+ * level of detail, the color spaces and the source tiles intersecting
+ * the needed rect of the cell. The source tiles are identified by
+ * their tile data versions, so the pixels are never read for that.
+ *
+ * The results of all the caches share one process-wide memory budget,
+ * KisImageConfig::filterResultCacheLimit(). The least recently used
+ * cells of any node are dropped first.
+ *
+ * Only the filters that can be split into patches (supportsThreading())
+ * and need pixels around the processed rect are cached. Point-wise
+ * filters are cheaper to recalculate than to fingerprint, so they are
+ * passed through directly.
+ *
+ * The cache is thread-safe. A node may update several rects at once.
+ */
+class KRITAIMAGE_EXPORT KisFilterResultCache
+{
+public:
+    KisFilterResultCache();
+    ~KisFilterResultCache();
+
+    /**
+     * Does the same as KisFilter::process() without a selection. The
+     * cells of \p rect with unchanged input are copied from the cache,
+     * the rest is filtered and stored in the cache. \p src and \p dst
+     * must be different devices.
+     */
+    void process(KisFilterSP filter,
+                 KisPaintDeviceSP src,
+                 KisPaintDeviceSP dst,
+                 const QRect &rect,
+                 const KisFilterConfigurationSP config);
+
+    /**
+     * Drops all the cached results
+     */
+    void clear();
+
+    /**
+     * The number of the cells copied from the cache and filtered again
+     * since the cache has been created
+     */
+    int hitCount() const;
+    int missCount() const;
+
+    /**
+     * The approximate size of the results held by all the caches
+     */
+    static qint64 totalMemory();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_FILTER_RESULT_CACHE_H */
@@ -22,33 +22,62 @@
 #include <KoColor.h>
 #include <KoColorModelStandardIds.h>
 #include "kis_debug.h"
+#include "kis_aligned_buffer_pool.h"
 
 KisFixedPaintDevice::KisFixedPaintDevice(const KoColorSpace* colorSpace)
-        : m_colorSpace(colorSpace)
+        : m_colorSpace(colorSpace),
+          m_data(0),
+          m_dataSize(0),
+          m_capacity(0)
 {
 }
 
 
 KisFixedPaintDevice::~KisFixedPaintDevice()
 {
+    KisAlignedBufferPool::release(m_data, m_capacity);
 }
 
 KisFixedPaintDevice::KisFixedPaintDevice(const KisFixedPaintDevice& rhs)
-        : KisShared()
+        : KisShared(),
+          m_data(0),
+          m_dataSize(0),
+          m_capacity(0)
 {
-    m_bounds = rhs.m_bounds;
-    m_colorSpace = rhs.m_colorSpace;
-    m_data = rhs.m_data;
+    *this = rhs;
 }
 
 KisFixedPaintDevice& KisFixedPaintDevice::operator=(const KisFixedPaintDevice& rhs)
 {
+    if (this == &rhs) return *this;
+
     m_bounds = rhs.m_bounds;
     m_colorSpace = rhs.m_colorSpace;
-    m_data = rhs.m_data;
+
+    if (resizeData(rhs.m_dataSize) && m_dataSize) {
+        memcpy(m_data, rhs.m_data, m_dataSize);
+    }
+
     return *this;
 }
 
+bool KisFixedPaintDevice::resizeData(int size)
+{
+    if (size > m_capacity) {
+        KisAlignedBufferPool::release(m_data, m_capacity);
+        m_data = KisAlignedBufferPool::allocate(size, &m_capacity);
+
+        if (!m_data) {
+            warnKrita << "KisFixedPaintDevice: failed to allocate" << size << "bytes";
+            m_dataSize = 0;
+            return false;
+        }
+    }
+
+    m_dataSize = size;
+    return true;
+}
+
 void KisFixedPaintDevice::setRect(const QRect& rc)
 {
     m_bounds = rc;
@@ -63,7 +92,7 @@ QRect KisFixedPaintDevice::bounds() const
 
 int KisFixedPaintDevice::allocatedPixels() const
 {
-    return m_data.size() / m_colorSpace->pixelSize();
+    return m_dataSize / m_colorSpace->pixelSize();
 }
 
 
@@ -74,19 +103,22 @@ quint32 KisFixedPaintDevice::pixelSize() const
 
 bool KisFixedPaintDevice::initialize(quint8 defaultValue)
 {
-    m_data.fill(defaultValue, m_bounds.height() * m_bounds.width() * pixelSize());
+    if (!resizeData(m_bounds.height() * m_bounds.width() * pixelSize())) {
+        return false;
+    }
 
+    memset(m_data, defaultValue, m_dataSize);
     return true;
 }
 
 quint8* KisFixedPaintDevice::data()
 {
-    return m_data.data();
+    return m_data;
 }
 
 quint8* KisFixedPaintDevice::data() const
 {
-    return const_cast<quint8*>(m_data.data());
+    return m_data;
 }
 
 void KisFixedPaintDevice::convertTo(const KoColorSpace* dstColorSpace,
@@ -97,16 +129,25 @@ void KisFixedPaintDevice::convertTo(const KoColorSpace* dstColorSpace,
         return;
     }
     quint32 size = m_bounds.width() * m_bounds.height();
-    QVector<quint8> dstData(size * dstColorSpace->pixelSize());
+    int dstCapacity = 0;
+    quint8 *dstData = KisAlignedBufferPool::allocate(size * dstColorSpace->pixelSize(), &dstCapacity);
+    if (!dstData) {
+        warnKrita << "KisFixedPaintDevice: failed to allocate the converted data";
+        return;
+    }
 
-    m_colorSpace->convertPixelsTo(data(), dstData.data(),
+    m_colorSpace->convertPixelsTo(data(), dstData,
                                   dstColorSpace,
                                   size,
                                   renderingIntent,
                                   conversionFlags);
 
+    KisAlignedBufferPool::release(m_data, m_capacity);
+
     m_colorSpace = dstColorSpace;
     m_data = dstData;
+    m_dataSize = size * dstColorSpace->pixelSize();
+    m_capacity = dstCapacity;
 
 }
 
@@ -202,7 +243,7 @@ void KisFixedPaintDevice::fill(const QRect &rc, const KoColor &color)
 
 void KisFixedPaintDevice::fill(qint32 x, qint32 y, qint32 w, qint32 h, const quint8 *fillPixel)
 {
-    if (m_data.isEmpty() || m_bounds.isEmpty()) {
+    if (!m_dataSize || m_bounds.isEmpty()) {
         setRect(QRect(x, y, w, h));
         initialize();
     }
@@ -236,7 +277,7 @@ void KisFixedPaintDevice::fill(qint32 x, qint32 y, qint32 w, qint32 h, const qui
 
 void KisFixedPaintDevice::readBytes(quint8* dstData, qint32 x, qint32 y, qint32 w, qint32 h) const
 {
-    if (m_data.isEmpty() || m_bounds.isEmpty()) {
+    if (!m_dataSize || m_bounds.isEmpty()) {
         return;
     }
 
@@ -277,7 +318,8 @@ void KisFixedPaintDevice::mirror(bool horizontal, bool vertical)
         int rowSize = pixelSize * w;
 
         quint8 * dabPointer = data();
-        quint8 * row = new quint8[ rowSize ];
+        KisAlignedBufferPool::Buffer rowBuffer(rowSize);
+        quint8 * row = rowBuffer.data();
         quint8 * mirror = 0;
 
         for (int y = 0; y < h ; y++){
@@ -290,8 +332,6 @@ void KisFixedPaintDevice::mirror(bool horizontal, bool vertical)
                 mirror -= pixelSize;
             }
         }
-
-        delete [] row;
     }
 
     if (vertical){
@@ -300,7 +340,8 @@ void KisFixedPaintDevice::mirror(bool horizontal, bool vertical)
 
         quint8 * startRow = data();
         quint8 * endRow = data() + (h-1) * w * pixelSize;
-        quint8 * row = new quint8[ rowSize ];
+        KisAlignedBufferPool::Buffer rowBuffer(rowSize);
+        quint8 * row = rowBuffer.data();
 
         for (int y = 0; y < rowsToMove; y++){
             memcpy(row, startRow, rowSize);
@@ -310,8 +351,6 @@ void KisFixedPaintDevice::mirror(bool horizontal, bool vertical)
             startRow += rowSize;
             endRow -= rowSize;
         }
-
-        delete [] row;
     }
 
 }
@@ -35,6 +35,11 @@ class KoColor;
  * of bytes and a rectangle. It cannot grow, it cannot shrink, all you can
  * do is fill the paint device with the right bytes and use it as an argument
  * to KisPainter or use the bytes as an argument to KoColorSpace functions.
+ *
+ * The data is taken from KisAlignedBufferPool and is aligned for the
+ * vector instructions. The buffer is reused when the device is
+ * initialized with a smaller or equal size, so a device reused for all
+ * the dabs of a stroke stops allocating after the first few of them.
  */
 class KRITAIMAGE_EXPORT KisFixedPaintDevice : public KisShared
 {
@@ -176,11 +181,20 @@ public:
      */
     void mirror(bool horizontal, bool vertical);
 
+private:
+    /**
+     * Makes the data \p size bytes long. The contents are undefined
+     * afterwards.
+     */
+    bool resizeData(int size);
+
 private:
 
     const KoColorSpace* m_colorSpace;
     QRect m_bounds;
-    QVector<quint8> m_data;
+    quint8 *m_data;
+    int m_dataSize;
+    int m_capacity;
 
 };
 
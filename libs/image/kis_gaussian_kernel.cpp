@@ -22,6 +22,18 @@
 #include "kis_convolution_kernel.h"
 #include <kis_convolution_painter.h>
 #include <QRect>
+#include <QtConcurrent>
+
+#include <KoChannelInfo.h>
+#include <KoColorSpace.h>
+#include <KoUpdater.h>
+
+#include "kis_paint_device.h"
+#include "kis_iterator_ng.h"
+#include "kis_repeat_iterators_pixel.h"
+#include "kis_math_toolbox.h"
+#include "tiles3/kis_tile_data.h"
+
 
 
 qreal KisGaussianKernel::sigmaFromRadius(qreal radius)
@@ -99,12 +111,395 @@ KisGaussianKernel::createVerticalKernel(qreal radius)
     return KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum());
 }
 
+namespace {
+
+/**
+ * The recursive filter is used for sigmas starting from this value
+ * only. Smaller kernels are cheap to convolve exactly anyway.
+ */
+const qreal minRecursiveSigma = 5.0;
+
+/**
+ * Coefficients of the fourth-order recursive Gaussian filter by
+ * Deriche, "Recursively implementing the Gaussian and its
+ * derivatives" (1993). The result is a sum of a causal and an
+ * anticausal pass, which approximates the Gaussian within 0.3% of its
+ * peak value for any sigma.
+ */
+struct RecursiveGaussianCoeffs {
+    RecursiveGaussianCoeffs(qreal sigma)
+    {
+        const qreal a1 = 1.3530;
+        const qreal b1 = 1.8151;
+        const qreal w1 = 0.6681;
+        const qreal l1 = -1.3932;
+
+        const qreal a2 = -0.3531;
+        const qreal b2 = 0.0902;
+        const qreal w2 = 2.0787;
+        const qreal l2 = -1.3732;
+
+        const qreal sin1 = std::sin(w1 / sigma);
+        const qreal sin2 = std::sin(w2 / sigma);
+        const qreal cos1 = std::cos(w1 / sigma);
+        const qreal cos2 = std::cos(w2 / sigma);
+        const qreal exp1 = std::exp(l1 / sigma);
+        const qreal exp2 = std::exp(l2 / sigma);
+
+        n[0] = a1 + a2;
+        n[1] = exp2 * (b2 * sin2 - (a2 + 2 * a1) * cos2) +
+               exp1 * (b1 * sin1 - (a1 + 2 * a2) * cos1);
+        n[2] = 2 * exp1 * exp2 * ((a1 + a2) * cos2 * cos1 - b1 * cos2 * sin1 - b2 * cos1 * sin2) +
+               a2 * pow2(exp1) + a1 * pow2(exp2);
+        n[3] = exp2 * pow2(exp1) * (b2 * sin2 - a2 * cos2) +
+               exp1 * pow2(exp2) * (b1 * sin1 - a1 * cos1);
+
+        d[0] = -2 * (exp2 * cos2 + exp1 * cos1);
+        d[1] = 4 * cos2 * cos1 * exp1 * exp2 + pow2(exp1) + pow2(exp2);
+        d[2] = -2 * cos1 * exp1 * pow2(exp2) - 2 * cos2 * exp2 * pow2(exp1);
+        d[3] = pow2(exp1) * pow2(exp2);
+
+        for (int i = 0; i < 3; i++) {
+            m[i] = n[i + 1] - d[i] * n[0];
+        }
+        m[3] = -d[3] * n[0];
+
+        const qreal sumN = n[0] + n[1] + n[2] + n[3];
+        const qreal sumM = m[0] + m[1] + m[2] + m[3];
+        const qreal sumD = 1.0 + d[0] + d[1] + d[2] + d[3];
+
+        // normalize the filter to unit gain
+        const qreal scale = sumD / (sumN + sumM);
+
+        for (int i = 0; i < 4; i++) {
+            n[i] *= scale;
+            m[i] *= scale;
+        }
+
+        causalGain = sumN * scale / sumD;
+        anticausalGain = sumM * scale / sumD;
+    }
+
+    qreal n[4];
+    qreal m[4];
+    qreal d[4];
+
+    qreal causalGain;
+    qreal anticausalGain;
+};
+
+struct RecursiveChannelsInfo {
+    RecursiveChannelsInfo(const KoColorSpace *colorSpace, const QBitArray &channelFlags)
+        : alphaCachePos(-1),
+          alphaRealPos(-1)
+    {
+        QList<KoChannelInfo*> channels = colorSpace->channels();
+
+        for (int i = 0; i < channels.size(); i++) {
+            if (channelFlags.isEmpty() || channelFlags.testBit(i)) {
+                convChannelList.append(channels[i]);
+            }
+        }
+
+        KisMathToolbox mathToolbox;
+
+        for (int i = 0; i < convChannelList.size(); i++) {
+            minClamp.append(mathToolbox.minChannelValue(convChannelList[i]));
+            maxClamp.append(mathToolbox.maxChannelValue(convChannelList[i]));
+
+            if (convChannelList[i]->channelType() == KoChannelInfo::ALPHA) {
+                alphaCachePos = i;
+                alphaRealPos = convChannelList[i]->pos();
+            }
+        }
+
+        toDoubleFuncPtr.resize(convChannelList.size());
+        fromDoubleFuncPtr.resize(convChannelList.size());
+
+        bool result = mathToolbox.getToDoubleChannelPtr(convChannelList, toDoubleFuncPtr);
+        result &= mathToolbox.getFromDoubleChannelPtr(convChannelList, fromDoubleFuncPtr);
+
+        KIS_ASSERT(result);
+    }
+
+    inline int numChannels() const {
+        return convChannelList.size();
+    }
+
+    inline void writeChannel(quint8 *dstPtr, int channel, qreal value) const {
+        value = qBound(minClamp[channel], value, maxClamp[channel]);
+        fromDoubleFuncPtr[channel](dstPtr, convChannelList[channel]->pos(), value);
+    }
+
+    QList<KoChannelInfo*> convChannelList;
+    QVector<qreal> minClamp;
+    QVector<qreal> maxClamp;
+
+    QVector<PtrToDouble> toDoubleFuncPtr;
+    QVector<PtrFromDouble> fromDoubleFuncPtr;
+
+    int alphaCachePos;
+    int alphaRealPos;
+};
+
+/**
+ * Filters a line in place, \p causal is a scratch buffer of the same
+ * length. The values beyond the line are considered to be equal to
+ * the edge ones.
+ */
+void applyRecursiveLine(double *line, double *causal, int length, const RecursiveGaussianCoeffs &c)
+{
+    const qreal *n = c.n;
+    const qreal *m = c.m;
+    const qreal *d = c.d;
+
+    double x1 = line[0];
+    double x2 = x1;
+    double x3 = x1;
+
+    double y1 = x1 * c.causalGain;
+    double y2 = y1;
+    double y3 = y1;
+    double y4 = y1;
+
+    for (int i = 0; i < length; i++) {
+        const double x0 = line[i];
+        const double y0 =
+            n[0] * x0 + n[1] * x1 + n[2] * x2 + n[3] * x3 -
+            d[0] * y1 - d[1] * y2 - d[2] * y3 - d[3] * y4;
+
+        causal[i] = y0;
+
+        x3 = x2; x2 = x1; x1 = x0;
+        y4 = y3; y3 = y2; y2 = y1; y1 = y0;
+    }
+
+    x1 = line[length - 1];
+    x2 = x1;
+    x3 = x1;
+    double x4 = x1;
+
+    y1 = x1 * c.anticausalGain;
+    y2 = y1;
+    y3 = y1;
+    y4 = y1;
+
+    for (int i = length - 1; i >= 0; i--) {
+        const double x0 = line[i];
+        const double y0 =
+            m[0] * x1 + m[1] * x2 + m[2] * x3 + m[3] * x4 -
+            d[0] * y1 - d[1] * y2 - d[2] * y3 - d[3] * y4;
+
+        line[i] = causal[i] + y0;
+
+        x4 = x3; x3 = x2; x2 = x1; x1 = x0;
+        y4 = y3; y3 = y2; y2 = y1; y1 = y0;
+    }
+}
+
+template <class IteratorSP>
+void readLine(IteratorSP it, int length, const RecursiveChannelsInfo &info, double *buffer, int stride)
+{
+    const int numChannels = info.numChannels();
+
+    for (int i = 0; i < length; i++) {
+        const quint8 *data = it->oldRawData();
+
+        // no alpha is a rare case, so just multiply by 1.0 in that case
+        const double alphaValue = info.alphaRealPos >= 0 ?
+            info.toDoubleFuncPtr[info.alphaCachePos](data, info.alphaRealPos) : 1.0;
+
+        for (int k = 0; k < numChannels; k++) {
+            buffer[k * stride + i] =
+                k != info.alphaCachePos ?
+                info.toDoubleFuncPtr[k](data, info.convChannelList[k]->pos()) * alphaValue :
+                alphaValue;
+        }
+
+        it->nextPixel();
+    }
+}
+
+template <class IteratorSP>
+void writeLine(IteratorSP it, int length, const RecursiveChannelsInfo &info, const double *buffer, int stride)
+{
+    const int numChannels = info.numChannels();
+
+    for (int i = 0; i < length; i++) {
+        quint8 *dstPtr = it->rawData();
+
+        if (info.alphaCachePos >= 0) {
+            const qreal alphaValue =
+                qBound(info.minClamp[info.alphaCachePos],
+                       buffer[info.alphaCachePos * stride + i],
+                       info.maxClamp[info.alphaCachePos]);
+
+            info.writeChannel(dstPtr, info.alphaCachePos, alphaValue);
+
+            const qreal alphaValueInv =
+                alphaValue > std::numeric_limits<qreal>::epsilon() ?
+                1.0 / alphaValue : 0.0;
+
+            for (int k = 0; k < numChannels; k++) {
+                if (k != info.alphaCachePos) {
+                    info.writeChannel(dstPtr, k, buffer[k * stride + i] * alphaValueInv);
+                }
+            }
+        } else {
+            for (int k = 0; k < numChannels; k++) {
+                info.writeChannel(dstPtr, k, buffer[k * stride + i]);
+            }
+        }
+
+        it->nextPixel();
+    }
+}
+
+/**
+ * Blurs \p rect of \p src along one axis and writes the result into
+ * \p dst. The lines are processed on the global thread pool in bands
+ * aligned to the tile grid, so the jobs never write into the same tile.
+ */
+void recursivePass(KisPaintDeviceSP src, KisPaintDeviceSP dst,
+                   const QRect &rect, int margin, bool horizontal,
+                   const RecursiveGaussianCoeffs &coeffs,
+                   const RecursiveChannelsInfo &info,
+                   KoUpdater *progressUpdater)
+{
+    const QRect dataRect = rect | src->exactBounds();
+
+    const int lineLength = (horizontal ? rect.width() : rect.height()) + 2 * margin;
+    const int firstLine = horizontal ? rect.top() : rect.left();
+    const int lastLine = horizontal ? rect.bottom() : rect.right();
+    const int tileSize = horizontal ? KisTileData::HEIGHT : KisTileData::WIDTH;
+    const int tileOrigin = horizontal ? dst->y() : dst->x();
+
+    QVector<QFuture<void>> jobs;
+
+    int bandStart = firstLine;
+    while (bandStart <= lastLine) {
+        const int bandEnd =
+            qMin(lastLine, bandStart + tileSize - 1 -
+                 ((bandStart - tileOrigin) % tileSize + tileSize) % tileSize);
+
+        jobs.append(QtConcurrent::run([&, bandStart, bandEnd] () {
+            if (progressUpdater && progressUpdater->interrupted()) return;
+
+            QVector<double> buffer(info.numChannels() * lineLength);
+            QVector<double> causal(lineLength);
+
+            for (int line = bandStart; line <= bandEnd; line++) {
+                if (horizontal) {
+                    KisRepeatHLineConstIteratorSP srcIt =
+                        src->createRepeatHLineConstIterator(rect.left() - margin, line, lineLength, dataRect);
+                    readLine(srcIt, lineLength, info, buffer.data(), lineLength);
+                } else {
+                    KisRepeatVLineConstIteratorSP srcIt =
+                        src->createRepeatVLineConstIterator(line, rect.top() - margin, lineLength, dataRect);
+                    readLine(srcIt, lineLength, info, buffer.data(), lineLength);
+                }
+
+                for (int k = 0; k < info.numChannels(); k++) {
+                    applyRecursiveLine(buffer.data() + k * lineLength, causal.data(), lineLength, coeffs);
+                }
+
+                if (horizontal) {
+                    KisHLineIteratorSP dstIt = dst->createHLineIteratorNG(rect.left(), line, rect.width());
+                    writeLine(dstIt, rect.width(), info, buffer.data() + margin, lineLength);
+                } else {
+                    KisVLineIteratorSP dstIt = dst->createVLineIteratorNG(line, rect.top(), rect.height());
+                    writeLine(dstIt, rect.height(), info, buffer.data() + margin, lineLength);
+                }
+            }
+        }));
+
+        bandStart = bandEnd + 1;
+    }
+
+    Q_FOREACH (QFuture<void> job, jobs) {
+        job.waitForFinished();
+    }
+}
+
+void applyRecursiveGaussian(KisPaintDeviceSP device,
+                            const QRect& rect,
+                            qreal xRadius, qreal yRadius,
+                            const QBitArray &channelFlags,
+                            KoUpdater *progressUpdater)
+{
+    const RecursiveChannelsInfo info(device->colorSpace(), channelFlags);
+
+    /**
+     * The margins are the same as the ones of the exact kernels,
+     * so the filters don't need to change their need rects
+     */
+    const int xMargin = xRadius > 0.0 ? KisGaussianKernel::kernelSizeFromRadius(xRadius) / 2 : 0;
+    const int yMargin = yRadius > 0.0 ? KisGaussianKernel::kernelSizeFromRadius(yRadius) / 2 : 0;
+
+    if (progressUpdater) {
+        progressUpdater->setProgress(0);
+    }
+
+    if (xRadius > 0.0 && yRadius > 0.0) {
+        KisPaintDeviceSP interm = new KisPaintDevice(device->colorSpace());
+
+        recursivePass(device, interm, rect.adjusted(0, -yMargin, 0, yMargin), xMargin, true,
+                      RecursiveGaussianCoeffs(KisGaussianKernel::sigmaFromRadius(xRadius)),
+                      info, progressUpdater);
+
+        if (progressUpdater) {
+            if (progressUpdater->interrupted()) return;
+            progressUpdater->setProgress(50);
+        }
+
+        recursivePass(interm, device, rect, yMargin, false,
+                      RecursiveGaussianCoeffs(KisGaussianKernel::sigmaFromRadius(yRadius)),
+                      info, progressUpdater);
+
+    } else if (xRadius > 0.0) {
+        recursivePass(device, device, rect, xMargin, true,
+                      RecursiveGaussianCoeffs(KisGaussianKernel::sigmaFromRadius(xRadius)),
+                      info, progressUpdater);
+
+    } else if (yRadius > 0.0) {
+        recursivePass(device, device, rect, yMargin, false,
+                      RecursiveGaussianCoeffs(KisGaussianKernel::sigmaFromRadius(yRadius)),
+                      info, progressUpdater);
+    }
+
+    if (progressUpdater) {
+        progressUpdater->setProgress(100);
+    }
+}
+
+}
+
+bool KisGaussianKernel::canUseRecursiveGaussian(qreal radius)
+{
+    return sigmaFromRadius(radius) >= minRecursiveSigma;
+}
+
 void KisGaussianKernel::applyGaussian(KisPaintDeviceSP device,
                                       const QRect& rect,
                                       qreal xRadius, qreal yRadius,
                                       const QBitArray &channelFlags,
-                                      KoUpdater *progressUpdater)
+                                      KoUpdater *progressUpdater,
+                                      bool allowRecursive)
 {
+    /**
+     * The wraparound mode needs special iterators, so leave it
+     * for the convolution painter
+     */
+    if (allowRecursive &&
+        (xRadius > 0.0 || yRadius > 0.0) &&
+        (xRadius <= 0.0 || canUseRecursiveGaussian(xRadius)) &&
+        (yRadius <= 0.0 || canUseRecursiveGaussian(yRadius)) &&
+        !device->defaultBounds()->wrapAroundMode()) {
+
+        applyRecursiveGaussian(device, rect, xRadius, yRadius, channelFlags, progressUpdater);
+        return;
+    }
+
     QPoint srcTopLeft = rect.topLeft();
 
     if (xRadius > 0.0 && yRadius > 0.0) {
@@ -44,11 +44,24 @@ public:
     static qreal sigmaFromRadius(qreal radius);
     static int kernelSizeFromRadius(qreal radius);
 
+    /**
+     * Blurs \p rect of the \p device with a Gaussian kernel.
+     *
+     * When \p allowRecursive is true and the radii are big enough
+     * (see canUseRecursiveGaussian()), the blur is done with a
+     * recursive (IIR) approximation of the Gaussian, whose cost
+     * doesn't depend on the radius. The result differs from the exact
+     * convolution by a couple of levels at most, so the callers that
+     * need exact results should leave it off.
+     */
     static void applyGaussian(KisPaintDeviceSP device,
                               const QRect& rect,
                               qreal xRadius, qreal yRadius,
                               const QBitArray &channelFlags,
-                              KoUpdater *updater);
+                              KoUpdater *updater,
+                              bool allowRecursive = false);
+
+    static bool canUseRecursiveGaussian(qreal radius);
 
     static Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> createLoGMatrix(qreal radius);
 
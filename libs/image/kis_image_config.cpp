@@ -163,6 +163,17 @@ void KisImageConfig::setSwapWindowSize(int value)
     m_config.writeEntry("swapWindowSize", value);
 }
 
+int KisImageConfig::savingCacheSize(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("savingCacheSize", 256) : 256; // in MiB
+}
+
+void KisImageConfig::setSavingCacheSize(int value)
+{
+    m_config.writeEntry("savingCacheSize", value);
+}
+
 int KisImageConfig::tilesHardLimit() const
 {
     qreal hp = qreal(memoryHardLimitPercent()) / 100.0;
@@ -186,6 +197,13 @@ int KisImageConfig::poolLimit() const
     return totalRAM() * hp * pp;
 }
 
+int KisImageConfig::filterResultCacheLimit() const
+{
+    qreal cp = qreal(filterResultCachePercent()) / 100.0;
+
+    return tilesHardLimit() * cp;
+}
+
 qreal KisImageConfig::memoryHardLimitPercent(bool requestDefault) const
 {
     return !requestDefault ?
@@ -219,6 +237,17 @@ void KisImageConfig::setMemoryPoolLimitPercent(qreal value)
     m_config.writeEntry("memoryPoolLimitPercent", value);
 }
 
+qreal KisImageConfig::filterResultCachePercent(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("filterResultCachePercent", 5.) : 5.;
+}
+
+void KisImageConfig::setFilterResultCachePercent(qreal value)
+{
+    m_config.writeEntry("filterResultCachePercent", value);
+}
+
 QString KisImageConfig::swapDir(bool requestDefault)
 {
     QString swap = QDir::tempPath();
@@ -311,6 +340,17 @@ void KisImageConfig::setLazyFrameCreationEnabled(bool value)
     m_config.writeEntry("lazyFrameCreationEnabled", value);
 }
 
+bool KisImageConfig::deltaFrameStorageEnabled(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("deltaFrameStorageEnabled", false) : false;
+}
+
+void KisImageConfig::setDeltaFrameStorageEnabled(bool value)
+{
+    m_config.writeEntry("deltaFrameStorageEnabled", value);
+}
+
 
 #if defined Q_OS_LINUX
 #include <sys/sysinfo.h>
@@ -58,16 +58,22 @@ public:
     int swapWindowSize() const;
     void setSwapWindowSize(int value);
 
+    int savingCacheSize(bool requestDefault = false) const; // MiB
+    void setSavingCacheSize(int value);
+
     int tilesHardLimit() const; // MiB
     int tilesSoftLimit() const; // MiB
     int poolLimit() const; // MiB
+    int filterResultCacheLimit() const; // MiB
 
     qreal memoryHardLimitPercent(bool requestDefault = false) const; // % of total RAM
     qreal memorySoftLimitPercent(bool requestDefault = false) const; // % of memoryHardLimitPercent() * (1 - 0.01 * memoryPoolLimitPercent())
     qreal memoryPoolLimitPercent(bool requestDefault = false) const; // % of memoryHardLimitPercent()
+    qreal filterResultCachePercent(bool requestDefault = false) const; // % of tilesHardLimit()
     void setMemoryHardLimitPercent(qreal value);
     void setMemorySoftLimitPercent(qreal value);
     void setMemoryPoolLimitPercent(qreal value);
+    void setFilterResultCachePercent(qreal value);
 
     static int totalRAM(); // MiB
 
@@ -99,6 +105,9 @@ public:
     bool lazyFrameCreationEnabled(bool requestDefault = false) const;
     void setLazyFrameCreationEnabled(bool value);
 
+    bool deltaFrameStorageEnabled(bool requestDefault = false) const;
+    void setDeltaFrameStorageEnabled(bool value);
+
     bool showAdditionalOnionSkinsSettings(bool requestDefault = false) const;
     void setShowAdditionalOnionSkinsSettings(bool value);
 
@@ -24,6 +24,7 @@
 #include "filter/kis_filter_registry.h"
 #include "filter/kis_filter_configuration.h"
 #include "generator/kis_generator_registry.h"
+#include "kis_filter_result_cache.h"
 
 #ifdef SANITY_CHECK_FILTER_CONFIGURATION_OWNER
 
@@ -54,13 +55,15 @@
 
 KisNodeFilterInterface::KisNodeFilterInterface(KisFilterConfigurationSP filterConfig, bool useGeneratorRegistry)
     : m_filter(filterConfig),
-      m_useGeneratorRegistry(useGeneratorRegistry)
+      m_useGeneratorRegistry(useGeneratorRegistry),
+      m_filterResultCache(new KisFilterResultCache())
 {
     SANITY_ACQUIRE_FILTER(m_filter);
 }
 
 KisNodeFilterInterface::KisNodeFilterInterface(const KisNodeFilterInterface &rhs)
-    : m_useGeneratorRegistry(rhs.m_useGeneratorRegistry)
+    : m_useGeneratorRegistry(rhs.m_useGeneratorRegistry),
+      m_filterResultCache(new KisFilterResultCache())
 {
     if (m_useGeneratorRegistry) {
         m_filter = KisGeneratorRegistry::instance()->cloneConfiguration(const_cast<KisFilterConfiguration*>(rhs.m_filter.data()));
@@ -87,6 +90,12 @@ void KisNodeFilterInterface::setFilter(KisFilterConfigurationSP filterConfig)
 
     Q_ASSERT(filterConfig);
     m_filter = filterConfig;
+    m_filterResultCache->clear();
 
     SANITY_ACQUIRE_FILTER(m_filter);
 }
+
+KisFilterResultCache* KisNodeFilterInterface::filterResultCache() const
+{
+    return m_filterResultCache.data();
+}
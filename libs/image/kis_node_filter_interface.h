@@ -19,9 +19,13 @@
 #ifndef _KIS_NODE_FILTER_INTERFACE_H_
 #define _KIS_NODE_FILTER_INTERFACE_H_
 
+#include <QScopedPointer>
+
 #include <kritaimage_export.h>
 #include <kis_types.h>
 
+class KisFilterResultCache;
+
 /**
  * Define an interface for nodes that are associated with a filter.
  */
@@ -48,12 +52,21 @@ public:
      */
     virtual void setFilter(KisFilterConfigurationSP filterConfig);
 
+    /**
+     * The results of the filter cached by the input they were
+     * calculated from. Nodes applying the filter to their projection
+     * should process through it. The cache is dropped when the
+     * filter is changed and is not copied with the node.
+     */
+    KisFilterResultCache* filterResultCache() const;
+
 // the child classes should access the filter with the filter() method
 private:
     KisNodeFilterInterface& operator=(const KisNodeFilterInterface &other);
 
     KisFilterConfigurationSP m_filter;
     bool m_useGeneratorRegistry;
+    QScopedPointer<KisFilterResultCache> m_filterResultCache;
 };
 
 #endif
@@ -35,6 +35,14 @@ struct KisOnionSkinCache::Private
 {
     KisPaintDeviceSP cachedProjection;
 
+    /**
+     * Tinted copies of the frames used by the cached projection. The
+     * frame active at the cache time is never stored here, so its
+     * copy is always regenerated after painting on it and switching
+     * to another frame.
+     */
+    KisOnionSkinCompositor::TintedFramesCache tintedFrames;
+
     int cacheTime = 0;
     int cacheConfigSeqNo = 0;
     int framesHash = 0;
@@ -96,7 +104,7 @@ KisPaintDeviceSP KisOnionSkinCache::projection(KisPaintDeviceSP source)
             }
 
             const QRect extent = compositor->calculateExtent(source);
-            compositor->composite(source, cachedProjection, extent);
+            compositor->composite(source, cachedProjection, extent, &m_d->tintedFrames);
 
             cachedProjection->setDefaultBounds(source->defaultBounds());
 
@@ -124,6 +132,7 @@ void KisOnionSkinCache::reset()
 {
     QWriteLocker writeLocker(&m_d->lock);
     m_d->cachedProjection = 0;
+    m_d->tintedFrames.clear();
 }
 
 KisPaintDeviceSP KisOnionSkinCache::lodCapableDevice() const
@@ -85,6 +85,38 @@ struct KisOnionSkinCompositor::Private
         gcDest.bitBlt(rect.topLeft(), gcFrame.device(), rect);
     }
 
+    KisPaintDeviceSP fetchTintedFrame(KisRasterKeyframeChannel *keyframes, KisKeyframeSP keyframe, bool backwards, KisPaintDeviceSP tintSource, const TintedFramesCache &cache, TintedFramesCache *usedFrames)
+    {
+        const QPair<int, bool> key(keyframes->frameId(keyframe), backwards);
+        const int contentSeqNo = keyframes->frameSequenceNumber(keyframe);
+        const KoColorSpace *colorSpace = tintSource->colorSpace();
+
+        TintedFrame frame = cache.value(key);
+
+        if (!frame.device ||
+            frame.contentSeqNo != contentSeqNo ||
+            frame.configSeqNo != configSeqNo ||
+            !(*frame.device->colorSpace() == *colorSpace)) {
+
+            frame.device = new KisPaintDevice(colorSpace);
+            keyframes->fetchFrame(keyframe, frame.device);
+
+            const QRect frameRect = keyframes->frameExtents(keyframe);
+
+            KisPainter gcFrame(frame.device);
+            gcFrame.setChannelFlags(colorSpace->channelFlags(true, false));
+            gcFrame.setOpacity(tintFactor);
+            gcFrame.bitBlt(frameRect.topLeft(), tintSource, frameRect);
+            gcFrame.end();
+
+            frame.contentSeqNo = contentSeqNo;
+            frame.configSeqNo = configSeqNo;
+        }
+
+        usedFrames->insert(key, frame);
+        return frame.device;
+    }
+
     void refreshConfig()
     {
         KisImageConfig config;
@@ -173,6 +205,56 @@ void KisOnionSkinCompositor::composite(const KisPaintDeviceSP sourceDevice, KisP
 
 }
 
+void KisOnionSkinCompositor::composite(const KisPaintDeviceSP sourceDevice, KisPaintDeviceSP targetDevice, const QRect &rect, TintedFramesCache *cache)
+{
+    KisRasterKeyframeChannel *keyframes = sourceDevice->keyframeChannel();
+
+    KisPaintDeviceSP backwardTintDevice = m_d->setUpTintDevice(m_d->backwardTintColor, sourceDevice->colorSpace());
+    KisPaintDeviceSP forwardTintDevice = m_d->setUpTintDevice(m_d->forwardTintColor, sourceDevice->colorSpace());
+
+    TintedFramesCache usedFrames;
+    QVector<QPair<KisPaintDeviceSP, int>> skins;
+
+    KisKeyframeSP keyframeBck;
+    KisKeyframeSP keyframeFwd;
+
+    int time = sourceDevice->defaultBounds()->currentTime();
+    keyframeBck = keyframeFwd = keyframes->activeKeyframeAt(time);
+
+    for (int offset = 1; offset <= m_d->numberOfSkins; offset++) {
+        keyframeBck = m_d->getNextFrameToComposite(keyframes, keyframeBck, true);
+        keyframeFwd = m_d->getNextFrameToComposite(keyframes, keyframeFwd, false);
+
+        const int opacityBck = m_d->skinOpacity(-offset);
+        const int opacityFwd = m_d->skinOpacity(offset);
+
+        if (!keyframeBck.isNull() && opacityBck != OPACITY_TRANSPARENT_U8) {
+            KisPaintDeviceSP frame = m_d->fetchTintedFrame(keyframes, keyframeBck, true, backwardTintDevice, *cache, &usedFrames);
+            skins.append(qMakePair(frame, opacityBck));
+        }
+
+        if (!keyframeFwd.isNull() && opacityFwd != OPACITY_TRANSPARENT_U8) {
+            KisPaintDeviceSP frame = m_d->fetchTintedFrame(keyframes, keyframeFwd, false, forwardTintDevice, *cache, &usedFrames);
+            skins.append(qMakePair(frame, opacityFwd));
+        }
+    }
+
+    /**
+     * The target device is empty, so instead of putting every skin
+     * behind the previous ones, we can paint them from the farthest
+     * to the nearest one with the (optimized) Over op.
+     */
+    KisPainter gcDest(targetDevice);
+    gcDest.setCompositeOp(sourceDevice->colorSpace()->compositeOp(COMPOSITE_OVER));
+
+    for (int i = skins.size() - 1; i >= 0; i--) {
+        gcDest.setOpacity(skins[i].second);
+        gcDest.bitBlt(rect.topLeft(), skins[i].first, rect);
+    }
+
+    *cache = usedFrames;
+}
+
 QRect KisOnionSkinCompositor::calculateFullExtent(const KisPaintDeviceSP device)
 {
     QRect rect;
@@ -19,6 +19,9 @@
 #ifndef KIS_ONION_SKIN_COMPOSITOR_H
 #define KIS_ONION_SKIN_COMPOSITOR_H
 
+#include <QHash>
+#include <QPair>
+
 #include "kis_types.h"
 #include "kritaimage_export.h"
 
@@ -26,6 +29,25 @@ class KRITAIMAGE_EXPORT KisOnionSkinCompositor : public QObject
 {
     Q_OBJECT
 
+public:
+    /**
+     * A tinted copy of a single keyframe. It depends neither on the
+     * current time nor on the opacity of the skin, so it can be reused
+     * while scrubbing the timeline.
+     */
+    struct TintedFrame
+    {
+        KisPaintDeviceSP device;
+        int contentSeqNo = -1;
+        int configSeqNo = -1;
+    };
+
+    /**
+     * Tinted frames of a single raster channel, indexed by the frame
+     * id and the tint direction (true for backward skins)
+     */
+    typedef QHash<QPair<int, bool>, TintedFrame> TintedFramesCache;
+
 public:
     KisOnionSkinCompositor();
     ~KisOnionSkinCompositor();
@@ -33,6 +55,15 @@ public:
 
     void composite(const KisPaintDeviceSP sourceDevice, KisPaintDeviceSP targetDevice, const QRect &rect);
 
+    /**
+     * Composites the onion skins of \p sourceDevice into an empty
+     * \p targetDevice. The tinted frames are taken from \p cache,
+     * only the frames whose content or the onion skin configuration
+     * has changed are tinted again. After the call \p cache contains
+     * only the frames used for the current time.
+     */
+    void composite(const KisPaintDeviceSP sourceDevice, KisPaintDeviceSP targetDevice, const QRect &rect, TintedFramesCache *cache);
+
     QRect calculateFullExtent(const KisPaintDeviceSP device);
     QRect calculateExtent(const KisPaintDeviceSP device);
 
@@ -216,6 +216,12 @@ public:
         return data->cache()->invalidate();
     }
 
+    int frameSequenceNumber(int frameId) const
+    {
+        DataSP data = m_frames[frameId];
+        return data->cache()->sequenceNumber();
+    }
+
 private:
     typedef KisPaintDeviceData Data;
     typedef QSharedPointer<Data> DataSP;
@@ -375,6 +381,23 @@ public:
         return data->dataManager()->write(store);
     }
 
+    bool readFrameDelta(QIODevice *stream, int frameId, int baseFrameId)
+    {
+        bool retval = false;
+        DataSP data = m_frames[frameId];
+        DataSP baseData = m_frames[baseFrameId];
+        retval = data->dataManager()->readDelta(stream, baseData->dataManager().data());
+        data->cache()->invalidate();
+        return retval;
+    }
+
+    bool writeFrameDelta(KisPaintDeviceWriter &store, int frameId, int baseFrameId)
+    {
+        DataSP data = m_frames[frameId];
+        DataSP baseData = m_frames[baseFrameId];
+        return data->dataManager()->writeDelta(store, baseData->dataManager().data());
+    }
+
     void setFrameDefaultPixel(const KoColor &defPixel, int frameId)
     {
         DataSP data = m_frames[frameId];
@@ -1049,6 +1072,24 @@ int KisPaintDevice::sequenceNumber() const
     return m_d->cache()->sequenceNumber();
 }
 
+QVector<quint64> KisPaintDevice::tileVersions(const QRect &rect) const
+{
+    QRect rc = rect;
+
+    /**
+     * In wrap-around mode the pixels outside the bounds are read
+     * from the tiles inside them
+     */
+    if (m_d->defaultBounds->wrapAroundMode()) {
+        const QRect bounds = m_d->defaultBounds->bounds();
+        if (!bounds.contains(rc)) {
+            rc = bounds;
+        }
+    }
+
+    return m_d->dataManager()->tileVersions(rc.translated(-m_d->x(), -m_d->y()));
+}
+
 void KisPaintDevice::setParentNode(KisNodeWSP parent)
 {
     m_d->parent = parent;
@@ -2053,6 +2094,22 @@ bool KisPaintDeviceFramesInterface::readFrame(QIODevice *stream, int frameId)
     return q->m_d->readFrame(stream, frameId);
 }
 
+bool KisPaintDeviceFramesInterface::writeFrameDelta(KisPaintDeviceWriter &store, int frameId, int baseFrameId)
+{
+    KIS_ASSERT_RECOVER(frameId >= 0 && baseFrameId >= 0 && frameId != baseFrameId) {
+        return false;
+    }
+    return q->m_d->writeFrameDelta(store, frameId, baseFrameId);
+}
+
+bool KisPaintDeviceFramesInterface::readFrameDelta(QIODevice *stream, int frameId, int baseFrameId)
+{
+    KIS_ASSERT_RECOVER(frameId >= 0 && baseFrameId >= 0 && frameId != baseFrameId) {
+        return false;
+    }
+    return q->m_d->readFrameDelta(stream, frameId, baseFrameId);
+}
+
 int KisPaintDeviceFramesInterface::currentFrameId() const
 {
     return q->m_d->currentFrameId();
@@ -2073,6 +2130,12 @@ void KisPaintDeviceFramesInterface::invalidateFrameCache(int frameId)
     return q->m_d->invalidateFrameCache(frameId);
 }
 
+int KisPaintDeviceFramesInterface::frameSequenceNumber(int frameId) const
+{
+    KIS_ASSERT_RECOVER(frameId >= 0) { return -1; }
+    return q->m_d->frameSequenceNumber(frameId);
+}
+
 void KisPaintDeviceFramesInterface::setFrameOffset(int frameId, const QPoint &offset)
 {
     KIS_ASSERT_RECOVER_RETURN(frameId >= 0);
@@ -761,6 +761,15 @@ public:
      */
     int sequenceNumber() const;
 
+    /**
+     * \return the version stamps of the tiles covering \p rect of the
+     *         current LoD plane. Unlike sequenceNumber(), the stamps
+     *         describe the pixels themselves: they are local to the
+     *         rect and come back unchanged when a change is undone.
+     *         Two equal vectors for the same rect mean equal pixels.
+     */
+    QVector<quint64> tileVersions(const QRect &rect) const;
+
 public:
 
     KisHLineIteratorSP createHLineIteratorNG(qint32 x, qint32 y, qint32 w);
@@ -106,6 +106,22 @@ public:
      */
     bool readFrame(QIODevice *stream, int frameId);
 
+    /**
+     * Write only the tiles of \p frameId that differ from the ones
+     * of \p baseFrameId onto \p store
+     */
+    bool writeFrameDelta(KisPaintDeviceWriter &store, int frameId, int baseFrameId);
+
+    /**
+     * Loads content of a \p frameId written with writeFrameDelta().
+     * The unchanged tiles are shared with \p baseFrameId, so the base
+     * frame must be loaded beforehand.
+     *
+     * NOTE: the frame must be created manually with createFrame()
+     *       beforehand!
+     */
+    bool readFrameDelta(QIODevice *stream, int frameId, int baseFrameId);
+
 
     /**
      * Returns frameId of the currently active frame.
@@ -125,6 +141,12 @@ public:
      */
     void invalidateFrameCache(int frameId);
 
+    /**
+     * Returns the sequence number of the cache associated with the
+     * frame. It changes every time the frame cache is invalidated.
+     */
+    int frameSequenceNumber(int frameId) const;
+
     /**
      * Sets the offset for \p frameId.
      * Should be used by Undo framework only!
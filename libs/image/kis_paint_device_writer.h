@@ -25,6 +25,13 @@ public:
     virtual ~KisPaintDeviceWriter() {}
     virtual bool write(const QByteArray &data) = 0;
     virtual bool write(const char* data, qint64 length) = 0;
+
+    /**
+     * The object owning the compressed tiles cached while writing,
+     * see KisCompressedTilesCache. Null means the tiles written to
+     * this writer are not cached.
+     */
+    virtual const void* tilesCacheOwner() const { return 0; }
 };
 
 
@@ -37,6 +37,9 @@
 #include <QRect>
 #include <QString>
 #include <QStringList>
+#include <QScopedPointer>
+#include <QVector>
+#include <QtConcurrent>
 #include <kundo2command.h>
 
 #include <kis_debug.h>
@@ -64,9 +67,13 @@
 #include "kis_paintop_registry.h"
 #include "kis_perspective_math.h"
 #include "tiles3/kis_random_accessor.h"
+#include "tiles3/kis_tile_data.h"
 #include <kis_distance_information.h>
 #include <KoColorSpaceMaths.h>
 #include "kis_lod_transform.h"
+#include "kis_dab_batch.h"
+#include "kis_aligned_buffer_pool.h"
+#include "kis_assert.h"
 
 
 
@@ -122,6 +129,28 @@ struct Q_DECL_HIDDEN KisPainter::Private {
     KoColorConversionTransformation::Intent renderingIntent;
     KoColorConversionTransformation::ConversionFlags conversionFlags;
 
+    /**
+     * The batch is flushed when its arena gets bigger than that
+     */
+    static const int MAX_DAB_BATCH_MEMORY = 4 * 1024 * 1024;
+
+    QScopedPointer<KisDabBatch> dabBatch;
+    int dabBatchDepth = 0;
+
+    void flushDabBatch();
+
+    /**
+     * Dabs bigger than that are composited in tile-aligned bands on the
+     * global thread pool
+     */
+    static const int PARALLEL_BLT_FIXED_AREA = 512 * 512;
+    bool parallelBltFixed = true;
+
+    void bltFixedInBands(qint32 dstX, qint32 dstY,
+                         const KisFixedPaintDeviceSP srcDev,
+                         qint32 srcX, qint32 srcY,
+                         qint32 srcWidth, qint32 srcHeight);
+
     bool tryReduceSourceRect(const KisPaintDevice *srcDev,
                              QRect *srcRect,
                              qint32 *srcX,
@@ -419,6 +448,8 @@ KisTransaction* KisPainter::takeTransaction()
 
 QVector<QRect> KisPainter::takeDirtyRegion()
 {
+    d->flushDabBatch();
+
     QVector<QRect> vrect = d->dirtyRects;
     d->dirtyRects.clear();
     return vrect;
@@ -910,13 +941,38 @@ void KisPainter::bltFixed(qint32 dstX, qint32 dstY,
     Q_ASSERT(srcBounds.contains(srcRect));
     Q_UNUSED(srcRect); // only used in above assertion
 
+    /**
+     * A huge dab is not worth batching: it is painted in parallel
+     * bands of its own
+     */
+    const bool paintInBands =
+        d->parallelBltFixed && srcWidth * srcHeight >= Private::PARALLEL_BLT_FIXED_AREA;
+
+    if (d->dabBatchDepth > 0 && !d->selection && !paintInBands) {
+        d->dabBatch->add(QPoint(dstX, dstY), srcDev, srcRect, d->compositeOp, d->paramInfo);
+
+        if (d->dabBatch->memoryUsage() > Private::MAX_DAB_BATCH_MEMORY) {
+            d->flushDabBatch();
+        }
+        return;
+    }
+
+    // the dabs batched earlier must be painted underneath
+    d->flushDabBatch();
+
+    if (paintInBands) {
+        d->bltFixedInBands(dstX, dstY, srcDev, srcX, srcY, srcWidth, srcHeight);
+        addDirtyRect(QRect(dstX, dstY, srcWidth, srcHeight));
+        return;
+    }
+
     /* Create an intermediate byte array to hold information before it is written
-    to the current paint device (aka: d->device) */
-    quint8* dstBytes = 0;
-    try {
-         dstBytes = new quint8[srcWidth * srcHeight * d->device->pixelSize()];
-    } catch (std::bad_alloc) {
-        warnKrita << "KisPainter::bltFixed std::bad_alloc for " << srcWidth << " * " << srcHeight << " * " << d->device->pixelSize() << "total bytes";
+    to the current paint device (aka: d->device). It comes from the pool, so
+    painting of a stream of dabs does not allocate memory for every dab */
+    KisAlignedBufferPool::Buffer dstBuffer(srcWidth * srcHeight * d->device->pixelSize());
+    quint8* dstBytes = dstBuffer.data();
+    if (!dstBytes) {
+        warnKrita << "KisPainter::bltFixed failed to allocate" << srcWidth << " * " << srcHeight << " * " << d->device->pixelSize() << "total bytes";
         return;
     }
     d->device->readBytes(dstBytes, dstX, dstY, srcWidth, srcHeight);
@@ -933,16 +989,14 @@ void KisPainter::bltFixed(qint32 dstX, qint32 dstY,
     d->paramInfo.rows          = srcHeight;
     d->paramInfo.cols          = srcWidth;
 
+    KisAlignedBufferPool::Buffer selBuffer(d->selection ? srcWidth * srcHeight * d->selection->projection()->pixelSize() : 0);
+
     if (d->selection) {
         /* d->selection is a KisPaintDevice, so first a readBytes is performed to
         get the area of interest... */
         KisPaintDeviceSP selectionProjection(d->selection->projection());
-        quint8* selBytes = 0;
-        try {
-            selBytes = new quint8[srcWidth * srcHeight * selectionProjection->pixelSize()];
-        }
-        catch (std::bad_alloc) {
-            delete[] dstBytes;
+        quint8* selBytes = selBuffer.data();
+        if (!selBytes) {
             return;
         }
 
@@ -955,17 +1009,138 @@ void KisPainter::bltFixed(qint32 dstX, qint32 dstY,
     d->colorSpace->bitBlt(srcDev->colorSpace(), d->paramInfo, d->compositeOp, d->renderingIntent, d->conversionFlags);
     d->device->writeBytes(dstBytes, dstX, dstY, srcWidth, srcHeight);
 
-    delete[] d->paramInfo.maskRowStart;
-    delete[] dstBytes;
+    d->paramInfo.maskRowStart = 0;
 
     addDirtyRect(QRect(dstX, dstY, srcWidth, srcHeight));
 }
 
+void KisPainter::Private::bltFixedInBands(qint32 dstX, qint32 dstY,
+                                          const KisFixedPaintDeviceSP srcDev,
+                                          qint32 srcX, qint32 srcY,
+                                          qint32 srcWidth, qint32 srcHeight)
+{
+    const QRect srcBounds = srcDev->bounds();
+    const int tileHeight = KisTileData::HEIGHT;
+
+    /**
+     * The bands span whole rows of tiles of the destination, so no two
+     * bands ever touch the same tile. Every pixel is composited exactly
+     * as in the serial path, just by another thread.
+     */
+    QVector<QRect> bands;
+
+    for (int y = dstY; y < dstY + srcHeight;) {
+        const int height = qMin(dstY + srcHeight - y,
+                                tileHeight - ((y - device->y()) % tileHeight + tileHeight) % tileHeight);
+
+        bands.append(QRect(dstX, y, srcWidth, height));
+        y += height;
+    }
+
+    KisPaintDeviceSP dst = device;
+    KisPaintDeviceSP selectionProjection = selection ? selection->projection() : 0;
+    const KoColorSpace *dstColorSpace = colorSpace;
+    const KoCompositeOp *op = compositeOp;
+    const KoCompositeOp::ParameterInfo commonParams = paramInfo;
+    const KoColorConversionTransformation::Intent intent = renderingIntent;
+    const KoColorConversionTransformation::ConversionFlags flags = conversionFlags;
+
+    QVector<QFuture<void>> jobs;
+
+    Q_FOREACH (const QRect &band, bands) {
+        jobs.append(QtConcurrent::run([=] () {
+            const int dstPixelSize = dst->pixelSize();
+            const int selPixelSize = selectionProjection ? selectionProjection->pixelSize() : 0;
+            const int rowOffset = band.y() - dstY;
+
+            /**
+             * The composite ops process the unaligned head of every row
+             * with scalar code, which may round differently. The rows of
+             * a band start at the same offset from the alignment as the
+             * same rows of the serial buffer, so that the result is
+             * exactly the same.
+             */
+            const int alignment = KisAlignedBufferPool::ALIGNMENT;
+            const int dstPhase = (rowOffset * band.width() * dstPixelSize) % alignment;
+            const int selPhase = (rowOffset * band.width() * selPixelSize) % alignment;
+
+            KisAlignedBufferPool::Buffer dstBuffer(dstPhase + band.width() * band.height() * dstPixelSize);
+            KisAlignedBufferPool::Buffer selBuffer(selectionProjection ?
+                                                   selPhase + band.width() * band.height() * selPixelSize : 0);
+
+            if (!dstBuffer.data() || (selectionProjection && !selBuffer.data())) {
+                warnKrita << "KisPainter::bltFixed failed to allocate a band of" << band.width() << "x" << band.height() << "pixels";
+                return;
+            }
+
+            quint8 *dstBytes = dstBuffer.data() + dstPhase;
+            dst->readBytes(dstBytes, band);
+
+            KoCompositeOp::ParameterInfo params(commonParams);
+            params.dstRowStart   = dstBytes;
+            params.dstRowStride  = band.width() * dstPixelSize;
+            params.srcRowStart   = srcDev->data() +
+                (srcBounds.width() * (srcY + rowOffset - srcBounds.top()) + (srcX - srcBounds.left())) * srcDev->pixelSize();
+            params.srcRowStride  = srcBounds.width() * srcDev->pixelSize();
+            params.maskRowStart  = 0;
+            params.maskRowStride = 0;
+            params.rows          = band.height();
+            params.cols          = band.width();
+
+            if (selectionProjection) {
+                quint8 *selBytes = selBuffer.data() + selPhase;
+                selectionProjection->readBytes(selBytes, band);
+                params.maskRowStart = selBytes;
+                params.maskRowStride = band.width() * selPixelSize;
+            }
+
+            dstColorSpace->bitBlt(srcDev->colorSpace(), params, op, intent, flags);
+            dst->writeBytes(dstBytes, band);
+        }));
+    }
+
+    Q_FOREACH (QFuture<void> job, jobs) {
+        job.waitForFinished();
+    }
+}
+
 void KisPainter::bltFixed(const QPoint & pos, const KisFixedPaintDeviceSP srcDev, const QRect & srcRect)
 {
     bltFixed(pos.x(), pos.y(), srcDev, srcRect.x(), srcRect.y(), srcRect.width(), srcRect.height());
 }
 
+void KisPainter::setParallelBltFixedEnabled(bool value)
+{
+    d->parallelBltFixed = value;
+}
+
+void KisPainter::beginDabBatch()
+{
+    if (!d->dabBatch) {
+        d->dabBatch.reset(new KisDabBatch());
+    }
+
+    d->dabBatchDepth++;
+}
+
+void KisPainter::endDabBatch()
+{
+    KIS_ASSERT_RECOVER_RETURN(d->dabBatchDepth > 0);
+
+    if (!--d->dabBatchDepth) {
+        d->flushDabBatch();
+    }
+}
+
+void KisPainter::Private::flushDabBatch()
+{
+    if (!dabBatch || dabBatch->isEmpty() || !device) return;
+
+    Q_FOREACH (const QRect &rc, dabBatch->flush(device, renderingIntent, conversionFlags)) {
+        q->addDirtyRect(rc);
+    }
+}
+
 void KisPainter::bltFixedWithFixedSelection(qint32 dstX, qint32 dstY,
                                             const KisFixedPaintDeviceSP srcDev,
                                             const KisFixedPaintDeviceSP selection,
@@ -999,11 +1174,10 @@ void KisPainter::bltFixedWithFixedSelection(qint32 dstX, qint32 dstY,
 
     /* Create an intermediate byte array to hold information before it is written
     to the current paint device (aka: d->device) */
-    quint8* dstBytes = 0;
-    try {
-        dstBytes = new quint8[srcWidth * srcHeight * d->device->pixelSize()];
-    } catch (std::bad_alloc) {
-        warnKrita << "KisPainter::bltFixedWithFixedSelection std::bad_alloc for " << srcWidth << " * " << srcHeight << " * " << d->device->pixelSize() << "total bytes";
+    KisAlignedBufferPool::Buffer dstBuffer(srcWidth * srcHeight * d->device->pixelSize());
+    quint8* dstBytes = dstBuffer.data();
+    if (!dstBytes) {
+        warnKrita << "KisPainter::bltFixedWithFixedSelection failed to allocate" << srcWidth << " * " << srcHeight << " * " << d->device->pixelSize() << "total bytes";
         return;
     }
     d->device->readBytes(dstBytes, dstX, dstY, srcWidth, srcHeight);
@@ -1030,12 +1204,10 @@ void KisPainter::bltFixedWithFixedSelection(qint32 dstX, qint32 dstY,
         /* Read the user selection (d->selection) bytes into an array, ready
         to merge in the next block*/
         quint32 totalBytes = srcWidth * srcHeight * selection->pixelSize();
-        quint8 * mergedSelectionBytes = 0;
-        try {
-            mergedSelectionBytes = new quint8[ totalBytes ];
-        } catch (std::bad_alloc) {
-            warnKrita << "KisPainter::bltFixedWithFixedSelection std::bad_alloc for " << totalBytes << "total bytes";
-            delete[] dstBytes;
+        KisAlignedBufferPool::Buffer mergedSelectionBuffer(totalBytes);
+        quint8 * mergedSelectionBytes = mergedSelectionBuffer.data();
+        if (!mergedSelectionBytes) {
+            warnKrita << "KisPainter::bltFixedWithFixedSelection failed to allocate" << totalBytes << "total bytes";
             return;
         }
         d->selection->projection()->readBytes(mergedSelectionBytes, dstX, dstY, srcWidth, srcHeight);
@@ -1059,14 +1231,10 @@ void KisPainter::bltFixedWithFixedSelection(qint32 dstX, qint32 dstY,
         d->paramInfo.maskRowStart  = mergedSelectionBytes;
         d->paramInfo.maskRowStride = srcWidth * selection->pixelSize();
         d->colorSpace->bitBlt(srcDev->colorSpace(), d->paramInfo, d->compositeOp, d->renderingIntent, d->conversionFlags);
-
-        delete[] mergedSelectionBytes;
     }
 
     d->device->writeBytes(dstBytes, dstX, dstY, srcWidth, srcHeight);
 
-    delete[] dstBytes;
-
     addDirtyRect(QRect(dstX, dstY, srcWidth, srcHeight));
 }
 
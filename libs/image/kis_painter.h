@@ -305,6 +305,32 @@ public:
      */
     void bltFixed(const QPoint & pos, const KisFixedPaintDeviceSP srcDev, const QRect & srcRect);
 
+    /**
+     * Big dabs passed to bltFixed() are composited in parallel bands,
+     * unless it is disabled here. The result is exactly the same, so
+     * it is only useful for getting a reference in tests.
+     */
+    void setParallelBltFixedEnabled(bool value);
+
+    /**
+     * Starts collecting the dabs passed to bltFixed() instead of
+     * painting them immediately. The collected dabs are composited
+     * tile by tile by endDabBatch(), which is much faster for the
+     * strokes consisting of many small overlapping dabs.
+     *
+     * Until the batch is ended, the device must not be read and the
+     * only painting method allowed is bltFixed(). The calls may be
+     * nested. Nothing is batched while the painter has a selection.
+     *
+     * \see KisDabBatch
+     */
+    void beginDabBatch();
+
+    /**
+     * Composites the dabs collected since beginDabBatch()
+     */
+    void endDabBatch();
+
     /**
      * Blasts a @param selection of srcWidth @param srcWidth and srcHeight @param srcHeight
      * of @param srcDev on the current paint device. There is parameters to control
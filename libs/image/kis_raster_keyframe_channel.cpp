@@ -54,13 +54,16 @@ struct KisRasterKeyframeChannel::Private
   Private(KisPaintDeviceWSP paintDevice, const QString filenameSuffix)
       : paintDevice(paintDevice),
         filenameSuffix(filenameSuffix),
-        onionSkinsEnabled(false)
+        onionSkinsEnabled(false),
+        deltaFrames(false)
   {}
 
   KisPaintDeviceWSP paintDevice;
   QMap<int, QString> frameFilenames;
+  QMap<int, int> frameBaseIds;
   QString filenameSuffix;
   bool onionSkinsEnabled;
+  bool deltaFrames;
 };
 
 KisRasterKeyframeChannel::KisRasterKeyframeChannel(const KoID &id, const KisPaintDeviceWSP paintDevice, KisDefaultBoundsBaseSP defaultBounds)
@@ -116,11 +119,21 @@ QRect KisRasterKeyframeChannel::frameExtents(KisKeyframeSP keyframe)
     return m_d->paintDevice->framesInterface()->frameBounds(frameId(keyframe));
 }
 
+int KisRasterKeyframeChannel::frameSequenceNumber(KisKeyframeSP keyframe) const
+{
+    return m_d->paintDevice->framesInterface()->frameSequenceNumber(frameId(keyframe));
+}
+
 QString KisRasterKeyframeChannel::frameFilename(int frameId) const
 {
     return m_d->frameFilenames.value(frameId, QString());
 }
 
+int KisRasterKeyframeChannel::frameBaseId(int frameId) const
+{
+    return m_d->frameBaseIds.value(frameId, -1);
+}
+
 void KisRasterKeyframeChannel::setFilenameSuffix(const QString &suffix)
 {
     m_d->filenameSuffix = suffix;
@@ -211,15 +224,26 @@ QRect KisRasterKeyframeChannel::affectedRect(KisKeyframeSP key)
 }
 
 QDomElement KisRasterKeyframeChannel::toXML(QDomDocument doc, const QString &layerFilename)
+{
+    return toXML(doc, layerFilename, false);
+}
+
+QDomElement KisRasterKeyframeChannel::toXML(QDomDocument doc, const QString &layerFilename, bool deltaFrames)
 {
     m_d->frameFilenames.clear();
+    m_d->frameBaseIds.clear();
+    m_d->deltaFrames = deltaFrames;
+
+    QDomElement element = KisKeyframeChannel::toXML(doc, layerFilename);
 
-    return KisKeyframeChannel::toXML(doc, layerFilename);
+    m_d->deltaFrames = false;
+    return element;
 }
 
 void KisRasterKeyframeChannel::loadXML(const QDomElement &channelNode)
 {
     m_d->frameFilenames.clear();
+    m_d->frameBaseIds.clear();
 
     KisKeyframeChannel::loadXML(channelNode);
 }
@@ -234,6 +258,22 @@ void KisRasterKeyframeChannel::saveKeyframe(KisKeyframeSP keyframe, QDomElement
     }
     keyframeElement.setAttribute("frame", filename);
 
+    /**
+     * In delta mode the frame is stored relative to the previous
+     * keyframe, which has already got its filename assigned, because
+     * the keyframes are saved in time order.
+     */
+    KisKeyframeSP baseKeyframe = previousKeyframe(keyframe);
+    if (baseKeyframe && m_d->deltaFrames) {
+        const int baseFrame = frameId(baseKeyframe);
+        const QString baseFilename = frameFilename(baseFrame);
+
+        if (!baseFilename.isEmpty() && baseFrame != frame) {
+            keyframeElement.setAttribute("base-frame", baseFilename);
+            m_d->frameBaseIds.insert(frame, baseFrame);
+        }
+    }
+
     QPoint offset = m_d->paintDevice->framesInterface()->frameOffset(frame);
     KisDomUtils::saveValue(&keyframeElement, "offset", offset);
 }
@@ -268,6 +308,16 @@ KisKeyframeSP KisRasterKeyframeChannel::loadKeyframe(const QDomElement &keyframe
 
     setFrameFilename(frameId(keyframe), frameFilename);
 
+    if (keyframeNode.hasAttribute("base-frame")) {
+        const int baseFrame = m_d->frameFilenames.key(keyframeNode.attribute("base-frame"), -1);
+
+        if (baseFrame >= 0) {
+            m_d->frameBaseIds.insert(frameId(keyframe), baseFrame);
+        } else {
+            warnKrita << "Could not find the base frame for" << frameFilename;
+        }
+    }
+
     return keyframe;
 }
 
@@ -54,8 +54,26 @@ public:
 
     QRect frameExtents(KisKeyframeSP keyframe);
 
+    /**
+     * @return ID of the paint device frame backing \p keyframe
+     */
+    int frameId(KisKeyframeSP keyframe) const;
+
+    /**
+     * @return a number that changes every time the cache of the
+     *         frame backing \p keyframe is invalidated, e.g. on undo
+     */
+    int frameSequenceNumber(KisKeyframeSP keyframe) const;
+
     QString frameFilename(int frameId) const;
 
+    /**
+     * Returns the id of the frame the content of \p frameId is stored
+     * relative to in the document, or -1 if the frame is stored in full.
+     * The value is valid after saving or loading the channel XML only.
+     */
+    int frameBaseId(int frameId) const;
+
     /**
      * When choosing filenames for frames, this will be appended to the node filename
      */
@@ -64,6 +82,15 @@ public:
     bool hasScalarValue() const;
 
     QDomElement toXML(QDomDocument doc, const QString &layerFilename);
+
+    /**
+     * Saves the channel like toXML(), but when \p deltaFrames is true,
+     * every keyframe but the first one is marked to be stored relative
+     * to the previous keyframe. Such documents must be saved with the
+     * syntax version that supports delta frames.
+     */
+    QDomElement toXML(QDomDocument doc, const QString &layerFilename, bool deltaFrames);
+
     void loadXML(const QDomElement &channelNode);
 
     void setOnionSkinsEnabled(bool value);
@@ -82,7 +109,6 @@ protected:
 private:
     void setFrameFilename(int frameId, const QString &filename);
     QString chooseFrameFilename(int frameId, const QString &layerFilename);
-    int frameId(KisKeyframeSP keyframe) const;
 
     struct Private;
     QScopedPointer<Private> m_d;
@@ -0,0 +1,337 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_sliding_histogram_filter.h"
+
+#include <algorithm>
+
+#include <QRect>
+#include <QVector>
+#include <QtConcurrent>
+#include <QAtomicInt>
+
+#include <KoColorSpace.h>
+#include <KoUpdater.h>
+
+#include "kis_assert.h"
+#include "kis_paint_device.h"
+#include "tiles3/kis_tile_data.h"
+
+
+struct KisSlidingHistogramFilter::Private
+{
+    int radius;
+    int numBins;
+    Statistic statistic;
+
+    /**
+     * Histogram of a set of pixels: the number of pixels in every bin
+     * and the sums of their channels
+     */
+    struct Histogram {
+        Histogram(int numBins, int numChannels)
+            : counts(numBins),
+              sums(numBins * numChannels)
+        {
+        }
+
+        QVector<int> counts;
+        QVector<double> sums;
+    };
+
+    int stripWidth() const;
+
+    void processStrip(KisPaintDeviceSP src, KisPaintDeviceSP dst,
+                      const QRect &strip, const QAtomicInt &cancelled) const;
+
+    int pickBin(const QVector<int> &counts, int numPixels) const;
+};
+
+KisSlidingHistogramFilter::KisSlidingHistogramFilter(int radius, int numBins, Statistic statistic)
+    : m_d(new Private)
+{
+    KIS_ASSERT_RECOVER_NOOP(radius >= 0);
+    KIS_ASSERT_RECOVER_NOOP(numBins > 0 && numBins <= 256);
+
+    m_d->radius = qMax(0, radius);
+    m_d->numBins = qBound(1, numBins, 256);
+    m_d->statistic = statistic;
+}
+
+KisSlidingHistogramFilter::~KisSlidingHistogramFilter()
+{
+}
+
+int KisSlidingHistogramFilter::Private::stripWidth() const
+{
+    /**
+     * Every scan line of a strip adds up the histograms of a whole
+     * window and moves the column histograms of the strip and its
+     * margins. The strip should be several windows wide, so that this
+     * overhead doesn't grow with the radius.
+     */
+    const int tileWidth = KisTileData::WIDTH;
+    const int minWidth = 4 * (2 * radius + 1);
+
+    return tileWidth * qMax(1, (minWidth + tileWidth - 1) / tileWidth);
+}
+
+int KisSlidingHistogramFilter::Private::pickBin(const QVector<int> &counts, int numPixels) const
+{
+    int result = 0;
+
+    if (statistic == MostFrequent) {
+        int maxCount = 0;
+
+        for (int i = 0; i < numBins; i++) {
+            if (counts[i] > maxCount) {
+                result = i;
+                maxCount = counts[i];
+            }
+        }
+    } else {
+        const int half = (numPixels + 1) / 2;
+        int accumulated = 0;
+
+        for (int i = 0; i < numBins; i++) {
+            accumulated += counts[i];
+            if (accumulated >= half) {
+                result = i;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+void KisSlidingHistogramFilter::Private::processStrip(KisPaintDeviceSP src, KisPaintDeviceSP dst,
+                                                      const QRect &strip,
+                                                      const QAtomicInt &cancelled) const
+{
+    const KoColorSpace *cs = dst->colorSpace();
+    const int numChannels = cs->channelCount();
+    const int windowSize = 2 * radius + 1;
+    const int numPixels = windowSize * windowSize;
+    const int pixelSize = cs->pixelSize();
+    const int tileHeight = KisTileData::HEIGHT;
+
+    // the source pixels needed for the strip
+    const QRect inRect = strip.adjusted(-radius, -radius, radius, radius);
+    const int numColumns = inRect.width();
+
+    /**
+     * Only the source rows covered by the window and the row above
+     * it are kept, as bins and normalized channel values, in a ring
+     * buffer. The source is read in bands of the tile height.
+     */
+    const int numRows = windowSize + 1;
+    QVector<quint16> bins(numRows * numColumns);
+    QVector<float> values(numRows * numColumns * numChannels);
+
+    QByteArray band;
+    int bandTop = inRect.top();
+    int bandHeight = 0;
+
+    const qreal scale = (numBins - 1) / 255.0;
+    QVector<float> channels(numChannels);
+
+    auto loadRow = [&] (int y) {
+        if (y >= bandTop + bandHeight) {
+            bandTop = y;
+            bandHeight = qMin(tileHeight, inRect.bottom() - y + 1);
+            band.resize(numColumns * bandHeight * pixelSize);
+            src->readBytes(reinterpret_cast<quint8*>(band.data()),
+                           QRect(inRect.x(), bandTop, numColumns, bandHeight));
+        }
+
+        const quint8 *srcPtr =
+            reinterpret_cast<const quint8*>(band.constData()) +
+            (y - bandTop) * numColumns * pixelSize;
+
+        const int index = ((y - inRect.top()) % numRows) * numColumns;
+        quint16 *rowBins = bins.data() + index;
+        float *rowValues = values.data() + index * numChannels;
+
+        for (int column = 0; column < numColumns; column++) {
+            rowBins[column] = quint16(cs->intensity8(srcPtr) * scale);
+
+            cs->normalisedChannelsValue(srcPtr, channels);
+            std::copy(channels.constBegin(), channels.constEnd(),
+                      rowValues + column * numChannels);
+
+            srcPtr += pixelSize;
+        }
+    };
+
+    auto addPixel = [&] (Histogram &hist, int column, int y, int sign) {
+        const int index = ((y - inRect.top()) % numRows) * numColumns + column;
+        const int bin = bins[index];
+        const float *pixelValues = values.constData() + index * numChannels;
+
+        hist.counts[bin] += sign;
+
+        double *sums = hist.sums.data() + bin * numChannels;
+        for (int k = 0; k < numChannels; k++) {
+            sums[k] += sign * pixelValues[k];
+        }
+    };
+
+    auto addHistogram = [&] (Histogram &to, const Histogram &from, int sign) {
+        for (int i = 0; i < numBins; i++) {
+            to.counts[i] += sign * from.counts[i];
+        }
+
+        const int numSums = numBins * numChannels;
+        for (int i = 0; i < numSums; i++) {
+            to.sums[i] += sign * from.sums[i];
+        }
+    };
+
+    /**
+     * The column histograms are built once for the first scan line
+     * and then slide down through the whole strip
+     */
+    QVector<Histogram> columns(numColumns, Histogram(numBins, numChannels));
+
+    for (int y = inRect.top(); y < inRect.top() + windowSize; y++) {
+        loadRow(y);
+
+        for (int column = 0; column < numColumns; column++) {
+            addPixel(columns[column], column, y, 1);
+        }
+    }
+
+    Histogram window(numBins, numChannels);
+
+    // the results are written in blocks aligned to the tiles of the destination
+    QByteArray block;
+    int blockTop = strip.top();
+    int blockHeight = 0;
+    quint8 *dstPtr = 0;
+
+    for (int y = strip.top(); y <= strip.bottom(); y++) {
+        if (cancelled.load()) return;
+
+        if (y > strip.top()) {
+            loadRow(y + radius);
+
+            for (int column = 0; column < numColumns; column++) {
+                addPixel(columns[column], column, y - radius - 1, -1);
+                addPixel(columns[column], column, y + radius, 1);
+            }
+        }
+
+        if (y == blockTop + blockHeight) {
+            blockTop = y;
+            blockHeight = qMin(strip.bottom() - y + 1,
+                               tileHeight - ((y - dst->y()) % tileHeight + tileHeight) % tileHeight);
+            block.resize(strip.width() * blockHeight * pixelSize);
+            dstPtr = reinterpret_cast<quint8*>(block.data());
+        }
+
+        window.counts.fill(0);
+        window.sums.fill(0.0);
+
+        for (int column = 0; column < windowSize; column++) {
+            addHistogram(window, columns[column], 1);
+        }
+
+        for (int x = 0; x < strip.width(); x++) {
+            if (x > 0) {
+                addHistogram(window, columns[x - 1], -1);
+                addHistogram(window, columns[x + windowSize - 1], 1);
+            }
+
+            const int bin = pickBin(window.counts, numPixels);
+            const int count = window.counts[bin];
+            const double *sums = window.sums.constData() + bin * numChannels;
+
+            // the window is never empty, so neither is the picked bin
+            KIS_ASSERT_RECOVER_NOOP(count > 0);
+
+            for (int k = 0; k < numChannels; k++) {
+                channels[k] = sums[k] / qMax(1, count);
+            }
+
+            cs->fromNormalisedChannelsValue(dstPtr, channels);
+            dstPtr += pixelSize;
+        }
+
+        if (y == blockTop + blockHeight - 1) {
+            dst->writeBytes(reinterpret_cast<const quint8*>(block.constData()),
+                            QRect(strip.x(), blockTop, strip.width(), blockHeight));
+        }
+    }
+}
+
+void KisSlidingHistogramFilter::apply(KisPaintDeviceSP src, KisPaintDeviceSP dst,
+                                      const QRect &rect, KoUpdater *progressUpdater) const
+{
+    if (rect.isEmpty()) return;
+
+    KIS_ASSERT_RECOVER_RETURN(*src->colorSpace() == *dst->colorSpace());
+
+    if (progressUpdater) {
+        progressUpdater->setProgress(0);
+    }
+
+    /**
+     * The strips write their results as soon as they are ready, so
+     * when filtering in place, the source is read from a
+     * copy-on-write copy of the device
+     */
+    KisPaintDeviceSP source = src;
+    if (source == dst) {
+        source = new KisPaintDevice(*src);
+    }
+
+    // the strips are aligned to the tiles of the destination
+    QVector<QRect> strips;
+    const int stripWidth = m_d->stripWidth();
+
+    for (int x = rect.left(); x <= rect.right();) {
+        const int width = qMin(rect.right() - x + 1,
+                               stripWidth - ((x - dst->x()) % stripWidth + stripWidth) % stripWidth);
+
+        strips.append(QRect(x, rect.top(), width, rect.height()));
+        x += width;
+    }
+
+    QVector<QFuture<void>> jobs;
+    QAtomicInt cancelled(0);
+
+    Q_FOREACH (const QRect &strip, strips) {
+        jobs.append(QtConcurrent::run([this, source, dst, &cancelled, strip] () {
+            if (cancelled.load()) return;
+            m_d->processStrip(source, dst, strip, cancelled);
+        }));
+    }
+
+    for (int i = 0; i < jobs.size(); i++) {
+        jobs[i].waitForFinished();
+
+        if (progressUpdater) {
+            progressUpdater->setProgress(100 * (i + 1) / jobs.size());
+
+            if (progressUpdater->interrupted()) {
+                cancelled.store(1);
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_SLIDING_HISTOGRAM_FILTER_H
+#define __KIS_SLIDING_HISTOGRAM_FILTER_H
+
+#include <QScopedPointer>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+class QRect;
+class KoUpdater;
+
+
+/**
+ * Computes a statistic of the intensity histogram over a square
+ * window of (2 * radius + 1) pixels around every pixel of the rect.
+ *
+ * The pixels are sorted into \p numBins bins by their intensity. The
+ * histogram of the window is not rebuilt for every pixel. Instead,
+ * every column of the window keeps its own histogram, which is moved
+ * one row down per scan line, and the window histogram is moved one
+ * column right by adding and subtracting the column histograms
+ * (Perreault and Hebert). The cost per pixel depends on the number of
+ * bins, but not on the radius.
+ *
+ * The rect is split into vertical strips aligned to the tiles, which
+ * are processed on the global thread pool. The column histograms
+ * slide down through the whole strip, the source is read in bands
+ * and the results are written tile by tile, so the memory doesn't
+ * depend on the size of the rect.
+ */
+class KRITAIMAGE_EXPORT KisSlidingHistogramFilter
+{
+public:
+    enum Statistic {
+        MostFrequent, ///< the average color of the most populated bin
+        Median        ///< the average color of the bin with the median intensity
+    };
+
+public:
+    KisSlidingHistogramFilter(int radius, int numBins, Statistic statistic);
+    ~KisSlidingHistogramFilter();
+
+    /**
+     * Writes the result for \p rect of \p src into the same rect of
+     * \p dst. The pixels up to the radius around \p rect are read, so
+     * the filters should add it to their need rect. The source
+     * and the destination may be the same device.
+     */
+    void apply(KisPaintDeviceSP src, KisPaintDeviceSP dst,
+               const QRect &rect, KoUpdater *progressUpdater = 0) const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_SLIDING_HISTOGRAM_FILTER_H */
@@ -0,0 +1,202 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tiled_histogram.h"
+
+#include <QRect>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <KoColorSpace.h>
+
+#include "kis_assert.h"
+#include "kis_paint_device.h"
+#include "tiles3/kis_tile_data.h"
+
+/**
+ * 4x4 tiles per cell keep the cache small (a few kilobytes per cell)
+ * while still giving enough cells to keep all the threads busy
+ */
+const int KisTiledHistogram::CELL_SIZE = 4 * KisTileData::WIDTH;
+
+namespace {
+
+inline int cellIndex(int coordinate)
+{
+    const int size = KisTiledHistogram::CELL_SIZE;
+    return coordinate >= 0 ? coordinate / size : -((size - 1 - coordinate) / size);
+}
+
+inline QRect cellRect(const KisTiledHistogram::Cell &cell)
+{
+    const int size = KisTiledHistogram::CELL_SIZE;
+    return QRect(cell.first * size, cell.second * size, size, size);
+}
+
+}
+
+struct KisTiledHistogram::Private
+{
+    QMutex dirtyLock;
+    CellSet dirtyCells;
+
+    /**
+     * Serializes calculate() and guards the cache below
+     */
+    QMutex cacheLock;
+    QHash<Cell, Bins> cells;
+    const KoColorSpace *colorSpace = 0;
+    QRect bounds;
+    int samplingStep = 1;
+
+    static Bins calculateCell(KisPaintDeviceSP device, const QRect &rect, int samplingStep);
+};
+
+KisTiledHistogram::KisTiledHistogram()
+    : m_d(new Private)
+{
+}
+
+KisTiledHistogram::~KisTiledHistogram()
+{
+}
+
+void KisTiledHistogram::invalidate(const QRect &rect)
+{
+    if (rect.isEmpty()) return;
+
+    QMutexLocker l(&m_d->dirtyLock);
+
+    for (int y = cellIndex(rect.top()); y <= cellIndex(rect.bottom()); y++) {
+        for (int x = cellIndex(rect.left()); x <= cellIndex(rect.right()); x++) {
+            m_d->dirtyCells.insert(Cell(x, y));
+        }
+    }
+}
+
+KisTiledHistogram::CellSet KisTiledHistogram::takeDirtyCells()
+{
+    QMutexLocker l(&m_d->dirtyLock);
+
+    CellSet result;
+    result.swap(m_d->dirtyCells);
+    return result;
+}
+
+KisTiledHistogram::Bins
+KisTiledHistogram::Private::calculateCell(KisPaintDeviceSP device, const QRect &rect, int samplingStep)
+{
+    const KoColorSpace *cs = device->colorSpace();
+    const int channelCount = cs->channelCount();
+    const int pixelSize = cs->pixelSize();
+
+    Bins bins(channelCount, std::vector<quint32>(256, 0));
+
+    // with sampling only the needed rows are read
+    QByteArray buffer(rect.width() * pixelSize, 0);
+    quint8 *data = reinterpret_cast<quint8*>(buffer.data());
+
+    for (int y = rect.top(); y <= rect.bottom(); y += samplingStep) {
+        device->readBytes(data, QRect(rect.left(), y, rect.width(), 1));
+
+        const quint8 *pixel = data;
+        for (int x = 0; x < rect.width(); x += samplingStep) {
+            for (int chan = 0; chan < channelCount; chan++) {
+                bins[chan][cs->scaleToU8(pixel, chan)]++;
+            }
+            pixel += samplingStep * pixelSize;
+        }
+    }
+
+    return bins;
+}
+
+KisTiledHistogram::Bins KisTiledHistogram::calculate(KisPaintDeviceSP device,
+                                                     const QRect &bounds,
+                                                     const CellSet &dirtyCells,
+                                                     int samplingStep)
+{
+    KIS_ASSERT_RECOVER_NOOP(samplingStep >= 1);
+    samplingStep = qMax(1, samplingStep);
+
+    const KoColorSpace *cs = device->colorSpace();
+    Bins result(cs->channelCount(), std::vector<quint32>(256, 0));
+
+    if (bounds.isEmpty()) return result;
+
+    QMutexLocker l(&m_d->cacheLock);
+
+    if (!m_d->colorSpace || !(*m_d->colorSpace == *cs) ||
+        m_d->bounds != bounds ||
+        m_d->samplingStep != samplingStep) {
+
+        m_d->cells.clear();
+        m_d->colorSpace = cs;
+        m_d->bounds = bounds;
+        m_d->samplingStep = samplingStep;
+    }
+
+    QVector<Cell> cells;
+    QVector<Cell> changedCells;
+    QVector<QFuture<Bins>> jobs;
+
+    for (int y = cellIndex(bounds.top()); y <= cellIndex(bounds.bottom()); y++) {
+        for (int x = cellIndex(bounds.left()); x <= cellIndex(bounds.right()); x++) {
+            const Cell cell(x, y);
+            cells.append(cell);
+
+            if (dirtyCells.contains(cell) || !m_d->cells.contains(cell)) {
+                const QRect rect = cellRect(cell) & bounds;
+
+                changedCells.append(cell);
+                jobs.append(QtConcurrent::run([device, rect, samplingStep] () {
+                    return Private::calculateCell(device, rect, samplingStep);
+                }));
+            }
+        }
+    }
+
+    for (int i = 0; i < jobs.size(); i++) {
+        m_d->cells.insert(changedCells[i], jobs[i].result());
+    }
+
+    const int channelCount = result.size();
+
+    Q_FOREACH (const Cell &cell, cells) {
+        const Bins &bins = m_d->cells[cell];
+        KIS_ASSERT_RECOVER(int(bins.size()) == channelCount) { continue; }
+
+        for (int chan = 0; chan < channelCount; chan++) {
+            for (int i = 0; i < 256; i++) {
+                result[chan][i] += bins[chan][i];
+            }
+        }
+    }
+
+    return result;
+}
+
+KisTiledHistogram::Bins KisTiledHistogram::calculate(KisPaintDeviceSP device,
+                                                     const QRect &bounds,
+                                                     int samplingStep)
+{
+    return calculate(device, bounds, takeDirtyCells(), samplingStep);
+}
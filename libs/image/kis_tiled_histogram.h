@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_TILED_HISTOGRAM_H
+#define __KIS_TILED_HISTOGRAM_H
+
+#include <vector>
+
+#include <QScopedPointer>
+#include <QSet>
+#include <QPair>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+class QRect;
+
+
+/**
+ * Computes 8-bit per-channel histograms of a paint device and keeps
+ * them up to date incrementally.
+ *
+ * The area is split into square cells of CELL_SIZE pixels, which
+ * cover whole tiles of a device with no offset. Every cell keeps its
+ * own partial histogram, so after a change only the invalidated cells
+ * are recalculated (in parallel on the global thread pool) and the
+ * result is merged from the partial histograms.
+ *
+ * With samplingStep > 1 only every samplingStep-th pixel of every
+ * samplingStep-th row is counted. This is meant for interactive
+ * display of huge images, where the shape of the histogram is more
+ * important than the exact counts.
+ *
+ * invalidate() and takeDirtyCells() may be called from any thread.
+ */
+class KRITAIMAGE_EXPORT KisTiledHistogram
+{
+public:
+    /**
+     * The bins of every channel in pixel order, 256 bins per channel
+     */
+    typedef std::vector<std::vector<quint32> > Bins;
+
+    /**
+     * The column and the row of a cell
+     */
+    typedef QPair<int, int> Cell;
+    typedef QSet<Cell> CellSet;
+
+    static const int CELL_SIZE;
+
+public:
+    KisTiledHistogram();
+    ~KisTiledHistogram();
+
+    /**
+     * Marks the cells intersecting \p rect for recalculation
+     */
+    void invalidate(const QRect &rect);
+
+    /**
+     * Returns the cells invalidated since the last call and resets
+     * them. Take them at the same moment as the snapshot of the device
+     * that is going to be passed to calculate(), otherwise the changes
+     * made in between would be lost.
+     */
+    CellSet takeDirtyCells();
+
+    /**
+     * Returns the histogram of \p bounds of \p device. Only the cells
+     * listed in \p dirtyCells and the ones missing in the cache are
+     * read from the device, the rest come from the cache. If the
+     * color space, the bounds or the sampling step differ from the
+     * previous call, all the cells are recalculated.
+     */
+    Bins calculate(KisPaintDeviceSP device, const QRect &bounds,
+                   const CellSet &dirtyCells, int samplingStep = 1);
+
+    /**
+     * Convenience version that takes the dirty cells itself
+     */
+    Bins calculate(KisPaintDeviceSP device, const QRect &bounds, int samplingStep = 1);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_TILED_HISTOGRAM_H */
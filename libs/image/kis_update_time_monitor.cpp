@@ -33,6 +33,8 @@
 
 #include <QFileInfo>
 
+#include <algorithm>
+
 #include "kis_debug.h"
 #include "kis_global.h"
 #include "kis_image_config.h"
@@ -85,9 +87,17 @@ struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
           numTickets(0),
           numUpdates(0),
           mousePath(0.0),
+          dabCacheHits(0),
+          dabCacheMisses(0),
+          predictionError(0.0),
+          numPredictions(0),
+          eventTimeOffset(0),
+          hasEventTimeOffset(false),
+          lastEventId(-1),
           loggingEnabled(false)
     {
         loggingEnabled = KisImageConfig().enablePerfLog();
+        clock.start();
     }
 
     QHash<void*, StrokeTicket*> preliminaryTickets;
@@ -104,6 +114,30 @@ struct Q_DECL_HIDDEN KisUpdateTimeMonitor::Private
     QElapsedTimer strokeTime;
     KisPaintOpPresetSP preset;
 
+    qint64 dabCacheHits;
+    qint64 dabCacheMisses;
+
+    qreal predictionError;
+    qint32 numPredictions;
+
+    QElapsedTimer clock;
+    qint64 eventTimeOffset;
+    bool hasEventTimeOffset;
+
+    /**
+     * The timestamps of the events that are not uploaded to the
+     * canvas yet and the regions of the ones that are not merged
+     * into the projection yet, by the ids of the events
+     */
+    qint64 lastEventId;
+    QHash<qint64, qint64> eventTimestamps;
+    QHash<qint64, QRegion> pendingEvents;
+    QSet<qint64> updatedEvents;
+    QVector<qint64> eventLatencies;
+
+    QVector<int> latencyHistogram() const;
+    void printLatencies(const QString &prefix);
+
     bool loggingEnabled;
 };
 
@@ -140,6 +174,14 @@ void KisUpdateTimeMonitor::startStrokeMeasure()
     m_d->numTickets = 0;
     m_d->numUpdates = 0;
     m_d->mousePath = 0;
+    m_d->dabCacheHits = 0;
+    m_d->dabCacheMisses = 0;
+    m_d->predictionError = 0.0;
+    m_d->numPredictions = 0;
+    m_d->eventTimestamps.clear();
+    m_d->pendingEvents.clear();
+    m_d->updatedEvents.clear();
+    m_d->eventLatencies.clear();
 
     m_d->lastMousePos = QPointF();
     m_d->preset = 0;
@@ -185,6 +227,9 @@ void KisUpdateTimeMonitor::printValues()
     qreal nonUpdateTime = qreal(m_d->jobsTime) / m_d->numTickets;
     qreal jobsPerUpdate = qreal(m_d->numTickets) / m_d->numUpdates;    
     qreal mouseSpeed = qreal(m_d->mousePath) / strokeTime;
+    qint64 numDabs = m_d->dabCacheHits + m_d->dabCacheMisses;
+    qreal dabCacheHitRate = numDabs ? qreal(m_d->dabCacheHits) / numDabs : 0.0;
+    qreal predictionError = m_d->numPredictions ? m_d->predictionError / m_d->numPredictions : 0.0;
 
     QString prefix;
 
@@ -203,7 +248,47 @@ void KisUpdateTimeMonitor::printValues()
            << i18n("Mouse Speed:") << QString::number( mouseSpeed, 'f', 3 ) << "\t"
            << i18n("Jobs/Update:") << QString::number( jobsPerUpdate, 'f', 3 ) << "\t"
            << i18n("Non Update Time:") << QString::number( nonUpdateTime, 'f', 3 ) << "\t"
-           << i18n("Response Time:") << responseTime << endl; // 'endl' will use the correct OS line ending
+           << i18n("Response Time:") << responseTime << "\t"
+           << i18n("Dab Cache Hit Rate:") << QString::number( dabCacheHitRate, 'f', 3 ) << "\t"
+           << i18n("Prediction Error:") << QString::number( predictionError, 'f', 3 ) << endl; // 'endl' will use the correct OS line ending
+    logFile.close();
+
+    m_d->printLatencies(prefix);
+}
+
+void KisUpdateTimeMonitor::Private::printLatencies(const QString &prefix)
+{
+    if (eventLatencies.isEmpty()) return;
+
+    QVector<qint64> latencies = eventLatencies;
+    std::sort(latencies.begin(), latencies.end());
+
+    auto percentile = [&latencies] (int percent) {
+        return latencies[(latencies.size() - 1) * percent / 100];
+    };
+
+    qint64 totalLatency = 0;
+    Q_FOREACH (qint64 latency, latencies) {
+        totalLatency += latency;
+    }
+
+    QFile logFile(QString("log/%1latency.rdata").arg(prefix));
+    logFile.open(QIODevice::Append);
+    QTextStream stream(&logFile);
+
+    stream << i18n("Events:") << latencies.size() << "\t"
+           << i18n("Mean Latency:") << QString::number( qreal(totalLatency) / latencies.size(), 'f', 3 ) << "\t"
+           << i18n("50%:") << percentile(50) << "\t"
+           << i18n("90%:") << percentile(90) << "\t"
+           << i18n("99%:") << percentile(99) << "\t"
+           << i18n("Max:") << latencies.last() << "\t"
+           << i18n("Histogram:");
+
+    Q_FOREACH (int count, latencyHistogram()) {
+        stream << " " << count;
+    }
+
+    stream << endl;
     logFile.close();
 }
 
@@ -256,3 +341,143 @@ void KisUpdateTimeMonitor::reportUpdateFinished(const QRect &rect)
     }
     m_d->numUpdates++;
 }
+
+void KisUpdateTimeMonitor::reportDabCacheStatistics(int hits, int misses)
+{
+    if (!m_d->loggingEnabled) return;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    m_d->dabCacheHits += hits;
+    m_d->dabCacheMisses += misses;
+}
+
+void KisUpdateTimeMonitor::reportPredictionError(qreal error)
+{
+    if (!m_d->loggingEnabled) return;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    m_d->predictionError += error;
+    m_d->numPredictions++;
+}
+
+qint64 KisUpdateTimeMonitor::registerEvent(ulong eventTime)
+{
+    if (!m_d->loggingEnabled) return -1;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    const qint64 now = m_d->clock.elapsed();
+    qint64 timestamp = now;
+
+    // synthesized events may have no timestamp
+    if (eventTime) {
+        const qint64 offset = now - qint64(eventTime);
+
+        if (!m_d->hasEventTimeOffset || offset < m_d->eventTimeOffset) {
+            m_d->eventTimeOffset = offset;
+            m_d->hasEventTimeOffset = true;
+        }
+
+        timestamp = qint64(eventTime) + m_d->eventTimeOffset;
+    }
+
+    const qint64 eventId = ++m_d->lastEventId;
+    m_d->eventTimestamps.insert(eventId, timestamp);
+
+    return eventId;
+}
+
+void KisUpdateTimeMonitor::reportEventPainted(qint64 eventId, const QVector<QRect> &rects)
+{
+    if (!m_d->loggingEnabled || eventId < 0) return;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    /**
+     * With LoD the event is painted twice, but only the first time
+     * is visible to the user
+     */
+    if (m_d->updatedEvents.contains(eventId)) return;
+
+    QRegion region;
+    Q_FOREACH (const QRect &rc, rects) {
+        region += rc;
+    }
+
+    if (!region.isEmpty()) {
+        m_d->pendingEvents[eventId] += region;
+    }
+}
+
+QVector<qint64> KisUpdateTimeMonitor::takeUpdatedEvents(const QRect &rect)
+{
+    QVector<qint64> result;
+
+    if (!m_d->loggingEnabled) return result;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    QHash<qint64, QRegion>::iterator it = m_d->pendingEvents.begin();
+    while (it != m_d->pendingEvents.end()) {
+        it.value() -= rect;
+
+        if (it.value().isEmpty()) {
+            result.append(it.key());
+            m_d->updatedEvents.insert(it.key());
+            it = m_d->pendingEvents.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return result;
+}
+
+void KisUpdateTimeMonitor::reportEventsUploaded(const QVector<qint64> &eventIds)
+{
+    if (!m_d->loggingEnabled || eventIds.isEmpty()) return;
+
+    QMutexLocker locker(&m_d->mutex);
+
+    const qint64 now = m_d->clock.elapsed();
+
+    Q_FOREACH (qint64 eventId, eventIds) {
+        QHash<qint64, qint64>::iterator it = m_d->eventTimestamps.find(eventId);
+
+        // the event may belong to a stroke that is not measured anymore
+        if (it == m_d->eventTimestamps.end()) continue;
+
+        m_d->eventLatencies.append(qMax(qint64(0), now - it.value()));
+        m_d->eventTimestamps.erase(it);
+    }
+}
+
+QVector<int> KisUpdateTimeMonitor::Private::latencyHistogram() const
+{
+    QVector<int> histogram(NUM_LATENCY_BUCKETS, 0);
+
+    Q_FOREACH (qint64 latency, eventLatencies) {
+        histogram[qMin(qint64(NUM_LATENCY_BUCKETS - 1), latency / LATENCY_BUCKET_SIZE)]++;
+    }
+
+    return histogram;
+}
+
+QVector<int> KisUpdateTimeMonitor::latencyHistogram() const
+{
+    QMutexLocker locker(&m_d->mutex);
+    return m_d->latencyHistogram();
+}
+
+void KisUpdateTimeMonitor::setLoggingEnabled(bool value)
+{
+    QMutexLocker locker(&m_d->mutex);
+    m_d->loggingEnabled = value;
+}
+
+bool KisUpdateTimeMonitor::loggingEnabled() const
+{
+    return m_d->loggingEnabled;
+}
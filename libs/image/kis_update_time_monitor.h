@@ -46,6 +46,61 @@ public:
     void reportJobFinished(void *key, const QVector<QRect> &rects);
     void reportUpdateFinished(const QRect &rect);
 
+    void reportDabCacheStatistics(int hits, int misses);
+
+    /**
+     * Reports the distance between the predicted and the real
+     * position of the stroke, see KisStrokePredictor
+     */
+    void reportPredictionError(qreal error);
+
+    /**
+     * Starts tracking the latency of an input event with the timestamp
+     * \p eventTime and returns the id of the event for the other calls.
+     * The timestamps of the events are not unique, several events may
+     * come within a millisecond. The clocks of the windowing system and
+     * the monitor differ, so the offset between them is estimated as
+     * the smallest one ever seen, i.e. the one of the event delivered
+     * the fastest. Returns -1 if logging is disabled.
+     */
+    qint64 registerEvent(ulong eventTime);
+
+    /**
+     * The pixels of the event \p eventId have been painted into
+     * \p rects (in the coordinates of the canvas updates). The rects
+     * must be cropped by the image bounds, the parts outside are
+     * never updated.
+     */
+    void reportEventPainted(qint64 eventId, const QVector<QRect> &rects);
+
+    /**
+     * Returns the ids of the events whose pixels have been completely
+     * merged into the projection after the update of \p rect
+     */
+    QVector<qint64> takeUpdatedEvents(const QRect &rect);
+
+    /**
+     * The pixels of the events \p eventIds have been uploaded to
+     * the canvas
+     */
+    void reportEventsUploaded(const QVector<qint64> &eventIds);
+
+    /**
+     * The number of events of the current stroke in every
+     * LATENCY_BUCKET_SIZE ms of the latency. The last bucket also
+     * collects all the slower events.
+     */
+    QVector<int> latencyHistogram() const;
+
+    static const int LATENCY_BUCKET_SIZE = 2;
+    static const int NUM_LATENCY_BUCKETS = 100;
+
+    /**
+     * Overrides the enablePerfLog() setting, used by the unit tests
+     */
+    void setLoggingEnabled(bool value);
+    bool loggingEnabled() const;
+
 
 private:
     struct Private;
@@ -157,7 +157,7 @@ void applyDropShadow(KisPaintDeviceSP srcDevice,
     //selection->convertToQImage(0, QRect(0,0,300,300)).save("1_selection_spread.png");
 
     if (d.blur_size) {
-        KisLsUtils::applyGaussian(selection, d.noiseNeedRect, d.blur_size);
+        KisLsUtils::applyGaussian(selection, d.noiseNeedRect, d.blur_size, true);
     }
     //selection->convertToQImage(0, QRect(0,0,300,300)).save("2_selection_blur.png");
 
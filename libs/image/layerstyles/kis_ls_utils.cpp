@@ -111,11 +111,13 @@ namespace KisLsUtils
 
     void applyGaussian(KisPixelSelectionSP selection,
                        const QRect &applyRect,
-                       qreal radius)
+                       qreal radius,
+                       bool allowRecursive)
     {
         KisGaussianKernel::applyGaussian(selection, applyRect,
                                          radius, radius,
-                                         QBitArray(), 0);
+                                         QBitArray(), 0,
+                                         allowRecursive);
     }
 
     namespace Private {
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_recorded_stroke.h"
+
+#include <QDomDocument>
+#include <QDomElement>
+#include <QFile>
+#include <QTextStream>
+
+#include <kis_debug.h>
+
+
+void KisRecordedStroke::addEvent(const KisPaintInformation &pi)
+{
+    m_events.append(pi);
+}
+
+const QVector<KisPaintInformation>& KisRecordedStroke::events() const
+{
+    return m_events;
+}
+
+bool KisRecordedStroke::isEmpty() const
+{
+    return m_events.isEmpty();
+}
+
+void KisRecordedStroke::clear()
+{
+    m_events.clear();
+}
+
+qreal KisRecordedStroke::duration() const
+{
+    return !m_events.isEmpty() ?
+        m_events.last().currentTime() - m_events.first().currentTime() : 0.0;
+}
+
+void KisRecordedStroke::toXML(QDomDocument &doc, QDomElement &elt) const
+{
+    Q_FOREACH (const KisPaintInformation &pi, m_events) {
+        QDomElement eventElt = doc.createElement("Event");
+        pi.toXML(doc, eventElt);
+        elt.appendChild(eventElt);
+    }
+}
+
+KisRecordedStroke KisRecordedStroke::fromXML(const QDomElement &elt)
+{
+    KisRecordedStroke stroke;
+
+    QDomElement eventElt = elt.firstChildElement("Event");
+    while (!eventElt.isNull()) {
+        stroke.addEvent(KisPaintInformation::fromXML(eventElt));
+        eventElt = eventElt.nextSiblingElement("Event");
+    }
+
+    return stroke;
+}
+
+bool KisRecordedStroke::save(const QString &fileName, const QVector<KisRecordedStroke> &strokes)
+{
+    QDomDocument doc("RecordedStrokes");
+    QDomElement root = doc.createElement("RecordedStrokes");
+    root.setAttribute("version", 1);
+    doc.appendChild(root);
+
+    Q_FOREACH (const KisRecordedStroke &stroke, strokes) {
+        QDomElement strokeElt = doc.createElement("Stroke");
+        stroke.toXML(doc, strokeElt);
+        root.appendChild(strokeElt);
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        warnImage << "Could not save the recorded strokes to" << fileName;
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    doc.save(stream, 1);
+
+    return true;
+}
+
+QVector<KisRecordedStroke> KisRecordedStroke::load(const QString &fileName, bool *ok)
+{
+    QVector<KisRecordedStroke> strokes;
+    if (ok) *ok = false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        warnImage << "Could not open the recorded strokes" << fileName;
+        return strokes;
+    }
+
+    QDomDocument doc;
+    QString errorMessage;
+    if (!doc.setContent(&file, &errorMessage)) {
+        warnImage << "Could not parse the recorded strokes" << fileName << errorMessage;
+        return strokes;
+    }
+
+    const QDomElement root = doc.documentElement();
+    if (root.tagName() != "RecordedStrokes") {
+        warnImage << fileName << "does not contain recorded strokes";
+        return strokes;
+    }
+
+    QDomElement strokeElt = root.firstChildElement("Stroke");
+    while (!strokeElt.isNull()) {
+        strokes.append(fromXML(strokeElt));
+        strokeElt = strokeElt.nextSiblingElement("Stroke");
+    }
+
+    if (ok) *ok = true;
+    return strokes;
+}
@@ -0,0 +1,81 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_RECORDED_STROKE_H
+#define __KIS_RECORDED_STROKE_H
+
+#include <QVector>
+
+#include <brushengine/kis_paint_information.h>
+#include "kritaimage_export.h"
+
+class QDomDocument;
+class QDomElement;
+class QString;
+
+
+/**
+ * The raw input events of a freehand stroke: position, pressure,
+ * tilt, rotation and time, as they came from the tablet. Unlike the
+ * recorded paint actions, the events are neither smoothed nor
+ * interpolated and do not depend on the preset, so the same stroke
+ * can be replayed through any paintop.
+ *
+ * A file keeps several strokes:
+ *
+ * \code
+ * <RecordedStrokes version="1">
+ *   <Stroke>
+ *     <Event pointX="10" pointY="20" pressure="0.5" time="0" .../>
+ *     ...
+ *   </Stroke>
+ * </RecordedStrokes>
+ * \endcode
+ *
+ * The attributes of the events are the ones of KisPaintInformation::toXML().
+ */
+class KRITAIMAGE_EXPORT KisRecordedStroke
+{
+public:
+    void addEvent(const KisPaintInformation &pi);
+    const QVector<KisPaintInformation>& events() const;
+
+    bool isEmpty() const;
+    void clear();
+
+    /**
+     * The time between the first and the last event in milliseconds
+     */
+    qreal duration() const;
+
+    void toXML(QDomDocument &doc, QDomElement &elt) const;
+    static KisRecordedStroke fromXML(const QDomElement &elt);
+
+    static bool save(const QString &fileName, const QVector<KisRecordedStroke> &strokes);
+
+    /**
+     * Loads the strokes from \p fileName. If the file cannot be read,
+     * an empty list is returned and \p ok is set to false.
+     */
+    static QVector<KisRecordedStroke> load(const QString &fileName, bool *ok = 0);
+
+private:
+    QVector<KisPaintInformation> m_events;
+};
+
+#endif /* __KIS_RECORDED_STROKE_H */
@@ -36,6 +36,7 @@
 #include "filter/kis_filter.h"
 #include "filter/kis_filter_configuration.h"
 #include "filter/kis_filter_registry.h"
+#include "filter/kis_color_transformation_filter.h"
 
 #include "../../sdk/tests/testutil.h"
 
@@ -287,5 +288,238 @@ void KisAsyncMergerTest::testSubgraphingWithoutUpdatingParent()
     }
 }
 
+    /*
+      +--------------+
+      |root          |
+      | desaturate 1 |
+      | invert 1     |
+      | paint 1      |
+      +--------------+
+     */
+
+void KisAsyncMergerTest::testFusedAdjustmentLayers()
+{
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, 640, 441, colorSpace, "fused adjustments test");
+
+    QImage sourceImage(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
+
+    KisPaintDeviceSP device1 = new KisPaintDevice(colorSpace);
+    device1->convertFromQImage(sourceImage, 0, 0, 0);
+
+    KisFilterSP invertFilter = KisFilterRegistry::instance()->value("invert");
+    KisFilterSP desaturateFilter = KisFilterRegistry::instance()->value("desaturate");
+    QVERIFY(invertFilter);
+    QVERIFY(desaturateFilter);
+
+    KisFilterConfigurationSP invertConfig = invertFilter->defaultConfiguration(0);
+    KisFilterConfigurationSP desaturateConfig = desaturateFilter->defaultConfiguration(0);
+
+    KisLayerSP paintLayer1 = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8, device1);
+    KisLayerSP invert1 = new KisAdjustmentLayer(image, "invert1", invertConfig, 0);
+    KisLayerSP desaturate1 = new KisAdjustmentLayer(image, "desaturate1", desaturateConfig, 0);
+
+    image->addNode(paintLayer1, image->rootLayer());
+    image->addNode(invert1, image->rootLayer());
+    image->addNode(desaturate1, image->rootLayer());
+
+    QRect cropRect(image->bounds());
+
+    KisMergeWalker walker(cropRect);
+    KisAsyncMerger merger;
+
+    walker.collectRects(paintLayer1, image->bounds());
+    merger.startMerge(walker);
+
+    // the same layers applied one by one
+    KisPaintDeviceSP inverted = new KisPaintDevice(*device1);
+    invertFilter->process(inverted, image->bounds(), invertConfig);
+
+    KisPaintDeviceSP desaturated = new KisPaintDevice(*inverted);
+    desaturateFilter->process(desaturated, image->bounds(), desaturateConfig);
+
+    QPoint pt;
+    QVERIFY(TestUtil::comparePaintDevices(pt, invert1->original(), inverted));
+    QVERIFY(TestUtil::comparePaintDevices(pt, desaturate1->original(), desaturated));
+    QVERIFY(TestUtil::comparePaintDevices(pt, image->rootLayer()->original(), desaturated));
+}
+
+/**
+ * An invert filter that counts how many times it is run by the
+ * filter machinery, or a filter without any transformation
+ */
+class TestInvertFilter : public KisColorTransformationFilter
+{
+public:
+    TestInvertFilter(const QString &id, bool nullTransformation)
+        : KisColorTransformationFilter(KoID(id, id), categoryAdjust(), id),
+          m_nullTransformation(nullTransformation)
+    {
+    }
+
+    void processImpl(KisPaintDeviceSP device,
+                     const QRect& applyRect,
+                     const KisFilterConfigurationSP config,
+                     KoUpdater* progressUpdater) const override {
+
+        numProcessCalls.ref();
+        KisColorTransformationFilter::processImpl(device, applyRect, config, progressUpdater);
+    }
+
+    KoColorTransformation* createTransformation(const KoColorSpace* cs, const KisFilterConfigurationSP config) const override {
+        Q_UNUSED(config);
+        return m_nullTransformation ? 0 : cs->createInvertTransformation();
+    }
+
+    static KisFilterSP fetch(const QString &id, bool nullTransformation) {
+        KisFilterRegistry *registry = KisFilterRegistry::instance();
+
+        if (!registry->value(id)) {
+            registry->add(KisFilterSP(new TestInvertFilter(id, nullTransformation)));
+        }
+
+        return registry->value(id);
+    }
+
+    static QAtomicInt numProcessCalls;
+
+private:
+    bool m_nullTransformation;
+};
+
+QAtomicInt TestInvertFilter::numProcessCalls;
+
+    /*
+      +--------------+
+      |root          |
+      | test invert 2|
+      | test invert 1|
+      | paint 1      |
+      +--------------+
+     */
+
+void KisAsyncMergerTest::testFusedLayersSkipFiltering()
+{
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, 640, 441, colorSpace, "fused adjustments test");
+
+    QImage sourceImage(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
+
+    KisPaintDeviceSP device1 = new KisPaintDevice(colorSpace);
+    device1->convertFromQImage(sourceImage, 0, 0, 0);
+
+    KisFilterSP invertFilter = TestInvertFilter::fetch("test_invert", false);
+    KisFilterConfigurationSP invertConfig = invertFilter->defaultConfiguration(0);
+
+    KisLayerSP paintLayer1 = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8, device1);
+    KisLayerSP invert1 = new KisAdjustmentLayer(image, "invert1", invertConfig, 0);
+    KisLayerSP invert2 = new KisAdjustmentLayer(image, "invert2", invertConfig, 0);
+
+    image->addNode(paintLayer1, image->rootLayer());
+    image->addNode(invert1, image->rootLayer());
+    image->addNode(invert2, image->rootLayer());
+
+    QRect cropRect(image->bounds());
+    KisAsyncMerger merger;
+
+    // the fused layers never run the filters themselves
+    {
+        TestInvertFilter::numProcessCalls = 0;
+
+        KisMergeWalker walker(cropRect);
+        walker.collectRects(paintLayer1, image->bounds());
+        merger.startMerge(walker);
+
+        QCOMPARE(int(TestInvertFilter::numProcessCalls), 0);
+    }
+
+    KisPaintDeviceSP inverted = new KisPaintDevice(*device1);
+    invertFilter->process(inverted, image->bounds(), invertConfig);
+
+    QPoint pt;
+    QVERIFY(TestUtil::comparePaintDevices(pt, invert1->original(), inverted));
+    QVERIFY(TestUtil::comparePaintDevices(pt, invert2->original(), device1));
+
+    // a translucent layer cannot be fused, so every layer is filtered separately
+    invert2->setOpacity(128);
+
+    {
+        TestInvertFilter::numProcessCalls = 0;
+
+        KisMergeWalker walker(cropRect);
+        walker.collectRects(paintLayer1, image->bounds());
+        merger.startMerge(walker);
+
+        QCOMPARE(int(TestInvertFilter::numProcessCalls), 2);
+    }
+
+    QVERIFY(TestUtil::comparePaintDevices(pt, invert1->original(), inverted));
+    QVERIFY(TestUtil::comparePaintDevices(pt, invert2->original(), device1));
+}
+
+    /*
+      +------------------+
+      |root              |
+      | test invert 2    |
+      | null transform 1 |
+      | test invert 1    |
+      | paint 1          |
+      +------------------+
+     */
+
+void KisAsyncMergerTest::testFusedNullTransformation()
+{
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, 640, 441, colorSpace, "fused adjustments test");
+
+    QImage sourceImage(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
+
+    KisPaintDeviceSP device1 = new KisPaintDevice(colorSpace);
+    device1->convertFromQImage(sourceImage, 0, 0, 0);
+
+    KisFilterSP invertFilter = TestInvertFilter::fetch("test_invert", false);
+    KisFilterSP nullFilter = TestInvertFilter::fetch("test_null_transformation", true);
+
+    KisFilterConfigurationSP invertConfig = invertFilter->defaultConfiguration(0);
+    KisFilterConfigurationSP nullConfig = nullFilter->defaultConfiguration(0);
+
+    KisLayerSP paintLayer1 = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8, device1);
+    KisLayerSP invert1 = new KisAdjustmentLayer(image, "invert1", invertConfig, 0);
+    KisLayerSP null1 = new KisAdjustmentLayer(image, "null1", nullConfig, 0);
+    KisLayerSP invert2 = new KisAdjustmentLayer(image, "invert2", invertConfig, 0);
+
+    image->addNode(paintLayer1, image->rootLayer());
+    image->addNode(invert1, image->rootLayer());
+    image->addNode(null1, image->rootLayer());
+    image->addNode(invert2, image->rootLayer());
+
+    TestInvertFilter::numProcessCalls = 0;
+
+    QRect cropRect(image->bounds());
+    KisMergeWalker walker(cropRect);
+    KisAsyncMerger merger;
+
+    walker.collectRects(paintLayer1, image->bounds());
+    merger.startMerge(walker);
+
+    QCOMPARE(int(TestInvertFilter::numProcessCalls), 0);
+
+    // the same layers applied one by one
+    KisPaintDeviceSP inverted = new KisPaintDevice(*device1);
+    invertFilter->process(inverted, image->bounds(), invertConfig);
+
+    KisPaintDeviceSP passedThrough = new KisPaintDevice(*inverted);
+    nullFilter->process(passedThrough, image->bounds(), nullConfig);
+
+    KisPaintDeviceSP invertedTwice = new KisPaintDevice(*passedThrough);
+    invertFilter->process(invertedTwice, image->bounds(), invertConfig);
+
+    QPoint pt;
+    QVERIFY(TestUtil::comparePaintDevices(pt, invert1->original(), inverted));
+    QVERIFY(TestUtil::comparePaintDevices(pt, null1->original(), passedThrough));
+    QVERIFY(TestUtil::comparePaintDevices(pt, invert2->original(), invertedTwice));
+    QVERIFY(TestUtil::comparePaintDevices(pt, image->rootLayer()->original(), invertedTwice));
+}
+
 QTEST_MAIN(KisAsyncMergerTest)
 
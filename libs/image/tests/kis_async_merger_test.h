@@ -30,6 +30,9 @@ private Q_SLOTS:
     void debugObligeChild();
     void testFullRefreshWithClones();
     void testSubgraphingWithoutUpdatingParent();
+    void testFusedAdjustmentLayers();
+    void testFusedLayersSkipFiltering();
+    void testFusedNullTransformation();
 };
 
 #endif /* KIS_ASYNC_MERGER_TEST_H */
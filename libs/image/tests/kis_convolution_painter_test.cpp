@@ -35,6 +35,9 @@
 #include <kis_mask_generator.h>
 #include "testutil.h"
 
+typedef Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> KernelMatrix;
+Q_DECLARE_METATYPE(KernelMatrix)
+
 KisPaintDeviceSP initAsymTestDevice(QRect &imageRect, int &pixelSize, QByteArray &initialData)
 {
     KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
@@ -437,4 +440,210 @@ void KisConvolutionPainterTest::testGaussianDetailsFFTW()
     testGaussianDetails(true);
 }
 
+void KisConvolutionPainterTest::testGaussianRecursive()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect applyRect(0, 0, 400, 400);
+    const qreal radius = 30.0;
+
+    QVERIFY(KisGaussianKernel::canUseRecursiveGaussian(radius));
+    QVERIFY(!KisGaussianKernel::canUseRecursiveGaussian(5.0));
+
+    KisPaintDeviceSP exactDev = new KisPaintDevice(cs);
+    exactDev->fill(QRect(100, 100, 200, 150), KoColor(Qt::red, cs));
+    exactDev->fill(QRect(150, 200, 100, 150), KoColor(Qt::blue, cs));
+    KisPaintDeviceSP recursiveDev = new KisPaintDevice(*exactDev);
+
+    KisGaussianKernel::applyGaussian(exactDev, applyRect, radius, radius, QBitArray(), 0, false);
+    KisGaussianKernel::applyGaussian(recursiveDev, applyRect, radius, radius, QBitArray(), 0, true);
+
+    QImage exactImage = exactDev->convertToQImage(0, applyRect);
+    QImage recursiveImage = recursiveDev->convertToQImage(0, applyRect);
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, exactImage, recursiveImage, 2, 2));
+}
+
+void KisConvolutionPainterTest::testSeparableKernel()
+{
+    qreal offset = 0.0;
+    qreal factor = 1.0;
+
+    KisConvolutionKernelSP symmKernel =
+        KisConvolutionKernel::fromMatrix(initSymmFilter(offset, factor), offset, factor);
+    QVERIFY(!symmKernel->isSeparable());
+
+    KisConvolutionKernelSP asymmKernel =
+        KisConvolutionKernel::fromMatrix(initAsymmFilter(offset, factor), offset, factor);
+    QVERIFY(!asymmKernel->isSeparable());
+
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix =
+        KisGaussianKernel::createVerticalMatrix(3.0) *
+        KisGaussianKernel::createHorizontalMatrix(5.0);
+
+    KisConvolutionKernelSP gaussianKernel =
+        KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum());
+
+    QVector<qreal> columnCoeffs;
+    QVector<qreal> rowCoeffs;
+    QVERIFY(gaussianKernel->separate(&columnCoeffs, &rowCoeffs));
+    QVERIFY(!gaussianKernel->isExactlySeparable());
+    QCOMPARE(columnCoeffs.size(), int(gaussianKernel->height()));
+    QCOMPARE(rowCoeffs.size(), int(gaussianKernel->width()));
+
+    for (int r = 0; r < matrix.rows(); r++) {
+        for (int c = 0; c < matrix.cols(); c++) {
+            QVERIFY(qAbs(columnCoeffs[r] * rowCoeffs[c] - matrix(r, c)) < 1e-12);
+        }
+    }
+}
+
+void KisConvolutionPainterTest::testSeparableConvolution()
+{
+    QImage referenceImage(TestUtil::fetchDataFileLazy("kritaTransparent.png"));
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->convertFromQImage(referenceImage, 0, 0, 0);
+
+    KisPaintDeviceSP spatialDev = new KisPaintDevice(cs);
+    KisPaintDeviceSP separableDev = new KisPaintDevice(cs);
+
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix =
+        KisGaussianKernel::createVerticalMatrix(1.0) *
+        KisGaussianKernel::createHorizontalMatrix(2.0);
+
+    KisConvolutionKernelSP kernel =
+        KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum());
+
+    const QRect applyRect = dev->exactBounds();
+
+    KisConvolutionPainter spatialPainter(spatialDev, KisConvolutionPainter::SPATIAL);
+    spatialPainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                               applyRect.size(), BORDER_REPEAT);
+
+    // this kernel can be separated only up to rounding
+    KisConvolutionPainter separablePainter(separableDev, KisConvolutionPainter::SEPARABLE);
+    separablePainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                                 applyRect.size(), BORDER_REPEAT);
+
+    QImage spatialImage = spatialDev->convertToQImage(0, applyRect);
+    QImage separableImage = separableDev->convertToQImage(0, applyRect);
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, spatialImage, separableImage, 1, 1));
+}
+
+void KisConvolutionPainterTest::testSeparableConvolutionExact_data()
+{
+    typedef KernelMatrix Matrix;
+
+    QTest::addColumn<QString>("imageName");
+    QTest::addColumn<Matrix>("matrix");
+
+    Matrix box = Matrix::Ones(5, 5);
+
+    Eigen::Matrix<qreal, 5, 1> binomialVector;
+    binomialVector << 1, 4, 6, 4, 1;
+    Matrix binomial = binomialVector * binomialVector.transpose();
+
+    Matrix motion = Matrix::Zero(7, 7);
+    motion.row(3).setOnes();
+
+    Matrix horizontalGaussian = KisGaussianKernel::createHorizontalMatrix(5.0);
+    Matrix verticalGaussian = KisGaussianKernel::createVerticalMatrix(5.0);
+
+    Q_FOREACH (const QString &imageName, QStringList() << "kritaTransparent.png" << "hakonepa.png") {
+        QTest::newRow(QString("%1 box").arg(imageName).toLatin1()) << imageName << box;
+        QTest::newRow(QString("%1 binomial").arg(imageName).toLatin1()) << imageName << binomial;
+        QTest::newRow(QString("%1 motion").arg(imageName).toLatin1()) << imageName << motion;
+        QTest::newRow(QString("%1 horizontal gaussian").arg(imageName).toLatin1()) << imageName << horizontalGaussian;
+        QTest::newRow(QString("%1 vertical gaussian").arg(imageName).toLatin1()) << imageName << verticalGaussian;
+    }
+}
+
+void KisConvolutionPainterTest::testSeparableConvolutionExact()
+{
+    QFETCH(QString, imageName);
+    QFETCH(KernelMatrix, matrix);
+
+    QImage referenceImage(TestUtil::fetchDataFileLazy(imageName));
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->convertFromQImage(referenceImage, 0, 0, 0);
+
+    KisConvolutionKernelSP kernel =
+        KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum());
+    QVERIFY(kernel->isExactlySeparable());
+
+    const QRect applyRect = dev->exactBounds();
+
+    KisPaintDeviceSP spatialDev = new KisPaintDevice(cs);
+    KisConvolutionPainter spatialPainter(spatialDev, KisConvolutionPainter::SPATIAL);
+    spatialPainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                               applyRect.size(), BORDER_REPEAT);
+
+    KisPaintDeviceSP separableDev = new KisPaintDevice(cs);
+    KisConvolutionPainter separablePainter(separableDev, KisConvolutionPainter::SEPARABLE);
+    separablePainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                                 applyRect.size(), BORDER_REPEAT);
+
+    // in place, the stripes must not see each other's results
+    KisPaintDeviceSP inPlaceDev = new KisPaintDevice(*dev);
+    KisConvolutionPainter inPlacePainter(inPlaceDev, KisConvolutionPainter::SEPARABLE);
+    inPlacePainter.applyMatrix(kernel, inPlaceDev, applyRect.topLeft(), applyRect.topLeft(),
+                               applyRect.size(), BORDER_REPEAT);
+
+    QImage spatialImage = spatialDev->convertToQImage(0, applyRect);
+    QImage separableImage = separableDev->convertToQImage(0, applyRect);
+    QImage inPlaceImage = inPlaceDev->convertToQImage(0, applyRect);
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt, spatialImage, separableImage));
+    QVERIFY(TestUtil::compareQImages(pt, spatialImage, inPlaceImage));
+}
+
+void KisConvolutionPainterTest::testFFTBlocks()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // the area is big enough to be split into several FFT blocks
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(QRect(100, 100, 900, 500), KoColor(Qt::red, cs));
+    dev->fill(QRect(500, 300, 500, 450), KoColor(Qt::blue, cs));
+    dev->fill(QRect(20, 520, 700, 40), KoColor(Qt::green, cs));
+
+    const QRect applyRect(0, 0, 1200, 800);
+
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix =
+        KisGaussianKernel::createVerticalMatrix(4.0) *
+        KisGaussianKernel::createHorizontalMatrix(6.0);
+
+    KisConvolutionKernelSP kernel =
+        KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum());
+
+    KisPaintDeviceSP spatialDev = new KisPaintDevice(cs);
+    KisConvolutionPainter spatialPainter(spatialDev, KisConvolutionPainter::SPATIAL);
+    spatialPainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                               applyRect.size(), BORDER_REPEAT);
+
+    QImage spatialImage = spatialDev->convertToQImage(0, applyRect);
+
+    // the second pass reuses the cached kernel spectra
+    for (int i = 0; i < 2; i++) {
+        KisPaintDeviceSP fftDev = new KisPaintDevice(cs);
+        KisConvolutionPainter fftPainter(fftDev, KisConvolutionPainter::FFTW);
+        fftPainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(),
+                               applyRect.size(), BORDER_REPEAT);
+
+        QImage fftImage = fftDev->convertToQImage(0, applyRect);
+
+        QPoint pt;
+        QVERIFY(TestUtil::compareQImages(pt, spatialImage, fftImage, 1, 1));
+    }
+}
+
 QTEST_MAIN(KisConvolutionPainterTest)
@@ -56,6 +56,15 @@ private Q_SLOTS:
 
     void testGaussianDetailsSpatial();
     void testGaussianDetailsFFTW();
+
+    void testGaussianRecursive();
+
+    void testSeparableKernel();
+    void testSeparableConvolution();
+    void testSeparableConvolutionExact_data();
+    void testSeparableConvolutionExact();
+
+    void testFFTBlocks();
 };
 
 #endif
@@ -0,0 +1,244 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_filter_result_cache_test.h"
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_random_accessor_ng.h"
+#include "kis_filter_result_cache.h"
+#include "filter/kis_filter.h"
+#include "filter/kis_filter_configuration.h"
+#include "filter/kis_filter_registry.h"
+#include "testutil.h"
+
+
+KisPaintDeviceSP createNoiseDevice(const QRect &rc)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    qsrand(1);
+
+    for (int y = rc.top(); y <= rc.bottom(); y++) {
+        for (int x = rc.left(); x <= rc.right(); x++) {
+            QColor color(qrand() % 256, qrand() % 256, qrand() % 256, 255);
+            dev->setPixel(x, y, color);
+        }
+    }
+
+    return dev;
+}
+
+bool compareResults(KisPaintDeviceSP dev1, KisPaintDeviceSP dev2, const QRect &rc)
+{
+    QPoint pt;
+
+    /**
+     * The filter may round differently when it processes the rect in
+     * several parts, so a difference of one is allowed
+     */
+    if (!TestUtil::compareQImages(pt, dev1->convertToQImage(0, rc), dev2->convertToQImage(0, rc), 1, 1)) {
+        qDebug() << "Images differ at" << pt;
+        return false;
+    }
+
+    return true;
+}
+
+void KisFilterResultCacheTest::testReuse()
+{
+    const QRect rect(-10, 20, 300, 200);
+    KisPaintDeviceSP src = createNoiseDevice(rect);
+
+    KisFilterSP filter = KisFilterRegistry::instance()->value("blur");
+    QVERIFY(filter);
+    KisFilterConfigurationSP config = filter->defaultConfiguration(0);
+
+    KisPaintDeviceSP reference = new KisPaintDevice(src->colorSpace());
+    filter->process(src, reference, 0, rect, config);
+
+    KisFilterResultCache cache;
+
+    KisPaintDeviceSP dst1 = new KisPaintDevice(src->colorSpace());
+    cache.process(filter, src, dst1, rect, config);
+
+    QCOMPARE(cache.hitCount(), 0);
+    QVERIFY(cache.missCount() > 0);
+
+    QPoint pt;
+    QVERIFY(TestUtil::comparePaintDevices(pt, dst1, reference));
+
+    const int numCells = cache.missCount();
+
+    // nothing has changed, so everything comes from the cache
+    KisPaintDeviceSP dst2 = new KisPaintDevice(src->colorSpace());
+    cache.process(filter, src, dst2, rect, config);
+
+    QCOMPARE(cache.hitCount(), numCells);
+    QCOMPARE(cache.missCount(), numCells);
+    QVERIFY(TestUtil::comparePaintDevices(pt, dst2, reference));
+}
+
+void KisFilterResultCacheTest::testPartialChange()
+{
+    const QRect rect(0, 0, 512, 256);
+    KisPaintDeviceSP src = createNoiseDevice(rect);
+
+    KisFilterSP filter = KisFilterRegistry::instance()->value("blur");
+    QVERIFY(filter);
+    KisFilterConfigurationSP config = filter->defaultConfiguration(0);
+
+    KisFilterResultCache cache;
+
+    KisPaintDeviceSP dst = new KisPaintDevice(src->colorSpace());
+    cache.process(filter, src, dst, rect, config);
+
+    const int numCells = cache.missCount();
+
+    /**
+     * The input is compared tile by tile. The needed rects of all the
+     * eight neighbours of the changed cell reach into its tile, so
+     * they are filtered again as well.
+     */
+    src->fill(QRect(290, 160, 4, 4), KoColor(Qt::red, src->colorSpace()));
+    cache.process(filter, src, dst, rect, config);
+
+    QCOMPARE(cache.missCount(), numCells + 9);
+    QCOMPARE(cache.hitCount(), numCells - 9);
+
+    KisPaintDeviceSP reference = new KisPaintDevice(src->colorSpace());
+    filter->process(src, reference, 0, rect, config);
+
+    QVERIFY(compareResults(dst, reference, rect));
+}
+
+void KisFilterResultCacheTest::testWriteDuringProcessing()
+{
+    const QRect rect(0, 0, 512, 256);
+    KisPaintDeviceSP src = createNoiseDevice(rect);
+
+    KisFilterSP filter = KisFilterRegistry::instance()->value("blur");
+    QVERIFY(filter);
+    KisFilterConfigurationSP config = filter->defaultConfiguration(0);
+
+    KisFilterResultCache cache;
+
+    KisPaintDeviceSP dst = new KisPaintDevice(src->colorSpace());
+    cache.process(filter, src, dst, rect, config);
+
+    const int numCells = cache.missCount();
+    const KoColor red(Qt::red, src->colorSpace());
+
+    {
+        /**
+         * The accessor keeps its tile locked for writing until it is
+         * destroyed, so the cache fingerprints the source in the
+         * middle of the write
+         */
+        KisRandomAccessorSP it = src->createRandomAccessorNG(290, 160);
+        memcpy(it->rawData(), red.data(), src->pixelSize());
+
+        cache.process(filter, src, dst, rect, config);
+        QCOMPARE(cache.missCount(), numCells + 9);
+
+        it->moveTo(291, 161);
+        memcpy(it->rawData(), red.data(), src->pixelSize());
+    }
+
+    // the cells fingerprinted during the write are not reused
+    cache.process(filter, src, dst, rect, config);
+
+    QCOMPARE(cache.missCount(), numCells + 18);
+    QCOMPARE(cache.hitCount(), 2 * numCells - 18);
+
+    KisPaintDeviceSP reference = new KisPaintDevice(src->colorSpace());
+    filter->process(src, reference, 0, rect, config);
+
+    QVERIFY(compareResults(dst, reference, rect));
+}
+
+void KisFilterResultCacheTest::testConfigurationChange()
+{
+    const QRect rect(0, 0, 200, 200);
+    KisPaintDeviceSP src = createNoiseDevice(rect);
+
+    KisFilterSP filter = KisFilterRegistry::instance()->value("blur");
+    QVERIFY(filter);
+    KisFilterConfigurationSP config = filter->defaultConfiguration(0);
+
+    KisFilterResultCache cache;
+
+    KisPaintDeviceSP dst = new KisPaintDevice(src->colorSpace());
+    cache.process(filter, src, dst, rect, config);
+
+    const int numCells = cache.missCount();
+
+    config->setProperty("halfWidth", 2);
+    config->setProperty("halfHeight", 2);
+    cache.process(filter, src, dst, rect, config);
+
+    QCOMPARE(cache.hitCount(), 0);
+    QCOMPARE(cache.missCount(), 2 * numCells);
+
+    KisPaintDeviceSP reference = new KisPaintDevice(src->colorSpace());
+    filter->process(src, reference, 0, rect, config);
+
+    QPoint pt;
+    QVERIFY(TestUtil::comparePaintDevices(pt, dst, reference));
+}
+
+void KisFilterResultCacheTest::testSharedMemory()
+{
+    const QRect rect(0, 0, 200, 200);
+    KisPaintDeviceSP src = createNoiseDevice(rect);
+
+    KisFilterSP filter = KisFilterRegistry::instance()->value("blur");
+    QVERIFY(filter);
+    KisFilterConfigurationSP config = filter->defaultConfiguration(0);
+
+    const qint64 initialMemory = KisFilterResultCache::totalMemory();
+
+    KisFilterResultCache cache1;
+    KisPaintDeviceSP dst1 = new KisPaintDevice(src->colorSpace());
+    cache1.process(filter, src, dst1, rect, config);
+
+    const qint64 cache1Memory = KisFilterResultCache::totalMemory() - initialMemory;
+    QVERIFY(cache1Memory >= rect.width() * rect.height() * src->pixelSize());
+
+    {
+        KisFilterResultCache cache2;
+        KisPaintDeviceSP dst2 = new KisPaintDevice(src->colorSpace());
+        cache2.process(filter, src, dst2, rect, config);
+
+        // the caches do not see each other's results
+        QCOMPARE(cache2.hitCount(), 0);
+        QCOMPARE(KisFilterResultCache::totalMemory(), initialMemory + 2 * cache1Memory);
+    }
+
+    // a destroyed cache gives its memory back
+    QCOMPARE(KisFilterResultCache::totalMemory(), initialMemory + cache1Memory);
+
+    cache1.clear();
+    QCOMPARE(KisFilterResultCache::totalMemory(), initialMemory);
+}
+
+QTEST_MAIN(KisFilterResultCacheTest)
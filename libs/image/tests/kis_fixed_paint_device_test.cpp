@@ -20,6 +20,7 @@
 #include <QTest>
 
 #include <QTime>
+#include <QtConcurrent>
 
 #include <KoColorSpace.h>
 #include <KoColor.h>
@@ -37,6 +38,7 @@
 #include "testutil.h"
 #include "kis_transaction.h"
 #include "kis_image.h"
+#include "kis_aligned_buffer_pool.h"
 
 void KisFixedPaintDeviceTest::testCreation()
 {
@@ -367,4 +369,83 @@ void KisFixedPaintDeviceTest::testMirroring()
     }
 }
 
+void KisFixedPaintDeviceTest::testBufferReuse()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // warm up the pool of this thread with two buffers
+    {
+        KisFixedPaintDevice dev(cs);
+        dev.setRect(QRect(0, 0, 100, 100));
+        dev.initialize();
+        KisFixedPaintDevice copy(dev);
+    }
+
+    const qint64 numAllocations = KisAlignedBufferPool::numSystemAllocations();
+
+    KisFixedPaintDevice dev(cs);
+
+    for (int i = 0; i < 100; i++) {
+        const int size = 100 - (i % 7) * 10;
+
+        dev.setRect(QRect(0, 0, size, size));
+        QVERIFY(dev.initialize(i));
+
+        QCOMPARE(quintptr(dev.data()) % KisAlignedBufferPool::ALIGNMENT, quintptr(0));
+        QCOMPARE(dev.data()[size * size * cs->pixelSize() - 1], quint8(i));
+
+        KisFixedPaintDevice copy(dev);
+        QCOMPARE(copy.data()[0], quint8(i));
+    }
+
+    // the buffers of the device and its copies come from the pool
+    QCOMPARE(KisAlignedBufferPool::numSystemAllocations(), numAllocations);
+}
+
+void KisFixedPaintDeviceTest::testBufferReleasedByOtherThread()
+{
+    const int size = 100 * 100 * 4;
+
+    int capacity = 0;
+    quint8 *ptr = KisAlignedBufferPool::allocate(size, &capacity);
+    QVERIFY(ptr);
+
+    // the block goes back to the pool of this thread, not to the worker's one
+    QtConcurrent::run([ptr, capacity] () {
+        KisAlignedBufferPool::release(ptr, capacity);
+    }).waitForFinished();
+
+    const qint64 numAllocations = KisAlignedBufferPool::numSystemAllocations();
+
+    int newCapacity = 0;
+    quint8 *newPtr = KisAlignedBufferPool::allocate(size, &newCapacity);
+
+    QCOMPARE(newPtr, ptr);
+    QCOMPARE(newCapacity, capacity);
+    QCOMPARE(KisAlignedBufferPool::numSystemAllocations(), numAllocations);
+
+    KisAlignedBufferPool::release(newPtr, newCapacity);
+}
+
+void KisFixedPaintDeviceTest::testPooledMemoryLimit()
+{
+    const int size = 4 * 1024 * 1024;
+    const int numBlocks = 2 * KisAlignedBufferPool::MAX_POOLED_MEMORY / size;
+
+    QVector<quint8*> blocks;
+    int capacity = 0;
+
+    for (int i = 0; i < numBlocks; i++) {
+        blocks.append(KisAlignedBufferPool::allocate(size, &capacity));
+        QVERIFY(blocks.last());
+    }
+
+    Q_FOREACH (quint8 *ptr, blocks) {
+        KisAlignedBufferPool::release(ptr, capacity);
+        QVERIFY(KisAlignedBufferPool::pooledMemory() <= KisAlignedBufferPool::MAX_POOLED_MEMORY);
+    }
+
+    QVERIFY(KisAlignedBufferPool::pooledMemory() > 0);
+}
+
 QTEST_MAIN(KisFixedPaintDeviceTest)
@@ -39,6 +39,9 @@ private Q_SLOTS:
     void testBltPerformance();
     void testMirroring_data();
     void testMirroring();
+    void testBufferReuse();
+    void testBufferReleasedByOtherThread();
+    void testPooledMemoryLimit();
 };
 
 #endif
@@ -188,4 +188,73 @@ void KisOnionSkinCompositorTest::testSettings()
     QVERIFY(result == expected);
 }
 
+void KisOnionSkinCompositorTest::testTintedFramesCache()
+{
+    KisImageConfig config;
+    config.setOnionSkinTintFactor(64);
+    config.setOnionSkinTintColorBackward(Qt::blue);
+    config.setOnionSkinTintColorForward(Qt::red);
+    config.setNumberOfOnionSkins(2);
+    config.setOnionSkinOpacity(-2, 64);
+    config.setOnionSkinOpacity(-1, 128);
+    config.setOnionSkinOpacity(1, 128);
+    config.setOnionSkinOpacity(2, 64);
+
+    KisOnionSkinCompositor *compositor = KisOnionSkinCompositor::instance();
+    compositor->configChanged();
+
+    TestUtil::MaskParent p;
+    KisImageAnimationInterface *i = p.image->animationInterface();
+    KisPaintDeviceSP paintDevice = p.layer->paintDevice();
+    KisKeyframeChannel *keyframes = paintDevice->keyframeChannel();
+
+    keyframes->addKeyframe(0);
+    keyframes->addKeyframe(1);
+    keyframes->addKeyframe(2);
+    keyframes->addKeyframe(3);
+
+    paintDevice->fill(QRect(0,0,256,256), KoColor(Qt::red, paintDevice->colorSpace()));
+
+    i->switchCurrentTimeAsync(1);
+    p.image->waitForDone();
+    paintDevice->fill(QRect(128,0,256,256), KoColor(Qt::green, paintDevice->colorSpace()));
+
+    i->switchCurrentTimeAsync(2);
+    p.image->waitForDone();
+    paintDevice->fill(QRect(0,128,256,256), KoColor(Qt::blue, paintDevice->colorSpace()));
+
+    i->switchCurrentTimeAsync(3);
+    p.image->waitForDone();
+    paintDevice->fill(QRect(128,128,256,256), KoColor(Qt::white, paintDevice->colorSpace()));
+
+    const QRect rect(0,0,512,512);
+    KisOnionSkinCompositor::TintedFramesCache cache;
+
+    for (int time = 0; time <= 3; time++) {
+        i->switchCurrentTimeAsync(time);
+        p.image->waitForDone();
+
+        KisPaintDeviceSP expectedComposite = new KisPaintDevice(p.image->colorSpace());
+        compositor->composite(paintDevice, expectedComposite, rect);
+
+        KisPaintDeviceSP cachedComposite = new KisPaintDevice(p.image->colorSpace());
+        compositor->composite(paintDevice, cachedComposite, rect, &cache);
+
+        QPoint pt;
+        QVERIFY(TestUtil::compareQImages(pt,
+                                         expectedComposite->convertToQImage(0, rect),
+                                         cachedComposite->convertToQImage(0, rect),
+                                         1, 1));
+
+        /**
+         * Only the skins used for the current frame are kept in the
+         * cache, and the active frame is never one of them
+         */
+        const int lastFrame = keyframes->keyframeCount() - 1;
+        const int skinsBackward = qMin(time, 2);
+        const int skinsForward = qMin(lastFrame - time, 2);
+        QCOMPARE(cache.size(), skinsBackward + skinsForward);
+    }
+}
+
 QTEST_MAIN(KisOnionSkinCompositorTest)
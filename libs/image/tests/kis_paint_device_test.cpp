@@ -20,6 +20,7 @@
 #include <QTest>
 
 #include <QTime>
+#include <QBuffer>
 
 #include <KoColor.h>
 #include <KoColorSpace.h>
@@ -2182,6 +2183,66 @@ void KisPaintDeviceTest::testCopyPaintDeviceWithFrames()
     QVERIFY(channel->keyframeAt(10));
 }
 
+class KisBufferPaintDeviceWriter : public KisPaintDeviceWriter {
+public:
+    KisBufferPaintDeviceWriter(QIODevice *device)
+        : m_device(device)
+    {
+    }
+
+    bool write(const QByteArray &data) override {
+        return (m_device->write(data) == data.size());
+    }
+
+    bool write(const char* data, qint64 length) override {
+        return (m_device->write(data, length) == length);
+    }
+
+    QIODevice *m_device;
+};
+
+void KisPaintDeviceTest::testFramesDeltaWriteRead()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    TestUtil::TestingTimedDefaultBounds *bounds = new TestUtil::TestingTimedDefaultBounds();
+    dev->setDefaultBounds(bounds);
+
+    KisRasterKeyframeChannel *channel = dev->createKeyframeChannel(KisKeyframeChannel::Content);
+    KisPaintDeviceFramesInterface *i = dev->framesInterface();
+    QVERIFY(channel);
+    QVERIFY(i);
+
+    fillRect(dev, 10, QRect(100,100,200,100), bounds);
+    fillRect(dev, 20, QRect(200,100,200,100), bounds);
+
+    const int baseFrameId = channel->frameIdAt(10);
+    const int frameId = channel->frameIdAt(20);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+
+    KisBufferPaintDeviceWriter writer(&buffer);
+    QVERIFY(i->writeFrameDelta(writer, frameId, baseFrameId));
+
+    // the loaded frame should reproduce frame 20, including the
+    // tiles that are present in the base frame only
+    KUndo2Command parentCommand;
+    channel->addKeyframe(30, &parentCommand);
+    const int loadedFrameId = channel->frameIdAt(30);
+
+    buffer.seek(0);
+    QVERIFY(i->readFrameDelta(&buffer, loadedFrameId, baseFrameId));
+
+    QVERIFY(checkRect(dev, 10, QRect(100,100,200,100), bounds));
+    QVERIFY(checkRect(dev, 20, QRect(200,100,200,100), bounds));
+    QVERIFY(checkRect(dev, 30, QRect(200,100,200,100), bounds));
+
+    // the tiles of the base frame are dropped, not loaded as default ones
+    QCOMPARE(i->frameBounds(loadedFrameId), i->frameBounds(frameId));
+}
+
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/variance.hpp>
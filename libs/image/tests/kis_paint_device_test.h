@@ -77,6 +77,7 @@ private Q_SLOTS:
     void testCrossDeviceFrameCopyChannel();
     void testLazyFrameCreation();
     void testCopyPaintDeviceWithFrames();
+    void testFramesDeltaWriteRead();
 
     void testCompositionAssociativity();
 };
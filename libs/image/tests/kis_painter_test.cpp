@@ -479,6 +479,113 @@ void KisPainterTest::testBitBltOldData()
     srcGc.deleteTransaction();
 }
 
+void paintDabs(KisPaintDeviceSP dst, bool useBatch, QVector<QRect> *dirtyRects)
+{
+    const KoColorSpace *cs = dst->colorSpace();
+
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+    dab->setRect(QRect(0, 0, 21, 21));
+    dab->initialize();
+
+    KisPainter gc(dst);
+    if (useBatch) {
+        gc.beginDabBatch();
+    }
+
+    // the dabs overlap each other and cross the tile borders
+    for (int i = 0; i < 60; i++) {
+        KoColor color(i % 2 ? Qt::red : Qt::blue, cs);
+        color.setOpacity(quint8(100 + i));
+
+        // the dab is changed right after being painted
+        dab->fill(0, 0, 21, 21, color.data());
+
+        gc.setOpacity(quint8(255 - 2 * i));
+        gc.bltFixed(QPoint(40 + 3 * i, 50 + i), dab, dab->bounds());
+    }
+
+    if (useBatch) {
+        gc.endDabBatch();
+    }
+
+    *dirtyRects = gc.takeDirtyRegion();
+}
+
+void KisPainterTest::testBltFixedDabBatch()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    KisPaintDeviceSP dst1 = new KisPaintDevice(cs);
+    KisPaintDeviceSP dst2 = new KisPaintDevice(cs);
+
+    QVector<QRect> dirtyRects1;
+    QVector<QRect> dirtyRects2;
+
+    paintDabs(dst1, false, &dirtyRects1);
+    paintDabs(dst2, true, &dirtyRects2);
+
+    QCOMPARE(dirtyRects2, dirtyRects1);
+    QCOMPARE(dst2->exactBounds(), dst1->exactBounds());
+
+    const QRect rc = dst1->exactBounds();
+    QPoint errpoint;
+
+    // the composite ops may round differently for the split rows
+    if (!TestUtil::compareQImages(errpoint,
+                                  dst1->convertToQImage(0, rc),
+                                  dst2->convertToQImage(0, rc), 1, 1)) {
+        QFAIL(QString("Batched dabs differ from the plain ones at %1,%2").arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+    }
+}
+
+void KisPainterTest::testBltFixedParallelBands()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    /**
+     * Big enough to be split into bands. The odd width puts the rows of
+     * the bands at different offsets from the alignment.
+     */
+    const QRect dabRect(0, 0, 1501, 1300);
+
+    KisFixedPaintDeviceSP dab = new KisFixedPaintDevice(cs);
+    dab->setRect(dabRect);
+    dab->initialize();
+
+    qsrand(17);
+    quint8 *data = dab->data();
+    for (int i = 0; i < dabRect.width() * dabRect.height() * cs->pixelSize(); i++) {
+        data[i] = quint8(qrand());
+    }
+
+    KisPaintDeviceSP dst1 = new KisPaintDevice(cs);
+    KisPaintDeviceSP dst2 = new KisPaintDevice(cs);
+    dst1->fill(QRect(0, 0, 1700, 1500), KoColor(Qt::green, cs));
+    dst2->fill(QRect(0, 0, 1700, 1500), KoColor(Qt::green, cs));
+
+    // the dab is not aligned to the tiles
+    const QPoint pos(37, 101);
+
+    KisPainter gc1(dst1);
+    gc1.setOpacity(150);
+    gc1.bltFixed(pos, dab, dabRect);
+    QCOMPARE(gc1.takeDirtyRegion(), QVector<QRect>() << dabRect.translated(pos));
+
+    KisPainter gc2(dst2);
+    gc2.setOpacity(150);
+    gc2.setParallelBltFixedEnabled(false);
+    gc2.bltFixed(pos, dab, dabRect);
+
+    const QRect rc = dst1->exactBounds();
+    QCOMPARE(dst2->exactBounds(), rc);
+
+    // the bands must be byte-exact, not just close
+    QPoint errpoint;
+    if (!TestUtil::comparePaintDevices(errpoint, dst1, dst2)) {
+        QFAIL(QString("Parallel bands differ from the serial blit at %1,%2").arg(errpoint.x()).arg(errpoint.y()).toLatin1());
+    }
+}
+
 void KisPainterTest::benchmarkBitBlt()
 {
     quint8 p = 128;
@@ -51,6 +51,8 @@ private Q_SLOTS:
     void testSelectionBitBltEraseCompositeOp();
 
     void testBitBltOldData();
+    void testBltFixedDabBatch();
+    void testBltFixedParallelBands();
     void benchmarkBitBlt();
     void benchmarkBitBltOldData();
 
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_recorded_stroke_test.h"
+
+#include <QTest>
+#include <QDir>
+
+#include "recorder/kis_recorded_stroke.h"
+
+
+void KisRecordedStrokeTest::testSaveLoad()
+{
+    QVector<KisRecordedStroke> strokes(2);
+
+    for (int i = 0; i < 10; i++) {
+        strokes[0].addEvent(KisPaintInformation(QPointF(10.5 + i, 20), 0.1 * i,
+                                                 15, -30, 90 + i, 0.0, 1.0, 5.0 * i, 0.25));
+    }
+    strokes[1].addEvent(KisPaintInformation(QPointF(100, 200), 0.75));
+
+    QCOMPARE(strokes[0].duration(), 45.0);
+
+    const QString fileName = QString(FILES_OUTPUT_DIR) + QDir::separator() + "recorded_strokes.kstroke";
+    QVERIFY(KisRecordedStroke::save(fileName, strokes));
+
+    bool ok = false;
+    const QVector<KisRecordedStroke> loaded = KisRecordedStroke::load(fileName, &ok);
+    QVERIFY(ok);
+    QCOMPARE(loaded.size(), 2);
+    QCOMPARE(loaded[0].events().size(), 10);
+    QCOMPARE(loaded[1].events().size(), 1);
+
+    for (int i = 0; i < 10; i++) {
+        const KisPaintInformation &pi = loaded[0].events()[i];
+        const KisPaintInformation &ref = strokes[0].events()[i];
+
+        QCOMPARE(pi.pos(), ref.pos());
+        QCOMPARE(pi.pressure(), ref.pressure());
+        QCOMPARE(pi.xTilt(), ref.xTilt());
+        QCOMPARE(pi.yTilt(), ref.yTilt());
+        QCOMPARE(pi.rotation(), ref.rotation());
+        QCOMPARE(pi.currentTime(), ref.currentTime());
+        QCOMPARE(pi.drawingSpeed(), ref.drawingSpeed());
+    }
+
+    QCOMPARE(loaded[1].events()[0].pos(), QPointF(100, 200));
+    QCOMPARE(loaded[1].events()[0].pressure(), 0.75);
+}
+
+void KisRecordedStrokeTest::testLoadBrokenFile()
+{
+    bool ok = true;
+    QVector<KisRecordedStroke> loaded =
+        KisRecordedStroke::load(QString(FILES_OUTPUT_DIR) + QDir::separator() + "no_such_file.kstroke", &ok);
+
+    QVERIFY(!ok);
+    QVERIFY(loaded.isEmpty());
+}
+
+QTEST_MAIN(KisRecordedStrokeTest)
@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_sliding_histogram_filter_test.h"
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_global.h"
+#include "kis_paint_device.h"
+#include "kis_random_accessor_ng.h"
+#include "kis_sliding_histogram_filter.h"
+#include "testutil.h"
+
+
+KisPaintDeviceSP createNoiseDevice(const QRect &rc)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    qsrand(1);
+
+    for (int y = rc.top(); y <= rc.bottom(); y++) {
+        for (int x = rc.left(); x <= rc.right(); x++) {
+            QColor color(qrand() % 256, qrand() % 256, qrand() % 256, 128 + qrand() % 128);
+            dev->setPixel(x, y, color);
+        }
+    }
+
+    return dev;
+}
+
+/**
+ * Straightforward implementation of the same statistics: builds
+ * the histogram of the whole window for every pixel
+ */
+KisPaintDeviceSP bruteForceFilter(KisPaintDeviceSP src, const QRect &rc,
+                                  int radius, int numBins,
+                                  KisSlidingHistogramFilter::Statistic statistic)
+{
+    const KoColorSpace *cs = src->colorSpace();
+    const int numChannels = cs->channelCount();
+    const qreal scale = (numBins - 1) / 255.0;
+
+    KisPaintDeviceSP dst = new KisPaintDevice(cs);
+    QVector<float> channels(numChannels);
+
+    for (int y = rc.top(); y <= rc.bottom(); y++) {
+        for (int x = rc.left(); x <= rc.right(); x++) {
+            QVector<int> counts(numBins);
+            QVector<double> sums(numBins * numChannels);
+
+            for (int j = y - radius; j <= y + radius; j++) {
+                for (int i = x - radius; i <= x + radius; i++) {
+                    KisRandomConstAccessorSP it = src->createRandomConstAccessorNG(i, j);
+                    const int bin = int(cs->intensity8(it->rawDataConst()) * scale);
+
+                    cs->normalisedChannelsValue(it->rawDataConst(), channels);
+                    counts[bin]++;
+                    for (int k = 0; k < numChannels; k++) {
+                        sums[bin * numChannels + k] += channels[k];
+                    }
+                }
+            }
+
+            int bin = 0;
+
+            if (statistic == KisSlidingHistogramFilter::MostFrequent) {
+                for (int i = 0; i < numBins; i++) {
+                    if (counts[i] > counts[bin]) bin = i;
+                }
+            } else {
+                const int half = (pow2(2 * radius + 1) + 1) / 2;
+                int accumulated = 0;
+                for (bin = 0; bin < numBins; bin++) {
+                    accumulated += counts[bin];
+                    if (accumulated >= half) break;
+                }
+            }
+
+            for (int k = 0; k < numChannels; k++) {
+                channels[k] = sums[bin * numChannels + k] / counts[bin];
+            }
+
+            KisRandomAccessorSP dstIt = dst->createRandomAccessorNG(x, y);
+            cs->fromNormalisedChannelsValue(dstIt->rawData(), channels);
+        }
+    }
+
+    return dst;
+}
+
+void testFilter(KisSlidingHistogramFilter::Statistic statistic,
+                const QRect &rc = QRect(10, 20, 150, 100),
+                int radius = 3)
+{
+    const int numBins = 16;
+
+    KisPaintDeviceSP src = createNoiseDevice(rc.adjusted(-radius, -radius, radius, radius));
+    KisPaintDeviceSP dst = new KisPaintDevice(src->colorSpace());
+
+    KisSlidingHistogramFilter filter(radius, numBins, statistic);
+    filter.apply(src, dst, rc);
+
+    KisPaintDeviceSP reference = bruteForceFilter(src, rc, radius, numBins, statistic);
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt,
+                                     reference->convertToQImage(0, rc),
+                                     dst->convertToQImage(0, rc),
+                                     1, 1));
+}
+
+void KisSlidingHistogramFilterTest::testMostFrequent()
+{
+    testFilter(KisSlidingHistogramFilter::MostFrequent);
+}
+
+void KisSlidingHistogramFilterTest::testMedian()
+{
+    testFilter(KisSlidingHistogramFilter::Median);
+}
+
+void KisSlidingHistogramFilterTest::testWideStrips()
+{
+    // the strips get wider than a tile for big radii
+    testFilter(KisSlidingHistogramFilter::Median, QRect(-30, 15, 300, 90), 12);
+}
+
+void KisSlidingHistogramFilterTest::testInPlace()
+{
+    const QRect rc(0, 0, 200, 150);
+    const int radius = 5;
+
+    KisPaintDeviceSP src = createNoiseDevice(rc.adjusted(-radius, -radius, radius, radius));
+    KisPaintDeviceSP dev = new KisPaintDevice(*src);
+    KisPaintDeviceSP dst = new KisPaintDevice(src->colorSpace());
+
+    KisSlidingHistogramFilter filter(radius, 31, KisSlidingHistogramFilter::MostFrequent);
+    filter.apply(src, dst, rc);
+    filter.apply(dev, dev, rc);
+
+    QPoint pt;
+    QVERIFY(TestUtil::compareQImages(pt,
+                                     dst->convertToQImage(0, rc),
+                                     dev->convertToQImage(0, rc)));
+}
+
+QTEST_MAIN(KisSlidingHistogramFilterTest)
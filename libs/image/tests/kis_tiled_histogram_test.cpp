@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tiled_histogram_test.h"
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include "kis_paint_device.h"
+#include "kis_tiled_histogram.h"
+
+
+KisPaintDeviceSP createNoiseDevice(const QRect &rc)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    qsrand(1);
+
+    for (int y = rc.top(); y <= rc.bottom(); y++) {
+        for (int x = rc.left(); x <= rc.right(); x++) {
+            QColor color(qrand() % 256, qrand() % 256, qrand() % 256, qrand() % 256);
+            dev->setPixel(x, y, color);
+        }
+    }
+
+    return dev;
+}
+
+KisTiledHistogram::Bins bruteForceHistogram(KisPaintDeviceSP dev, const QRect &rc)
+{
+    const KoColorSpace *cs = dev->colorSpace();
+    const int pixelSize = cs->pixelSize();
+    const int channelCount = cs->channelCount();
+
+    KisTiledHistogram::Bins bins(channelCount, std::vector<quint32>(256, 0));
+
+    QByteArray buffer(rc.width() * rc.height() * pixelSize, 0);
+    dev->readBytes(reinterpret_cast<quint8*>(buffer.data()), rc);
+
+    const quint8 *pixel = reinterpret_cast<const quint8*>(buffer.constData());
+    for (int i = 0; i < rc.width() * rc.height(); i++) {
+        for (int chan = 0; chan < channelCount; chan++) {
+            bins[chan][cs->scaleToU8(pixel, chan)]++;
+        }
+        pixel += pixelSize;
+    }
+
+    return bins;
+}
+
+void KisTiledHistogramTest::testFull()
+{
+    // not aligned to the cells on purpose
+    const QRect bounds(-10, -20, 600, 400);
+    KisPaintDeviceSP dev = createNoiseDevice(bounds);
+
+    KisTiledHistogram histogram;
+    QVERIFY(histogram.calculate(dev, bounds) == bruteForceHistogram(dev, bounds));
+}
+
+void KisTiledHistogramTest::testIncremental()
+{
+    const QRect bounds(0, 0, 600, 400);
+    KisPaintDeviceSP dev = createNoiseDevice(bounds);
+
+    KisTiledHistogram histogram;
+    const KisTiledHistogram::Bins initial = histogram.calculate(dev, bounds);
+    QVERIFY(initial == bruteForceHistogram(dev, bounds));
+
+    const QRect changeRect(100, 300, 50, 70);
+    dev->fill(changeRect, KoColor(Qt::red, dev->colorSpace()));
+
+    // the unchanged cells come from the cache...
+    QVERIFY(histogram.calculate(dev, bounds) == initial);
+
+    // ... and only the invalidated ones are read again
+    histogram.invalidate(changeRect);
+    QVERIFY(histogram.calculate(dev, bounds) == bruteForceHistogram(dev, bounds));
+}
+
+void KisTiledHistogramTest::testSampling()
+{
+    const QRect bounds(0, 0, 2 * KisTiledHistogram::CELL_SIZE, 300);
+    KisPaintDeviceSP dev = createNoiseDevice(bounds);
+
+    const int step = 3;
+
+    KisTiledHistogram histogram;
+    const KisTiledHistogram::Bins bins = histogram.calculate(dev, bounds, step);
+
+    // every cell is sampled from its own top-left corner
+    const int cellSamples = (KisTiledHistogram::CELL_SIZE + step - 1) / step;
+    const int lastRowSamples = (300 - KisTiledHistogram::CELL_SIZE + step - 1) / step;
+    const quint32 expectedCount = 2 * cellSamples * (cellSamples + lastRowSamples);
+
+    for (const std::vector<quint32> &channel : bins) {
+        quint32 count = 0;
+        for (quint32 value : channel) {
+            count += value;
+        }
+        QCOMPARE(count, expectedCount);
+    }
+}
+
+QTEST_MAIN(KisTiledHistogramTest)
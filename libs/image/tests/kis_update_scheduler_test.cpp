@@ -411,6 +411,62 @@ void KisUpdateSchedulerTest::testTimeMonitor()
     KisUpdateTimeMonitor::instance()->endStrokeMeasure();
 }
 
+void KisUpdateSchedulerTest::testEventLatency()
+{
+    KisUpdateTimeMonitor *monitor = KisUpdateTimeMonitor::instance();
+
+    // the monitor does nothing unless the performance log is enabled
+    const bool loggingEnabled = monitor->loggingEnabled();
+    monitor->setLoggingEnabled(true);
+
+    monitor->startStrokeMeasure();
+
+    // the events come within the same millisecond
+    const qint64 event1 = monitor->registerEvent(1000);
+    const qint64 event2 = monitor->registerEvent(1000);
+
+    QVERIFY(event1 >= 0);
+    QVERIFY(event2 >= 0);
+    QVERIFY(event1 != event2);
+
+    monitor->reportEventPainted(event1, QVector<QRect>() << QRect(0,0,10,10) << QRect(100,0,10,10));
+    monitor->reportEventPainted(event2, QVector<QRect>() << QRect(100,0,10,10));
+
+    // the first event is only partially merged into the projection
+    QCOMPARE(monitor->takeUpdatedEvents(QRect(90,0,30,30)), QVector<qint64>() << event2);
+
+    // the second painting of an event with LoD is ignored
+    monitor->reportEventPainted(event2, QVector<QRect>() << QRect(100,0,10,10));
+
+    QCOMPARE(monitor->takeUpdatedEvents(QRect(0,0,50,50)), QVector<qint64>() << event1);
+
+    QVERIFY(monitor->takeUpdatedEvents(QRect(0,0,200,200)).isEmpty());
+
+    // the unknown ids are skipped
+    monitor->reportEventsUploaded(QVector<qint64>() << event1 << event2 << event2 + 100);
+
+    int numEvents = 0;
+    Q_FOREACH (int count, monitor->latencyHistogram()) {
+        numEvents += count;
+    }
+
+    QCOMPARE(monitor->latencyHistogram().size(), int(KisUpdateTimeMonitor::NUM_LATENCY_BUCKETS));
+    QCOMPARE(numEvents, 2);
+
+    // every event is counted only once
+    monitor->reportEventsUploaded(QVector<qint64>() << event1);
+    numEvents = 0;
+    Q_FOREACH (int count, monitor->latencyHistogram()) {
+        numEvents += count;
+    }
+    QCOMPARE(numEvents, 2);
+
+    monitor->endStrokeMeasure();
+    monitor->setLoggingEnabled(loggingEnabled);
+
+    QCOMPARE(monitor->registerEvent(1000), loggingEnabled ? event2 + 1 : -1);
+}
+
 void KisUpdateSchedulerTest::testLodSync()
 {
     KisImageSP image = buildTestingImage();
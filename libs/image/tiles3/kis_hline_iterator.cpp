@@ -163,7 +163,7 @@ KisHLineIterator2::~KisHLineIterator2()
 {
     for (uint i = 0; i < m_tilesCacheSize; i++) {
         unlockTile(m_tilesCache[i].tile);
-        unlockTile(m_tilesCache[i].oldtile);
+        unlockOldTile(m_tilesCache[i].oldtile);
     }
 }
 
@@ -217,7 +217,7 @@ void KisHLineIterator2::preallocateTiles()
 {
     for (quint32 i = 0; i < m_tilesCacheSize; ++i){
         unlockTile(m_tilesCache[i].tile);
-        unlockTile(m_tilesCache[i].oldtile);
+        unlockOldTile(m_tilesCache[i].oldtile);
         fetchTileDataForCache(m_tilesCache[i], m_leftCol + i, m_row);
     }
 }
@@ -58,6 +58,13 @@ private:
     }
 
     inline void unlockTile(KisTileSP &tile) {
+        if (m_writable)
+            tile->unlockForWrite();
+        else
+            tile->unlock();
+    }
+
+    inline void unlockOldTile(KisTileSP &tile) {
         tile->unlock();
     }
 
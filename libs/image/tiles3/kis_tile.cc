@@ -199,6 +199,8 @@ void KisTile::lockForWrite()
         m_COWMutex.unlock();
     }
 
+    m_tileData->bumpVersion();
+
     DEBUG_LOG_ACTION("lock [W]");
 }
 
@@ -208,6 +210,19 @@ void KisTile::unlock() const
     DEBUG_LOG_ACTION("unlock");
 }
 
+void KisTile::unlockForWrite()
+{
+    /**
+     * The stamp is bumped once more when the write has completed,
+     * so a reader that fetched the version in the middle of the write
+     * will never see it matching the final pixels.
+     */
+    m_tileData->bumpVersion();
+
+    unblockSwapping();
+    DEBUG_LOG_ACTION("unlock [W]");
+}
+
 
 #include <stdio.h>
 void KisTile::debugPrintInfo()
@@ -74,6 +74,7 @@ public:
     void lockForRead() const;
     void lockForWrite();
     void unlock() const;
+    void unlockForWrite();
 
     /* this allows us work directly on tile's data */
     inline quint8 *data() const {
@@ -35,11 +35,14 @@ typedef boost::singleton_pool<KisTileData, TILE_SIZE_8BPP, boost::default_user_a
 const qint32 KisTileData::WIDTH = __TILE_DATA_WIDTH;
 const qint32 KisTileData::HEIGHT = __TILE_DATA_HEIGHT;
 
+static QAtomicInteger<quint64> s_lastTileDataVersion(0);
+
 
 KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store)
     : m_state(NORMAL),
       m_mementoFlag(0),
       m_age(0),
+      m_version(s_lastTileDataVersion.fetchAndAddRelaxed(1) + 1),
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(pixelSize),
@@ -67,6 +70,7 @@ KisTileData::KisTileData(const KisTileData& rhs, bool checkFreeMemory)
     : m_state(NORMAL),
       m_mementoFlag(0),
       m_age(0),
+      m_version(s_lastTileDataVersion.fetchAndAddRelaxed(1) + 1),
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(rhs.m_pixelSize),
@@ -86,6 +90,11 @@ KisTileData::~KisTileData()
     releaseMemory();
 }
 
+void KisTileData::bumpVersion()
+{
+    m_version.store(s_lastTileDataVersion.fetchAndAddRelaxed(1) + 1);
+}
+
 void KisTileData::fillWithPixel(const quint8 *defPixel)
 {
     quint8 *it = m_data;
@@ -133,5 +133,9 @@ inline qint32 KisTileData::numUsers() const {
     return m_usersCount;
 }
 
+inline quint64 KisTileData::version() const {
+    return m_version.load();
+}
+
 #endif /* KIS_TILE_DATA_H_ */
 
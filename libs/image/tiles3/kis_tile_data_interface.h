@@ -139,6 +139,16 @@ public:
      */
      inline bool historical() const;
 
+    /**
+     * Returns a process-wide unique stamp of the content of the tile
+     * data. A new stamp is assigned when the tile data is created and
+     * every time its tile is locked and unlocked for writing, so equal
+     * stamps always mean equal pixels, even when the stamp has been
+     * read while the write was still in progress. Unlike the address
+     * of the tile data, the stamp is never reused.
+     */
+    inline quint64 version() const;
+
     /**
      * Used for swapping purposes only.
      * Frees the memory occupied by the tile data.
@@ -169,6 +179,7 @@ public:
 
 private:
     void fillWithPixel(const quint8 *defPixel);
+    void bumpVersion();
 
     static quint8* allocateData(const qint32 pixelSize);
     static void freeData(quint8 *ptr, const qint32 pixelSize);
@@ -229,6 +240,11 @@ private:
     //FIXME: make memory aligned
     int m_age;
 
+    /**
+     * The stamp of the current content, see version()
+     */
+    QAtomicInteger<quint64> m_version;
+
 
     /**
      * The primitive for controlling swapping of the tile.
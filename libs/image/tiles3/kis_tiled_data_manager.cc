@@ -130,19 +130,27 @@ bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
     }
 
 
-    KisTileHashTableIterator iter(m_hashTable);
-    KisTileSP tile;
+    QVector<KisTileSP> tiles;
+    tiles.reserve(m_hashTable->numTiles());
+
+    {
+        KisTileHashTableIterator iter(m_hashTable);
+        KisTileSP tile;
+
+        while ((tile = iter.tile())) {
+            tiles.append(tile);
+            ++iter;
+        }
+    }
 
     KisAbstractTileCompressorSP compressor =
         KisTileCompressorFactory::create(CURRENT_VERSION);
 
-    while ((tile = iter.tile())) {
-        retval = compressor->writeTile(tile, store);
+    if (retval) {
+        retval = compressor->writeTiles(tiles, store);
         if (!retval) {
-            warnFile << "Failed to write tile";
-            break;
+            warnFile << "Failed to write tiles";
         }
-        ++iter;
     }
 
     return retval;
@@ -152,6 +160,11 @@ bool KisTiledDataManager::read(QIODevice *stream)
     if (!stream) return false;
     clear();
 
+    return readTilesImpl(stream);
+}
+
+bool KisTiledDataManager::readTilesImpl(QIODevice *stream)
+{
     QWriteLocker locker(&m_lock);
     KisMementoSP nothing = m_mementoManager->getMemento();
 
@@ -185,17 +198,186 @@ bool KisTiledDataManager::read(QIODevice *stream)
     KisAbstractTileCompressorSP compressor =
         KisTileCompressorFactory::create(tilesVersion);
 
-    bool readSuccess = true;
-    for (quint32 i = 0; i < numTiles; i++) {
-        if (!compressor->readTile(stream, this)) {
-            readSuccess = false;
-        }
-    }
+    bool readSuccess = compressor->readTiles(stream, this, numTiles);
 
     m_mementoManager->commit();
     return readSuccess;
 }
 
+inline bool sameTileContent(KisTileSP tile, KisTileSP baseTile, qint32 pixelSize)
+{
+    tile->lockForRead();
+    baseTile->lockForRead();
+
+    const bool result =
+        tile->tileData() == baseTile->tileData() ||
+        !memcmp(tile->data(), baseTile->data(),
+                pixelSize * KisTileData::WIDTH * KisTileData::HEIGHT);
+
+    baseTile->unlock();
+    tile->unlock();
+
+    return result;
+}
+
+inline bool defaultTileContent(KisTileSP tile, KisTileData *defaultTileData, qint32 pixelSize)
+{
+    tile->lockForRead();
+
+    const bool result =
+        tile->tileData() == defaultTileData ||
+        !memcmp(tile->data(), defaultTileData->data(),
+                pixelSize * KisTileData::WIDTH * KisTileData::HEIGHT);
+
+    tile->unlock();
+
+    return result;
+}
+
+bool KisTiledDataManager::writeDelta(KisPaintDeviceWriter &store, KisTiledDataManager *baseDM)
+{
+    KIS_ASSERT_RECOVER(baseDM && baseDM != this &&
+                       baseDM->pixelSize() == pixelSize()) {
+        return write(store);
+    }
+
+    QReadLocker locker(&m_lock);
+    QReadLocker baseLocker(&baseDM->m_lock);
+
+    QVector<KisTileSP> changedTiles;
+    QVector<QPoint> removedTiles;
+
+    {
+        KisTileData *defaultTileData = m_hashTable->defaultTileData();
+        defaultTileData->blockSwapping();
+
+        KisTileHashTableIterator iter(m_hashTable);
+        KisTileSP tile;
+
+        while ((tile = iter.tile())) {
+            KisTileSP baseTile = baseDM->m_hashTable->getExistedTile(tile->col(), tile->row());
+
+            /**
+             * A tile filled with the default pixel is never written,
+             * it only has to drop the tile of the base, if any
+             */
+            if (defaultTileContent(tile, defaultTileData, pixelSize())) {
+                if (baseTile) {
+                    removedTiles.append(tile->extent().topLeft());
+                }
+            } else if (!baseTile || !sameTileContent(tile, baseTile, pixelSize())) {
+                changedTiles.append(tile);
+            }
+            ++iter;
+        }
+
+        defaultTileData->unblockSwapping();
+    }
+
+    {
+        KisTileHashTableIterator iter(baseDM->m_hashTable);
+        KisTileSP baseTile;
+
+        while ((baseTile = iter.tile())) {
+            if (!m_hashTable->tileExists(baseTile->col(), baseTile->row())) {
+                removedTiles.append(baseTile->extent().topLeft());
+            }
+            ++iter;
+        }
+    }
+
+    bool retval = writeTilesHeader(store, changedTiles.size());
+
+    KisAbstractTileCompressorSP compressor =
+        KisTileCompressorFactory::create(CURRENT_VERSION);
+
+    if (retval) {
+        retval = compressor->writeTiles(changedTiles, store);
+        if (!retval) {
+            warnFile << "Failed to write tiles";
+        }
+    }
+
+    if (retval) {
+        QString buffer = QString("REMOVED %1\n").arg(removedTiles.size());
+        Q_FOREACH (const QPoint &pt, removedTiles) {
+            buffer += QString("%1,%2\n").arg(pt.x()).arg(pt.y());
+        }
+
+        retval = store.write(buffer.toLatin1());
+        if (!retval) {
+            warnFile << "Failed to write removed tiles";
+        }
+    }
+
+    return retval;
+}
+
+bool KisTiledDataManager::readDelta(QIODevice *stream, KisTiledDataManager *baseDM)
+{
+    if (!stream) return false;
+    clear();
+
+    KIS_ASSERT_RECOVER(baseDM && baseDM != this &&
+                       baseDM->pixelSize() == pixelSize()) {
+        return readTilesImpl(stream);
+    }
+
+    {
+        QWriteLocker locker(&m_lock);
+        QReadLocker baseLocker(&baseDM->m_lock);
+
+        KisTileHashTableIterator iter(baseDM->m_hashTable);
+        KisTileSP baseTile;
+
+        while ((baseTile = iter.tile())) {
+            baseTile->lockForRead();
+            KisTileData *td = baseTile->tileData();
+            KisTileSP clonedTile = KisTileSP(new KisTile(baseTile->col(), baseTile->row(), td, m_mementoManager));
+            baseTile->unlock();
+
+            m_hashTable->addTile(clonedTile);
+            updateExtent(baseTile->col(), baseTile->row());
+            ++iter;
+        }
+    }
+
+    if (!readTilesImpl(stream)) {
+        return false;
+    }
+
+    const qint32 maxLineLength = 79;
+    QList<QByteArray> lineItems = stream->readLine(maxLineLength).trimmed().split(' ');
+
+    if (lineItems.size() != 2 || lineItems.first() != "REMOVED") {
+        warnFile << "Corrupted list of removed tiles";
+        return false;
+    }
+
+    const int numRemovedTiles = lineItems.last().toInt();
+
+    QWriteLocker locker(&m_lock);
+
+    for (int i = 0; i < numRemovedTiles; i++) {
+        QList<QByteArray> pointItems = stream->readLine(maxLineLength).trimmed().split(',');
+
+        if (pointItems.size() != 2) {
+            warnFile << "Corrupted removed tile" << i;
+            recalculateExtent();
+            return false;
+        }
+
+        const qint32 x = pointItems.first().toInt();
+        const qint32 y = pointItems.last().toInt();
+
+        m_hashTable->deleteTile(xToCol(x), yToRow(y));
+    }
+
+    recalculateExtent();
+
+    return true;
+}
+
 bool KisTiledDataManager::writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles)
 {
     QString buffer;
@@ -628,7 +810,7 @@ void KisTiledDataManager::setExtent(QRect newRect)
                         }
                     }
                 }
-                tile->unlock();
+                tile->unlockForWrite();
                 ++iter;
             } else {
                 iter.deleteCurrent();
@@ -704,6 +886,30 @@ QRegion KisTiledDataManager::region() const
     return region;
 }
 
+QVector<quint64> KisTiledDataManager::tileVersions(const QRect &rect) const
+{
+    QVector<quint64> versions;
+    if (rect.isEmpty()) return versions;
+
+    QReadLocker locker(&m_lock);
+
+    const qint32 firstColumn = xToCol(rect.left());
+    const qint32 lastColumn = xToCol(rect.right());
+    const qint32 firstRow = yToRow(rect.top());
+    const qint32 lastRow = yToRow(rect.bottom());
+
+    versions.reserve((lastColumn - firstColumn + 1) * (lastRow - firstRow + 1));
+
+    for (qint32 row = firstRow; row <= lastRow; row++) {
+        for (qint32 column = firstColumn; column <= lastColumn; column++) {
+            KisTileSP tile = m_hashTable->getReadOnlyTileLazy(column, row);
+            versions.append(tile->tileData()->version());
+        }
+    }
+
+    return versions;
+}
+
 void KisTiledDataManager::setPixel(qint32 x, qint32 y, const quint8 * data)
 {
     QWriteLocker locker(&m_lock);
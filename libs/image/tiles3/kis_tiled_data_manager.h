@@ -175,6 +175,21 @@ protected:
     bool write(KisPaintDeviceWriter &store);
     bool read(QIODevice *stream);
 
+    /**
+     * Writes only the tiles that differ from the tiles of \p baseDM.
+     * Tiles filled with the default pixel are skipped. The stream has
+     * the format of write(), followed by a "REMOVED" list of the tiles
+     * of \p baseDM that are absent or default in this data manager.
+     */
+    bool writeDelta(KisPaintDeviceWriter &store, KisTiledDataManager *baseDM);
+
+    /**
+     * Reads a stream written with writeDelta(). The tiles of
+     * \p baseDM are shared with this data manager, the changed
+     * tiles are read on top of them and the removed ones are dropped.
+     */
+    bool readDelta(QIODevice *stream, KisTiledDataManager *baseDM);
+
     void purge(const QRect& area);
 
     inline quint32 pixelSize() const {
@@ -192,6 +207,13 @@ public:
 
     QRegion region() const;
 
+    /**
+     * Returns the version stamps of the tile datas covering \p rect,
+     * row by row. Missing tiles report the version of the default
+     * tile. Two equal vectors mean the pixels of the rect are equal.
+     */
+    QVector<quint64> tileVersions(const QRect &rect) const;
+
     void clear(QRect clearRect, quint8 clearValue);
     void clear(QRect clearRect, const quint8 *clearPixel);
     void clear(qint32 x, qint32 y, qint32 w, qint32 h, quint8 clearValue);
@@ -328,6 +350,7 @@ private:
 
     bool writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles);
     bool processTilesHeader(QIODevice *stream, quint32 &numTiles);
+    bool readTilesImpl(QIODevice *stream);
 
     qint32 divideRoundDown(qint32 x, const qint32 y) const;
 
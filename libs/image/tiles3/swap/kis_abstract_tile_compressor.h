@@ -47,6 +47,16 @@ public:
      */
     virtual bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store) = 0;
 
+    /**
+     * Compresses all the \a tiles and writes them into the \a store.
+     * The default implementation just calls writeTile() for every
+     * tile, the compressors may reimplement it to compress the tiles
+     * in parallel.
+     *
+     * \see writeTile()
+     */
+    virtual bool writeTiles(const QVector<KisTileSP> &tiles, KisPaintDeviceWriter &store);
+
     /**
      * Decompresses the \a tile from the \a stream.
      * Used by datamanager in load/save routines
@@ -55,6 +65,16 @@ public:
      */
     virtual bool readTile(QIODevice *stream, KisTiledDataManager *dm) = 0;
 
+    /**
+     * Decompresses \a numTiles consecutive tiles from the \a stream.
+     * The default implementation just calls readTile() for every
+     * tile, the compressors may reimplement it to decompress the
+     * tiles in parallel.
+     *
+     * \see readTile()
+     */
+    virtual bool readTiles(QIODevice *stream, KisTiledDataManager *dm, quint32 numTiles);
+
     /**
      * Compresses a \a tileData and writes it into the \a buffer.
      * The buffer must be at least tileDataBufferSize() bytes long.
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_compressed_tiles_cache.h"
+
+#include <QGlobalStatic>
+
+#include "kis_image_config.h"
+#include "kis_chunk_allocator.h"
+#include "../kis_tile_data.h"
+
+
+Q_GLOBAL_STATIC(KisCompressedTilesCache, s_instance)
+
+KisCompressedTilesCache::KisCompressedTilesCache()
+    : m_size(0)
+{
+    KisImageConfig config;
+    m_limit = config.savingCacheSize() * MiB;
+}
+
+KisCompressedTilesCache::~KisCompressedTilesCache()
+{
+    clear();
+}
+
+KisCompressedTilesCache* KisCompressedTilesCache::instance()
+{
+    return s_instance;
+}
+
+qint64 KisCompressedTilesCache::entrySize(const QByteArray &data)
+{
+    // the hash node and the array header are not free either
+    return data.size() + sizeof(CachedTile) + sizeof(quint64) + 2 * sizeof(void*);
+}
+
+bool KisCompressedTilesCache::fetch(const void *owner, KisTileSP tile, QByteArray *data)
+{
+    QMutexLocker l(&m_lock);
+
+    auto ownerIt = m_owners.find(owner);
+    if (ownerIt == m_owners.end()) return false;
+
+    auto it = ownerIt->find(tile->tileData()->version());
+    if (it == ownerIt->end()) return false;
+
+    it->used = true;
+    *data = it->data;
+    return true;
+}
+
+void KisCompressedTilesCache::store(const void *owner, KisTileSP tile, const QByteArray &data)
+{
+    QMutexLocker l(&m_lock);
+
+    const qint64 size = entrySize(data);
+    if (m_size + size > m_limit) return;
+
+    OwnerTiles &tiles = m_owners[owner];
+
+    const quint64 version = tile->tileData()->version();
+    if (tiles.contains(version)) return;
+
+    CachedTile cachedTile;
+    cachedTile.data = data;
+    cachedTile.used = true;
+
+    tiles.insert(version, cachedTile);
+    m_size += size;
+}
+
+void KisCompressedTilesCache::finishSave(const void *owner)
+{
+    QMutexLocker l(&m_lock);
+
+    auto ownerIt = m_owners.find(owner);
+    if (ownerIt == m_owners.end()) return;
+
+    auto it = ownerIt->begin();
+    while (it != ownerIt->end()) {
+        if (!it->used) {
+            m_size -= entrySize(it->data);
+            it = ownerIt->erase(it);
+        } else {
+            it->used = false;
+            ++it;
+        }
+    }
+
+    if (ownerIt->isEmpty()) {
+        m_owners.erase(ownerIt);
+    }
+}
+
+void KisCompressedTilesCache::dropOwner(const void *owner)
+{
+    QMutexLocker l(&m_lock);
+
+    auto ownerIt = m_owners.find(owner);
+    if (ownerIt == m_owners.end()) return;
+
+    Q_FOREACH (const CachedTile &tile, *ownerIt) {
+        m_size -= entrySize(tile.data);
+    }
+    m_owners.erase(ownerIt);
+}
+
+void KisCompressedTilesCache::clear()
+{
+    QMutexLocker l(&m_lock);
+
+    m_owners.clear();
+    m_size = 0;
+}
+
+qint64 KisCompressedTilesCache::size() const
+{
+    QMutexLocker l(&m_lock);
+    return m_size;
+}
@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_COMPRESSED_TILES_CACHE_H
+#define __KIS_COMPRESSED_TILES_CACHE_H
+
+#include "kritaimage_export.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+
+#include "../kis_tile.h"
+
+
+/**
+ * Keeps the compressed representation of the tiles written by the
+ * tile compressor, so that the tiles that haven't changed since the
+ * previous save are not compressed again.
+ *
+ * The entries are keyed by the version of the tile data (see
+ * KisTileData::version()), which changes on every write, so a cached
+ * entry can never get stale. The cache doesn't reference the tiles
+ * themselves, therefore it neither causes copy-on-writes nor keeps
+ * any pixel data alive. The only memory it holds is the compressed
+ * data, which is what the limit counts.
+ *
+ * Every entry belongs to an owner, usually the document being saved.
+ * After each save the owner calls finishSave() to forget the versions
+ * it didn't write anymore, and dropOwner() when it is closed.
+ */
+class KRITAIMAGE_EXPORT KisCompressedTilesCache
+{
+public:
+    KisCompressedTilesCache();
+    ~KisCompressedTilesCache();
+
+    static KisCompressedTilesCache* instance();
+
+    /**
+     * Fetches the compressed data for the tile data of \p tile.
+     * The tile must be locked by the caller.
+     */
+    bool fetch(const void *owner, KisTileSP tile, QByteArray *data);
+
+    /**
+     * Stores the compressed \p data for the tile data of \p tile.
+     * The tile must be locked by the caller.
+     */
+    void store(const void *owner, KisTileSP tile, const QByteArray &data);
+
+    /**
+     * Drops the entries of \p owner that have been neither fetched
+     * nor stored since the previous call, that is, the tiles that
+     * have been changed or removed since the previous save
+     */
+    void finishSave(const void *owner);
+
+    /**
+     * Drops all the entries of \p owner
+     */
+    void dropOwner(const void *owner);
+
+    void clear();
+
+    /**
+     * The total amount of memory kept by the cache
+     */
+    qint64 size() const;
+
+private:
+    struct CachedTile {
+        QByteArray data;
+        bool used;
+    };
+
+    typedef QHash<quint64, CachedTile> OwnerTiles;
+
+    static qint64 entrySize(const QByteArray &data);
+
+private:
+    QHash<const void*, OwnerTiles> m_owners;
+    qint64 m_size;
+    qint64 m_limit;
+    mutable QMutex m_lock;
+};
+
+#endif /* __KIS_COMPRESSED_TILES_CACHE_H */
@@ -72,7 +72,7 @@ bool KisLegacyTileCompressor::readTile(QIODevice *stream, KisTiledDataManager *d
 
     tile->lockForWrite();
     stream->read((char *)tile->data(), tileDataSize);
-    tile->unlock();
+    tile->unlockForWrite();
 
     return true;
 }
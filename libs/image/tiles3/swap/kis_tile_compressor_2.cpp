@@ -19,7 +19,10 @@
 #include "kis_tile_compressor_2.h"
 #include "kis_lzf_compression.h"
 #include <QIODevice>
+#include <QThread>
+#include <QtConcurrent>
 #include "kis_paint_device_writer.h"
+#include "kis_compressed_tiles_cache.h"
 #define TILE_DATA_SIZE(pixelSize) ((pixelSize) * KisTileData::WIDTH * KisTileData::HEIGHT)
 
 const QString KisTileCompressor2::m_compressionName = "LZF";
@@ -65,31 +68,218 @@ bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
     prepareStreamingBuffer(tileDataSize);
 
-    QByteArray header = stream->readLine(maxHeaderLength());
+    qint32 row, col, dataSize;
+    if (!readTileHeader(stream, dm, &col, &row, &dataSize)) {
+        return false;
+    }
 
-    QList<QByteArray> headerItems = header.trimmed().split(',');
-    if (headerItems.size() == 4) {
-        qint32 x = headerItems.takeFirst().toInt();
-        qint32 y = headerItems.takeFirst().toInt();
-        QString compressionName = headerItems.takeFirst();
-        qint32 dataSize = headerItems.takeFirst().toInt();
+    KisTileSP tile = dm->getTile(col, row, true);
 
-        Q_ASSERT(headerItems.isEmpty());
-        Q_ASSERT(compressionName == m_compressionName);
+    stream->read(m_streamingBuffer.data(), dataSize);
 
-        qint32 row = yToRow(dm, y);
-        qint32 col = xToCol(dm, x);
+    tile->lockForWrite();
+    bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
+    tile->unlockForWrite();
+    return res;
+}
 
-        KisTileSP tile = dm->getTile(col, row, true);
+namespace {
+struct PendingTile {
+    KisTileSP tile;
+    QByteArray data;
+    bool cached = false;
+    bool result = false;
+};
+
+/**
+ * Splits the \p batch into equal slices and runs \p func for
+ * every slice on the global thread pool
+ */
+template <typename Func>
+void startJobs(QVector<PendingTile> &batch, int numThreads,
+               QVector<QFuture<void>> &jobs, Func func)
+{
+    const int numJobs = qMin(numThreads, batch.size());
+    PendingTile *begin = batch.data();
 
-        stream->read(m_streamingBuffer.data(), dataSize);
+    for (int i = 0; i < numJobs; i++) {
+        PendingTile *jobBegin = begin + i * batch.size() / numJobs;
+        PendingTile *jobEnd = begin + (i + 1) * batch.size() / numJobs;
 
-        tile->lockForWrite();
-        bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
-        tile->unlock();
-        return res;
+        jobs.append(QtConcurrent::run([func, jobBegin, jobEnd] () {
+            func(jobBegin, jobEnd);
+        }));
     }
-    return false;
+}
+
+void waitForJobs(QVector<QFuture<void>> &jobs)
+{
+    Q_FOREACH (QFuture<void> job, jobs) {
+        job.waitForFinished();
+    }
+    jobs.clear();
+}
+}
+
+bool KisTileCompressor2::writeTiles(const QVector<KisTileSP> &tiles, KisPaintDeviceWriter &store)
+{
+    if (tiles.isEmpty()) return true;
+
+    const void *cacheOwner = store.tilesCacheOwner();
+    KisCompressedTilesCache *cache = cacheOwner ? KisCompressedTilesCache::instance() : 0;
+    KisAbstractCompression *compression = m_compression;
+
+    const int numThreads = QThread::idealThreadCount();
+    const qint32 tileDataSize = TILE_DATA_SIZE(tiles.first()->pixelSize());
+    const int batchSize = qMax(numThreads, MAX_BATCH_BYTES / tileDataSize);
+
+    /**
+     * The tiles that have not been changed since the previous save
+     * are taken from the cache, the rest of them are compressed on the
+     * global thread pool. The store is written on the calling thread
+     * in the original order of the tiles.
+     */
+    QVector<PendingTile> batch;
+    QVector<QFuture<void>> jobs;
+    bool retval = true;
+
+    for (int start = 0; retval && start < tiles.size(); start += batchSize) {
+        const int end = qMin(start + batchSize, tiles.size());
+        batch.resize(end - start);
+
+        for (int i = start; i < end; i++) {
+            PendingTile &pending = batch[i - start];
+            pending.tile = tiles[i];
+            pending.tile->lockForRead();
+            pending.cached = cache && cache->fetch(cacheOwner, pending.tile, &pending.data);
+        }
+
+        startJobs(batch, numThreads, jobs, [compression, tileDataSize] (PendingTile *begin, PendingTile *end) {
+            QByteArray linearizationBuffer(tileDataSize, Qt::Uninitialized);
+            QByteArray compressionBuffer(compression->outputBufferSize(tileDataSize), Qt::Uninitialized);
+
+            for (PendingTile *it = begin; it != end; ++it) {
+                if (it->cached) continue;
+
+                qint32 bytesWritten;
+                it->data.resize(tileDataSize + 1);
+                compressTileDataImpl(compression, it->tile->tileData(),
+                                     (quint8*)it->data.data(), bytesWritten,
+                                     linearizationBuffer, compressionBuffer);
+                it->data.resize(bytesWritten);
+            }
+        });
+        waitForJobs(jobs);
+
+        for (auto it = batch.begin(); it != batch.end(); ++it) {
+            if (cache && !it->cached) {
+                cache->store(cacheOwner, it->tile, it->data);
+            }
+            it->tile->unlock();
+
+            if (!retval) continue;
+
+            retval = store.write(getHeader(it->tile, it->data.size()).toLatin1());
+            if (!retval) {
+                warnFile << "Failed to write the tile header";
+                continue;
+            }
+
+            retval = store.write(it->data.data(), it->data.size());
+            if (!retval) {
+                warnFile << "Failed to write the tile data";
+            }
+        }
+
+        batch.clear();
+    }
+
+    return retval;
+}
+
+bool KisTileCompressor2::readTiles(QIODevice *stream, KisTiledDataManager *dm, quint32 numTiles)
+{
+    const int numThreads = QThread::idealThreadCount();
+
+    if (numThreads <= 1 || numTiles < 2 * quint32(numThreads)) {
+        return KisAbstractTileCompressor::readTiles(stream, dm, numTiles);
+    }
+
+    KisAbstractCompression *compression = m_compression;
+
+    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
+    const int batchSize = qMax(numThreads, MAX_BATCH_BYTES / tileDataSize);
+
+    /**
+     * Reading from the store is sequential, so we read the compressed
+     * data of a batch of tiles on the calling thread and decompress it
+     * on the global thread pool, while the next batch is being read.
+     *
+     * All the tile-level operations (fetching, COW and memento
+     * registration) happen on the calling thread, the workers touch
+     * the raw tile data only.
+     */
+    QVector<PendingTile> batches[2];
+    QVector<QFuture<void>> jobs[2];
+    bool result = true;
+
+    auto finishBatch = [&result] (QVector<PendingTile> &batch, QVector<QFuture<void>> &batchJobs) {
+        waitForJobs(batchJobs);
+
+        for (auto it = batch.begin(); it != batch.end(); ++it) {
+            it->tile->unlockForWrite();
+            result &= it->result;
+        }
+        batch.clear();
+    };
+
+    int current = 0;
+    quint32 tilesLeft = numTiles;
+
+    while (tilesLeft > 0) {
+        QVector<PendingTile> &batch = batches[current];
+        const int size = qMin(quint32(batchSize), tilesLeft);
+        batch.reserve(size);
+
+        for (int i = 0; i < size; i++) {
+            qint32 row, col, dataSize;
+            if (!readTileHeader(stream, dm, &col, &row, &dataSize)) {
+                result = false;
+                continue;
+            }
+
+            PendingTile pending;
+            pending.data = stream->read(dataSize);
+            if (pending.data.size() != dataSize) {
+                result = false;
+                continue;
+            }
+
+            pending.tile = dm->getTile(col, row, true);
+            pending.tile->lockForWrite();
+            batch.append(pending);
+        }
+        tilesLeft -= size;
+
+        startJobs(batch, numThreads, jobs[current], [compression, tileDataSize] (PendingTile *begin, PendingTile *end) {
+            QByteArray linearizationBuffer(tileDataSize, Qt::Uninitialized);
+
+            for (PendingTile *it = begin; it != end; ++it) {
+                it->result = decompressTileDataImpl(compression,
+                                                    (quint8*)it->data.data(), it->data.size(),
+                                                    it->tile->tileData(),
+                                                    linearizationBuffer);
+                it->data.clear();
+            }
+        });
+
+        current = 1 - current;
+        finishBatch(batches[current], jobs[current]);
+    }
+
+    finishBatch(batches[1 - current], jobs[1 - current]);
+
+    return result;
 }
 
 void KisTileCompressor2::prepareStreamingBuffer(qint32 tileDataSize)
@@ -114,24 +304,37 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
                                           qint32 bufferSize,
                                           qint32 &bytesWritten)
 {
-    const qint32 pixelSize = tileData->pixelSize();
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
-    qint32 compressedBytes;
+    const qint32 tileDataSize = TILE_DATA_SIZE(tileData->pixelSize());
 
     Q_UNUSED(bufferSize);
     Q_ASSERT(bufferSize >= tileDataSize + 1);
 
     prepareWorkBuffers(tileDataSize);
 
-    KisAbstractCompression::linearizeColors(tileData->data(), (quint8*)m_linearizationBuffer.data(),
+    compressTileDataImpl(m_compression, tileData, buffer, bytesWritten,
+                         m_linearizationBuffer, m_compressionBuffer);
+}
+
+void KisTileCompressor2::compressTileDataImpl(KisAbstractCompression *compression,
+                                              KisTileData *tileData,
+                                              quint8 *buffer,
+                                              qint32 &bytesWritten,
+                                              QByteArray &linearizationBuffer,
+                                              QByteArray &compressionBuffer)
+{
+    const qint32 pixelSize = tileData->pixelSize();
+    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
+    qint32 compressedBytes;
+
+    KisAbstractCompression::linearizeColors(tileData->data(), (quint8*)linearizationBuffer.data(),
                                             tileDataSize, pixelSize);
 
-    compressedBytes = m_compression->compress((quint8*)m_linearizationBuffer.data(), tileDataSize,
-                                              (quint8*)m_compressionBuffer.data(), m_compressionBuffer.size());
+    compressedBytes = compression->compress((quint8*)linearizationBuffer.data(), tileDataSize,
+                                            (quint8*)compressionBuffer.data(), compressionBuffer.size());
 
     if(compressedBytes < tileDataSize) {
         buffer[0] = COMPRESSED_DATA_FLAG;
-        memcpy(buffer + 1, m_compressionBuffer.data(), compressedBytes);
+        memcpy(buffer + 1, compressionBuffer.data(), compressedBytes);
         bytesWritten = compressedBytes + 1;
     }
     else {
@@ -144,18 +347,27 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
 bool KisTileCompressor2::decompressTileData(quint8 *buffer,
                                             qint32 bufferSize,
                                             KisTileData *tileData)
+{
+    prepareWorkBuffers(TILE_DATA_SIZE(tileData->pixelSize()));
+    return decompressTileDataImpl(m_compression, buffer, bufferSize,
+                                  tileData, m_linearizationBuffer);
+}
+
+bool KisTileCompressor2::decompressTileDataImpl(KisAbstractCompression *compression,
+                                                quint8 *buffer,
+                                                qint32 bufferSize,
+                                                KisTileData *tileData,
+                                                QByteArray &linearizationBuffer)
 {
     const qint32 pixelSize = tileData->pixelSize();
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
 
     if(buffer[0] == COMPRESSED_DATA_FLAG) {
-        prepareWorkBuffers(tileDataSize);
-
         qint32 bytesWritten;
-        bytesWritten = m_compression->decompress(buffer + 1, bufferSize - 1,
-                                                 (quint8*)m_linearizationBuffer.data(), tileDataSize);
+        bytesWritten = compression->decompress(buffer + 1, bufferSize - 1,
+                                               (quint8*)linearizationBuffer.data(), tileDataSize);
         if (bytesWritten == tileDataSize) {
-            KisAbstractCompression::delinearizeColors((quint8*)m_linearizationBuffer.data(),
+            KisAbstractCompression::delinearizeColors((quint8*)linearizationBuffer.data(),
                                                       tileData->data(),
                                                       tileDataSize, pixelSize);
             return true;
@@ -193,3 +405,32 @@ inline QString KisTileCompressor2::getHeader(KisTileSP tile,
 
     return QString("%1,%2,%3,%4\n").arg(x).arg(y).arg(m_compressionName).arg(compressedSize);
 }
+
+bool KisTileCompressor2::readTileHeader(QIODevice *stream, KisTiledDataManager *dm,
+                                        qint32 *col, qint32 *row, qint32 *dataSize)
+{
+    QByteArray header = stream->readLine(maxHeaderLength());
+
+    QList<QByteArray> headerItems = header.trimmed().split(',');
+    if (headerItems.size() != 4) {
+        return false;
+    }
+
+    qint32 x = headerItems.takeFirst().toInt();
+    qint32 y = headerItems.takeFirst().toInt();
+    QString compressionName = headerItems.takeFirst();
+    *dataSize = headerItems.takeFirst().toInt();
+
+    Q_ASSERT(headerItems.isEmpty());
+    Q_ASSERT(compressionName == m_compressionName);
+
+    if (*dataSize <= 0 || *dataSize > TILE_DATA_SIZE(pixelSize(dm)) + 1) {
+        warnFile << "Corrupted tile header:" << header;
+        return false;
+    }
+
+    *row = yToRow(dm, y);
+    *col = xToCol(dm, x);
+
+    return true;
+}
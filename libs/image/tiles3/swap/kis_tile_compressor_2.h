@@ -30,7 +30,9 @@ public:
     virtual ~KisTileCompressor2();
 
     bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store);
+    bool writeTiles(const QVector<KisTileSP> &tiles, KisPaintDeviceWriter &store);
     bool readTile(QIODevice *io, KisTiledDataManager *dm);
+    bool readTiles(QIODevice *stream, KisTiledDataManager *dm, quint32 numTiles);
 
 
     void compressTileData(KisTileData *tileData,quint8 *buffer,
@@ -46,6 +48,25 @@ private:
 
     QString getHeader(KisTileSP tile, qint32 compressedSize);
 
+    /**
+     * Reads the header of the next tile in the \a stream and
+     * validates the size of the compressed data
+     */
+    bool readTileHeader(QIODevice *stream, KisTiledDataManager *dm,
+                        qint32 *col, qint32 *row, qint32 *dataSize);
+
+    static void compressTileDataImpl(KisAbstractCompression *compression,
+                                     KisTileData *tileData,
+                                     quint8 *buffer,
+                                     qint32 &bytesWritten,
+                                     QByteArray &linearizationBuffer,
+                                     QByteArray &compressionBuffer);
+
+    static bool decompressTileDataImpl(KisAbstractCompression *compression,
+                                       quint8 *buffer, qint32 bufferSize,
+                                       KisTileData *tileData,
+                                       QByteArray &linearizationBuffer);
+
     void prepareWorkBuffers(qint32 tileDataSize);
     void prepareStreamingBuffer(qint32 tileDataSize);
 
@@ -53,6 +74,13 @@ private:
     static const qint8 RAW_DATA_FLAG = 0;
     static const qint8 COMPRESSED_DATA_FLAG = 1;
 
+    /**
+     * The tiles waiting for the decompression are locked for
+     * writing, so they cannot be swapped out. Limit the amount of
+     * such tiles by the size of their raw data.
+     */
+    static const qint32 MAX_BATCH_BYTES = 16 * 1024 * 1024;
+
 private:
     QByteArray m_linearizationBuffer;
     QByteArray m_compressionBuffer;
@@ -61,6 +61,39 @@ void KisTileCompressorsTest::doRoundTrip(KisAbstractTileCompressor *compressor)
     tile11 = 0;
 }
 
+void KisTileCompressorsTest::doManyTilesRoundTrip(KisAbstractTileCompressor *compressor)
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    const int numTiles = 300;
+
+    KoStoreFake fakeStore;
+    KisFakePaintDeviceWriter writer(&fakeStore);
+
+    for (int i = 0; i < numTiles; i++) {
+        quint8 oddPixel = 1 + i % 254;
+        dm.clear(64 * i, 0, 64, 64, &oddPixel);
+
+        KisTileSP tile = dm.getTile(i, 0, false);
+        bool retval = compressor->writeTile(tile, writer);
+        QVERIFY(retval);
+    }
+
+    fakeStore.startReading();
+
+    dm.clear();
+
+    bool res = compressor->readTiles(fakeStore.device(), &dm, numTiles);
+    QVERIFY(res);
+
+    for (int i = 0; i < numTiles; i++) {
+        quint8 oddPixel = 1 + i % 254;
+        KisTileSP tile = dm.getTile(i, 0, false);
+        QVERIFY(memoryIsFilled(oddPixel, tile->data(), TILESIZE));
+    }
+}
+
 void KisTileCompressorsTest::doLowLevelRoundTrip(KisAbstractTileCompressor *compressor)
 {
     const qint32 pixelSize = 1;
@@ -165,6 +198,13 @@ void KisTileCompressorsTest::testRoundTrip2()
     delete compressor;
 }
 
+void KisTileCompressorsTest::testManyTilesRoundTrip2()
+{
+    KisAbstractTileCompressor *compressor = new KisTileCompressor2();
+    doManyTilesRoundTrip(compressor);
+    delete compressor;
+}
+
 void KisTileCompressorsTest::testLowLevelRoundTrip2()
 {
     KisAbstractTileCompressor *compressor = new KisTileCompressor2();
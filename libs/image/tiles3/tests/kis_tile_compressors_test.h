@@ -27,6 +27,7 @@ class KisTileCompressorsTest : public QObject
     Q_OBJECT
 private:
     void doRoundTrip(KisAbstractTileCompressor *compressor);
+    void doManyTilesRoundTrip(KisAbstractTileCompressor *compressor);
     void doLowLevelRoundTrip(KisAbstractTileCompressor *compressor);
     void doLowLevelRoundTripIncompressible(KisAbstractTileCompressor *compressor);
 
@@ -36,6 +37,7 @@ private Q_SLOTS:
     void testLowLevelRoundTripLegacy();
 
     void testRoundTrip2();
+    void testManyTilesRoundTrip2();
     void testLowLevelRoundTrip2();
     void testLowLevelRoundTripIncompressible2();
 };
@@ -20,6 +20,7 @@
 #include <QTest>
 
 #include "tiles3/kis_tiled_data_manager.h"
+#include "tiles3/swap/kis_compressed_tiles_cache.h"
 
 #include "tiles_test_utils.h"
 
@@ -474,6 +475,69 @@ void KisTiledDataManagerTest::testPurgeHistory()
     dm.purgeHistory(memento4);
 }
 
+void KisTiledDataManagerTest::testCompressedTilesCache()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    quint8 oddPixel1 = 128;
+    quint8 oddPixel2 = 129;
+
+    dm.clear(0, 0, 64, 64, &oddPixel1);
+
+    KisCompressedTilesCache cache;
+    QByteArray data;
+    const int owner = 0;
+    const int otherOwner = 0;
+
+    KisTileSP tile = dm.getTile(0, 0, false);
+    tile->lockForRead();
+    QVERIFY(!cache.fetch(&owner, tile, &data));
+    cache.store(&owner, tile, QByteArray("compressed"));
+    QVERIFY(cache.fetch(&owner, tile, &data));
+    QVERIFY(!cache.fetch(&otherOwner, tile, &data));
+    tile->unlock();
+
+    QCOMPARE(data, QByteArray("compressed"));
+
+    const qint64 entrySize = cache.size();
+    QVERIFY(entrySize >= 10);
+
+    // the tile has been written during this save
+    cache.finishSave(&owner);
+    QCOMPARE(cache.size(), entrySize);
+
+    // writing changes the version of the tile data
+    const quint64 oldVersion = tile->tileData()->version();
+
+    tile = dm.getTile(0, 0, true);
+    tile->lockForWrite();
+    memset(tile->data(), oddPixel2, TILESIZE);
+    QVERIFY(tile->tileData()->version() != oldVersion);
+    QVERIFY(!cache.fetch(&owner, tile, &data));
+
+    // the version read during the write doesn't match the final pixels
+    const quint64 midWriteVersion = tile->tileData()->version();
+    tile->unlockForWrite();
+    QVERIFY(tile->tileData()->version() != midWriteVersion);
+
+    // the old version has not been written during this save
+    cache.finishSave(&owner);
+    QCOMPARE(cache.size(), qint64(0));
+
+    // closing the document drops all its tiles
+    tile->lockForRead();
+    cache.store(&owner, tile, QByteArray("compressed"));
+    cache.store(&otherOwner, tile, QByteArray("compressed"));
+    tile->unlock();
+
+    cache.dropOwner(&owner);
+    QCOMPARE(cache.size(), entrySize);
+
+    cache.dropOwner(&otherOwner);
+    QCOMPARE(cache.size(), qint64(0));
+}
+
 void KisTiledDataManagerTest::testUndoSetDefaultPixel()
 {
     quint8 defaultPixel = 0;
@@ -52,6 +52,7 @@ private Q_SLOTS:
     void testTransactions();
     void testPurgeHistory();
     void testUndoSetDefaultPixel();
+    void testCompressedTilesCache();
 
     void benchmarkReadOnlyTileLazy();
     void benchmarkSharedPointers();
@@ -90,6 +90,7 @@
 #include <kis_signal_auto_connection.h>
 #include <kis_debug.h>
 #include <kis_canvas_widget_base.h>
+#include <tiles3/swap/kis_compressed_tiles_cache.h>
 
 // Local
 #include "KisViewManager.h"
@@ -475,6 +476,8 @@ KisDocument::~KisDocument()
     d->autoSaveTimer.disconnect(this);
     d->autoSaveTimer.stop();
 
+    KisCompressedTilesCache::instance()->dropOwner(this);
+
     delete d->importExportManager;
 
     // Despite being QObject they needs to be deleted before the image
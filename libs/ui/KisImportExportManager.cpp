@@ -139,6 +139,15 @@ KisImportExportFilter *KisImportExportManager::filterForMimeType(const QString &
     KisImportExportFilter *filter = 0;
     KoJsonTrader trader;
     QList<QPluginLoader *>list = trader.query("Krita/FileFilter", "");
+
+    /**
+     * Animation exporters (video formats) are not listed among the
+     * file filters, but they can still render the document directly,
+     * e.g. when exporting from the command line in batch mode.
+     */
+    if (direction == Export) {
+        list += trader.query("Krita/AnimationExporter", "");
+    }
     Q_FOREACH(QPluginLoader *loader, list) {
         QJsonObject json = loader->metaData().value("MetaData").toObject();
         QString directionKey = direction == Export ? "X-KDE-Export" : "X-KDE-Import";
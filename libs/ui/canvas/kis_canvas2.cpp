@@ -84,6 +84,7 @@
 #include "kis_painting_assistants_decoration.h"
 
 #include "kis_canvas_updates_compressor.h"
+#include "kis_update_time_monitor.h"
 #include "KoZoomController.h"
 
 
@@ -639,6 +640,8 @@ void KisCanvas2::finishResizingImage(qint32 w, qint32 h)
 void KisCanvas2::startUpdateCanvasProjection(const QRect & rc)
 {
     KisUpdateInfoSP info = m_d->canvasWidget->startUpdateCanvasProjection(rc, m_d->channelFlags);
+    info->eventIds = KisUpdateTimeMonitor::instance()->takeUpdatedEvents(rc);
+
     if (m_d->projectionUpdatesCompressor.putUpdateInfo(info)) {
         emit sigCanvasCacheUpdated();
     }
@@ -648,6 +651,8 @@ void KisCanvas2::updateCanvasProjection()
 {
     while (KisUpdateInfoSP info = m_d->projectionUpdatesCompressor.takeUpdateInfo()) {
         QRect vRect = m_d->canvasWidget->updateCanvasProjection(info);
+        KisUpdateTimeMonitor::instance()->reportEventsUploaded(info->eventIds);
+
         if (!vRect.isEmpty()) {
             updateCanvasWidgetImpl(m_d->coordinatesConverter->viewportToWidget(vRect).toAlignedRect());
         }
@@ -27,11 +27,16 @@ bool KisCanvasUpdatesCompressor::putUpdateInfo(KisUpdateInfoSP info)
     QMutexLocker l(&m_mutex);
     bool updateOverridden = false;
 
+    KisUpdateInfoSP newInfo = info;
+
     UpdateInfoList::iterator it = m_updatesList.begin();
     while (it != m_updatesList.end()) {
         if (levelOfDetail == (*it)->levelOfDetail() &&
             newUpdateRect.contains((*it)->dirtyImageRect())) {
 
+            // the events of the dropped update are shown by the new one
+            newInfo->eventIds += (*it)->eventIds;
+
             if (info) {
                 *it = info;
                 info = 0;
@@ -20,6 +20,7 @@
 #define KIS_UPDATE_INFO_H_
 
 #include <QPainter>
+#include <QVector>
 
 #include "kis_image_patch.h"
 #include "kis_shared.h"
@@ -37,6 +38,12 @@ public:
     virtual QRect dirtyViewportRect();
     virtual QRect dirtyImageRect() const = 0;
     virtual int levelOfDetail() const = 0;
+
+    /**
+     * The ids of the input events whose pixels become visible with
+     * this update, see KisUpdateTimeMonitor
+     */
+    QVector<qint64> eventIds;
 };
 
 Q_DECLARE_METATYPE(KisUpdateInfoSP)
@@ -38,6 +38,7 @@
 #include "kis_painter.h"
 
 #include "kis_image_lock_hijacker.h"
+#include "kis_debug.h"
 
 
 struct KisAnimationExporterUI::Private
@@ -212,15 +213,15 @@ void KisAnimationExporter::frameReadyToSave()
     if (!m_d->batchMode) {
         emit m_d->document->sigProgress((time - m_d->firstFrame) * 100 /
                                         (m_d->lastFrame - m_d->firstFrame));
-    }
 
-    qDebug() << result << time << m_d->lastFrame;
+        QString dialogText = QString("Exporting Frame ").append(QString::number(time)).append(" of ").append(QString::number(m_d->lastFrame));
+        int percentageProcessed = (float(time) / float(m_d->lastFrame) * 100);
 
-    QString dialogText = QString("Exporting Frame ").append(QString::number(time)).append(" of ").append(QString::number(m_d->lastFrame));
-    int percentageProcessed = (float(time) / float(m_d->lastFrame) * 100);
+        m_d->progress.setLabelText(dialogText);
+        m_d->progress.setValue(int(percentageProcessed));
+    }
 
-    m_d->progress.setLabelText(dialogText);
-    m_d->progress.setValue(int(percentageProcessed));
+    dbgFile << result << time << m_d->lastFrame;
 
     if (result == KisImportExportFilter::OK && time < m_d->lastFrame) {
         m_d->currentFrame = time + 1;
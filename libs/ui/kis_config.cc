@@ -1756,6 +1756,16 @@ void KisConfig::setStabilizerDelayedPaintInterval(int value)
     m_cfg.writeEntry("stabilizerDelayedPaintInterval", value);
 }
 
+int KisConfig::strokePredictionHorizon(bool defaultValue) const
+{
+    return defaultValue ? 0 : m_cfg.readEntry("strokePredictionHorizon", 0);
+}
+
+void KisConfig::setStrokePredictionHorizon(int value)
+{
+    m_cfg.writeEntry("strokePredictionHorizon", value);
+}
+
 QString KisConfig::customFFMpegPath(bool defaultValue) const
 {
     return defaultValue ? QString() : m_cfg.readEntry("ffmpegExecutablePath", QString());
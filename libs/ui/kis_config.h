@@ -501,6 +501,13 @@ public:
     int stabilizerDelayedPaintInterval(bool defaultValue = false) const;
     void setStabilizerDelayedPaintInterval(int value);
 
+    /**
+     * How many milliseconds ahead of the tablet the freehand tools
+     * predict the brush outline, 0 disables the prediction
+     */
+    int strokePredictionHorizon(bool defaultValue = false) const;
+    void setStrokePredictionHorizon(int value);
+
     QString customFFMpegPath(bool defaultValue = false) const;
     void setCustomFFMpegPath(const QString &value) const;
 
@@ -24,7 +24,8 @@
 class KisStorePaintDeviceWriter : public KisPaintDeviceWriter {
 public:
     KisStorePaintDeviceWriter(KoStore *store)
-        : m_store(store)
+        : m_store(store),
+          m_tilesCacheOwner(0)
     {
     }
 
@@ -40,7 +41,16 @@ public:
         return (length == len);
     }
 
+    const void* tilesCacheOwner() const {
+        return m_tilesCacheOwner;
+    }
+
+    void setTilesCacheOwner(const void *owner) {
+        m_tilesCacheOwner = owner;
+    }
+
     KoStore *m_store;
+    const void *m_tilesCacheOwner;
 
 };
 
@@ -0,0 +1,141 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_stroke_predictor_test.h"
+
+#include <cmath>
+
+#include "kis_stroke_predictor.h"
+#include "kis_paint_information.h"
+
+namespace {
+
+KisPaintInformation event(const QPointF &pos, qreal time, qreal speed)
+{
+    return KisPaintInformation(pos, 0.5, 0.0, 0.0, 0.0, 0.0, 1.0, time, speed);
+}
+
+}
+
+void KisStrokePredictorTest::testStraightLine()
+{
+    KisStrokePredictor predictor;
+    predictor.reset(event(QPointF(0, 0), 0, 0.0));
+
+    // 10 px every 10 ms
+    for (int i = 1; i <= 5; i++) {
+        predictor.addEvent(event(QPointF(10 * i, 0), 10 * i, 1.0));
+    }
+
+    KisPaintInformation result;
+    QVERIFY(predictor.predict(15, 1.0, &result));
+    QCOMPARE(result.pos(), QPointF(65, 0));
+    QCOMPARE(result.pressure(), 0.5);
+
+    // the speed is given in view pixels
+    QVERIFY(predictor.predict(15, 0.5, &result));
+    QCOMPARE(result.pos(), QPointF(57.5, 0));
+
+    // the prediction is limited by the length of the last segments
+    QVERIFY(predictor.predict(1000, 1.0, &result));
+    QCOMPARE(result.pos(), QPointF(90, 0));
+}
+
+void KisStrokePredictorTest::testStandingStill()
+{
+    KisStrokePredictor predictor;
+    predictor.reset(event(QPointF(10, 10), 0, 0.0));
+
+    KisPaintInformation result;
+    QVERIFY(!predictor.predict(15, 1.0, &result));
+
+    predictor.addEvent(event(QPointF(10.1, 10), 10, 0.0));
+    QVERIFY(!predictor.predict(15, 1.0, &result));
+}
+
+void KisStrokePredictorTest::testSharpTurn()
+{
+    KisStrokePredictor predictor;
+    predictor.reset(event(QPointF(0, 0), 0, 0.0));
+
+    predictor.addEvent(event(QPointF(10, 0), 10, 1.0));
+    predictor.addEvent(event(QPointF(20, 0), 20, 1.0));
+
+    // the stroke goes back
+    predictor.addEvent(event(QPointF(10, 0), 30, 1.0));
+
+    KisPaintInformation result;
+    QVERIFY(predictor.predict(5, 1.0, &result));
+    QCOMPARE(result.pos(), QPointF(5, 0));
+}
+
+void KisStrokePredictorTest::testPredictionError()
+{
+    KisStrokePredictor predictor;
+    predictor.reset(event(QPointF(0, 0), 0, 0.0));
+    predictor.addEvent(event(QPointF(10, 0), 10, 1.0));
+
+    KisPaintInformation result;
+    QVERIFY(predictor.predict(10, 1.0, &result));
+    QCOMPARE(result.pos(), QPointF(20, 0));
+
+    qreal error = 0.0;
+    QVERIFY(!predictor.takeError(&error));
+
+    // the event comes too early to check the prediction
+    predictor.addEvent(event(QPointF(14, 3), 15, 1.0));
+    QVERIFY(!predictor.takeError(&error));
+
+    // the real position at 20 ms is (18, 6)
+    predictor.addEvent(event(QPointF(22, 9), 25, 1.0));
+    QVERIFY(predictor.takeError(&error));
+    QCOMPARE(error, 2 * std::sqrt(10.0));
+
+    QVERIFY(!predictor.takeError(&error));
+}
+
+void KisStrokePredictorTest::testHorizonLongerThanInterval()
+{
+    KisStrokePredictor predictor;
+    predictor.reset(event(QPointF(0, 0), 0, 0.0));
+
+    int numPredictions = 0;
+    int numErrors = 0;
+
+    // 5 px every 5 ms, predicted 12 ms ahead after every event, as the freehand helper does
+    for (int i = 1; i <= 10; i++) {
+        predictor.addEvent(event(QPointF(5 * i, 0), 5 * i, 1.0));
+
+        qreal error = 0.0;
+        while (predictor.takeError(&error)) {
+            QVERIFY(error < 1e-6);
+            numErrors++;
+        }
+
+        KisPaintInformation result;
+        QVERIFY(predictor.predict(12, 1.0, &result));
+        QCOMPARE(result.pos(), QPointF(5 * i + 12, 0));
+        numPredictions++;
+    }
+
+    // every prediction for the time up to 50 ms has been checked: 17, 22, ... 47 ms
+    QCOMPARE(numPredictions, 10);
+    QCOMPARE(numErrors, 7);
+}
+
+QTEST_MAIN(KisStrokePredictorTest)
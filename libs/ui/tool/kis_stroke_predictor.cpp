@@ -0,0 +1,155 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_stroke_predictor.h"
+
+#include <QPointF>
+#include <QMultiMap>
+#include <QQueue>
+
+#include <kis_paint_information.h>
+
+#include "kis_global.h"
+#include "kis_algebra_2d.h"
+
+/**
+ * Shorter steps are mostly the noise of the tablet, they do not
+ * change the direction of the prediction
+ */
+#define MIN_DIRECTION_STEP 0.5
+#define MAX_SEGMENTS_AHEAD 4.0
+
+
+struct KisStrokePredictor::Private
+{
+    bool hasLastInfo = false;
+    KisPaintInformation lastInfo;
+
+    bool hasDirection = false;
+    QPointF direction;
+    qreal lastStep = 0.0;
+
+    /**
+     * The predicted positions by the time they are predicted for. The
+     * horizon is usually longer than the interval between the events,
+     * so several predictions wait for their time at once.
+     */
+    QMultiMap<qreal, QPointF> pendingPredictions;
+
+    QQueue<qreal> errors;
+
+    void checkPendingPredictions(const KisPaintInformation &pi);
+};
+
+KisStrokePredictor::KisStrokePredictor()
+    : m_d(new Private)
+{
+}
+
+KisStrokePredictor::~KisStrokePredictor()
+{
+}
+
+void KisStrokePredictor::reset(const KisPaintInformation &pi)
+{
+    *m_d = Private();
+    m_d->hasLastInfo = true;
+    m_d->lastInfo = pi;
+}
+
+void KisStrokePredictor::Private::checkPendingPredictions(const KisPaintInformation &pi)
+{
+    const qreal timeDiff = pi.currentTime() - lastInfo.currentTime();
+
+    while (!pendingPredictions.isEmpty() &&
+           pendingPredictions.firstKey() <= pi.currentTime()) {
+
+        const qreal pendingTime = pendingPredictions.firstKey();
+        const QPointF pendingPos = pendingPredictions.first();
+        pendingPredictions.erase(pendingPredictions.begin());
+
+        const qreal t = timeDiff > 0 ? (pendingTime - lastInfo.currentTime()) / timeDiff : 1.0;
+        const QPointF realPos = lastInfo.pos() + qBound(0.0, t, 1.0) * (pi.pos() - lastInfo.pos());
+
+        errors.enqueue(kisDistance(realPos, pendingPos));
+    }
+}
+
+void KisStrokePredictor::addEvent(const KisPaintInformation &pi)
+{
+    if (!m_d->hasLastInfo) {
+        reset(pi);
+        return;
+    }
+
+    m_d->checkPendingPredictions(pi);
+
+    const QPointF step = pi.pos() - m_d->lastInfo.pos();
+    const qreal length = kisDistance(pi.pos(), m_d->lastInfo.pos());
+
+    if (length < MIN_DIRECTION_STEP) {
+        // keep the position the direction is measured from
+        const QPointF pos = m_d->lastInfo.pos();
+        m_d->lastInfo = pi;
+        m_d->lastInfo.setPos(pos);
+        return;
+    }
+
+    const QPointF unitStep = step / length;
+
+    if (!m_d->hasDirection ||
+        KisAlgebra2D::dotProduct(unitStep, m_d->direction) < 0) {
+
+        // a sharp turn, the old direction is useless
+        m_d->direction = unitStep;
+        m_d->hasDirection = true;
+    } else {
+        const qreal alpha = 0.5;
+        const QPointF direction = alpha * unitStep + (1 - alpha) * m_d->direction;
+        m_d->direction = direction / KisAlgebra2D::norm(direction);
+    }
+
+    m_d->lastStep = length;
+    m_d->lastInfo = pi;
+}
+
+bool KisStrokePredictor::predict(qreal horizon, qreal speedScale, KisPaintInformation *result)
+{
+    if (!m_d->hasDirection || horizon <= 0) return false;
+
+    const qreal distance =
+        qMin(m_d->lastInfo.drawingSpeed() * speedScale * horizon,
+             m_d->lastStep * MAX_SEGMENTS_AHEAD);
+
+    if (distance < MIN_DIRECTION_STEP) return false;
+
+    *result = m_d->lastInfo;
+    result->setPos(m_d->lastInfo.pos() + distance * m_d->direction);
+
+    m_d->pendingPredictions.insert(m_d->lastInfo.currentTime() + horizon, result->pos());
+
+    return true;
+}
+
+bool KisStrokePredictor::takeError(qreal *error)
+{
+    if (m_d->errors.isEmpty()) return false;
+
+    *error = m_d->errors.dequeue();
+    return true;
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_STROKE_PREDICTOR_H
+#define __KIS_STROKE_PREDICTOR_H
+
+#include <QScopedPointer>
+
+#include "kritaui_export.h"
+
+class KisPaintInformation;
+
+
+/**
+ * Extrapolates a freehand stroke a few milliseconds ahead of the last
+ * event that has actually arrived.
+ *
+ * The direction of the prediction is a smoothed direction of the last
+ * segments of the stroke, the distance comes from the drawing speed
+ * that KisSpeedSmoother has already calculated for the event. The
+ * predicted point is never further than a few last segments from the
+ * last event, so the prediction does not run away on jittery input.
+ *
+ * Every prediction is remembered and compared to the real position of
+ * the stroke at the predicted time as soon as the events for that time
+ * arrive, even if newer predictions have been made in the meantime. The
+ * errors can be fetched with takeError().
+ *
+ * KisToolFreehandHelper uses the prediction for the brush outline
+ * only. The predicted part of the stroke is never painted.
+ */
+class KRITAUI_EXPORT KisStrokePredictor
+{
+public:
+    KisStrokePredictor();
+    ~KisStrokePredictor();
+
+    /**
+     * Starts a new stroke at \p pi
+     */
+    void reset(const KisPaintInformation &pi);
+
+    void addEvent(const KisPaintInformation &pi);
+
+    /**
+     * Predicts the stroke \p horizon milliseconds after the last event.
+     * \p speedScale converts the drawing speed of the events (view
+     * pixels per millisecond) into the units of their positions.
+     * Returns false if there is not enough data for a prediction,
+     * e.g. when the stylus stands still.
+     */
+    bool predict(qreal horizon, qreal speedScale, KisPaintInformation *result);
+
+    /**
+     * Returns true if a prediction has been checked against the real
+     * events and its error has not been taken yet. The distance between
+     * the predicted and the real position of the oldest such prediction
+     * is stored in \p error.
+     */
+    bool takeError(qreal *error);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_STROKE_PREDICTOR_H */
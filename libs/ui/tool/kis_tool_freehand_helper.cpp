@@ -20,6 +20,7 @@
 
 #include <QTimer>
 #include <QQueue>
+#include <QDateTime>
 
 #include <klocalizedstring.h>
 
@@ -37,7 +38,10 @@
 #include "kis_update_time_monitor.h"
 #include "kis_stabilized_events_sampler.h"
 #include "KisStabilizerDelayedPaintHelper.h"
+#include "kis_stroke_predictor.h"
 #include "kis_config.h"
+#include "kis_image_config.h"
+#include "recorder/kis_recorded_stroke.h"
 
 
 #include <math.h>
@@ -85,6 +89,26 @@ struct KisToolFreehandHelper::Private
     int canvasRotation;
     bool canvasMirroredH;
 
+    /**
+     * The id of the event being handled by paint() in
+     * KisUpdateTimeMonitor, the jobs created by the timers have no
+     * event
+     */
+    qint64 eventId = -1;
+
+    /**
+     * With the performance log enabled the raw events of every stroke
+     * are saved, so that they can be replayed by the benchmarks
+     */
+    bool recordEvents = false;
+    KisRecordedStroke recordedStroke;
+
+    // Prediction data
+    KisStrokePredictor predictor;
+    int predictionHorizon = 0;
+    bool hasPrediction = false;
+    KisPaintInformation predictedPaintInformation;
+
     KisPaintInformation
     getStabilizedPaintInfo(const QQueue<KisPaintInformation> &queue,
                            const KisPaintInformation &lastPaintInfo);
@@ -188,6 +212,24 @@ QPainterPath KisToolFreehandHelper::paintOpOutline(const QPointF &savedCursorPos
 
     QPainterPath outline = settings->brushOutline(info, mode);
 
+    /**
+     * Only the outline is predicted: the brush outline at the
+     * predicted point and the segment leading to it are added to the
+     * outline, no dabs are rendered for them. The outline is
+     * recalculated on every event, so it follows the real stroke as
+     * soon as the events arrive.
+     */
+    if (!m_d->painterInfos.isEmpty() && m_d->hasPrediction) {
+        KisDistanceInformation predictedDistanceInfo(distanceInfo);
+        KisPaintInformation predictedInfo(m_d->predictedPaintInformation);
+
+        KisPaintInformation::DistanceInformationRegistrar predictedRegistrar =
+            predictedInfo.registerDistanceInformation(&predictedDistanceInfo);
+
+        outline.addPath(settings->brushOutline(predictedInfo, mode));
+        outline.moveTo(info.pos());
+        outline.lineTo(predictedInfo.pos());
+    }
 
 
     if (m_d->resources &&
@@ -248,6 +290,12 @@ void KisToolFreehandHelper::initPaintImpl(const KisPaintInformation &previousPai
 
     m_d->previousPaintInformation = previousPaintInformation;
 
+    m_d->recordEvents = KisImageConfig().enablePerfLog();
+    m_d->recordedStroke.clear();
+    if (m_d->recordEvents) {
+        m_d->recordedStroke.addEvent(previousPaintInformation);
+    }
+
     createPainters(m_d->painterInfos,
                    m_d->previousPaintInformation.pos(),
                    m_d->previousPaintInformation.currentTime());
@@ -283,6 +331,17 @@ void KisToolFreehandHelper::initPaintImpl(const KisPaintInformation &previousPai
     if (m_d->smoothingOptions->smoothingType() == KisSmoothingOptions::STABILIZER) {
         stabilizerStart(m_d->previousPaintInformation);
     }
+
+    /**
+     * The stabilizer lags behind the stylus on purpose, predicting
+     * the stroke would defeat it
+     */
+    KisConfig cfg;
+    m_d->predictionHorizon =
+        m_d->smoothingOptions->smoothingType() != KisSmoothingOptions::STABILIZER ?
+        cfg.strokePredictionHorizon() : 0;
+    m_d->hasPrediction = false;
+    m_d->predictor.reset(m_d->previousPaintInformation);
 }
 
 void KisToolFreehandHelper::paintBezierSegment(KisPaintInformation pi1, KisPaintInformation pi2,
@@ -387,6 +446,8 @@ qreal KisToolFreehandHelper::Private::effectiveSmoothnessDistance() const
 
 void KisToolFreehandHelper::paint(KoPointerEvent *event)
 {
+    m_d->eventId = KisUpdateTimeMonitor::instance()->registerEvent(event->time());
+
     KisPaintInformation info =
             m_d->infoBuilder->continueStroke(event,
                                              elapsedStrokeTime());
@@ -395,6 +456,24 @@ void KisToolFreehandHelper::paint(KoPointerEvent *event)
 
     KisUpdateTimeMonitor::instance()->reportMouseMove(info.pos());
 
+    if (m_d->recordEvents) {
+        m_d->recordedStroke.addEvent(info);
+    }
+
+    if (m_d->predictionHorizon > 0) {
+        m_d->predictor.addEvent(info);
+
+        qreal predictionError = 0.0;
+        while (m_d->predictor.takeError(&predictionError)) {
+            KisUpdateTimeMonitor::instance()->reportPredictionError(predictionError);
+        }
+
+        m_d->hasPrediction =
+            m_d->predictor.predict(m_d->predictionHorizon,
+                                   1.0 / m_d->resources->effectiveZoom(),
+                                   &m_d->predictedPaintInformation);
+    }
+
     /**
      * Smooth the coordinates out using the history and the
      * distance. This is a heavily modified version of an algo used in
@@ -540,6 +619,8 @@ void KisToolFreehandHelper::paint(KoPointerEvent *event)
     if(m_d->airbrushingTimer.isActive()) {
         m_d->airbrushingTimer.start();
     }
+
+    m_d->eventId = -1;
 }
 
 void KisToolFreehandHelper::endPaint()
@@ -550,6 +631,7 @@ void KisToolFreehandHelper::endPaint()
         finishStroke();
     }
     m_d->strokeTimeoutTimer.stop();
+    m_d->hasPrediction = false;
 
     if(m_d->airbrushingTimer.isActive()) {
         m_d->airbrushingTimer.stop();
@@ -573,6 +655,14 @@ void KisToolFreehandHelper::endPaint()
     if(m_d->recordingAdapter) {
         m_d->recordingAdapter->endStroke();
     }
+
+    if (m_d->recordEvents && !m_d->recordedStroke.isEmpty()) {
+        const QString fileName =
+            QString("log/%1.kstroke").arg(QDateTime::currentMSecsSinceEpoch());
+
+        KisRecordedStroke::save(fileName, QVector<KisRecordedStroke>() << m_d->recordedStroke);
+        m_d->recordedStroke.clear();
+    }
 }
 
 void KisToolFreehandHelper::cancelPaint()
@@ -580,6 +670,7 @@ void KisToolFreehandHelper::cancelPaint()
     if (!m_d->strokeId) return;
 
     m_d->strokeTimeoutTimer.stop();
+    m_d->hasPrediction = false;
 
     if (m_d->airbrushingTimer.isActive()) {
         m_d->airbrushingTimer.stop();
@@ -598,6 +689,7 @@ void KisToolFreehandHelper::cancelPaint()
 
     m_d->strokesFacade->cancelStroke(m_d->strokeId);
     m_d->strokeId.clear();
+    m_d->recordedStroke.clear();
 
     if(m_d->recordingAdapter) {
         //FIXME: not implemented
@@ -781,9 +873,12 @@ void KisToolFreehandHelper::paintAt(int painterInfoId,
                                     const KisPaintInformation &pi)
 {
     m_d->hasPaintAtLeastOnce = true;
-    m_d->strokesFacade->addJob(m_d->strokeId,
-                               new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
-                                                                painterInfoId, pi));
+
+    FreehandStrokeStrategy::Data *data =
+        new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
+                                         painterInfoId, pi);
+    data->eventId = m_d->eventId;
+    m_d->strokesFacade->addJob(m_d->strokeId, data);
 
     if(m_d->recordingAdapter) {
         m_d->recordingAdapter->addPoint(pi);
@@ -795,9 +890,12 @@ void KisToolFreehandHelper::paintLine(int painterInfoId,
                                       const KisPaintInformation &pi2)
 {
     m_d->hasPaintAtLeastOnce = true;
-    m_d->strokesFacade->addJob(m_d->strokeId,
-                               new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
-                                                                painterInfoId, pi1, pi2));
+
+    FreehandStrokeStrategy::Data *data =
+        new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
+                                         painterInfoId, pi1, pi2);
+    data->eventId = m_d->eventId;
+    m_d->strokesFacade->addJob(m_d->strokeId, data);
 
     if(m_d->recordingAdapter) {
         m_d->recordingAdapter->addLine(pi1, pi2);
@@ -835,10 +933,13 @@ void KisToolFreehandHelper::paintBezierCurve(int painterInfoId,
 #endif
 
     m_d->hasPaintAtLeastOnce = true;
-    m_d->strokesFacade->addJob(m_d->strokeId,
-                               new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
-                                                                painterInfoId,
-                                                                pi1, control1, control2, pi2));
+
+    FreehandStrokeStrategy::Data *data =
+        new FreehandStrokeStrategy::Data(m_d->resources->currentNode(),
+                                         painterInfoId,
+                                         pi1, control1, control2, pi2);
+    data->eventId = m_d->eventId;
+    m_d->strokesFacade->addJob(m_d->strokeId, data);
 
     if(m_d->recordingAdapter) {
         m_d->recordingAdapter->addCurve(pi1, control1, control2, pi2);
@@ -24,6 +24,8 @@
 #include "kis_painter.h"
 
 #include "kis_update_time_monitor.h"
+#include "kis_image.h"
+#include "kis_lod_transform.h"
 
 #include <brushengine/kis_stroke_random_source.h>
 
@@ -34,6 +36,7 @@ struct FreehandStrokeStrategy::Private
 
     KisStrokeRandomSource randomSource;
     KisResourcesSnapshotSP resources;
+    int levelOfDetail = 0;
 };
 
 FreehandStrokeStrategy::FreehandStrokeStrategy(bool needsIndirectPainting,
@@ -65,6 +68,7 @@ FreehandStrokeStrategy::FreehandStrokeStrategy(const FreehandStrokeStrategy &rhs
       m_d(new Private(*rhs.m_d))
 {
     m_d->randomSource.setLevelOfDetail(levelOfDetail);
+    m_d->levelOfDetail = levelOfDetail;
 }
 
 FreehandStrokeStrategy::~FreehandStrokeStrategy()
@@ -137,6 +141,33 @@ void FreehandStrokeStrategy::doStrokeCallback(KisStrokeJobData *data)
 
     QVector<QRect> dirtyRects = info->painter->takeDirtyRegion();
     KisUpdateTimeMonitor::instance()->reportJobFinished(data, dirtyRects);
+
+    if (d->eventId >= 0) {
+        /**
+         * The walkers crop the updates by the image bounds, so the
+         * parts of the dabs outside the image never reach the canvas.
+         * The canvas gets the updates in the coordinates of the
+         * full-size image.
+         */
+        const QRect imageBounds = m_d->resources->image()->bounds();
+        const QRect lodBounds = KisLodTransform(m_d->levelOfDetail).map(imageBounds);
+
+        QVector<QRect> eventRects;
+
+        Q_FOREACH (const QRect &rc, dirtyRects) {
+            QRect eventRect = rc & lodBounds;
+            if (eventRect.isEmpty()) continue;
+
+            if (m_d->levelOfDetail) {
+                eventRect = KisLodTransform::upscaledRect(eventRect, m_d->levelOfDetail) & imageBounds;
+            }
+
+            eventRects.append(eventRect);
+        }
+
+        KisUpdateTimeMonitor::instance()->reportEventPainted(d->eventId, eventRects);
+    }
+
     d->node->setDirty(dirtyRects);
 }
 
@@ -110,7 +110,8 @@ public:
             : KisStrokeJobData(rhs),
               node(rhs.node),
               painterInfoId(rhs.painterInfoId),
-              type(rhs.type)
+              type(rhs.type),
+              eventId(rhs.eventId)
         {
             KisLodTransform t(levelOfDetail);
 
@@ -169,6 +170,12 @@ public:
         QPainterPath path;
         QPen pen;
         KoColor customColor;
+
+        /**
+         * The id of the input event that caused the job in
+         * KisUpdateTimeMonitor, or -1 if there is no such event
+         */
+        qint64 eventId = -1;
     };
 
 public:
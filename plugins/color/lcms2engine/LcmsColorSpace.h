@@ -26,6 +26,9 @@
 #include <KoColorSpaceAbstract.h>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QVector>
+#include <limits>
+#include <type_traits>
 
 class LcmsColorProfileContainer;
 
@@ -153,6 +156,93 @@ class LcmsColorSpace : public KoColorSpaceAbstract<_CSTraits>, public KoLcmsInfo
         cmsHTRANSFORM cmsAlphaTransform;
     };
 
+    /**
+     * Applies the transfer tables passed to createPerChannelAdjustment()
+     * as plain per-channel lookups. The tables are resampled once into
+     * a lookup of every possible channel value, so no LCMS transform
+     * and no separate alpha pass is needed. Works for integer channels
+     * only.
+     */
+    struct KoLcmsPerChannelLutTransformation : public KoColorTransformation {
+        typedef typename _CSTraits::channels_type channels_type;
+
+        KoLcmsPerChannelLutTransformation(const KoColorSpace *colorSpace, const quint16 *const *transferValues)
+            : m_tables(_CSTraits::channels_nb)
+        {
+            const QList<KoChannelInfo *> channels =
+                KoChannelInfo::displayOrderSorted(colorSpace->channels());
+            const quint32 colorChannelCount = colorSpace->colorChannelCount();
+
+            // the transfers go in display order, the alpha one is the last
+            int colorIndex = 0;
+            Q_FOREACH (KoChannelInfo *channel, channels) {
+                const quint16 *transfer =
+                    channel->channelType() == KoChannelInfo::ALPHA ?
+                    transferValues[colorChannelCount] :
+                    transferValues[colorIndex++];
+
+                const int nativeIndex = channel->pos() / sizeof(channels_type);
+                m_tables[nativeIndex] = createTable(transfer);
+            }
+        }
+
+        virtual void transform(const quint8 *src, quint8 *dst, qint32 nPixels) const
+        {
+            const channels_type *srcPtr = reinterpret_cast<const channels_type *>(src);
+            channels_type *dstPtr = reinterpret_cast<channels_type *>(dst);
+            const int numChannels = _CSTraits::channels_nb;
+
+            for (int ch = 0; ch < numChannels; ch++) {
+                const channels_type *table = m_tables[ch].constData();
+                const channels_type *s = srcPtr + ch;
+                channels_type *d = dstPtr + ch;
+
+                if (table) {
+                    for (qint32 i = 0; i < nPixels; i++) {
+                        *d = table[*s];
+                        s += numChannels;
+                        d += numChannels;
+                    }
+                } else if (src != dst) {
+                    for (qint32 i = 0; i < nPixels; i++) {
+                        *d = *s;
+                        s += numChannels;
+                        d += numChannels;
+                    }
+                }
+            }
+        }
+
+    private:
+        /**
+         * Resamples a 256-entry 16-bit transfer table into a lookup of
+         * every value of the channel, linearly interpolating between
+         * the entries like the LCMS tone curves do. A null \p transfer
+         * means identity and gives an empty table.
+         */
+        static QVector<channels_type> createTable(const quint16 *transfer)
+        {
+            QVector<channels_type> table;
+            if (!transfer) return table;
+
+            const int maxValue = std::numeric_limits<channels_type>::max();
+            table.resize(maxValue + 1);
+
+            for (int value = 0; value <= maxValue; value++) {
+                const qreal position = qreal(value) * 255 / maxValue;
+                const int cell = qMin(int(position), 254);
+                const qreal rest = position - cell;
+
+                const qreal result = transfer[cell] + (transfer[cell + 1] - transfer[cell]) * rest;
+                table[value] = channels_type(qBound(0, qRound(result * maxValue / 65535), maxValue));
+            }
+
+            return table;
+        }
+
+        QVector<QVector<channels_type> > m_tables;
+    };
+
     struct Private {
         mutable quint8 *qcolordata; // A small buffer for conversion from and to qcolor.
         KoLcmsDefaultTransformations *defaultTransformations;
@@ -328,6 +418,25 @@ public:
             return 0;
         }
 
+        /**
+         * For integer RGB and Gray the linearization device link is
+         * just a set of independent curves, so apply them directly.
+         * Other models (Lab, CMYK, ...) still go through LCMS.
+         */
+        if (this->colorSpaceSignature() == cmsSigRgbData ||
+            this->colorSpaceSignature() == cmsSigGrayData) {
+
+            typedef typename _CSTraits::channels_type channels_type;
+            typedef std::integral_constant<bool,
+                std::numeric_limits<channels_type>::is_integer &&
+                sizeof(channels_type) <= 2> UseLut;
+
+            KoColorTransformation *lut = createPerChannelLutTransformation(transferValues, UseLut());
+            if (lut) {
+                return lut;
+            }
+        }
+
         cmsToneCurve **transferFunctions = new cmsToneCurve*[ this->colorChannelCount()];
 
         for (uint ch = 0; ch < this->colorChannelCount(); ch++) {
@@ -425,6 +534,17 @@ public:
 
 private:
 
+    KoColorTransformation *createPerChannelLutTransformation(const quint16 *const *transferValues, std::true_type) const
+    {
+        return new KoLcmsPerChannelLutTransformation(this, transferValues);
+    }
+
+    KoColorTransformation *createPerChannelLutTransformation(const quint16 *const *transferValues, std::false_type) const
+    {
+        Q_UNUSED(transferValues);
+        return 0;
+    }
+
     inline LcmsColorProfileContainer *lcmsProfile() const
     {
         return d->profile;
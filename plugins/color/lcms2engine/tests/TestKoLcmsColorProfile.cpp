@@ -5,6 +5,7 @@
 #include <LcmsColorProfileContainer.h>
 
 #include <KoColor.h>
+#include <KoColorTransformation.h>
 
 #include <QTest>
 
@@ -211,4 +212,35 @@ void TestKoLcmsColorProfile::testProofingConversion()
     Q_ASSERT((dst[0] == alarm[0]) && (dst[1] == alarm[1]) && (dst[2] == alarm[2]));
 
 }
+
+void TestKoLcmsColorProfile::testPerChannelAdjustment()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    quint16 invertTransfer[256];
+    quint16 halfTransfer[256];
+    for (int i = 0; i < 256; i++) {
+        invertTransfer[i] = (255 - i) * 257;
+        halfTransfer[i] = i * 257 / 2;
+    }
+
+    // red, green, blue and alpha; null means identity
+    const quint16 *transfers[4] = {invertTransfer, 0, 0, halfTransfer};
+
+    KoColorTransformation *adjustment = cs->createPerChannelAdjustment(transfers);
+    QVERIFY(adjustment);
+
+    // the pixels are stored as BGRA
+    const quint8 src[4] = {30, 20, 10, 255};
+    quint8 dst[4] = {0, 0, 0, 0};
+    adjustment->transform(src, dst, 1);
+
+    QCOMPARE(int(dst[0]), 30);
+    QCOMPARE(int(dst[1]), 20);
+    QCOMPARE(int(dst[2]), 245);
+    QCOMPARE(int(dst[3]), 127);
+
+    delete adjustment;
+}
+
 QTEST_MAIN(TestKoLcmsColorProfile)
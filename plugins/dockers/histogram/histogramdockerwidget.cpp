@@ -24,15 +24,16 @@
 #include <QTime>
 #include <QPainter>
 #include <functional>
+#include <cmath>
+#include <QtMath>
 
 #include "KoChannelInfo.h"
 #include "kis_paint_device.h"
 #include "KoColorSpace.h"
-#include "kis_iterator_ng.h"
 #include "kis_canvas2.h"
 
 HistogramDockerWidget::HistogramDockerWidget(QWidget *parent, const char *name, Qt::WindowFlags f)
-    : QLabel(parent, f), m_paintDevice(nullptr), m_smoothHistogram(true)
+    : QLabel(parent, f), m_paintDevice(nullptr), m_histogram(new KisTiledHistogram()), m_updatePending(false), m_smoothHistogram(true)
 {
     setObjectName(name);
 }
@@ -52,18 +53,55 @@ void HistogramDockerWidget::setPaintDevice(KisCanvas2* canvas)
         m_bounds = QRect();
         m_histogramData.clear();
     }
+
+    // the cached cells belong to the previous image
+    m_histogram.reset(new KisTiledHistogram());
+}
+
+void HistogramDockerWidget::invalidate(const QRect &rect)
+{
+    if (m_histogram) {
+        m_histogram->invalidate(rect);
+    }
 }
 
 void HistogramDockerWidget::updateHistogram()
 {
+    /**
+     * Only one worker may update the cells at a time, otherwise a
+     * slower worker working on an older clone could overwrite the
+     * cells computed by a newer one. The requests coming while a
+     * worker is running are coalesced into a single update, which
+     * takes all the cells dirtied meanwhile.
+     */
+    if (m_workerThread) {
+        m_updatePending = true;
+        return;
+    }
+
     if (!m_paintDevice.isNull()) {
         KisPaintDeviceSP m_devClone = new KisPaintDevice(m_paintDevice->colorSpace());
 
         m_devClone->makeCloneFrom(m_paintDevice, m_bounds);
 
-        HistogramComputationThread *workerThread = new HistogramComputationThread(m_devClone, m_bounds);
+        /**
+         * The dirty cells must be taken together with the clone,
+         * otherwise the changes done before the thread starts would
+         * be marked as processed.
+         */
+        const KisTiledHistogram::CellSet dirtyCells = m_histogram->takeDirtyCells();
+
+        // for speed use about 1M pixels for computing histograms
+        const qreal imageSize = qreal(m_bounds.width()) * m_bounds.height();
+        const int samplingStep = qMax(1, qCeil(std::sqrt(imageSize / (1 << 20))));
+
+        HistogramComputationThread *workerThread =
+            new HistogramComputationThread(m_histogram, m_devClone, m_bounds,
+                                           dirtyCells, samplingStep);
         connect(workerThread, &HistogramComputationThread::resultReady, this, &HistogramDockerWidget::receiveNewHistogram);
+        connect(workerThread, &HistogramComputationThread::finished, this, &HistogramDockerWidget::slotWorkerFinished);
         connect(workerThread, &HistogramComputationThread::finished, workerThread, &QObject::deleteLater);
+        m_workerThread = workerThread;
         workerThread->start();
     } else {
         m_histogramData.clear();
@@ -71,8 +109,23 @@ void HistogramDockerWidget::updateHistogram()
     }
 }
 
+void HistogramDockerWidget::slotWorkerFinished()
+{
+    m_workerThread.clear();
+
+    if (m_updatePending) {
+        m_updatePending = false;
+        updateHistogram();
+    }
+}
+
 void HistogramDockerWidget::receiveNewHistogram(HistVector *histogramData)
 {
+    HistogramComputationThread *workerThread = qobject_cast<HistogramComputationThread*>(sender());
+
+    // the result was computed for the previous image
+    if (workerThread && workerThread->histogram() != m_histogram) return;
+
     m_histogramData = *histogramData;
     update();
 }
@@ -156,40 +209,6 @@ void HistogramDockerWidget::paintEvent(QPaintEvent *event)
 
 void HistogramComputationThread::run()
 {
-    const KoColorSpace *cs = m_dev->colorSpace();
-    quint32 channelCount = m_dev->channelCount();
-    quint32 pixelSize = m_dev->pixelSize();
-
-    quint32 imageSize = m_bounds.width() * m_bounds.height();
-    quint32 nSkip = 1 + (imageSize >> 20); //for speed use about 1M pixels for computing histograms
-
-    //allocate space for the histogram data
-    bins.resize((int)channelCount);
-    for (auto &bin : bins) {
-        bin.resize(std::numeric_limits<quint8>::max() + 1);
-    }
-
-    QRect bounds = m_dev->exactBounds();
-    if (bounds.isEmpty())
-        return;
-
-    KisSequentialConstIterator it(m_dev, m_dev->exactBounds());
-    int i;
-    quint32 toSkip = nSkip;
-
-    do {
-        i = it.nConseqPixels();
-        const quint8* pixel = it.rawDataConst();
-        for (int k = 0; k < i; ++k) {
-            if (--toSkip == 0) {
-                for (int chan = 0; chan < (int)channelCount; ++chan) {
-                    bins[chan][cs->scaleToU8(pixel, chan)]++;
-                }
-                toSkip = nSkip;
-            }
-            pixel += pixelSize;
-        }
-    } while (it.nextPixels(i));
-
+    bins = m_histogram->calculate(m_dev, m_bounds, m_dirtyCells, m_samplingStep);
     emit resultReady(&bins);
 }
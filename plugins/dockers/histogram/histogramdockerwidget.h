@@ -23,7 +23,10 @@
 #include <QWidget>
 #include <QLabel>
 #include <QThread>
+#include <QSharedPointer>
+#include <QPointer>
 #include "kis_types.h"
+#include "kis_tiled_histogram.h"
 #include <vector>
 
 class KisCanvas2;
@@ -35,17 +38,32 @@ class HistogramComputationThread : public QThread
 {
     Q_OBJECT
 public:
-    HistogramComputationThread(KisPaintDeviceSP _dev, const QRect& _bounds) : m_dev(_dev), m_bounds(_bounds)
+    HistogramComputationThread(QSharedPointer<KisTiledHistogram> histogram,
+                               KisPaintDeviceSP _dev, const QRect& _bounds,
+                               const KisTiledHistogram::CellSet &dirtyCells,
+                               int samplingStep)
+        : m_histogram(histogram),
+          m_dev(_dev),
+          m_bounds(_bounds),
+          m_dirtyCells(dirtyCells),
+          m_samplingStep(samplingStep)
     {}
 
     void run() override;
 
+    QSharedPointer<KisTiledHistogram> histogram() const {
+        return m_histogram;
+    }
+
 Q_SIGNALS:
     void resultReady(HistVector*);
 
 private:
+    QSharedPointer<KisTiledHistogram> m_histogram;
     KisPaintDeviceSP m_dev;
     QRect m_bounds;
+    KisTiledHistogram::CellSet m_dirtyCells;
+    int m_samplingStep;
     HistVector bins;
 };
 
@@ -58,14 +76,21 @@ public:
     HistogramDockerWidget(QWidget *parent = 0, const char *name = 0, Qt::WindowFlags f = 0);
     ~HistogramDockerWidget();
     void setPaintDevice(KisCanvas2* canvas);
+    void invalidate(const QRect &rect);
     void paintEvent(QPaintEvent *event);
 
 public Q_SLOTS:
     void updateHistogram();
     void receiveNewHistogram(HistVector*);
 
+private Q_SLOTS:
+    void slotWorkerFinished();
+
 private:
     KisPaintDeviceSP m_paintDevice;
+    QSharedPointer<KisTiledHistogram> m_histogram;
+    QPointer<HistogramComputationThread> m_workerThread;
+    bool m_updatePending;
     HistVector m_histogramData;
     QRect m_bounds;
     bool m_smoothHistogram;
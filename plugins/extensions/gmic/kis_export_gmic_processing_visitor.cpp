@@ -23,10 +23,12 @@
 #include <kis_node.h>
 #include <kis_debug.h>
 
-KisExportGmicProcessingVisitor::KisExportGmicProcessingVisitor(const KisNodeListSP nodes, QSharedPointer<gmic_list<float> > images, QRect rc)
+KisExportGmicProcessingVisitor::KisExportGmicProcessingVisitor(const KisNodeListSP nodes, QSharedPointer<gmic_list<float> > images, QRect rc,
+                                                               KisGmicLayersCacheSP cache)
     : m_nodes(nodes),
       m_images(images),
-      m_rc(rc)
+      m_rc(rc),
+      m_cache(cache)
 {
 }
 
@@ -42,12 +44,53 @@ void KisExportGmicProcessingVisitor::visitNodeWithPaintDevice(KisNode *node, Kis
         KisPaintDeviceSP device = node->paintDevice();
         gmic_image<float> &gimg = m_images->_data[index];
 
+        /**
+         * The dialog is not modal, so the layers may be painted on
+         * between the previews. The cancelled preview is undone by
+         * now, and the undo brings the old tiles back, so their
+         * versions match the cached ones again.
+         */
+        QVector<quint64> versions;
+
+        if (m_cache)
+        {
+            versions = device->tileVersions(m_rc);
+
+            QMutexLocker l(&m_cache->lock);
+            gmic_image<float> &cached = m_cache->images._data[index];
+
+            if (!cached.is_empty() && m_cache->versions[index] == versions)
+            {
+                // gmic modifies the images in place, so the cached ones are copied
+                dbgPlugins << "Using cached gmic image for" << node->name();
+                gimg = cached;
+                return;
+            }
+
+            m_cache->memory -= qint64(cached.size()) * sizeof(float);
+            cached.assign();
+            m_cache->versions[index].clear();
+        }
+
         quint32 x = m_rc.width();
         quint32 y = m_rc.height();
         quint32 z = 1;
         quint32 colorChannelCount = 4; // RGBA
         gimg.assign(x,y,z,colorChannelCount);
         KisGmicSimpleConvertor::convertToGmicImageFast(device, gimg, m_rc);
+
+        if (m_cache)
+        {
+            const qint64 size = qint64(gimg.size()) * sizeof(float);
+
+            QMutexLocker l(&m_cache->lock);
+            if (m_cache->memory + size <= m_cache->maxMemory)
+            {
+                m_cache->images._data[index] = gimg;
+                m_cache->versions[index] = versions;
+                m_cache->memory += size;
+            }
+        }
     }
 }
 
@@ -22,6 +22,8 @@
 
 #include <QSharedPointer>
 #include <QList>
+#include <QVector>
+#include <QMutex>
 
 #include <processing/kis_simple_processing_visitor.h>
 #include <kis_types.h>
@@ -34,10 +36,45 @@ class KisUndoAdapter;
 
 #include <kis_paint_device.h>
 
+/**
+ * The layers converted for a preview together with the versions of the
+ * tiles they were converted from, see KisPaintDevice::tileVersions()
+ */
+struct KisGmicLayersCache
+{
+    KisGmicLayersCache(int numLayers, qint64 maxMemory)
+        : versions(numLayers),
+          memory(0),
+          maxMemory(maxMemory)
+    {
+        images.assign(numLayers);
+    }
+
+    gmic_list<float> images;
+    QVector< QVector<quint64> > versions;
+
+    /**
+     * The size of the cached images in bytes, never above maxMemory
+     */
+    qint64 memory;
+    const qint64 maxMemory;
+
+    QMutex lock;
+};
+
+typedef QSharedPointer<KisGmicLayersCache> KisGmicLayersCacheSP;
+
 class KisExportGmicProcessingVisitor : public KisSimpleProcessingVisitor
 {
 public:
-    KisExportGmicProcessingVisitor(const KisNodeListSP nodes, QSharedPointer< gmic_list<float> > images, QRect rc = QRect());
+    /**
+     * If \p cache is set, it must have an image per node. The nodes
+     * whose tiles have not changed since they were cached are copied
+     * from there instead of being converted again; the converted ones
+     * are stored in the cache while it fits into its memory limit.
+     */
+    KisExportGmicProcessingVisitor(const KisNodeListSP nodes, QSharedPointer< gmic_list<float> > images, QRect rc = QRect(),
+                                   KisGmicLayersCacheSP cache = KisGmicLayersCacheSP());
 
 protected:
     void visitNodeWithPaintDevice(KisNode *node, KisUndoAdapter *undoAdapter);
@@ -52,6 +89,7 @@ private:
     KisNodeListSP m_nodes;
     QSharedPointer<gmic_list<float> > m_images;
     QRect m_rc; // size of the layer has to be same for some filters, e.g. colorize, use image size
+    KisGmicLayersCacheSP m_cache;
 };
 
 #endif /* __KIS_EXPORT_GMIC_PROCESSING_VISITOR_H */
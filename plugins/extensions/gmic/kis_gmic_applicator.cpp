@@ -24,6 +24,7 @@
 #include "kis_gmic_command.h"
 #include "kis_import_gmic_processing_visitor.h"
 #include "kis_image.h"
+#include "kis_image_config.h"
 #include <kis_selection.h>
 
 #include <gmic.h>
@@ -56,7 +57,7 @@ void KisGmicApplicator::preview()
 {
     // cancel previous preview if there is one
     dbgPlugins << "Request for preview, cancelling any previous possible on-canvas preview";
-    cancel();
+    cancelApplicator();
 
     KisImageSignalVector emitSignals;
     emitSignals << ComplexSizeChangedSignal() << ModifiedSignal;
@@ -82,8 +83,18 @@ void KisGmicApplicator::preview()
         layerSize = QRect(0, 0, m_image->width(), m_image->height());
     }
 
+    if (!m_layersCache || m_layersCacheRect != layerSize || m_layersCacheNodes != *m_kritaNodes)
+    {
+        dbgPlugins << "Layers cache is not valid anymore, layers will be converted";
+        KisImageConfig config(true);
+        const qint64 maxMemory = qint64(config.filterResultCacheLimit()) * 1024 * 1024;
+        m_layersCache = KisGmicLayersCacheSP(new KisGmicLayersCache(m_kritaNodes->size(), maxMemory));
+        m_layersCacheRect = layerSize;
+        m_layersCacheNodes = *m_kritaNodes;
+    }
+
     // convert krita layers to gmic layers
-    KisProcessingVisitorSP exportVisitor = new KisExportGmicProcessingVisitor(m_kritaNodes, gmicLayers, layerSize);
+    KisProcessingVisitorSP exportVisitor = new KisExportGmicProcessingVisitor(m_kritaNodes, gmicLayers, layerSize, m_layersCache);
     m_applicator->applyVisitor(exportVisitor, KisStrokeJobData::CONCURRENT);
 
     // apply gmic filters to provided layers
@@ -108,6 +119,12 @@ void KisGmicApplicator::preview()
 }
 
 void KisGmicApplicator::cancel()
+{
+    cancelApplicator();
+    dropLayersCache();
+}
+
+void KisGmicApplicator::cancelApplicator()
 {
     if (m_gmicData)
     {
@@ -152,6 +169,15 @@ void KisGmicApplicator::finish()
         m_applicatorStrokeEnded = true;
     }
     dbgPlugins << ppVar(m_applicatorStrokeEnded);
+
+    dropLayersCache();
+}
+
+void KisGmicApplicator::dropLayersCache()
+{
+    m_layersCache.clear();
+    m_layersCacheRect = QRect();
+    m_layersCacheNodes.clear();
 }
 
 float KisGmicApplicator::getProgress() const
@@ -25,6 +25,12 @@
 #include <kis_gmic_data.h>
 
 #include <QThread>
+#include <QSharedPointer>
+#include <QRect>
+
+#include <gmic.h>
+
+#include "kis_export_gmic_processing_visitor.h"
 
 class KisProcessingApplicator;
 
@@ -46,6 +52,10 @@ public:
 Q_SIGNALS:
     void gmicFinished(bool successfully, int miliseconds = -1, const QString &msg = QString());
 
+private:
+    void cancelApplicator();
+    void dropLayersCache();
+
 private:
     KisProcessingApplicator * m_applicator;
     KisImageWSP m_image;
@@ -57,8 +67,16 @@ private:
     bool m_applicatorStrokeEnded;
     KisGmicDataSP m_gmicData;
 
-
-
+    /**
+     * The layers converted for the previous preview. Every preview
+     * cancels the previous one first, so the layers are back in the
+     * same state and need not be converted again while only the
+     * filter parameters change. The cache is dropped when the
+     * preview is finished or cancelled.
+     */
+    KisGmicLayersCacheSP m_layersCache;
+    QRect m_layersCacheRect;
+    QList<KisNodeSP> m_layersCacheNodes;
 };
 
 #endif
@@ -18,6 +18,9 @@
 
 #include <kis_gmic_simple_convertor.h>
 
+#include <QVector>
+#include <QtConcurrent>
+
 #include <kis_debug.h>
 #include <kis_random_accessor_ng.h>
 
@@ -258,25 +261,45 @@ static KoColorTransformation* createTransformation(const KoColorSpace* colorSpac
 }
 
 
-void KisGmicSimpleConvertor::convertFromGmicFast(gmic_image<float>& gmicImage, KisPaintDeviceSP dst, float gmicUnitValue)
+/**
+ * Calls \p convertBand for bands of rows of \p rect, which are aligned
+ * to the tiles of \p dev, on the global thread pool. The bands never
+ * share tiles, so every one of them uses its own accessor and buffers.
+ */
+template <typename Func>
+static void processTileRowsInParallel(KisPaintDeviceSP dev, const QRect &rect, Func convertBand)
 {
-    const KoColorSpace * dstColorSpace = dst->colorSpace();
-    KoColorTransformation * gmicToDstPixelFormat = createTransformationFromGmic(dstColorSpace,gmicImage._spectrum,gmicUnitValue);
-    if (gmicToDstPixelFormat == 0)
-    {
-            dbgPlugins << "Fall-back to slow color conversion";
-            convertFromGmicImage(gmicImage, dst, gmicUnitValue);
-            return;
+    KisRandomConstAccessorSP it = dev->createRandomConstAccessorNG(rect.x(), rect.y());
+
+    QVector<QFuture<void>> jobs;
+
+    for (qint32 top = rect.top(); top <= rect.bottom();) {
+        const qint32 bandHeight = qMin(rect.bottom() - top + 1, it->numContiguousRows(top));
+
+        const QRect band(rect.left(), top, rect.width(), bandHeight);
+        jobs.append(QtConcurrent::run([convertBand, band] () { convertBand(band); }));
+
+        top += bandHeight;
     }
 
-    qint32 x = 0;
-    qint32 y = 0;
-    qint32 width = gmicImage._width;
-    qint32 height = gmicImage._height;
+    Q_FOREACH (QFuture<void> job, jobs) {
+        job.waitForFinished();
+    }
+}
 
-    width  = width < 0  ? 0 : width;
-    height = height < 0 ? 0 : height;
+/**
+ * Converts the rows of \p band of the gmic image into \p dst.
+ */
+static void convertBandFromGmicFast(gmic_image<float>& gmicImage, KisPaintDeviceSP dst,
+                                    const KoColorTransformation *gmicToDstPixelFormat,
+                                    float gmicUnitValue, const QRect &band)
+{
+    const KoColorSpace * dstColorSpace = dst->colorSpace();
 
+    qint32 x = band.x();
+    qint32 y = band.y();
+    qint32 width = gmicImage._width;
+    qint32 height = band.height();
 
     const KoColorSpace *rgbaFloat32bitcolorSpace = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(),
                                                                                                 Float32BitsColorDepthID.id(),
@@ -299,7 +322,7 @@ void KisGmicSimpleConvertor::convertFromGmicFast(gmic_image<float>& gmicImage, K
         planes[channelIndex] = 0; //turn off
     }
 
-    qint32 dataY = 0;
+    qint32 dataY = y;
     qint32 imageY = y;
     qint32 rowsRemaining = height;
 
@@ -388,36 +411,47 @@ void KisGmicSimpleConvertor::convertFromGmicFast(gmic_image<float>& gmicImage, K
     }
 
     delete [] convertedTile;
-    delete gmicToDstPixelFormat;
-
 }
 
-
-
-void KisGmicSimpleConvertor::convertToGmicImageFast(KisPaintDeviceSP dev, CImg< float >& gmicImage, QRect rc)
+void KisGmicSimpleConvertor::convertFromGmicFast(gmic_image<float>& gmicImage, KisPaintDeviceSP dst, float gmicUnitValue)
 {
-    KoColorTransformation * pixelToGmicPixelFormat = createTransformation(dev->colorSpace());
-    if (pixelToGmicPixelFormat == 0)
-    {
-        dbgPlugins << "Fall-back to slow color conversion method";
-        convertToGmicImage(dev, gmicImage, rc);
-        return;
-    }
-
-    if (rc.isEmpty())
+    const KoColorSpace * dstColorSpace = dst->colorSpace();
+    KoColorTransformation * gmicToDstPixelFormat = createTransformationFromGmic(dstColorSpace,gmicImage._spectrum,gmicUnitValue);
+    if (gmicToDstPixelFormat == 0)
     {
-        dbgPlugins << "Image rectangle is empty! Using supplied gmic layer dimension";
-        rc = QRect(0,0,gmicImage._width, gmicImage._height);
+            dbgPlugins << "Fall-back to slow color conversion";
+            convertFromGmicImage(gmicImage, dst, gmicUnitValue);
+            return;
     }
 
-    qint32 x = rc.x();
-    qint32 y = rc.y();
-    qint32 width = rc.width();
-    qint32 height = rc.height();
+    qint32 width = gmicImage._width;
+    qint32 height = gmicImage._height;
 
     width  = width < 0  ? 0 : width;
     height = height < 0 ? 0 : height;
 
+    // the transformations from gmic are stateless, so the bands share it
+    processTileRowsInParallel(dst, QRect(0, 0, width, height),
+        [&gmicImage, dst, gmicToDstPixelFormat, gmicUnitValue] (const QRect &band) {
+            convertBandFromGmicFast(gmicImage, dst, gmicToDstPixelFormat, gmicUnitValue, band);
+        });
+
+    delete gmicToDstPixelFormat;
+}
+
+/**
+ * Converts \p band of \p dev into the corresponding rows of the
+ * gmic image, which covers \p rc
+ */
+static void convertBandToGmicImageFast(KisPaintDeviceSP dev, gmic_image<float>& gmicImage,
+                                       const KoColorTransformation *pixelToGmicPixelFormat,
+                                       const QRect &rc, const QRect &band)
+{
+    qint32 x = band.x();
+    qint32 y = band.y();
+    qint32 width = rc.width();
+    qint32 height = band.height();
+
     const qint32 numChannels = 4;
 
     int greenOffset = gmicImage._width * gmicImage._height;
@@ -446,7 +480,7 @@ void KisGmicSimpleConvertor::convertToGmicImageFast(KisPaintDeviceSP dev, CImg<
 
     quint8 * dstTile = new quint8[rgbaFloat32bitcolorSpace->pixelSize() * tileWidth * tileHeight];
 
-    qint32 dataY = 0;
+    qint32 dataY = y - rc.y();
     qint32 imageX = x;
     qint32 imageY = y;
     it->moveTo(imageX, imageY);
@@ -528,8 +562,31 @@ void KisGmicSimpleConvertor::convertToGmicImageFast(KisPaintDeviceSP dev, CImg<
     }
 
     delete [] dstTile;
-    delete pixelToGmicPixelFormat;
+}
 
+void KisGmicSimpleConvertor::convertToGmicImageFast(KisPaintDeviceSP dev, CImg< float >& gmicImage, QRect rc)
+{
+    KoColorTransformation * pixelToGmicPixelFormat = createTransformation(dev->colorSpace());
+    if (pixelToGmicPixelFormat == 0)
+    {
+        dbgPlugins << "Fall-back to slow color conversion method";
+        convertToGmicImage(dev, gmicImage, rc);
+        return;
+    }
+
+    if (rc.isEmpty())
+    {
+        dbgPlugins << "Image rectangle is empty! Using supplied gmic layer dimension";
+        rc = QRect(0,0,gmicImage._width, gmicImage._height);
+    }
+
+    // the transformations to gmic are stateless, so the bands share it
+    processTileRowsInParallel(dev, rc,
+        [dev, &gmicImage, pixelToGmicPixelFormat, rc] (const QRect &band) {
+            convertBandToGmicImageFast(dev, gmicImage, pixelToGmicPixelFormat, rc, band);
+        });
+
+    delete pixelToGmicPixelFormat;
 }
 
 // gmic assumes float rgba in 0.0 - 255.0, thus default value
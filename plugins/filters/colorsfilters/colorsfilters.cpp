@@ -92,6 +92,7 @@ KisAutoContrast::KisAutoContrast() : KisFilter(id(), categoryAdjust(), i18n("&Au
     setSupportsAdjustmentLayers(false);
     setColorSpaceIndependence(TO_LAB16);
     setShowConfigurationWidget(false);
+    setSupportsLevelOfDetail(true);
 }
 
 void KisAutoContrast::processImpl(KisPaintDeviceSP device,
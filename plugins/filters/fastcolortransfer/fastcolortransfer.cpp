@@ -60,6 +60,7 @@ KisFilterFastColorTransfer::KisFilterFastColorTransfer() : KisFilter(id(), categ
     setSupportsThreading(false);
     setSupportsPainting(false);
     setSupportsAdjustmentLayers(false);
+    setSupportsLevelOfDetail(true);
 }
 
 
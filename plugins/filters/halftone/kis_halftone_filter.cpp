@@ -35,6 +35,7 @@
 #include <kis_painter.h>
 #include <kis_pixel_selection.h>
 #include <kis_selection.h>
+#include <kis_lod_transform.h>
 
 #include "kis_halftone_filter.h"
 
@@ -57,7 +58,7 @@ KisHalftoneFilter::KisHalftoneFilter()
 
     setSupportsPainting(false);
     setShowConfigurationWidget(true);
-    setSupportsLevelOfDetail(false);
+    setSupportsLevelOfDetail(true);
     setSupportsAdjustmentLayers(false);
     setSupportsThreading(false);
 }
@@ -68,7 +69,8 @@ void KisHalftoneFilter::processImpl(KisPaintDeviceSP device,
                                     const KisFilterConfigurationSP config,
                                     KoUpdater *progressUpdater) const
 {
-    qreal cellSize = (qreal)config->getInt("cellSize", 8);
+    KisLodTransformScalar t(device);
+    qreal cellSize = qMax(qreal(1.0), t.scale(config->getInt("cellSize", 8)));
     qreal angle = fmod((qreal)config->getInt("patternAngle", 45), 90.0);
     KoColor foregroundC(Qt::black, device->colorSpace());
     foregroundC.fromKoColor(config->getColor("foreGroundColor", KoColor(Qt::black, device->colorSpace()) ) );
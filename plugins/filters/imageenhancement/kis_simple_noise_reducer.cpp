@@ -35,11 +35,13 @@
 #include <kis_paint_device.h>
 #include <kis_selection.h>
 #include <kis_iterator_ng.h>
+#include <kis_lod_transform.h>
 
 KisSimpleNoiseReducer::KisSimpleNoiseReducer()
         : KisFilter(id(), categoryEnhance(), i18n("&Gaussian Noise Reduction..."))
 {
     setSupportsPainting(false);
+    setSupportsLevelOfDetail(true);
 }
 
 KisSimpleNoiseReducer::~KisSimpleNoiseReducer()
@@ -90,6 +92,9 @@ void KisSimpleNoiseReducer::processImpl(KisPaintDeviceSP device,
     threshold = config->getInt("threshold", 15);
     windowsize = config->getInt("windowsize", 1);
 
+    KisLodTransformScalar t(device);
+    windowsize = qRound(t.scale(windowsize));
+
     const KoColorSpace* cs = device->colorSpace();
 
     // Compute the blur mask
@@ -37,6 +37,7 @@ KisWaveletNoiseReduction::KisWaveletNoiseReduction()
 {
     setSupportsPainting(false);
     setSupportsThreading(false);
+    setSupportsLevelOfDetail(true);
 }
 
 
@@ -65,6 +65,7 @@ KisFilterNoise::KisFilterNoise() : KisFilter(id(), categoryOther(), i18n("&Rando
 {
     setColorSpaceIndependence(FULLY_INDEPENDENT);
     setSupportsPainting(true);
+    setSupportsLevelOfDetail(true);
 }
 
 KisFilterConfigurationSP KisFilterNoise::factoryConfiguration() const
@@ -27,6 +27,7 @@
 
 #include <stdlib.h>
 #include <vector>
+#include <algorithm>
 
 #include <QPoint>
 #include <QSpinBox>
@@ -48,6 +49,7 @@
 #include <filter/kis_filter_configuration.h>
 #include <kis_processing_information.h>
 #include <kis_paint_device.h>
+#include "kis_lod_transform.h"
 #include "widgets/kis_multi_integer_filter_widget.h"
 
 
@@ -56,6 +58,16 @@ KisOilPaintFilter::KisOilPaintFilter() : KisFilter(id(), KisFilter::categoryArti
     setSupportsPainting(true);
     setSupportsThreading(false);
     setSupportsAdjustmentLayers(true);
+    setSupportsLevelOfDetail(true);
+}
+
+int KisOilPaintFilter::getBrushSize(const KisFilterConfigurationSP config, int lod)
+{
+    KisLodTransformScalar t(lod);
+    const int brushSize = config ? config->getInt("brushSize", 1) : 1;
+
+    // the smallest brush is still one pixel, whatever the zoom level
+    return qMax(1, qRound(t.scale(brushSize)));
 }
 
 void KisOilPaintFilter::processImpl(KisPaintDeviceSP device,
@@ -64,139 +76,157 @@ void KisOilPaintFilter::processImpl(KisPaintDeviceSP device,
                                     KoUpdater* progressUpdater
                                     ) const
 {
-    QPoint srcTopLeft = applyRect.topLeft();
     Q_ASSERT(!device.isNull());
 
-    qint32 width = applyRect.width();
-    qint32 height = applyRect.height();
-
     //read the filter configuration values from the KisFilterConfiguration object
-    quint32 brushSize = config ? config->getInt("brushSize", 1) : 1;
+    const int lod = device->defaultBounds()->currentLevelOfDetail();
+    quint32 brushSize = getBrushSize(config, lod);
     quint32 smooth = config ? config->getInt("smooth", 30) : 30;
 
-    OilPaint(device, device, srcTopLeft, applyRect.topLeft(), width, height, brushSize, smooth, progressUpdater);
+    OilPaint(device, applyRect, brushSize, smooth, progressUpdater);
 }
 
 // This method have been ported from Pieter Z. Voloshyn algorithm code.
 
 /* Function to apply the OilPaint effect.
  *
- * data             => The image data in RGBA mode.
- * w                => Width of image.
- * h                => Height of image.
+ * device           => The image data, filtered in place.
+ * bounds           => The rect to filter.
  * BrushSize        => Brush size.
  * Smoothness       => Smooth value.
  *
- * Theory           => Using MostFrequentColor function we take the main color in
- *                     a matrix and simply write at the original position.
+ * Theory           => Using the most frequent intensity in a matrix we take
+ *                     the average color of its pixels and simply write it at
+ *                     the original position.
  */
 
-void KisOilPaintFilter::OilPaint(const KisPaintDeviceSP src, KisPaintDeviceSP dst, const QPoint& srcTopLeft, const QPoint& dstTopLeft, int w, int h,
+void KisOilPaintFilter::OilPaint(KisPaintDeviceSP device, const QRect& bounds,
                                  int BrushSize, int Smoothness, KoUpdater* progressUpdater) const
 {
+    const int w = bounds.width();
+    const int h = bounds.height();
+
     if (progressUpdater) {
         progressUpdater->setRange(0, w * h);
     }
 
-    QRect bounds(srcTopLeft.x(), srcTopLeft.y(), w, h);
+    const KoColorSpace* cs = device->colorSpace();
+    const int pixelSize = cs->pixelSize();
+    const int numChannels = cs->channelCount();
+    const double Scale = Smoothness / 255.0;
+
+    /**
+     * The filter works in place and every matrix already contains the
+     * filtered pixels above and to the left of its center, so the
+     * pixels are processed strictly in order. The matrix is clipped to
+     * \p bounds, but a clipped matrix is shifted instead of being
+     * shrunk on its top and left sides, so it may reach 2 * BrushSize
+     * rows below its center.
+     *
+     * Instead of iterating the device for every pixel, the intensity
+     * and the normalized channels of the rows under the matrix are
+     * kept in a ring buffer, which is updated with every filtered pixel.
+     */
+    const int numRows = 2 * BrushSize + 1;
+    QVector<uint> intensities(numRows * w);
+    QVector<float> channels(numRows * w * numChannels);
+    QByteArray row(w * pixelSize, 0);
+    int lastLoadedRow = bounds.top() - 1;
+
+    QVector<float> channel(numChannels);
+
+    auto updatePixel = [&] (const quint8 *pixel, int x, int y) {
+        const int index = ((y - bounds.top()) % numRows) * w + (x - bounds.left());
+
+        intensities[index] = (uint)(cs->intensity8(pixel) * Scale);
+
+        cs->normalisedChannelsValue(pixel, channel);
+        std::copy(channel.constBegin(), channel.constEnd(), channels.begin() + index * numChannels);
+    };
+
+    auto loadRow = [&] (int y) {
+        device->readBytes(reinterpret_cast<quint8*>(row.data()), QRect(bounds.left(), y, w, 1));
+
+        const quint8 *pixel = reinterpret_cast<const quint8*>(row.constData());
+        for (int x = bounds.left(); x <= bounds.right(); x++) {
+            updatePixel(pixel, x, y);
+            pixel += pixelSize;
+        }
+    };
 
-    KisHLineConstIteratorSP it = src->createHLineConstIteratorNG(srcTopLeft.x(), srcTopLeft.y(), w);
-    KisHLineIteratorSP dstIt = dst->createHLineIteratorNG(dstTopLeft.x(), dstTopLeft.y(), w);
+    QVector<int> IntensityCount(Smoothness + 1);
+    QVector<float> AverageChannels((Smoothness + 1) * numChannels);
 
     int progress = 0;
-    for (qint32 yOffset = 0; yOffset < h; yOffset++) {
-        do {  //&& !cancelRequested()) {
-                MostFrequentColor(src, dstIt->rawData(), bounds, it->x(), it->y(), BrushSize, Smoothness);
-        }  while (it->nextPixel() && dstIt->nextPixel());
-        it->nextRow();
-        dstIt->nextRow();
+    for (int Y = bounds.top(); Y <= bounds.bottom(); Y++) {
+        int starty = qMax(Y - BrushSize, bounds.top());
+        int height = (2 * BrushSize) + 1;
+        if ((starty + height) > bounds.bottom()) height = bounds.bottom() - starty + 1;
 
-        if (progressUpdater) progressUpdater->setValue(progress += w);
-    }
-}
-
-// This method has been ported from Pieter Z. Voloshyn's algorithm code in Digikam.
-
-/* Function to determine the most frequent color in a matrix
- *
- * Bits             => Bits array
- * Width            => Image width
- * Height           => Image height
- * X                => Position horizontal
- * Y                => Position vertical
- * Radius           => Is the radius of the matrix to be analyzed
- * Intensity        => Intensity to calculate
- *
- * Theory           => This function creates a matrix with the analyzed pixel in
- *                     the center of this matrix and find the most frequenty color
- */
-
-void KisOilPaintFilter::MostFrequentColor(KisPaintDeviceSP src, quint8* dst, const QRect& bounds, int X, int Y, int Radius, int Intensity) const
-{
-    uint I;
+        while (lastLoadedRow < starty + height - 1) {
+            loadRow(++lastLoadedRow);
+        }
 
-    double Scale = Intensity / 255.0;
+        quint8 *dst = reinterpret_cast<quint8*>(row.data());
 
-    // Alloc some arrays to be used
-    uchar *IntensityCount = new uchar[(Intensity + 1) * sizeof(uchar)];
+        for (int X = bounds.left(); X <= bounds.right(); X++) {
+            int startx = qMax(X - BrushSize, bounds.left());
+            int width = (2 * BrushSize) + 1;
+            if ((startx + width - 1) > bounds.right()) width = bounds.right() - startx + 1;
 
-    const KoColorSpace* cs = src->colorSpace();
+            IntensityCount.fill(0);
 
-    QVector<float> channel(cs->channelCount());
-    QVector<float>* AverageChannels = new QVector<float>[(Intensity + 1)];
+            for (int y = starty; y < starty + height; y++) {
+                const int rowIndex = ((y - bounds.top()) % numRows) * w - bounds.left();
 
-    // Erase the array
-    memset(IntensityCount, 0, (Intensity + 1) * sizeof(uchar));
+                for (int x = startx; x < startx + width; x++) {
+                    const uint I = intensities[rowIndex + x];
+                    const float *pixelChannels = channels.constData() + (rowIndex + x) * numChannels;
+                    float *average = AverageChannels.data() + I * numChannels;
 
-    int startx = qMax(X - Radius, bounds.left());
-    int starty = qMax(Y - Radius, bounds.top());
-    int width = (2 * Radius) + 1;
-    if ((startx + width - 1) > bounds.right()) width = bounds.right() - startx + 1;
-    Q_ASSERT((startx + width - 1) <= bounds.right());
-    int height = (2 * Radius) + 1;
-    if ((starty + height) > bounds.bottom()) height = bounds.bottom() - starty + 1;
-    Q_ASSERT((starty + height - 1) <= bounds.bottom());
-    KisSequentialConstIterator srcIt(src, QRect(startx, starty, width, height));
-    do {
+                    IntensityCount[I]++;
 
-        cs->normalisedChannelsValue(srcIt.rawDataConst(), channel);
+                    if (IntensityCount[I] == 1) {
+                        std::copy(pixelChannels, pixelChannels + numChannels, average);
+                    } else {
+                        for (int i = 0; i < numChannels; i++) {
+                            average[i] += pixelChannels[i];
+                        }
+                    }
+                }
+            }
 
-        I = (uint)(cs->intensity8(srcIt.rawDataConst()) * Scale);
-        IntensityCount[I]++;
+            uint I = 0;
+            int MaxInstance = 0;
 
-        if (IntensityCount[I] == 1) {
-            AverageChannels[I] = channel;
-        } else {
-            for (int i = 0; i < channel.size(); i++) {
-                AverageChannels[I][i] += channel[i];
+            for (int i = 0 ; i <= Smoothness ; ++i) {
+                if (IntensityCount[i] > MaxInstance) {
+                    I = i;
+                    MaxInstance = IntensityCount[i];
+                }
             }
-        }
-    } while (srcIt.nextPixel());
-
-    I = 0;
-    int MaxInstance = 0;
 
-    for (int i = 0 ; i <= Intensity ; ++i) {
-        if (IntensityCount[i] > MaxInstance) {
-            I = i;
-            MaxInstance = IntensityCount[i];
-        }
-    }
+            if (MaxInstance != 0) {
+                const float *average = AverageChannels.constData() + I * numChannels;
+                for (int i = 0; i < numChannels; i++) {
+                    channel[i] = average[i];
+                    channel[i] /= MaxInstance;
+                }
+                cs->fromNormalisedChannelsValue(dst, channel);
+            } else {
+                memset(dst, 0, pixelSize);
+                cs->setOpacity(dst, OPACITY_OPAQUE_U8, 1);
+            }
 
-    if (MaxInstance != 0) {
-        channel = AverageChannels[I];
-        for (int i = 0; i < channel.size(); i++) {
-            channel[i] /= MaxInstance;
+            // the next matrices see the filtered pixel
+            updatePixel(dst, X, Y);
+            dst += pixelSize;
         }
-        cs->fromNormalisedChannelsValue(dst, channel);
-    } else {
-        memset(dst, 0, cs->pixelSize());
-        cs->setOpacity(dst, OPACITY_OPAQUE_U8, 1);
-    }
 
+        device->writeBytes(reinterpret_cast<const quint8*>(row.constData()), QRect(bounds.left(), Y, w, 1));
 
-    delete [] IntensityCount;        // free all the arrays
-    delete [] AverageChannels;
+        if (progressUpdater) progressUpdater->setValue(progress += w);
+    }
 }
 
 
@@ -43,9 +43,9 @@ public:
     virtual KisConfigWidget * createConfigurationWidget(QWidget* parent, const KisPaintDeviceSP dev) const;
 
 private:
-    void OilPaint(const KisPaintDeviceSP src, KisPaintDeviceSP dst, const QPoint& srcTopLeft, const QPoint& dstTopLeft, int w, int h,
+    void OilPaint(KisPaintDeviceSP device, const QRect& bounds,
                   int BrushSize, int Smoothness, KoUpdater* progressUpdater) const;
-    void MostFrequentColor(KisPaintDeviceSP src, quint8* dst, const QRect& bounds, int X, int Y, int Radius, int Intensity) const;
+    static int getBrushSize(const KisFilterConfigurationSP config, int lod);
 };
 
 #endif
@@ -46,6 +46,7 @@
 #include <kis_types.h>
 #include <filter/kis_filter_configuration.h>
 #include <kis_processing_information.h>
+#include <kis_lod_transform.h>
 
 #include "widgets/kis_multi_integer_filter_widget.h"
 #include <kis_iterator_ng.h>
@@ -56,6 +57,7 @@ KisPixelizeFilter::KisPixelizeFilter() : KisFilter(id(), KisFilter::categoryArti
     setSupportsPainting(true);
     setSupportsThreading(false);
     setSupportsAdjustmentLayers(false);
+    setSupportsLevelOfDetail(true);
 }
 
 void KisPixelizeFilter::processImpl(KisPaintDeviceSP device,
@@ -71,8 +73,9 @@ void KisPixelizeFilter::processImpl(KisPaintDeviceSP device,
     qint32 height = applyRect.height();
 
     //read the filter configuration values from the KisFilterConfiguration object
-    quint32 pixelWidth = config ? config->getInt("pixelWidth", 10) : 10;
-    quint32 pixelHeight = config ? config->getInt("pixelHeight", 10) : 10;
+    KisLodTransformScalar t(device);
+    quint32 pixelWidth = qRound(t.scale(config ? config->getInt("pixelWidth", 10) : 10));
+    quint32 pixelHeight = qRound(t.scale(config ? config->getInt("pixelHeight", 10) : 10));
     if (pixelWidth == 0) pixelWidth = 1;
     if (pixelHeight == 0) pixelHeight = 1;
 
@@ -48,6 +48,7 @@
 #include <filter/kis_filter_configuration.h>
 #include <kis_processing_information.h>
 #include <kis_random_accessor_ng.h>
+#include <kis_lod_transform.h>
 
 #include "widgets/kis_multi_integer_filter_widget.h"
 
@@ -58,6 +59,7 @@ KisRainDropsFilter::KisRainDropsFilter()
     setSupportsPainting(false);
     setSupportsThreading(false);
     setSupportsAdjustmentLayers(true);
+    setSupportsLevelOfDetail(true);
 }
 
 // This method have been ported from Pieter Z. Voloshyn algorithm code.
@@ -128,6 +130,8 @@ void KisRainDropsFilter::processImpl(KisPaintDeviceSP device,
 
     const KoColorSpace * cs = device->colorSpace();
 
+    KisLodTransformScalar t(device);
+
     // Init booleen Matrix.
 
     for (i = 0 ; (i < Width) && !(progressUpdater && progressUpdater->interrupted()) ; ++i) {
@@ -140,6 +144,14 @@ void KisRainDropsFilter::processImpl(KisPaintDeviceSP device,
     
     for (uint NumBlurs = 0; (NumBlurs <= number) && !(progressUpdater && progressUpdater->interrupted()); ++NumBlurs) {
         NewSize = (int)(qrand() * ((double)(DropSize - 5) / RAND_MAX) + 5);
+
+        /**
+         * The drop is scaled after it has been generated, so that the
+         * sequence of random numbers, and therefore the positions of
+         * the drops relative to the rect, are the same for every
+         * level of detail. The drop needs at least a one pixel radius.
+         */
+        NewSize = qMax(3, qRound(t.scale(NewSize)));
         halfSize = NewSize / 2;
         Radius = halfSize;
         s = Radius / log(NewfishEyes * Radius + 1);
@@ -44,6 +44,7 @@
 #include <kis_types.h>
 #include <filter/kis_filter_configuration.h>
 #include <kis_processing_information.h>
+#include <kis_lod_transform.h>
 
 #include "kis_wdg_random_pick.h"
 #include "ui_wdgrandompickoptions.h"
@@ -65,6 +66,7 @@ KisFilterRandomPick::KisFilterRandomPick() : KisFilter(id(), categoryOther(), i1
 {
     setColorSpaceIndependence(FULLY_INDEPENDENT);
     setSupportsPainting(true);
+    setSupportsLevelOfDetail(true);
 }
 
 
@@ -87,7 +89,8 @@ void KisFilterRandomPick::processImpl(KisPaintDeviceSP device,
     QVariant value;
     int level = (config && config->getProperty("level", value)) ? value.toInt() : 50;
     int opacity = (config && config->getProperty("opacity", value)) ? value.toInt() : 100;
-    double windowsize = (config && config->getProperty("windowsize", value)) ? value.toDouble() : 2.5;
+    KisLodTransformScalar t(device);
+    double windowsize = t.scale((config && config->getProperty("windowsize", value)) ? value.toDouble() : 2.5);
 
     int seedThreshold = rand();
     int seedH = rand();
@@ -146,10 +149,10 @@ KisFilterConfigurationSP KisFilterRandomPick::factoryConfiguration() const
 
 QRect KisFilterRandomPick::neededRect(const QRect& rect, const KisFilterConfigurationSP config, int lod) const
 {
-    Q_UNUSED(lod);
+    KisLodTransformScalar t(lod);
 
     QVariant value;
-    int windowsize = ceil((config && config->getProperty("windowsize", value)) ? value.toDouble() : 2.5);
+    int windowsize = ceil(t.scale((config && config->getProperty("windowsize", value)) ? value.toDouble() : 2.5));
     return rect.adjusted(-windowsize, -windowsize, windowsize, windowsize);
 }
 
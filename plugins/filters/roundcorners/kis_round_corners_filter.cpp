@@ -46,11 +46,12 @@
 #include <kis_processing_information.h>
 #include <kis_types.h>
 #include <kis_iterator_ng.h>
+#include <kis_lod_transform.h>
 
 KisRoundCornersFilter::KisRoundCornersFilter() : KisFilter(id(), KisFilter::categoryMap(), i18n("&Round Corners..."))
 {
     setSupportsPainting(false);
-
+    setSupportsLevelOfDetail(true);
 }
 
 void KisRoundCornersFilter::processImpl(KisPaintDeviceSP device,
@@ -69,7 +70,8 @@ void KisRoundCornersFilter::processImpl(KisPaintDeviceSP device,
     }
 
     //read the filter configuration values from the KisFilterConfiguration object
-    qint32 radius = qMax(1, config->getInt("radius" , 30));
+    KisLodTransformScalar t(device);
+    qint32 radius = qMax(1, qRound(t.scale(config->getInt("radius" , 30))));
 
     if (progressUpdater) {
         progressUpdater->setRange(0, applyRect.height());
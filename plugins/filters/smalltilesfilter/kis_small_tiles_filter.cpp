@@ -57,6 +57,7 @@ KisSmallTilesFilter::KisSmallTilesFilter() : KisFilter(id(), KisFilter::category
     setSupportsPainting(true);
     setSupportsThreading(false);
     setSupportsAdjustmentLayers(false);
+    setSupportsLevelOfDetail(true);
 }
 
 void KisSmallTilesFilter::processImpl(KisPaintDeviceSP device,
@@ -25,6 +25,9 @@
 #include "filter/kis_filter.h"
 #include "kis_pixel_selection.h"
 #include "kis_transaction.h"
+#include "kis_default_bounds_base.h"
+#include "kis_lod_transform.h"
+#include "krita_utils.h"
 #include <KoColorSpaceRegistry.h>
 
 bool compareQImages(QPoint & pt, const QImage & image1, const QImage & image2)
@@ -233,6 +236,134 @@ bool testFilterWithSelections(KisFilterSP f)
     return true;
 }
 
+struct TestingLodDefaultBounds : public KisDefaultBoundsBase {
+    TestingLodDefaultBounds(const QRect &bounds)
+        : m_lod(0), m_bounds(bounds) {}
+
+    QRect bounds() const override {
+        return KisLodTransform(m_lod).map(m_bounds);
+    }
+    bool wrapAroundMode() const override {
+        return false;
+    }
+    int currentLevelOfDetail() const override {
+        return m_lod;
+    }
+    int currentTime() const override {
+        return 0;
+    }
+    bool externalFrameActive() const override {
+        return false;
+    }
+
+    void testingSetLevelOfDetail(int lod) {
+        m_lod = lod;
+    }
+
+private:
+    int m_lod;
+    QRect m_bounds;
+};
+
+void syncLodCache(KisPaintDeviceSP dev, int levelOfDetail)
+{
+    KisPaintDevice::LodDataStruct* s = dev->createLodDataStruct(levelOfDetail);
+
+    QRegion region = dev->regionForLodSyncing();
+    Q_FOREACH(QRect rect2, KritaUtils::splitRegionIntoPatches(region, KritaUtils::optimalPatchSize())) {
+        dev->updateLodDataStruct(s, rect2);
+    }
+
+    dev->uploadLodDataStruct(s);
+}
+
+/**
+ * The mean difference of the premultiplied channels of the two
+ * images, in 8-bit units
+ */
+qreal meanDifference(const QImage &image1, const QImage &image2)
+{
+    const QImage img1 = image1.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const QImage img2 = image2.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    if (img1.size() != img2.size() || img1.isNull()) return 255.0;
+
+    qint64 sum = 0;
+
+    for (int y = 0; y < img1.height(); ++y) {
+        for (int x = 0; x < img1.width(); ++x) {
+            const QRgb p1 = img1.pixel(x, y);
+            const QRgb p2 = img2.pixel(x, y);
+
+            sum += qAbs(qRed(p1) - qRed(p2)) + qAbs(qGreen(p1) - qGreen(p2)) +
+                   qAbs(qBlue(p1) - qBlue(p2)) + qAbs(qAlpha(p1) - qAlpha(p2));
+        }
+    }
+
+    return qreal(sum) / (4 * img1.width() * img1.height());
+}
+
+/**
+ * Compares the filter applied on a LoD plane with the LoD plane of the
+ * filtered full-size image. The planes are never identical, but with
+ * properly scaled parameters the difference should stay small.
+ */
+bool testFilterLevelOfDetail(KisFilterSP f, int lod, bool *skipped)
+{
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    const qreal tolerance = 10.0;
+
+    QImage qimage(QString(FILES_DATA_DIR) + QDir::separator() + "carrot.png");
+    const QRect rect = KisLodTransform::alignedRect(qimage.rect(), lod);
+
+    KisFilterConfigurationSP  kfc = f->defaultConfiguration();
+
+    QFile file(QString(FILES_DATA_DIR) + QDir::separator() + f->id() + ".cfg");
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&file);
+        in.setCodec("UTF-8");
+        kfc->fromXML(in.readAll());
+    }
+
+    *skipped = !f->supportsLevelOfDetail(kfc, lod);
+    if (*skipped) return true;
+
+    TestingLodDefaultBounds *refBounds = new TestingLodDefaultBounds(rect);
+    KisPaintDeviceSP ref = new KisPaintDevice(cs);
+    ref->setDefaultBounds(refBounds);
+    ref->convertFromQImage(qimage, 0, 0, 0);
+
+    f->process(ref, rect, kfc);
+
+    refBounds->testingSetLevelOfDetail(lod);
+    syncLodCache(ref, lod);
+
+    TestingLodDefaultBounds *bounds = new TestingLodDefaultBounds(rect);
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->setDefaultBounds(bounds);
+    dev->convertFromQImage(qimage, 0, 0, 0);
+
+    bounds->testingSetLevelOfDetail(lod);
+    syncLodCache(dev, lod);
+
+    const QRect lodRect = KisLodTransform::scaledRect(rect, lod);
+    f->process(dev, lodRect, kfc);
+
+    const QImage refImage = ref->convertToQImage(0, lodRect);
+    const QImage image = dev->convertToQImage(0, lodRect);
+
+    const qreal difference = meanDifference(refImage, image);
+    dbgKrita << f->id() << ppVar(lod) << ppVar(difference);
+
+    if (difference > tolerance) {
+        refImage.save(QString("lod%1_ref_carrot_%2.png").arg(lod).arg(f->id()));
+        image.save(QString("lod%1_carrot_%2.png").arg(lod).arg(f->id()));
+        return false;
+    }
+
+    return true;
+}
+
 void KisAllFilterTest::testAllFilters()
 {
     QStringList failures;
@@ -312,5 +443,40 @@ void KisAllFilterTest::testAllFiltersWithSelections()
 }
 
 
+void KisAllFilterTest::testAllFiltersLevelOfDetail()
+{
+    QStringList failures;
+    QStringList successes;
+    QStringList skipped;
+
+    /**
+     * These filters pick a random value for every pixel, so the
+     * result of the scaled run has nothing to do with the scaled
+     * result of the full-size one
+     */
+    QStringList randomFilters;
+    randomFilters << "noise" << "randompick";
+
+    QList<QString> filterList = KisFilterRegistry::instance()->keys();
+    qSort(filterList);
+    for (QList<QString>::Iterator it = filterList.begin(); it != filterList.end(); ++it) {
+        if (randomFilters.contains(*it)) continue;
+
+        bool isSkipped = false;
+        const bool result = testFilterLevelOfDetail(KisFilterRegistry::instance()->value(*it), 1, &isSkipped);
+
+        if (isSkipped)
+            skipped << *it;
+        else if (result)
+            successes << *it;
+        else
+            failures << *it;
+    }
+    dbgKrita << "LoD Success: " << successes;
+    dbgKrita << "LoD not supported: " << skipped;
+    if (failures.size() > 0) {
+        QFAIL(QString("LoD Failed filters:\n\t %1").arg(failures.join("\n\t")).toLatin1());
+    }
+}
 
 QTEST_MAIN(KisAllFilterTest)
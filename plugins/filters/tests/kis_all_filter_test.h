@@ -31,6 +31,7 @@ private Q_SLOTS:
     void testAllFiltersNoTransaction();
     void testAllFiltersSrcNotIsDev();
     void testAllFiltersWithSelections();
+    void testAllFiltersLevelOfDetail();
 };
 
 #endif
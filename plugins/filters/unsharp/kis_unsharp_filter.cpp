@@ -47,9 +47,10 @@ KisUnsharpFilter::KisUnsharpFilter() : KisFilter(id(), categoryEnhance(), i18n("
     setSupportsThreading(true);
 
     /**
-     * Officially Unsharp Mask doesn't support LoD, because it
-     * generates subtle artifacts when the unsharp radius is smaller
-     * than current zoom level. But LoD devices can still appear when
+     * Unsharp Mask generates subtle artifacts when the unsharp radius
+     * is smaller than current zoom level, so LoD is supported only
+     * when the radius is still at least a pixel at that level (see
+     * supportsLevelOfDetail()). But LoD devices can still appear when
      * the filter is used in Adjustment Layer. So the actual LoD is
      * still counted on.
      */
@@ -106,7 +107,8 @@ void KisUnsharpFilter::processImpl(KisPaintDeviceSP device,
     KisGaussianKernel::applyGaussian(device, applyRect,
                                      halfSize, halfSize,
                                      channelFlags,
-                                     progressUpdater);
+                                     progressUpdater,
+                                     true);
 
     if (progressUpdater && progressUpdater->interrupted()) {
         return;
@@ -227,3 +229,13 @@ QRect KisUnsharpFilter::changedRect(const QRect & rect, const KisFilterConfigura
 
     return rect.adjusted( -halfSize, -halfSize, halfSize, halfSize);
 }
+
+bool KisUnsharpFilter::supportsLevelOfDetail(const KisFilterConfigurationSP config, int lod) const
+{
+    KisLodTransformScalar t(lod);
+
+    QVariant value;
+    const qreal halfSize = t.scale(config && config->getProperty("halfSize", value) ? value.toDouble() : 1.0);
+
+    return halfSize >= 1.0;
+}
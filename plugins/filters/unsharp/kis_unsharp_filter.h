@@ -45,6 +45,8 @@ public:
     QRect changedRect(const QRect & rect, const KisFilterConfigurationSP _config, int lod) const;
     QRect neededRect(const QRect & rect, const KisFilterConfigurationSP _config, int lod) const;
 
+    bool supportsLevelOfDetail(const KisFilterConfigurationSP config, int lod) const;
+
 private:
     void processLightnessOnly(KisPaintDeviceSP device,
                               const QRect &rect,
@@ -41,6 +41,7 @@
 #include <kis_paint_device.h>
 #include <filter/kis_filter_configuration.h>
 #include <kis_processing_information.h>
+#include <kis_lod_transform.h>
 #include "kis_wdg_wave.h"
 #include "ui_wdgwaveoptions.h"
 #include <kis_iterator_ng.h>
@@ -99,7 +100,7 @@ KisFilterWave::KisFilterWave() : KisFilter(id(), categoryOther(), i18n("&Wave...
     setColorSpaceIndependence(FULLY_INDEPENDENT);
     setSupportsPainting(false);
     setSupportsAdjustmentLayers(false);
-
+    setSupportsLevelOfDetail(true);
 }
 
 KisFilterConfigurationSP KisFilterWave::factoryConfiguration() const
@@ -142,6 +143,16 @@ void KisFilterWave::processImpl(KisPaintDeviceSP device,
     int verticalshift = (config && config->getProperty("verticalshift", value)) ? value.toInt() : 50;
     int verticalamplitude = (config && config->getProperty("verticalamplitude", value)) ? value.toInt() : 4;
     int verticalshape = (config && config->getProperty("verticalshape", value)) ? value.toInt() : 0;
+
+    // all the lengths are in pixels, the wavelengths must stay positive
+    KisLodTransformScalar t(device);
+    horizontalwavelength = qMax(1, qRound(t.scale(horizontalwavelength)));
+    horizontalshift = qRound(t.scale(horizontalshift));
+    horizontalamplitude = qRound(t.scale(horizontalamplitude));
+    verticalwavelength = qMax(1, qRound(t.scale(verticalwavelength)));
+    verticalshift = qRound(t.scale(verticalshift));
+    verticalamplitude = qRound(t.scale(verticalamplitude));
+
     KisSequentialIterator dstIt(device, applyRect);
     KisWaveCurve* verticalcurve;
     if (verticalshape == 1)
@@ -168,11 +179,11 @@ void KisFilterWave::processImpl(KisPaintDeviceSP device,
 
 QRect KisFilterWave::neededRect(const QRect& rect, const KisFilterConfigurationSP config, int lod) const
 {
-    Q_UNUSED(lod);
+    KisLodTransformScalar t(lod);
 
     QVariant value;
-    int horizontalamplitude = (config && config->getProperty("horizontalamplitude", value)) ? value.toInt() : 4;
-    int verticalamplitude = (config && config->getProperty("verticalamplitude", value)) ? value.toInt() : 4;
+    int horizontalamplitude = qRound(t.scale((config && config->getProperty("horizontalamplitude", value)) ? value.toInt() : 4));
+    int verticalamplitude = qRound(t.scale((config && config->getProperty("verticalamplitude", value)) ? value.toInt() : 4));
     return rect.adjusted(-horizontalamplitude, -verticalamplitude, horizontalamplitude, verticalamplitude);
 }
 
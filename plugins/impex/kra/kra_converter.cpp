@@ -37,6 +37,7 @@
 #include <kis_paint_layer.h>
 #include <kis_png_converter.h>
 #include <KisDocument.h>
+#include <kis_kra_tags.h>
 
 static const char CURRENT_DTD_VERSION[] = "2.0";
 
@@ -201,7 +202,7 @@ QDomDocument KraConverter::createDomDocument()
     QDomElement root = doc.documentElement();
 
     root.setAttribute("editor", "Krita");
-    root.setAttribute("syntaxVersion", "2");
+    root.setAttribute("syntaxVersion", QString::number(m_kraSaver->syntaxVersion()));
     root.setAttribute("kritaVersion", KritaVersionWrapper::versionString(false));
 
     root.appendChild(m_kraSaver->saveXML(doc, m_image));
@@ -273,8 +274,8 @@ bool KraConverter::loadXML(const KoXmlDocument &doc, KoStore *store)
         return false;
     }
     root = doc.documentElement();
-    int syntaxVersion = root.attribute("syntaxVersion", "3").toInt();
-    if (syntaxVersion > 2) {
+    int syntaxVersion = root.attribute("syntaxVersion", QString::number(KRA::LATEST_SYNTAX_VERSION + 1)).toInt();
+    if (syntaxVersion > KRA::LATEST_SYNTAX_VERSION) {
        m_doc->setErrorMessage(i18n("The file is too new for this version of Krita (%1).", syntaxVersion));
         return false;
     }
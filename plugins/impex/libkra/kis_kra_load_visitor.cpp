@@ -24,6 +24,7 @@
 #include <QRect>
 #include <QBuffer>
 #include <QByteArray>
+#include <QSet>
 
 #include <KoColorSpaceRegistry.h>
 #include <KoColorProfile.h>
@@ -210,7 +211,7 @@ bool KisKraLoadVisitor::visit(KisAdjustmentLayer* layer)
         KisPixelSelectionSP pixelSelection = selection->pixelSelection();
         result = loadPaintDevice(pixelSelection, getLocation(layer, ".selection"));
         layer->setInternalSelection(selection);
-    } else if (m_syntaxVersion == 2) {
+    } else if (m_syntaxVersion >= 2) {
         result = loadSelection(getLocation(layer), layer->internalSelection());
 
     } else {
@@ -428,6 +429,23 @@ struct FramedDevicePolicy
     int m_frameId;
 };
 
+struct DeltaFramedDevicePolicy
+{
+    DeltaFramedDevicePolicy(int frameId, int baseFrameId)
+        :  m_frameId(frameId), m_baseFrameId(baseFrameId) {}
+
+    bool read(KisPaintDeviceSP dev, QIODevice *stream) {
+        return dev->framesInterface()->readFrameDelta(stream, m_frameId, m_baseFrameId);
+    }
+
+    void setDefaultPixel(KisPaintDeviceSP dev, const KoColor &defaultPixel) const {
+        return dev->framesInterface()->setFrameDefaultPixel(defaultPixel, m_frameId);
+    }
+
+    int m_frameId;
+    int m_baseFrameId;
+};
+
 bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString& location)
 {
     // Layer data
@@ -443,14 +461,41 @@ bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString&
         return loadPaintDeviceFrame(device, location, SimpleDevicePolicy());
     } else {
         KisRasterKeyframeChannel *keyframeChannel = device->keyframeChannel();
+        QSet<int> loadedFrames;
 
         for (int i = 0; i < frames.count(); i++) {
-            int id = frames[i];
-            QString frameFilename = getLocation(keyframeChannel->frameFilename(id));
-            Q_ASSERT(!frameFilename.isEmpty());
+            /**
+             * A delta-encoded frame can be loaded only on top of its
+             * base frame, so load the chain of its bases first
+             */
+            QVector<int> chain;
+
+            for (int id = frames[i];
+                 id >= 0 && !loadedFrames.contains(id);
+                 id = keyframeChannel->frameBaseId(id)) {
+
+                if (chain.contains(id)) {
+                    m_errorMessages << i18n("Circular frame dependency in %1.", getLocation(keyframeChannel->frameFilename(id)));
+                    return false;
+                }
+                chain.prepend(id);
+            }
 
-            if (!loadPaintDeviceFrame(device, frameFilename, FramedDevicePolicy(id))) {
-                return false;
+            Q_FOREACH (int id, chain) {
+                QString frameFilename = getLocation(keyframeChannel->frameFilename(id));
+                Q_ASSERT(!frameFilename.isEmpty());
+
+                const int baseId = keyframeChannel->frameBaseId(id);
+
+                const bool result = baseId >= 0 ?
+                    loadPaintDeviceFrame(device, frameFilename, DeltaFramedDevicePolicy(id, baseId)) :
+                    loadPaintDeviceFrame(device, frameFilename, FramedDevicePolicy(id));
+
+                if (!result) {
+                    return false;
+                }
+
+                loadedFrames.insert(id);
             }
         }
     }
@@ -88,6 +88,11 @@ void KisKraSaveVisitor::setExternalUri(const QString &uri)
     m_uri = uri;
 }
 
+void KisKraSaveVisitor::setTilesCacheOwner(const void *owner)
+{
+    m_writer->setTilesCacheOwner(owner);
+}
+
 bool KisKraSaveVisitor::visit(KisExternalLayer * layer)
 {
     bool result = false;
@@ -328,6 +333,23 @@ struct FramedDevicePolicy
     int m_frameId;
 };
 
+struct DeltaFramedDevicePolicy
+{
+    DeltaFramedDevicePolicy(int frameId, int baseFrameId)
+        :  m_frameId(frameId), m_baseFrameId(baseFrameId) {}
+
+    bool write(KisPaintDeviceSP dev, KisPaintDeviceWriter &store) {
+        return dev->framesInterface()->writeFrameDelta(store, m_frameId, m_baseFrameId);
+    }
+
+    KoColor defaultPixel(KisPaintDeviceSP dev) const {
+        return dev->framesInterface()->frameDefaultPixel(m_frameId);
+    }
+
+    int m_frameId;
+    int m_baseFrameId;
+};
+
 bool KisKraSaveVisitor::savePaintDevice(KisPaintDeviceSP device,
                                         QString location)
 {
@@ -353,7 +375,13 @@ bool KisKraSaveVisitor::savePaintDevice(KisPaintDeviceSP device,
             QString frameFilename = getLocation(keyframeChannel->frameFilename(id));
             Q_ASSERT(!frameFilename.isEmpty());
 
-            if (!savePaintDeviceFrame(device, frameFilename, FramedDevicePolicy(id))) {
+            const int baseId = keyframeChannel->frameBaseId(id);
+
+            const bool result = baseId >= 0 ?
+                savePaintDeviceFrame(device, frameFilename, DeltaFramedDevicePolicy(id, baseId)) :
+                savePaintDeviceFrame(device, frameFilename, FramedDevicePolicy(id));
+
+            if (!result) {
                 return false;
             }
         }
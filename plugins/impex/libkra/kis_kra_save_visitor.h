@@ -28,7 +28,7 @@
 #include "kis_image.h"
 #include "kritalibkra_export.h"
 
-class KisPaintDeviceWriter;
+class KisStorePaintDeviceWriter;
 class KoStore;
 
 class KRITALIBKRA_EXPORT KisKraSaveVisitor : public KisNodeVisitor
@@ -41,6 +41,12 @@ public:
 public:
     void setExternalUri(const QString &uri);
 
+    /**
+     * Keeps the compressed tiles of the saved devices in
+     * KisCompressedTilesCache on behalf of \p owner
+     */
+    void setTilesCacheOwner(const void *owner);
+
     bool visit(KisNode*) {
         return true;
     }
@@ -91,7 +97,7 @@ private:
     QString m_uri;
     QString m_name;
     QMap<const KisNode*, QString> m_nodeFileNames;
-    KisPaintDeviceWriter *m_writer;
+    KisStorePaintDeviceWriter *m_writer;
     QStringList m_errorMessages;
 };
 
@@ -49,6 +49,8 @@
 #include <kis_psd_layer_style_resource.h>
 #include "kis_png_converter.h"
 #include "kis_keyframe_channel.h"
+#include "kis_raster_keyframe_channel.h"
+#include "kis_image_config.h"
 #include <kis_time_range.h>
 #include "KisDocument.h"
 #include <string>
@@ -56,6 +58,7 @@
 #include "kis_grid_config.h"
 #include "kis_guides_config.h"
 #include "KisProofingConfiguration.h"
+#include "tiles3/swap/kis_compressed_tiles_cache.h"
 
 #include <QFileInfo>
 #include <QDir>
@@ -71,12 +74,14 @@ public:
     QMap<const KisNode*, QString> keyframeFilenames;
     QString imageName;
     QStringList errorMessages;
+    bool deltaFrames;
 };
 
 KisKraSaver::KisKraSaver(KisDocument* document)
         : m_d(new Private)
 {
     m_d->doc = document;
+    m_d->deltaFrames = KisImageConfig(true).deltaFrameStorageEnabled();
 
     m_d->imageName = m_d->doc->documentInfo()->aboutInfo("title");
     if (m_d->imageName.isEmpty()) {
@@ -167,7 +172,12 @@ bool KisKraSaver::saveNodeKeyframes(KoStore *store, QString location, const KisN
 
     KisKeyframeChannel *channel;
     Q_FOREACH (channel, node->keyframeChannels()) {
-        QDomElement element = channel->toXML(doc, m_d->nodeFileNames[node]);
+        KisRasterKeyframeChannel *rasterChannel = dynamic_cast<KisRasterKeyframeChannel*>(channel);
+
+        QDomElement element = rasterChannel ?
+            rasterChannel->toXML(doc, m_d->nodeFileNames[node], m_d->deltaFrames) :
+            channel->toXML(doc, m_d->nodeFileNames[node]);
+
         root.appendChild(element);
     }
 
@@ -193,8 +203,17 @@ bool KisKraSaver::saveBinaryData(KoStore* store, KisImageSP image, const QString
     if (external)
         visitor.setExternalUri(uri);
 
+    visitor.setTilesCacheOwner(m_d->doc);
+
     image->rootLayer()->accept(visitor);
 
+    /**
+     * Unchanged tiles are not recompressed on the next save. Now we
+     * can forget the tiles that have been changed or removed since
+     * the previous save.
+     */
+    KisCompressedTilesCache::instance()->finishSave(m_d->doc);
+
     m_d->errorMessages.append(visitor.errorMessages());
     if (!m_d->errorMessages.isEmpty()) {
         return false;
@@ -286,6 +305,11 @@ bool KisKraSaver::saveBinaryData(KoStore* store, KisImageSP image, const QString
     return true;
 }
 
+int KisKraSaver::syntaxVersion() const
+{
+    return m_d->deltaFrames ? DELTA_FRAMES_SYNTAX_VERSION : BASIC_SYNTAX_VERSION;
+}
+
 QStringList KisKraSaver::errorMessages() const
 {
     return m_d->errorMessages;
@@ -44,6 +44,14 @@ public:
 
     bool saveBinaryData(KoStore* store, KisImageSP image, const QString & uri, bool external, bool includeMerge);
 
+    /**
+     * @return the syntax version of the document being saved. Files
+     * with delta-encoded keyframes get a newer version so that older
+     * readers refuse to load them instead of loading a delta as a
+     * complete frame.
+     */
+    int syntaxVersion() const;
+
     /// @return a list with everthing that went wrong while saving
     QStringList errorMessages() const;
 
@@ -31,6 +31,11 @@ namespace KRA
 // mimetype
 const QString NATIVE_MIMETYPE = "application/x-kra";
 
+// syntax versions of maindoc.xml
+const int BASIC_SYNTAX_VERSION = 2;
+const int DELTA_FRAMES_SYNTAX_VERSION = 3; // keyframes may be stored as deltas
+const int LATEST_SYNTAX_VERSION = DELTA_FRAMES_SYNTAX_VERSION;
+
 // xml tags
 const QString SEPARATOR = "/";
 const QString SHAPE_LAYER_PATH = "/shapelayers/";
@@ -33,6 +33,8 @@
 #include <kis_image.h>
 #include <kis_image_animation_interface.h>
 #include <kis_time_range.h>
+#include <kis_paint_device.h>
+#include <kundo2command.h>
 
 #include "kis_config.h"
 #include "kis_animation_exporter.h"
@@ -45,6 +47,8 @@
 #include <QTemporaryDir>
 #include <QTime>
 
+#include <functional>
+
 #include "KisPart.h"
 
 class KisFFMpegProgressWatcher : public QObject {
@@ -99,14 +103,23 @@ private:
 class KisFFMpegRunner
 {
 public:
-    KisFFMpegRunner(const QString &ffmpegPath)
+    /**
+     * A functor that writes raw frames into the standard input of
+     * the running ffmpeg process
+     */
+    typedef std::function<KisImageBuilder_Result (QProcess &)> FrameFeeder;
+
+public:
+    KisFFMpegRunner(const QString &ffmpegPath, bool batchMode)
         : m_cancelled(false),
+          m_batchMode(batchMode),
           m_ffmpegPath(ffmpegPath) {}
 public:
     KisImageBuilder_Result runFFMpeg(const QStringList &specialArgs,
                                      const QString &actionName,
                                      const QString &logPath,
-                                     int totalFrames)
+                                     int totalFrames,
+                                     FrameFeeder frameFeeder = FrameFeeder())
     {
         dbgFile << "runFFMpeg: specialArgs" << specialArgs
                 << "actionName" << actionName
@@ -128,9 +141,31 @@ public:
 
         m_cancelled = false;
         m_process.start(m_ffmpegPath, args);
+
+        if (frameFeeder) {
+            if (!m_process.waitForStarted()) {
+                return KisImageBuilder_RESULT_FAILURE;
+            }
+
+            KisImageBuilder_Result feederResult = frameFeeder(m_process);
+
+            // closing stdin is the EOF signal for the rawvideo demuxer
+            m_process.closeWriteChannel();
+
+            if (feederResult != KisImageBuilder_RESULT_OK) {
+                m_process.kill();
+                m_process.waitForFinished();
+                return m_cancelled ? KisImageBuilder_RESULT_CANCEL : feederResult;
+            }
+        }
+
         return waitForFFMpegProcess(actionName, progressFile, m_process, totalFrames);
     }
 
+    bool isCancelled() const {
+        return m_cancelled;
+    }
+
     void cancel() {
         m_cancelled = true;
         m_process.kill();
@@ -145,18 +180,32 @@ private:
 
         KisFFMpegProgressWatcher watcher(progressFile, totalFrames);
 
-        QProgressDialog progress(message, "", 0, 0, KisPart::instance()->currentMainwindow());
-        progress.setWindowModality(Qt::ApplicationModal);
-        progress.setCancelButton(0);
-        progress.setMinimumDuration(0);
-        progress.setValue(0);
-        progress.setRange(0, 100);
+        QScopedPointer<QProgressDialog> progress;
+
+        if (!m_batchMode) {
+            progress.reset(new QProgressDialog(message, "", 0, 0, KisPart::instance()->currentMainwindow()));
+            progress->setWindowModality(Qt::ApplicationModal);
+            progress->setCancelButton(0);
+            progress->setMinimumDuration(0);
+            progress->setValue(0);
+            progress->setRange(0, 100);
+        }
 
         QEventLoop loop;
         loop.connect(&watcher, SIGNAL(sigProcessingFinished()), SLOT(quit()));
         loop.connect(&ffmpegProcess, SIGNAL(finished(int, QProcess::ExitStatus)), SLOT(quit()));
-        loop.connect(&watcher, SIGNAL(sigProgressChanged(int)), &progress, SLOT(setValue(int)));
-        loop.exec();
+        if (progress) {
+            loop.connect(&watcher, SIGNAL(sigProgressChanged(int)), progress.data(), SLOT(setValue(int)));
+        }
+
+        /**
+         * When the frames are streamed through a pipe, ffmpeg might
+         * have already finished while we were feeding it, so the
+         * finished() signal has already been delivered.
+         */
+        if (ffmpegProcess.state() != QProcess::NotRunning) {
+            loop.exec();
+        }
 
         // wait for some errorneous case
         ffmpegProcess.waitForFinished(5000);
@@ -179,6 +228,7 @@ private:
 private:
     QProcess m_process;
     bool m_cancelled;
+    bool m_batchMode;
     QString m_ffmpegPath;
 };
 
@@ -188,7 +238,7 @@ VideoSaver::VideoSaver(KisDocument *doc, const QString &ffmpegPath, bool batchMo
     , m_doc(doc)
     , m_batchMode(batchMode)
     , m_ffmpegPath(ffmpegPath)
-    , m_runner(new KisFFMpegRunner(ffmpegPath))
+    , m_runner(new KisFFMpegRunner(ffmpegPath, batchMode))
 {
 }
 
@@ -224,9 +274,21 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
     const KisTimeRange fullRange = animation->fullClipRange();
     const int frameRate = animation->framerate();
 
-    KIS_SAFE_ASSERT_RECOVER_NOOP(configuration->hasProperty("first_frame"));
-    KIS_SAFE_ASSERT_RECOVER_NOOP(configuration->hasProperty("last_frame"));
-    KIS_SAFE_ASSERT_RECOVER_NOOP(configuration->hasProperty("include_audio"));
+    const QString savedFilesMask = configuration->getString("savedFilesMask");
+
+    /**
+     * If nobody has rendered an image sequence for us, render the
+     * frames ourselves and stream them into ffmpeg's stdin as raw
+     * video. It saves us a PNG encode/decode round trip per frame
+     * and makes it possible to export from the command line.
+     */
+    const bool streamFrames = savedFilesMask.isEmpty();
+
+    if (!streamFrames) {
+        KIS_SAFE_ASSERT_RECOVER_NOOP(configuration->hasProperty("first_frame"));
+        KIS_SAFE_ASSERT_RECOVER_NOOP(configuration->hasProperty("last_frame"));
+        KIS_SAFE_ASSERT_RECOVER_NOOP(configuration->hasProperty("include_audio"));
+    }
 
     const KisTimeRange clipRange(configuration->getInt("first_frame", fullRange.start()), configuration->getInt("last_frame", fullRange.end()));
     const bool includeAudio = configuration->getBool("include_audio", true);
@@ -243,24 +305,57 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
     const QFileInfo info(resultFile);
     const QString suffix = info.suffix().toLower();
 
-    const QString palettePath = framesDir.filePath("palette.png");
+    const QDir logDir = configuration->getString("directory").isEmpty() ? info.absoluteDir() : framesDir;
 
-    const QString savedFilesMask = configuration->getString("savedFilesMask");
+    const QString palettePath = framesDir.filePath("palette.png");
 
     const QStringList additionalOptionsList = configuration->getString("customUserOptions").split(' ', QString::SkipEmptyParts);
 
-    if (suffix == "gif") {
+    QStringList inputArgs;
+    KisFFMpegRunner::FrameFeeder frameFeeder;
+
+    if (streamFrames) {
+        const QRect bounds = m_image->bounds();
+
+        inputArgs << "-f" << "rawvideo"
+                  << "-pix_fmt" << "bgra"
+                  << "-s" << QString("%1x%2").arg(bounds.width()).arg(bounds.height())
+                  << "-r" << QString::number(frameRate)
+                  << "-i" << "-";
+
+        using namespace std::placeholders; // For _1 placeholder
+        frameFeeder = std::bind(&VideoSaver::feedFrames, this, _1, clipRange);
+    } else {
+        inputArgs << "-r" << QString::number(frameRate)
+                  << "-start_number" << QString::number(clipRange.start())
+                  << "-i" << savedFilesMask;
+    }
+
+    if (suffix == "gif" && streamFrames) {
+        /**
+         * The frames can be streamed only once, so generate the
+         * palette and apply it in a single filter graph
+         */
+        QStringList args;
+        args << inputArgs
+             << "-lavfi" << "split [a][b]; [a] palettegen [p]; [b][p] paletteuse"
+             << additionalOptionsList
+             << "-y" << resultFile;
+
+        result = m_runner->runFFMpeg(args, i18n("Encoding frames..."),
+                                     logDir.filePath("log_encode_gif.log"),
+                                     clipRange.duration(),
+                                     frameFeeder);
+    } else if (suffix == "gif") {
         {
             QStringList args;
-            args << "-r" << QString::number(frameRate)
-                 << "-start_number" << QString::number(clipRange.start())
-                 << "-i" << savedFilesMask
+            args << inputArgs
                  << "-vf" << "palettegen"
                  << "-y" << palettePath;
 
             KisImageBuilder_Result result =
                 m_runner->runFFMpeg(args, i18n("Fetching palette..."),
-                                    framesDir.filePath("log_generate_palette_gif.log"),
+                                    logDir.filePath("log_generate_palette_gif.log"),
                                     clipRange.duration());
 
             if (result != KisImageBuilder_RESULT_OK) {
@@ -270,9 +365,7 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
 
         {
             QStringList args;
-            args << "-r" << QString::number(frameRate)
-                 << "-start_number" << QString::number(clipRange.start())
-                 << "-i" << savedFilesMask
+            args << inputArgs
                  << "-i" << palettePath
                  << "-lavfi" << "[0:v][1:v] paletteuse"
                  << additionalOptionsList
@@ -282,7 +375,7 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
 
             KisImageBuilder_Result result =
                 m_runner->runFFMpeg(args, i18n("Encoding frames..."),
-                                    framesDir.filePath("log_encode_gif.log"),
+                                    logDir.filePath("log_encode_gif.log"),
                                     clipRange.duration());
 
             if (result != KisImageBuilder_RESULT_OK) {
@@ -291,10 +384,7 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
         }
     } else {
         QStringList args;
-        args << "-r" << QString::number(frameRate)
-             << "-start_number" << QString::number(clipRange.start())
-             << "-i" << savedFilesMask;
-
+        args << inputArgs;
 
         QFileInfo audioFileInfo = animation->audioChannelFileName();
         if (includeAudio && audioFileInfo.exists()) {
@@ -315,13 +405,64 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
              << "-y" << resultFile;
 
         result = m_runner->runFFMpeg(args, i18n("Encoding frames..."),
-                                     framesDir.filePath("log_encode.log"),
-                                     clipRange.duration());
+                                     logDir.filePath("log_encode.log"),
+                                     clipRange.duration(),
+                                     frameFeeder);
     }
 
     return result;
 }
 
+KisImageBuilder_Result VideoSaver::feedFrames(QProcess &ffmpegProcess, const KisTimeRange &range)
+{
+    const KoColorSpace *dstColorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect bounds = m_image->bounds();
+
+    // the buffer is reused for all the frames of the clip
+    QByteArray frameBuffer(bounds.width() * bounds.height() * dstColorSpace->pixelSize(), 0);
+
+    KisAnimationExporter exporter(m_doc, range.start(), range.end());
+
+    exporter.setSaveFrameCallback(
+        [&] (int time, KisPaintDeviceSP frame, KisPropertiesConfigurationSP) {
+            Q_UNUSED(time);
+
+            if (m_runner->isCancelled()) {
+                return KisImportExportFilter::ProgressCancelled;
+            }
+
+            KisPaintDeviceSP dev = frame;
+
+            if (!(*dev->colorSpace() == *dstColorSpace)) {
+                dev = new KisPaintDevice(*frame.data());
+                KUndo2Command *cmd = dev->convertTo(dstColorSpace);
+                delete cmd;
+            }
+
+            dev->readBytes(reinterpret_cast<quint8*>(frameBuffer.data()), bounds);
+
+            if (ffmpegProcess.write(frameBuffer) != frameBuffer.size() ||
+                !ffmpegProcess.waitForBytesWritten(-1)) {
+
+                warnFile << "Failed to stream frame" << time << "to ffmpeg:" << ffmpegProcess.errorString();
+                return KisImportExportFilter::CreationError;
+            }
+
+            return KisImportExportFilter::OK;
+        });
+
+    KisImportExportFilter::ConversionStatus status = exporter.exportAnimation();
+
+    if (status == KisImportExportFilter::OK) {
+        return KisImageBuilder_RESULT_OK;
+    } else if (status == KisImportExportFilter::ProgressCancelled ||
+               status == KisImportExportFilter::UserCancelled) {
+        return KisImageBuilder_RESULT_CANCEL;
+    }
+
+    return KisImageBuilder_RESULT_FAILURE;
+}
+
 void VideoSaver::cancel()
 {
     m_runner->cancel();
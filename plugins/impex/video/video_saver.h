@@ -29,6 +29,8 @@
 #include "kritavideoexport_export.h"
 
 class KisFFMpegRunner;
+class KisTimeRange;
+class QProcess;
 
 /* The KisImageBuilder_Result definitions come from kis_png_converter.h here */
 
@@ -49,6 +51,13 @@ public:
 private Q_SLOTS:
     void cancel();
 
+private:
+    /**
+     * Renders frames of \p range and writes them into the stdin of
+     * \p ffmpegProcess as raw BGRA8 video
+     */
+    KisImageBuilder_Result feedFrames(QProcess &ffmpegProcess, const KisTimeRange &range);
+
 private:
     KisImageSP m_image;
     KisDocument* m_doc;
@@ -25,8 +25,10 @@
 #include <KoColorSpaceRegistry.h>
 #include <KoColor.h>
 #include <KoColorProfile.h>
+#include <KoCompositeOp.h>
 #include <KoCompositeOpRegistry.h>
 
+#include <kis_debug.h>
 #include <kis_brush.h>
 #include <kis_global.h>
 #include <kis_paint_device.h>
@@ -37,6 +39,7 @@
 #include <kis_cross_device_color_picker.h>
 #include <kis_fixed_paint_device.h>
 #include <kis_lod_transform.h>
+#include <kis_aligned_buffer_pool.h>
 
 
 KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPainter* painter, KisNodeSP node, KisImageSP image)
@@ -44,6 +47,8 @@ KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPaint
     , m_firstRun(true)
     , m_image(image)
     , m_tempDev(painter->device()->createCompositionSourceDevice())
+    , m_smudgeDab(new KisFixedPaintDevice(m_tempDev->colorSpace()))
+    , m_backgroundDab(new KisFixedPaintDevice(m_tempDev->colorSpace()))
     , m_backgroundPainter(new KisPainter(m_tempDev))
     , m_smudgePainter(new KisPainter(m_tempDev))
     , m_colorRatePainter(new KisPainter(m_tempDev))
@@ -203,6 +208,15 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
     QString oldCompositeOpId = painter()->compositeOp()->id();
     qreal   fpOpacity  = (qreal(oldOpacity) / 255.0) * m_opacityOption.getOpacityf(info);
 
+    if (canPaintFused()) {
+        paintFused(info, srcDabRect, hotSpot, fpOpacity);
+
+        painter()->setOpacity(oldOpacity);
+        painter()->setCompositeOp(oldCompositeOpId);
+
+        return spacingInfo;
+    }
+
     if (m_image && m_overlayModeOption.isChecked()) {
         m_image->blockUpdates();
         m_backgroundPainter->bitBlt(QPoint(), m_image->projection(), srcDabRect);
@@ -285,3 +299,125 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
 
     return spacingInfo;
 }
+
+bool KisColorSmudgeOp::canPaintFused() const
+{
+    const KoColorSpace *cs = m_tempDev->colorSpace();
+
+    if (!(*painter()->device()->colorSpace() == *cs)) return false;
+
+    if (m_image && m_overlayModeOption.isChecked() &&
+        !(*m_image->projection()->colorSpace() == *cs)) {
+
+        return false;
+    }
+
+    return true;
+}
+
+void KisColorSmudgeOp::paintFused(const KisPaintInformation& info, const QRect &srcDabRect, const QPointF &hotSpot, qreal fpOpacity)
+{
+    const KoColorSpace *cs = m_tempDev->colorSpace();
+    const bool useOverlay = m_image && m_overlayModeOption.isChecked();
+    const QRect dabRect(QPoint(), m_dstDabRect.size());
+
+    m_projectionCache.nextDab();
+
+    m_smudgeDab->setRect(dabRect);
+    if (!m_smudgeDab->initialize()) {
+        warnKrita << "KisColorSmudgeOp: failed to allocate the dab of size" << dabRect.size();
+        return;
+    }
+
+    KoCompositeOp::ParameterInfo params;
+    params.dstRowStart   = m_smudgeDab->data();
+    params.dstRowStride  = dabRect.width() * cs->pixelSize();
+    params.maskRowStart  = 0;
+    params.maskRowStride = 0;
+    params.rows          = dabRect.height();
+    params.cols          = dabRect.width();
+
+    if (useOverlay) {
+        m_image->blockUpdates();
+        m_projectionCache.read(m_image->projection(), m_smudgeDab->data(), srcDabRect);
+        m_image->unblockUpdates();
+    }
+
+    if (m_smudgeRateOption.getMode() == KisSmudgeOption::SMEARING_MODE) {
+        if (useOverlay) {
+            KisAlignedBufferPool::Buffer layerPixels(dabRect.width() * dabRect.height() * cs->pixelSize());
+            if (!layerPixels.data()) {
+                warnKrita << "KisColorSmudgeOp: failed to allocate the dab of size" << dabRect.size();
+                return;
+            }
+            painter()->device()->readBytes(layerPixels.data(), srcDabRect);
+
+            params.srcRowStart  = layerPixels.data();
+            params.srcRowStride = params.dstRowStride;
+            cs->compositeOp(COMPOSITE_OVER)->composite(params);
+        } else {
+            // composing over transparent pixels is just a copy
+            painter()->device()->readBytes(m_smudgeDab->data(), srcDabRect);
+        }
+    } else {
+        QPoint pt = (srcDabRect.topLeft() + hotSpot).toPoint();
+        KoColor color = painter()->paintColor();
+
+        if (m_smudgeRadiusOption.isChecked()) {
+            qreal effectiveSize = 0.5 * (m_dstDabRect.width() + m_dstDabRect.height());
+            m_smudgeRadiusOption.apply(*m_smudgePainter, info, effectiveSize, pt.x(), pt.y(), painter()->device());
+            color = m_smudgePainter->paintColor();
+        } else {
+            KisCrossDeviceColorPickerInt colorPicker(painter()->device(), color);
+            colorPicker.pickColor(pt.x(), pt.y(), color.data());
+        }
+
+        color.convertTo(cs);
+        params.srcRowStart  = color.data();
+        params.srcRowStride = 0;
+        cs->compositeOp(COMPOSITE_OVER)->composite(params);
+    }
+
+    if (m_colorRateOption.isChecked()) {
+        qreal maxColorRate = qMax<qreal>(1.0 - m_smudgeRateOption.getRate(), 0.2);
+        m_colorRateOption.apply(*m_colorRatePainter, info, 0.0, maxColorRate, fpOpacity);
+
+        KoColor color = painter()->paintColor();
+        m_gradientOption.apply(color, m_gradient, info);
+        color.convertTo(cs);
+
+        params.srcRowStart  = color.data();
+        params.srcRowStride = 0;
+        params.opacity      = m_colorRatePainter->opacity() / 255.0f;
+        m_colorRatePainter->compositeOp()->composite(params);
+    }
+
+    if (useOverlay && !m_colorRateOption.isChecked()) {
+        m_backgroundDab->setRect(dabRect);
+        if (!m_backgroundDab->initialize()) {
+            warnKrita << "KisColorSmudgeOp: failed to allocate the dab of size" << dabRect.size();
+            return;
+        }
+
+        m_image->blockUpdates();
+        m_projectionCache.read(m_image->projection(), m_backgroundDab->data(), m_dstDabRect);
+        m_image->unblockUpdates();
+
+        painter()->setCompositeOp(COMPOSITE_COPY);
+        painter()->setOpacity(OPACITY_OPAQUE_U8);
+        painter()->bltFixed(m_dstDabRect.x(), m_dstDabRect.y(), m_backgroundDab, 0, 0, dabRect.width(), dabRect.height());
+    }
+
+    m_smudgeRateOption.apply(*painter(), info, 0.0, 1.0, fpOpacity);
+
+    painter()->setCompositeOp(COMPOSITE_COPY);
+    painter()->bltFixedWithFixedSelection(m_dstDabRect.x(), m_dstDabRect.y(), m_smudgeDab, m_maskDab, m_dstDabRect.width(), m_dstDabRect.height());
+
+    if (painter()->hasMirroring()) {
+        // the smudged dab is built anew for every dab, only the mask has to be preserved
+        KisFixedPaintDeviceSP mask = m_dabCache->needSeparateOriginal() ?
+            m_maskDab : new KisFixedPaintDevice(*m_maskDab);
+
+        painter()->renderMirrorMask(m_dstDabRect, m_smudgeDab, mask);
+    }
+}
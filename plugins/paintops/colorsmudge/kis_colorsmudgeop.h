@@ -34,6 +34,7 @@
 #include "kis_rate_option.h"
 #include "kis_smudge_option.h"
 #include "kis_smudge_radius_option.h"
+#include "kis_projection_sample_cache.h"
 
 class QPointF;
 class KoAbstractGradient;
@@ -54,10 +55,22 @@ private:
 
     inline void getTopLeftAligned(const QPointF &pos, const QPointF &hotSpot, qint32 *x, qint32 *y);
 
+    /**
+     * The fused path builds the smudged dab in a fixed device and
+     * composites it right into the layer, without going through the
+     * tiles of m_tempDev. It needs the layer (and the projection in
+     * overlay mode) to have the color space of m_tempDev.
+     */
+    bool canPaintFused() const;
+    void paintFused(const KisPaintInformation& info, const QRect &srcDabRect, const QPointF &hotSpot, qreal fpOpacity);
+
 private:
     bool                      m_firstRun;
     KisImageWSP               m_image;
     KisPaintDeviceSP          m_tempDev;
+    KisFixedPaintDeviceSP     m_smudgeDab;
+    KisFixedPaintDeviceSP     m_backgroundDab;
+    KisProjectionSampleCache  m_projectionCache;
     KisPainter*               m_backgroundPainter;
     KisPainter*               m_smudgePainter;
     KisPainter*               m_colorRatePainter;
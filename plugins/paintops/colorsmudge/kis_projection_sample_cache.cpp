@@ -0,0 +1,174 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_projection_sample_cache.h"
+
+#include <cstring>
+
+#include <QRect>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+
+#include <KoColorSpace.h>
+
+#include <kis_assert.h>
+#include <kis_paint_device.h>
+
+namespace {
+
+/**
+ * The cells match the tiles of the device, so that every miss reads
+ * exactly one tile
+ */
+const int CELL_SIZE = 64;
+
+typedef QPair<int, int> Cell;
+
+inline int cellIndex(int coordinate)
+{
+    return coordinate >= 0 ? coordinate / CELL_SIZE : -((CELL_SIZE - 1 - coordinate) / CELL_SIZE);
+}
+
+}
+
+struct KisProjectionSampleCache::Private
+{
+    struct Entry {
+        QByteArray pixels;
+        QVector<quint64> versions;
+        int lastUsed;
+    };
+
+    int maxAge;
+    int currentDab = 0;
+
+    KisPaintDeviceSP device;
+    const KoColorSpace *colorSpace = 0;
+    QHash<Cell, Entry> cells;
+
+    int hitCount = 0;
+    int missCount = 0;
+};
+
+KisProjectionSampleCache::KisProjectionSampleCache(int maxAge)
+    : m_d(new Private)
+{
+    KIS_ASSERT_RECOVER_NOOP(maxAge >= 0);
+    m_d->maxAge = qMax(0, maxAge);
+}
+
+KisProjectionSampleCache::~KisProjectionSampleCache()
+{
+}
+
+void KisProjectionSampleCache::read(KisPaintDeviceSP device, quint8 *dst, const QRect &rect)
+{
+    if (rect.isEmpty()) return;
+
+    if (m_d->device != device || !m_d->colorSpace || !(*m_d->colorSpace == *device->colorSpace())) {
+        m_d->cells.clear();
+        m_d->device = device;
+        m_d->colorSpace = device->colorSpace();
+    }
+
+    const int pixelSize = device->pixelSize();
+    const int dstRowStride = rect.width() * pixelSize;
+    const int cellRowStride = CELL_SIZE * pixelSize;
+
+    // the cells are aligned to the tiles of the device
+    const QRect deviceRect = rect.translated(-device->x(), -device->y());
+
+    for (int row = cellIndex(deviceRect.top()); row <= cellIndex(deviceRect.bottom()); row++) {
+        for (int column = cellIndex(deviceRect.left()); column <= cellIndex(deviceRect.right()); column++) {
+            const QRect cellRect(column * CELL_SIZE + device->x(),
+                                 row * CELL_SIZE + device->y(),
+                                 CELL_SIZE, CELL_SIZE);
+
+            Private::Entry &entry = m_d->cells[Cell(column, row)];
+
+            /**
+             * The previous dabs of the stroke are merged into the
+             * projection in the meantime, so a cell is valid only
+             * while the tile it was read from stays the same. The
+             * versions are fetched before the pixels and a tile is
+             * stamped again when a write to it completes, so a cell
+             * read in the middle of a write is never reused.
+             */
+            const QVector<quint64> versions = device->tileVersions(cellRect);
+
+            if (entry.pixels.isEmpty() || entry.versions != versions) {
+                entry.pixels.resize(CELL_SIZE * cellRowStride);
+                device->readBytes(reinterpret_cast<quint8*>(entry.pixels.data()), cellRect);
+                entry.versions = versions;
+                m_d->missCount++;
+            } else {
+                m_d->hitCount++;
+            }
+
+            entry.lastUsed = m_d->currentDab;
+
+            const QRect part = cellRect & rect;
+            const int rowSize = part.width() * pixelSize;
+
+            const quint8 *srcPtr = reinterpret_cast<const quint8*>(entry.pixels.constData()) +
+                (part.y() - cellRect.y()) * cellRowStride +
+                (part.x() - cellRect.x()) * pixelSize;
+
+            quint8 *dstPtr = dst +
+                (part.y() - rect.y()) * dstRowStride +
+                (part.x() - rect.x()) * pixelSize;
+
+            for (int y = 0; y < part.height(); y++) {
+                memcpy(dstPtr, srcPtr, rowSize);
+                srcPtr += cellRowStride;
+                dstPtr += dstRowStride;
+            }
+        }
+    }
+}
+
+void KisProjectionSampleCache::nextDab()
+{
+    m_d->currentDab++;
+
+    QMutableHashIterator<Cell, Private::Entry> it(m_d->cells);
+    while (it.hasNext()) {
+        it.next();
+        if (m_d->currentDab - it.value().lastUsed > m_d->maxAge) {
+            it.remove();
+        }
+    }
+}
+
+void KisProjectionSampleCache::clear()
+{
+    m_d->cells.clear();
+    m_d->device = 0;
+    m_d->colorSpace = 0;
+}
+
+int KisProjectionSampleCache::hitCount() const
+{
+    return m_d->hitCount;
+}
+
+int KisProjectionSampleCache::missCount() const
+{
+    return m_d->missCount;
+}
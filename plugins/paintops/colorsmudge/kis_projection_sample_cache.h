@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_PROJECTION_SAMPLE_CACHE_H
+#define __KIS_PROJECTION_SAMPLE_CACHE_H
+
+#include <QScopedPointer>
+
+#include <kis_types.h>
+
+class QRect;
+
+
+/**
+ * A stroke-local cache of the tiles of the image projection sampled by
+ * the color smudge op in overlay mode.
+ *
+ * Every dab reads the projection twice: under the previous position of
+ * the brush and under the current one, and the current area is read
+ * again by the next dab as its "previous" one. The cache keeps the
+ * tile-sized cells read during the last \p maxAge dabs, so every area
+ * of the projection is read from the device only once while it stays
+ * unchanged.
+ *
+ * The projection is merged asynchronously, so the previous dabs of the
+ * stroke may appear in it at any moment. Every cell remembers the
+ * version of the tile it was read from (KisPaintDevice::tileVersions())
+ * and is read again when the tile has changed. Older cells are dropped
+ * in nextDab().
+ *
+ * The cache is not thread-safe, it belongs to a single paintop.
+ */
+class KisProjectionSampleCache
+{
+public:
+    KisProjectionSampleCache(int maxAge = 1);
+    ~KisProjectionSampleCache();
+
+    /**
+     * Reads \p rect of \p device into \p dst the same way
+     * KisPaintDevice::readBytes() does. The cells that have been read
+     * recently and whose tiles have not changed since then are copied
+     * from the cache. If \p device or its color space has changed
+     * since the previous call, the cache is cleared.
+     */
+    void read(KisPaintDeviceSP device, quint8 *dst, const QRect &rect);
+
+    /**
+     * Marks the beginning of a new dab and drops the cells that have
+     * not been used for maxAge dabs
+     */
+    void nextDab();
+
+    /**
+     * Drops all the cached cells
+     */
+    void clear();
+
+    /**
+     * The number of the cells copied from the cache and read from the
+     * device since the cache has been created
+     */
+    int hitCount() const;
+    int missCount() const;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_PROJECTION_SAMPLE_CACHE_H */
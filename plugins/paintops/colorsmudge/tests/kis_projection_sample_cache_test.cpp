@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+#include "kis_projection_sample_cache_test.h"
+
+#include <cstring>
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_image.h>
+#include <kis_paint_layer.h>
+#include <kis_paint_device.h>
+#include <kis_random_accessor_ng.h>
+
+#include "kis_projection_sample_cache.h"
+
+
+KisImageSP createImage(KisPaintLayerSP *layer)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, 300, 300, cs, "projection sample cache test");
+
+    *layer = new KisPaintLayer(image, "layer", OPACITY_OPAQUE_U8);
+    (*layer)->paintDevice()->fill(image->bounds(), KoColor(Qt::white, cs));
+    image->addNode(*layer, image->root());
+
+    image->initialRefreshGraph();
+
+    return image;
+}
+
+bool isFilledWith(const QByteArray &pixels, const KoColor &color)
+{
+    const int pixelSize = color.colorSpace()->pixelSize();
+
+    for (int i = 0; i < pixels.size(); i += pixelSize) {
+        if (memcmp(pixels.constData() + i, color.data(), pixelSize) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void KisProjectionSampleCacheTest::testReuse()
+{
+    KisPaintLayerSP layer;
+    KisImageSP image = createImage(&layer);
+    KisPaintDeviceSP projection = image->projection();
+
+    const QRect dabRect(50, 50, 40, 40);
+    QByteArray pixels(dabRect.width() * dabRect.height() * projection->pixelSize(), 0);
+
+    KisProjectionSampleCache cache;
+
+    cache.read(projection, reinterpret_cast<quint8*>(pixels.data()), dabRect);
+    QCOMPARE(cache.hitCount(), 0);
+
+    const int numCells = cache.missCount();
+    QVERIFY(numCells > 0);
+
+    // the next dab reads the same area of the unchanged projection
+    cache.nextDab();
+    cache.read(projection, reinterpret_cast<quint8*>(pixels.data()), dabRect);
+
+    QCOMPARE(cache.hitCount(), numCells);
+    QCOMPARE(cache.missCount(), numCells);
+    QVERIFY(isFilledWith(pixels, KoColor(Qt::white, projection->colorSpace())));
+}
+
+void KisProjectionSampleCacheTest::testOverlayOwnPaint()
+{
+    KisPaintLayerSP layer;
+    KisImageSP image = createImage(&layer);
+    KisPaintDeviceSP projection = image->projection();
+
+    const QRect dabRect(50, 50, 40, 40);
+    QByteArray pixels(dabRect.width() * dabRect.height() * projection->pixelSize(), 0);
+
+    KisProjectionSampleCache cache;
+
+    // the first dab samples the untouched projection...
+    cache.read(projection, reinterpret_cast<quint8*>(pixels.data()), dabRect);
+    QVERIFY(isFilledWith(pixels, KoColor(Qt::white, projection->colorSpace())));
+
+    // ... and paints on the layer, which is merged into the projection
+    const KoColor red(Qt::red, layer->colorSpace());
+    layer->paintDevice()->fill(dabRect, red);
+    layer->setDirty(dabRect);
+    image->waitForDone();
+
+    // the next dab smudges over the fresh paint, not over the old sample
+    cache.nextDab();
+    cache.read(projection, reinterpret_cast<quint8*>(pixels.data()), dabRect);
+
+    QVERIFY(isFilledWith(pixels, KoColor(Qt::red, projection->colorSpace())));
+    QCOMPARE(cache.hitCount(), 0);
+}
+
+void KisProjectionSampleCacheTest::testWriteDuringRead()
+{
+    KisPaintLayerSP layer;
+    KisImageSP image = createImage(&layer);
+    KisPaintDeviceSP projection = image->projection();
+
+    const QRect dabRect(50, 50, 40, 40);
+    QByteArray pixels(dabRect.width() * dabRect.height() * projection->pixelSize(), 0);
+
+    KisProjectionSampleCache cache;
+    const KoColor red(Qt::red, projection->colorSpace());
+
+    {
+        /**
+         * The accessor keeps its tile locked for writing until it is
+         * destroyed, the same way the merger does while it updates
+         * the projection in the middle of the read
+         */
+        KisRandomAccessorSP it = projection->createRandomAccessorNG(60, 60);
+        memcpy(it->rawData(), red.data(), projection->pixelSize());
+
+        cache.read(projection, reinterpret_cast<quint8*>(pixels.data()), dabRect);
+
+        for (int y = dabRect.top(); y <= dabRect.bottom(); y++) {
+            for (int x = dabRect.left(); x <= dabRect.right(); x++) {
+                it->moveTo(x, y);
+                memcpy(it->rawData(), red.data(), projection->pixelSize());
+            }
+        }
+    }
+
+    const int numCells = cache.missCount();
+
+    // the cells read during the write are read again
+    cache.nextDab();
+    cache.read(projection, reinterpret_cast<quint8*>(pixels.data()), dabRect);
+
+    QCOMPARE(cache.hitCount(), 0);
+    QCOMPARE(cache.missCount(), 2 * numCells);
+    QVERIFY(isFilledWith(pixels, red));
+}
+
+QTEST_MAIN(KisProjectionSampleCacheTest)
@@ -91,6 +91,9 @@ KisBrushOp::KisBrushOp(const KisPaintOpSettingsSP settings, KisPainter *painter,
 
     m_dabCache->setSharpnessPostprocessing(&m_sharpnessOption);
     m_rotationOption.applyFanCornersInfo(this);
+
+    // the dabs are painted with bltFixed() only and the device is never read
+    setDabBatchingEnabled(true);
 }
 
 KisBrushOp::~KisBrushOp()
@@ -18,66 +18,70 @@
 
 #include "bristle.h"
 
-Bristle::Bristle()
-{
-    init(0, 0, 0);
-}
+#include <KoColorSpace.h>
+#include <KoColorConversionTransformation.h>
 
-Bristle::Bristle(float x, float y, float length)
-{
-    init(x, y, length);
-}
+#include <kis_assert.h>
 
-void Bristle::init(float x, float y, float length)
+BristleSet::BristleSet()
+    : m_size(0),
+      m_colorSpace(0),
+      m_pixelSize(0)
 {
-    m_x = x;
-    m_y = y;
-    m_prevX = x;
-    m_prevY = y;
-    m_length = length;
-    m_counter = 0;
-    m_enabled = true;
 }
 
-Bristle::~Bristle()
+BristleSet::~BristleSet()
 {
 }
 
-void Bristle::setLength(float length)
+void BristleSet::reset(const KoColorSpace *colorSpace)
 {
-    m_length = length;
-}
-
+    x.clear();
+    y.clear();
+    prevX.clear();
+    prevY.clear();
+    length.clear();
+    inkAmount.clear();
+    counter.clear();
+    m_colors.clear();
 
-void Bristle::addInk(float value)
-{
-    m_inkAmount = m_inkAmount + value;
+    m_size = 0;
+    m_colorSpace = colorSpace;
+    m_pixelSize = colorSpace->pixelSize();
 }
 
-void Bristle::removeInk(float value)
+void BristleSet::append(float bristleX, float bristleY, float bristleLength, const quint8 *bristleColor)
 {
-    m_inkAmount = m_inkAmount - value;
-}
+    KIS_ASSERT_RECOVER_RETURN(m_colorSpace);
 
-void Bristle::setInkAmount(float inkAmount)
-{
-    if (inkAmount > 1.0f) {
-        inkAmount = 1.0f;
-    }
-    else if (inkAmount < -1.0f) {
-        inkAmount = -1.0f;
-    }
+    x.append(bristleX);
+    y.append(bristleY);
+    prevX.append(bristleX);
+    prevY.append(bristleY);
+    length.append(bristleLength);
+    inkAmount.append(1.0f);
+    counter.append(0);
+    m_colors.append(reinterpret_cast<const char*>(bristleColor), m_pixelSize);
 
-    m_inkAmount = inkAmount;
+    m_size++;
 }
 
-void Bristle::setColor(const KoColor &color)
+void BristleSet::convertColorsTo(const KoColorSpace *colorSpace)
 {
-    m_color = color;
-}
+    KIS_ASSERT_RECOVER_RETURN(m_colorSpace);
+    if (*m_colorSpace == *colorSpace) return;
 
+    QByteArray converted(m_size * colorSpace->pixelSize(), 0);
 
-void Bristle::setEnabled(bool enabled)
-{
-    m_enabled = enabled;
+    if (m_size > 0) {
+        m_colorSpace->convertPixelsTo(reinterpret_cast<const quint8*>(m_colors.constData()),
+                                      reinterpret_cast<quint8*>(converted.data()),
+                                      colorSpace, m_size,
+                                      KoColorConversionTransformation::internalRenderingIntent(),
+                                      KoColorConversionTransformation::internalConversionFlags());
+    }
+
+    m_colors = converted;
+    m_colorSpace = colorSpace;
+    m_pixelSize = colorSpace->pixelSize();
 }
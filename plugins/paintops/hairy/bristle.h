@@ -19,101 +19,87 @@
 #ifndef _BRISTLE_H_
 #define _BRISTLE_H_
 
-#include <cmath>
-#include <KoColor.h>
+#include <QVector>
+#include <QByteArray>
 
-class Bristle
-{
+class KoColorSpace;
 
+/**
+ * The state of all the bristles of a hairy brush, stored as a
+ * structure of arrays.
+ *
+ * Every per-bristle property lives in its own contiguous array, so the
+ * loops that update one property of all the bristles (the positions
+ * when the brush moves, the ink when it depletes) walk linear memory
+ * and can be vectorized by the compiler. The colors of the bristles
+ * are packed into a single byte array, colorSpace()->pixelSize() bytes
+ * per bristle.
+ */
+class BristleSet
+{
 public:
-    Bristle(float x, float y, float length);
-    Bristle();
-    ~Bristle();
-
-    inline float x() const {
-        return m_x;
-    }
-
-    inline float y() const {
-        return m_y;
+    BristleSet();
+    ~BristleSet();
+
+    /**
+     * Removes all the bristles and sets the color space of the colors
+     * of the bristles added later
+     */
+    void reset(const KoColorSpace *colorSpace);
+
+    /**
+     * Adds a bristle at (\p x, \p y) relative to the center of the
+     * brush. The bristle is full of ink.
+     */
+    void append(float x, float y, float length, const quint8 *color);
+
+    /**
+     * Converts the colors of all the bristles into \p colorSpace
+     */
+    void convertColorsTo(const KoColorSpace *colorSpace);
+
+    inline int size() const {
+        return m_size;
     }
 
-    inline float prevX() const {
-        return m_prevX;
+    inline const KoColorSpace* colorSpace() const {
+        return m_colorSpace;
     }
 
-    inline float prevY() const {
-        return m_prevY;
+    inline quint8* color(int i) {
+        return reinterpret_cast<quint8*>(m_colors.data()) + i * m_pixelSize;
     }
 
-    inline float length() const {
-        return m_length;
+    inline const quint8* color(int i) const {
+        return reinterpret_cast<const quint8*>(m_colors.constData()) + i * m_pixelSize;
     }
 
-    inline  const KoColor &color() const {
-        return m_color;
+    static inline float boundInkAmount(float inkAmount) {
+        return qBound(-1.0f, inkAmount, 1.0f);
     }
 
-    inline int counter() const {
-        return m_counter;
-    }
-
-    inline void upIncrement() {
-        m_counter++;
-    }
-
-    inline float inkAmount() const {
-        return m_inkAmount;
-    };
-
-    inline float distanceCenter() {
-        return std::sqrt(m_x * m_x + m_y * m_y);
-    }
-
-    inline void setX(float x) {
-        m_x = x;
-    }
-    inline void setY(float y) {
-        m_y = y;
-    }
-
-    inline void setPrevX(float prevX) {
-        m_prevX = prevX;
-    }
-
-    inline void setPrevY(float prevY) {
-        m_prevY = prevY;
-    }
+public:
+    // coordinates of the bristles relative to the center of the brush
+    QVector<float> x;
+    QVector<float> y;
 
-    inline bool enabled() const {
-        return m_enabled;
-    }
+    // the end of the previous path of the bristles relative to the center
+    QVector<float> prevX;
+    QVector<float> prevY;
 
-    void setLength(float length);
-    void setColor(const KoColor &color);
+    // z - coordinate
+    QVector<float> length;
 
-    void addInk(float value);
-    void removeInk(float value);
-    void setInkAmount(float inkAmount);
-    void setEnabled(bool enabled);
+    QVector<float> inkAmount;
 
+    // the number of pixels painted by the bristles, drives ink depletion
+    QVector<int> counter;
 
 private:
-    void init(float x, float y, float length);
-
-    // coordinates of bristle
-    float m_x;
-    float m_y;
-    float m_prevX;
-    float m_prevY;
-    float m_length; // z - coordinate
-    KoColor m_color;
-    float m_inkAmount;
-
-    // new dimension in bristle
-    int m_counter;
-
-    bool m_enabled;
+    int m_size;
+    const KoColorSpace *m_colorSpace;
+    int m_pixelSize;
+    QByteArray m_colors;
 };
 
 #endif
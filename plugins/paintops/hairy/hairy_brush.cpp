@@ -28,12 +28,13 @@
 #include <QVector>
 
 #include <kis_types.h>
-#include <kis_random_accessor_ng.h>
 #include <kis_cross_device_color_picker.h>
 #include <kis_fixed_paint_device.h>
+#include <kis_aligned_buffer_pool.h>
 
 
 #include <cmath>
+#include <cstring>
 #include <ctime>
 
 
@@ -45,20 +46,37 @@ HairyBrush::HairyBrush()
 
     m_saturationId = -1;
     m_transfo = 0;
+    m_depositColorOffset = -1;
 }
 
 HairyBrush::~HairyBrush()
 {
     delete m_transfo;
-    qDeleteAll(m_bristles.begin(), m_bristles.end());
-    m_bristles.clear();
 }
 
+namespace {
+
+/**
+ * The deposits are grouped by the tiles of the dab, so that every tile
+ * is read and written only once per segment
+ */
+const int DEPOSIT_TILE_SIZE = 64;
+
+inline int tileIndex(int coordinate)
+{
+    return coordinate >= 0 ? coordinate / DEPOSIT_TILE_SIZE : -((DEPOSIT_TILE_SIZE - 1 - coordinate) / DEPOSIT_TILE_SIZE);
+}
+
+}
 
 void HairyBrush::initAndCache()
 {
     m_compositeOp = m_dab->colorSpace()->compositeOp(COMPOSITE_OVER);
     m_pixelSize = m_dab->colorSpace()->pixelSize();
+    m_plotColor = KoColor(m_dab->colorSpace());
+
+    // image brushes may come in a different color space than the dab
+    m_bristles.convertColorsTo(m_dab->colorSpace());
 
     if (m_properties->useSaturation) {
         m_transfo = m_dab->colorSpace()->createColorTransformation("hsv_adjustment", m_params);
@@ -77,13 +95,13 @@ void HairyBrush::fromDabWithDensity(KisFixedPaintDeviceSP dab, qreal density)
     int centerY = height * 0.5;
 
     // make mask
-    Bristle * bristle = 0;
     qreal alpha;
 
     quint8 * dabPointer = dab->data();
     quint8 pixelSize = dab->pixelSize();
     const KoColorSpace * cs = dab->colorSpace();
-    KoColor bristleColor(cs);
+
+    m_bristles.reset(cs);
 
     KisRandomSource randomSource(0);
 
@@ -92,12 +110,8 @@ void HairyBrush::fromDabWithDensity(KisFixedPaintDeviceSP dab, qreal density)
             alpha =  cs->opacityF(dabPointer);
             if (alpha != 0.0) {
                 if (density == 1.0 || randomSource.generateNormalized() <= density) {
-                    memcpy(bristleColor.data(), dabPointer, pixelSize);
-
-                    bristle = new Bristle(x - centerX, y - centerY, alpha); // using value from image as length of bristle
-                    bristle->setColor(bristleColor);
-
-                    m_bristles.append(bristle);
+                    // using value from image as length of bristle
+                    m_bristles.append(x - centerX, y - centerY, alpha, dabPointer);
                 }
             }
             dabPointer += pixelSize;
@@ -105,6 +119,61 @@ void HairyBrush::fromDabWithDensity(KisFixedPaintDeviceSP dab, qreal density)
     }
 }
 
+void HairyBrush::transformBristles(KisRandomSourceSP randomSource, qreal scale, qreal rotation, qreal shear)
+{
+    const int bristleCount = m_bristles.size();
+
+    m_pathStartX.resize(bristleCount);
+    m_pathStartY.resize(bristleCount);
+    m_pathEndX.resize(bristleCount);
+    m_pathEndY.resize(bristleCount);
+    m_randomX.resize(bristleCount);
+    m_randomY.resize(bristleCount);
+
+    // the random offsets are generated in the order of the bristles
+    for (int i = 0; i < bristleCount; i++) {
+        m_randomX[i] = (randomSource->generateNormalized() * 2 - 1.0) * m_properties->randomFactor;
+        m_randomY[i] = (randomSource->generateNormalized() * 2 - 1.0) * m_properties->randomFactor;
+    }
+
+    /**
+     * Every bristle is sheared, moved by its random offset, scaled and
+     * rotated. The loop touches only the arrays of the bristle set, so
+     * it can be vectorized by the compiler.
+     */
+    const float cosA = std::cos(rotation);
+    const float sinA = std::sin(rotation);
+    const float fScale = scale;
+    const float fShear = shear;
+
+    const float *x = m_bristles.x.constData();
+    const float *y = m_bristles.y.constData();
+    const float *randomX = m_randomX.constData();
+    const float *randomY = m_randomY.constData();
+    float *endX = m_pathEndX.data();
+    float *endY = m_pathEndY.data();
+
+    for (int i = 0; i < bristleCount; i++) {
+        const float sx = (x[i] + fShear * y[i] + randomX[i]) * fScale;
+        const float sy = (y[i] + fShear * x[i] + randomY[i]) * fScale;
+
+        endX[i] = cosA * sx + sinA * sy;
+        endY[i] = cosA * sy - sinA * sx;
+    }
+
+    if (firstStroke() || (!m_properties->connectedPath)) {
+        m_pathStartX = m_pathEndX;
+        m_pathStartY = m_pathEndY;
+    } else {
+        // continue the path of the bristle from the previous position
+        m_pathStartX = m_bristles.prevX;
+        m_pathStartY = m_bristles.prevY;
+    }
+
+    // remember the end point
+    m_bristles.prevX = m_pathEndX;
+    m_bristles.prevY = m_pathEndY;
+}
 
 void HairyBrush::paintLine(KisPaintDeviceSP dab, KisPaintDeviceSP layer, const KisPaintInformation &pi1, const KisPaintInformation &pi2, qreal scale, qreal rotation)
 {
@@ -133,11 +202,8 @@ void HairyBrush::paintLine(KisPaintDeviceSP dab, KisPaintDeviceSP layer, const K
     // this pressure controls shear and ink depletion
     qreal pressure = mousePressure * (pi2.pressure() * 2);
 
-    Bristle *bristle = 0;
     KoColor bristleColor(dab->colorSpace());
 
-    m_dabAccessor = dab->createRandomAccessorNG((int)x1, (int)y1);
-
     m_dab = dab;
 
     // initialization block
@@ -155,11 +221,7 @@ void HairyBrush::paintLine(KisPaintDeviceSP dab, KisPaintDeviceSP layer, const K
         }
     }
 
-    KisRandomSourceSP randomSource = pi2.randomSource();
-
-    qreal fx1, fy1, fx2, fy2;
-    qreal randomX, randomY;
-    qreal shear;
+    transformBristles(pi2.randomSource(), scale, angle, pressure * m_properties->shearFactor);
 
     float inkDeplation = 0.0;
     int inkDepletionSize = m_properties->inkDepletionCurve.size();
@@ -168,107 +230,82 @@ void HairyBrush::paintLine(KisPaintDeviceSP dab, KisPaintDeviceSP layer, const K
     qreal treshold = 1.0 - pi2.pressure();
     for (int i = 0; i < bristleCount; i++) {
 
-        if (!m_bristles.at(i)->enabled()) continue;
-        bristle = m_bristles[i];
-
-        randomX = (randomSource->generateNormalized() * 2 - 1.0) * m_properties->randomFactor;
-        randomY = (randomSource->generateNormalized() * 2 - 1.0) * m_properties->randomFactor;
-
-        shear = pressure * m_properties->shearFactor;
-
-        m_transform.reset();
-        m_transform.rotateRadians(-angle);
-        m_transform.scale(scale, scale);
-        m_transform.translate(randomX, randomY);
-        m_transform.shear(shear, shear);
-
-        if (firstStroke() || (!m_properties->connectedPath)) {
-            // transform start dab
-            m_transform.map(bristle->x(), bristle->y(), &fx1, &fy1);
-            // transform end dab
-            m_transform.map(bristle->x(), bristle->y(), &fx2, &fy2);
-        }
-        else {
-            // continue the path of the bristle from the previous position
-            fx1 = bristle->prevX();
-            fy1 = bristle->prevY();
-            m_transform.map(bristle->x(), bristle->y(), &fx2, &fy2);
-        }
-        // remember the end point
-        bristle->setPrevX(fx2);
-        bristle->setPrevY(fy2);
+        if (m_properties->threshold && (m_bristles.length[i] < treshold)) continue;
 
         // all coords relative to device position
-        fx1 += x1;
-        fy1 += y1;
+        const qreal fx1 = m_pathStartX[i] + x1;
+        const qreal fy1 = m_pathStartY[i] + y1;
+        const qreal fx2 = m_pathEndX[i] + x2;
+        const qreal fy2 = m_pathEndY[i] + y2;
 
-        fx2 += x2;
-        fy2 += y2;
-
-        if (m_properties->threshold && (bristle->length() < treshold)) continue;
         // paint between first and last dab
-        const QVector<QPointF> bristlePath = m_trajectory.getLinearTrajectory(QPointF(fx1, fy1), QPointF(fx2, fy2), 1.0);
+        const QVector<QPointF> &bristlePath = m_trajectory.getLinearTrajectory(QPointF(fx1, fy1), QPointF(fx2, fy2), 1.0);
         bristlePathSize = m_trajectory.size();
 
-        memcpy(bristleColor.data(), bristle->color().data() , m_pixelSize);
-        for (int i = 0; i < bristlePathSize ; i++) {
+        memcpy(bristleColor.data(), m_bristles.color(i), m_pixelSize);
+        for (int j = 0; j < bristlePathSize ; j++) {
 
             if (m_properties->inkDepletionEnabled) {
-                inkDeplation = fetchInkDepletion(bristle, inkDepletionSize);
+                inkDeplation = fetchInkDepletion(m_bristles.counter[i], inkDepletionSize);
 
                 if (m_properties->useSaturation && m_transfo != 0) {
-                    saturationDepletion(bristle, bristleColor, pressure, inkDeplation);
+                    saturationDepletion(i, bristleColor, pressure, inkDeplation);
                 }
 
                 if (m_properties->useOpacity) {
-                    opacityDepletion(bristle, bristleColor, pressure, inkDeplation);
+                    opacityDepletion(i, bristleColor, pressure, inkDeplation);
                 }
 
             }
             else {
                 if (bristleColor.opacityU8() != 0) {
-                    bristleColor.setOpacity(bristle->length());
+                    bristleColor.setOpacity(qreal(m_bristles.length[i]));
                 }
             }
 
-            addBristleInk(bristle, bristlePath.at(i), bristleColor);
-            bristle->setInkAmount(1.0 - inkDeplation);
-            bristle->upIncrement();
+            addBristleInk(bristlePath.at(j), bristleColor);
+            m_bristles.inkAmount[i] = BristleSet::boundInkAmount(1.0 - inkDeplation);
+            m_bristles.counter[i]++;
         }
 
     }
+
+    flushDeposits();
+
     m_dab = 0;
-    m_dabAccessor = 0;
 }
 
 
-inline qreal HairyBrush::fetchInkDepletion(Bristle* bristle, int inkDepletionSize)
+inline qreal HairyBrush::fetchInkDepletion(int counter, int inkDepletionSize) const
 {
-    if (bristle->counter() >= inkDepletionSize - 1) {
+    if (counter >= inkDepletionSize - 1) {
         return m_properties->inkDepletionCurve[inkDepletionSize - 1];
     } else {
-        return m_properties->inkDepletionCurve[bristle->counter()];
+        return m_properties->inkDepletionCurve[counter];
     }
 }
 
 
-void HairyBrush::saturationDepletion(Bristle * bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation)
+void HairyBrush::saturationDepletion(int bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation)
 {
+    const qreal length = m_bristles.length[bristle];
+    const qreal inkAmount = m_bristles.inkAmount[bristle];
+
     qreal saturation;
     if (m_properties->useWeights) {
         // new weighted way (experiment)
         saturation = (
                          (pressure * m_properties->pressureWeight) +
-                         (bristle->length() * m_properties->bristleLengthWeight) +
-                         (bristle->inkAmount() * m_properties->bristleInkAmountWeight) +
+                         (length * m_properties->bristleLengthWeight) +
+                         (inkAmount * m_properties->bristleInkAmountWeight) +
                          ((1.0 - inkDeplation) * m_properties->inkDepletionWeight)) - 1.0;
     }
     else {
         // old way of computing saturation
         saturation = (
                          pressure *
-                         bristle->length() *
-                         bristle->inkAmount() *
+                         length *
+                         inkAmount *
                          (1.0 - inkDeplation)) - 1.0;
 
     }
@@ -280,52 +317,52 @@ void HairyBrush::saturationDepletion(Bristle * bristle, KoColor &bristleColor, q
     m_transfo->transform(bristleColor.data(), bristleColor.data() , 1);
 }
 
-void HairyBrush::opacityDepletion(Bristle* bristle, KoColor& bristleColor, qreal pressure, qreal inkDeplation)
+void HairyBrush::opacityDepletion(int bristle, KoColor& bristleColor, qreal pressure, qreal inkDeplation)
 {
+    const qreal length = m_bristles.length[bristle];
+    const qreal inkAmount = m_bristles.inkAmount[bristle];
+
     qreal opacity = OPACITY_OPAQUE_F;
     if (m_properties->useWeights) {
         opacity = qBound(0.0,
                          (pressure * m_properties->pressureWeight) +
-                         (bristle->length() * m_properties->bristleLengthWeight) +
-                         (bristle->inkAmount() * m_properties->bristleInkAmountWeight) +
+                         (length * m_properties->bristleLengthWeight) +
+                         (inkAmount * m_properties->bristleInkAmountWeight) +
                          ((1.0 - inkDeplation) * m_properties->inkDepletionWeight), 1.0);
 
     }
     else {
         opacity =
-            bristle->length() *
-            bristle->inkAmount();
+            length *
+            inkAmount;
     }
     bristleColor.setOpacity(opacity);
 }
 
-inline void HairyBrush::addBristleInk(Bristle *bristle,const QPointF &pos, const KoColor &color)
+inline void HairyBrush::addBristleInk(const QPointF &pos, const KoColor &color)
 {
-    Q_UNUSED(bristle);
+    // the deposits share the color until it changes
+    if (m_depositColorOffset < 0 ||
+        memcmp(m_depositColors.constData() + m_depositColorOffset, color.data(), m_pixelSize) != 0) {
+
+        m_depositColorOffset = m_depositColors.size();
+        m_depositColors.append(reinterpret_cast<const char*>(color.data()), m_pixelSize);
+    }
+
     if (m_properties->antialias) {
-        if (m_properties->useCompositing) {
-            paintParticle(pos, color);
-        } else {
-            paintParticle(pos, color, 1.0);
-        }
+        paintParticle(pos, color);
     }
     else {
         int ix = qRound(pos.x());
         int iy = qRound(pos.y());
-        if (m_properties->useCompositing) {
-            plotPixel(ix, iy, color);
-        }
-        else {
-            darkenPixel(ix, iy, color);
-        }
+        depositPixel(ix, iy, -1);
     }
 }
 
-void HairyBrush::paintParticle(QPointF pos, const KoColor& color, qreal weight)
+void HairyBrush::paintParticle(QPointF pos, const KoColor& color)
 {
     // opacity top left, right, bottom left, right
     quint8 opacity = color.opacityU8();
-    opacity *= weight;
 
     int ipx = int (pos.x());
     int ipy = int (pos.y());
@@ -337,71 +374,95 @@ void HairyBrush::paintParticle(QPointF pos, const KoColor& color, qreal weight)
     quint8 bbl = qRound((1.0 - fx) * (fy)  * opacity);
     quint8 bbr = qRound((fx)  * (fy)  * opacity);
 
-    const KoColorSpace * cs = m_dab->colorSpace();
-
-    m_dabAccessor->moveTo(ipx  , ipy);
-    btl = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, btl + cs->opacityU8(m_dabAccessor->rawData()), OPACITY_OPAQUE_U8));
-    memcpy(m_dabAccessor->rawData(), color.data(), cs->pixelSize());
-    cs->setOpacity(m_dabAccessor->rawData(), btl, 1);
+    depositPixel(ipx    , ipy    , btl);
+    depositPixel(ipx + 1, ipy    , btr);
+    depositPixel(ipx    , ipy + 1, bbl);
+    depositPixel(ipx + 1, ipy + 1, bbr);
+}
 
-    m_dabAccessor->moveTo(ipx + 1, ipy);
-    btr =  quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, btr + cs->opacityU8(m_dabAccessor->rawData()), OPACITY_OPAQUE_U8));
-    memcpy(m_dabAccessor->rawData(), color.data(), cs->pixelSize());
-    cs->setOpacity(m_dabAccessor->rawData(), btr, 1);
+inline void HairyBrush::depositPixel(int x, int y, qint16 opacity)
+{
+    const Tile tile(tileIndex(x - m_dab->x()), tileIndex(y - m_dab->y()));
 
-    m_dabAccessor->moveTo(ipx, ipy + 1);
-    bbl = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, bbl + cs->opacityU8(m_dabAccessor->rawData()), OPACITY_OPAQUE_U8));
-    memcpy(m_dabAccessor->rawData(), color.data(), cs->pixelSize());
-    cs->setOpacity(m_dabAccessor->rawData(), bbl, 1);
+    PixelDeposit deposit;
+    deposit.x = x;
+    deposit.y = y;
+    deposit.colorOffset = m_depositColorOffset;
+    deposit.opacity = opacity;
 
-    m_dabAccessor->moveTo(ipx + 1, ipy + 1);
-    bbr = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, bbr + cs->opacityU8(m_dabAccessor->rawData()), OPACITY_OPAQUE_U8));
-    memcpy(m_dabAccessor->rawData(), color.data(), cs->pixelSize());
-    cs->setOpacity(m_dabAccessor->rawData(), bbr, 1);
+    m_deposits[tile].append(deposit);
 }
 
-void HairyBrush::paintParticle(QPointF pos, const KoColor& color)
+void HairyBrush::flushDeposits()
 {
-    // opacity top left, right, bottom left, right
-    memcpy(m_color.data(), color.data(), m_pixelSize);
-    quint8 opacity = color.opacityU8();
-
-    int ipx = int (pos.x());
-    int ipy = int (pos.y());
-    qreal fx = pos.x() - ipx;
-    qreal fy = pos.y() - ipy;
-
-    quint8 btl = qRound((1.0 - fx) * (1.0 - fy) * opacity);
-    quint8 btr = qRound((fx)  * (1.0 - fy) * opacity);
-    quint8 bbl = qRound((1.0 - fx) * (fy)  * opacity);
-    quint8 bbr = qRound((fx)  * (fy)  * opacity);
+    const int rowStride = DEPOSIT_TILE_SIZE * m_pixelSize;
+
+    KisAlignedBufferPool::Buffer buffer(DEPOSIT_TILE_SIZE * rowStride);
+    quint8 *tileData = buffer.data();
+
+    if (tileData) {
+        for (auto it = m_deposits.constBegin(); it != m_deposits.constEnd(); ++it) {
+            const QRect tileRect(it.key().first * DEPOSIT_TILE_SIZE + m_dab->x(),
+                                 it.key().second * DEPOSIT_TILE_SIZE + m_dab->y(),
+                                 DEPOSIT_TILE_SIZE, DEPOSIT_TILE_SIZE);
+
+            m_dab->readBytes(tileData, tileRect);
+
+            // the pixels of a tile are deposited in the order they were painted
+            Q_FOREACH (const PixelDeposit &deposit, it.value()) {
+                quint8 *dst = tileData +
+                    (deposit.y - tileRect.y()) * rowStride +
+                    (deposit.x - tileRect.x()) * m_pixelSize;
+                const quint8 *color =
+                    reinterpret_cast<const quint8*>(m_depositColors.constData()) + deposit.colorOffset;
+
+                if (m_properties->useCompositing) {
+                    plotPixel(dst, color, deposit.opacity);
+                } else if (m_properties->antialias) {
+                    addPixelOpacity(dst, color, deposit.opacity);
+                } else {
+                    darkenPixel(dst, color);
+                }
+            }
 
-    m_color.setOpacity(btl);
-    plotPixel(ipx  , ipy, m_color);
+            m_dab->writeBytes(tileData, tileRect);
+        }
+    } else {
+        warnKrita << "HairyBrush: failed to allocate a tile of" << DEPOSIT_TILE_SIZE * rowStride << "bytes";
+    }
 
-    m_color.setOpacity(btr);
-    plotPixel(ipx + 1  , ipy, m_color);
+    m_deposits.clear();
+    m_depositColors.clear();
+    m_depositColorOffset = -1;
+}
 
-    m_color.setOpacity(bbl);
-    plotPixel(ipx  , ipy + 1, m_color);
+inline void HairyBrush::plotPixel(quint8 *dst, const quint8 *color, qint16 opacity)
+{
+    if (opacity >= 0) {
+        memcpy(m_plotColor.data(), color, m_pixelSize);
+        m_dab->colorSpace()->setOpacity(m_plotColor.data(), quint8(opacity), 1);
+        color = m_plotColor.data();
+    }
 
-    m_color.setOpacity(bbr);
-    plotPixel(ipx + 1 , ipy + 1, m_color);
+    m_compositeOp->composite(dst, m_pixelSize, color, m_pixelSize, 0, 0, 1, 1, OPACITY_OPAQUE_U8);
 }
 
-
-inline void HairyBrush::plotPixel(int wx, int wy, const KoColor &color)
+inline void HairyBrush::darkenPixel(quint8 *dst, const quint8 *color)
 {
-    m_dabAccessor->moveTo(wx, wy);
-    m_compositeOp->composite(m_dabAccessor->rawData(), m_pixelSize, color.data() , m_pixelSize, 0, 0, 1, 1, OPACITY_OPAQUE_U8);
+    const KoColorSpace *cs = m_dab->colorSpace();
+
+    if (cs->opacityU8(dst) < cs->opacityU8(color)) {
+        memcpy(dst, color, m_pixelSize);
+    }
 }
 
-inline void HairyBrush::darkenPixel(int wx, int wy, const KoColor &color)
+inline void HairyBrush::addPixelOpacity(quint8 *dst, const quint8 *color, quint8 opacity)
 {
-    m_dabAccessor->moveTo(wx, wy);
-    if (m_dab->colorSpace()->opacityU8(m_dabAccessor->rawData()) < color.opacityU8()) {
-        memcpy(m_dabAccessor->rawData(), color.data(), m_pixelSize);
-    }
+    const KoColorSpace *cs = m_dab->colorSpace();
+
+    const quint8 newOpacity = quint8(qBound<quint16>(OPACITY_TRANSPARENT_U8, opacity + cs->opacityU8(dst), OPACITY_OPAQUE_U8));
+    memcpy(dst, color, m_pixelSize);
+    cs->setOpacity(dst, newOpacity, 1);
 }
 
 double HairyBrush::computeMousePressure(double distance)
@@ -426,17 +487,12 @@ void HairyBrush::colorifyBristles(KisPaintDeviceSP source, QPointF point)
     KoColor bristleColor(m_dab->colorSpace());
     KisCrossDeviceColorPickerInt colorPicker(source, bristleColor);
 
-    Bristle *b = 0;
     int size = m_bristles.size();
     for (int i = 0; i < size; i++) {
-        b = m_bristles[i];
-        int x = qRound(b->x() + point.x());
-        int y = qRound(b->y() + point.y());
+        int x = qRound(m_bristles.x[i] + point.x());
+        int y = qRound(m_bristles.y[i] + point.y());
 
-        colorPicker.pickOldColor(x, y, bristleColor.data());
-        b->setColor(bristleColor);
+        colorPicker.pickOldColor(x, y, m_bristles.color(i));
     }
 
 }
-
-
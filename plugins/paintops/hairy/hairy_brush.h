@@ -21,7 +21,9 @@
 
 #include <QVector>
 #include <QList>
-#include <QTransform>
+#include <QHash>
+#include <QPair>
+#include <QByteArray>
 
 #include <KoColor.h>
 
@@ -30,7 +32,6 @@
 
 #include <kis_paint_device.h>
 #include <brushengine/kis_paint_information.h>
-#include <kis_random_accessor_ng.h>
 
 class KoCompositeOp;
 
@@ -84,46 +85,80 @@ public:
     }
     /// set the shape of the bristles according the dab
     void fromDabWithDensity(KisFixedPaintDeviceSP dab, qreal density);
+    /// the number of bristles created by fromDabWithDensity()
+    int bristleCount() const {
+        return m_bristles.size();
+    }
 
 private:
+    /**
+     * A pixel of a bristle waiting to be deposited into the dab. The
+     * color is stored at colorOffset in m_depositColors; opacity, if
+     * not negative, replaces the opacity of the color.
+     */
+    struct PixelDeposit {
+        int x;
+        int y;
+        int colorOffset;
+        qint16 opacity;
+    };
+
+    typedef QPair<int, int> Tile;
+
     /// paints single bristle
-    void addBristleInk(Bristle *bristle,const QPointF &pos, const KoColor &color);
+    void addBristleInk(const QPointF &pos, const KoColor &color);
+    /// queues a pixel of the current deposit color for the tile it belongs to
+    void depositPixel(int x, int y, qint16 opacity);
+    /// applies the queued pixels to the dab, one tile at a time
+    void flushDeposits();
     /// composite single pixel to dab
-    void plotPixel(int wx, int wy, const KoColor &color);
+    void plotPixel(quint8 *dst, const quint8 *color, qint16 opacity);
     /// check the opacity of dab pixel and if the opacity is less then color, it will copy color to dab
-    void darkenPixel(int wx, int wy, const KoColor &color);
-    /// paint wu particle by copying the color and setup just the opacity, weight is complementary to opacity of the color
-    void paintParticle(QPointF pos, const KoColor& color, qreal weight);
-    /// paint wu particle using composite operation
+    void darkenPixel(quint8 *dst, const quint8 *color);
+    /// add the opacity to the one of the dab pixel and set the color, used by wu particles without compositing
+    void addPixelOpacity(quint8 *dst, const quint8 *color, quint8 opacity);
+    /// paint wu particle, the opacity of every pixel is proportional to its coverage
     void paintParticle(QPointF pos, const KoColor& color);
     /// similar to sample input color in spray
     void colorifyBristles(KisPaintDeviceSP source, QPointF point);
 
-    void repositionBristles(double angle, double slope);
+    /// transforms the bristles to their new positions, the result is stored in m_pathStart and m_pathEnd
+    void transformBristles(KisRandomSourceSP randomSource, qreal scale, qreal rotation, qreal shear);
     /// compute mouse pressure according distance
     double computeMousePressure(double distance);
 
     /// simulate running out of saturation
-    void saturationDepletion(Bristle * bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation);
+    void saturationDepletion(int bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation);
     /// simulate running out of ink through opacity decreasing
-    void opacityDepletion(Bristle * bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation);
+    void opacityDepletion(int bristle, KoColor &bristleColor, qreal pressure, qreal inkDeplation);
     /// fetch actaul ink status according depletion curve
-    qreal fetchInkDepletion(Bristle * bristle, int inkDepletionSize);
+    inline qreal fetchInkDepletion(int counter, int inkDepletionSize) const;
 
     void initAndCache();
 
 private:
     const KisHairyProperties * m_properties;
 
-    QVector<Bristle*> m_bristles;
-    QTransform m_transform;
+    BristleSet m_bristles;
+
+    // the positions of the bristles in the current segment, relative to the center of the brush
+    QVector<float> m_pathStartX;
+    QVector<float> m_pathStartY;
+    QVector<float> m_pathEndX;
+    QVector<float> m_pathEndY;
+    QVector<float> m_randomX;
+    QVector<float> m_randomY;
+
+    // the pixels waiting for deposition, per tile of the dab
+    QHash<Tile, QVector<PixelDeposit> > m_deposits;
+    QByteArray m_depositColors;
+    int m_depositColorOffset;
 
     // used for interpolation the path of bristles
     Trajectory m_trajectory;
     QHash<QString, QVariant> m_params;
     // temporary device
     KisPaintDeviceSP m_dab;
-    KisRandomAccessorSP m_dabAccessor;
     const KoCompositeOp * m_compositeOp;
     quint32 m_pixelSize;
 
@@ -132,6 +167,8 @@ private:
     double m_lastAngle;
     double m_oldPressure;
     KoColor m_color;
+    // scratch pixel for compositing the particles
+    KoColor m_plotColor;
 
     int m_saturationId;
     KoColorTransformation * m_transfo;
@@ -30,6 +30,11 @@
 #include <brushengine/kis_paintop.h>
 
 #include <kundo2command.h>
+#include <kis_update_time_monitor.h>
+
+#include <QCache>
+#include <QtMath>
+#include <cmath>
 
 struct PrecisionValues {
     qreal angle;
@@ -47,6 +52,65 @@ static const PrecisionValues precisionLevels[] = {
     {eps,         0, eps,  eps}
 };
 
+namespace {
+
+/**
+ * The parameters of a dab rounded to the precision level, dabs with
+ * equal keys are considered interchangeable
+ */
+struct DabCacheKey {
+    int precisionLevel;
+    const KoColorSpace *colorSpace;
+    QByteArray color;
+    qint64 angle;
+    int width;
+    int height;
+    qint64 subPixelX;
+    qint64 subPixelY;
+    qint64 softnessFactor;
+    int index;
+    bool horizontalMirror;
+    bool verticalMirror;
+};
+
+inline bool operator==(const DabCacheKey &lhs, const DabCacheKey &rhs)
+{
+    return lhs.precisionLevel == rhs.precisionLevel &&
+           lhs.colorSpace == rhs.colorSpace &&
+           lhs.color == rhs.color &&
+           lhs.angle == rhs.angle &&
+           lhs.width == rhs.width &&
+           lhs.height == rhs.height &&
+           lhs.subPixelX == rhs.subPixelX &&
+           lhs.subPixelY == rhs.subPixelY &&
+           lhs.softnessFactor == rhs.softnessFactor &&
+           lhs.index == rhs.index &&
+           lhs.horizontalMirror == rhs.horizontalMirror &&
+           lhs.verticalMirror == rhs.verticalMirror;
+}
+
+inline uint qHash(const DabCacheKey &key, uint seed = 0)
+{
+    return ::qHash(key.color, seed) ^
+        ::qHash(key.angle) ^
+        ::qHash((key.width << 16) ^ key.height) ^
+        ::qHash(key.subPixelX * 31 + key.subPixelY) ^
+        ::qHash(key.softnessFactor) ^
+        ::qHash((key.index << 3) ^ (key.horizontalMirror << 1) ^ key.verticalMirror ^ (key.precisionLevel << 24));
+}
+
+/**
+ * The size is rounded on the logarithmic scale, so that the allowed
+ * difference is proportional to the size itself
+ */
+inline int quantizeSize(int size, qreal sizeFrac)
+{
+    return sizeFrac > 0 ?
+        qRound(std::log(qreal(qMax(1, size))) / std::log1p(sizeFrac)) : size;
+}
+
+}
+
 struct KisDabCache::SavedDabParameters {
     KoColor color;
     qreal angle;
@@ -58,19 +122,26 @@ struct KisDabCache::SavedDabParameters {
     int index;
     MirrorProperties mirrorProperties;
 
-    bool compare(const SavedDabParameters &rhs, int precisionLevel) const {
+    DabCacheKey key(int precisionLevel) const {
         const PrecisionValues &prec = precisionLevels[precisionLevel];
 
-        return color == rhs.color &&
-               qAbs(angle - rhs.angle) <= prec.angle &&
-               qAbs(width - rhs.width) <= (int)(prec.sizeFrac * width) &&
-               qAbs(height - rhs.height) <= (int)(prec.sizeFrac * height) &&
-               qAbs(subPixelX - rhs.subPixelX) <= prec.subPixel &&
-               qAbs(subPixelY - rhs.subPixelY) <= prec.subPixel &&
-               qAbs(softnessFactor - rhs.softnessFactor) <= prec.softnessFactor &&
-               index == rhs.index &&
-               mirrorProperties.horizontalMirror == rhs.mirrorProperties.horizontalMirror &&
-               mirrorProperties.verticalMirror == rhs.mirrorProperties.verticalMirror;
+        DabCacheKey key;
+        key.precisionLevel = precisionLevel;
+        key.colorSpace = color.colorSpace();
+        key.color = color.colorSpace() ?
+            QByteArray(reinterpret_cast<const char*>(color.data()), color.colorSpace()->pixelSize()) :
+            QByteArray();
+        key.angle = qRound64(angle / prec.angle);
+        key.width = quantizeSize(width, prec.sizeFrac);
+        key.height = quantizeSize(height, prec.sizeFrac);
+        key.subPixelX = qFloor(subPixelX / prec.subPixel);
+        key.subPixelY = qFloor(subPixelY / prec.subPixel);
+        key.softnessFactor = qRound64(softnessFactor / prec.softnessFactor);
+        key.index = index;
+        key.horizontalMirror = mirrorProperties.horizontalMirror;
+        key.verticalMirror = mirrorProperties.verticalMirror;
+
+        return key;
     }
 };
 
@@ -83,10 +154,29 @@ struct KisDabCache::Private {
           textureOption(0),
           precisionOption(0),
           subPixelPrecisionDisabled(false),
-          cachedDabParameters(new SavedDabParameters)
+          dabs(MAX_CACHE_MEMORY),
+          hitCount(0),
+          missCount(0)
     {}
+
+    /**
+     * A cached dab. If postprocessing is needed, it is the dab before
+     * the postprocessing, which is applied to a copy on every fetch
+     */
+    struct CachedDab {
+        KisFixedPaintDeviceSP dab;
+    };
+
+    /**
+     * Pressure-driven size and rotation produce many different dabs
+     * in a stroke, a few megabytes keep most of them
+     */
+    static const int MAX_CACHE_MEMORY = 8 * 1024 * 1024;
+
+    /**
+     * The dab handed out when it cannot be shared with the cache
+     */
     KisFixedPaintDeviceSP dab;
-    KisFixedPaintDeviceSP dabOriginal;
 
     KisBrushSP brush;
     KisPaintDeviceSP colorSourceDevice;
@@ -97,7 +187,12 @@ struct KisDabCache::Private {
     KisPrecisionOption *precisionOption;
     bool subPixelPrecisionDisabled;
 
-    SavedDabParameters *cachedDabParameters;
+    const KoColorSpace *cachedColorSpace = 0;
+    bool cachedSeparateOriginal = false;
+    QCache<DabCacheKey, CachedDab> dabs;
+
+    int hitCount;
+    int missCount;
 };
 
 
@@ -109,7 +204,7 @@ KisDabCache::KisDabCache(KisBrushSP brush)
 
 KisDabCache::~KisDabCache()
 {
-    delete m_d->cachedDabParameters;
+    KisUpdateTimeMonitor::instance()->reportDabCacheStatistics(m_d->hitCount, m_d->missCount);
     delete m_d;
 }
 
@@ -193,6 +288,16 @@ KisFixedPaintDeviceSP KisDabCache::fetchDab(const KoColorSpace *cs,
                           dstDabRect);
 }
 
+int KisDabCache::hitCount() const
+{
+    return m_d->hitCount;
+}
+
+int KisDabCache::missCount() const
+{
+    return m_d->missCount;
+}
+
 bool KisDabCache::needSeparateOriginal()
 {
     return (m_d->textureOption && m_d->textureOption->m_enabled) ||
@@ -229,23 +334,32 @@ KisFixedPaintDeviceSP KisDabCache::tryFetchFromCache(const SavedDabParameters &p
         const KisPaintInformation& info,
         QRect *dstDabRect)
 {
-    int precisionLevel = m_d->precisionOption ? m_d->precisionOption->precisionLevel() - 1 : 3;
+    const Private::CachedDab *cached = m_d->dabs.object(params.key(precisionLevel()));
 
-    if (!params.compare(*m_d->cachedDabParameters, precisionLevel)) {
+    if (!cached) {
         return 0;
     }
 
+    KisFixedPaintDeviceSP dab = cached->dab;
+    *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, dab->bounds().size());
+
     if (needSeparateOriginal()) {
-        *m_d->dab = *m_d->dabOriginal;
-        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, m_d->dab->bounds().size());
-        postProcessDab(m_d->dab, dstDabRect->topLeft(), info);
-    }
-    else {
-        *dstDabRect = correctDabRectWhenFetchedFromCache(*dstDabRect, m_d->dab->bounds().size());
+        /**
+         * The postprocessing changes the dab, so it works on a copy
+         * and the cached dab stays untouched
+         */
+        *m_d->dab = *dab;
+        dab = m_d->dab;
+        postProcessDab(dab, dstDabRect->topLeft(), info);
     }
 
     m_d->brush->notifyCachedDabPainted(info);
-    return m_d->dab;
+    return dab;
+}
+
+inline int KisDabCache::precisionLevel() const
+{
+    return m_d->precisionOption ? qBound(0, m_d->precisionOption->precisionLevel() - 1, 4) : 3;
 }
 
 qreal positiveFraction(qreal x) {
@@ -352,21 +466,40 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
     if (!m_d->dab || *m_d->dab->colorSpace() != *cs) {
         m_d->dab = new KisFixedPaintDevice(cs);
     }
-    else if (cachingIsPossible) {
+
+    if (!m_d->cachedColorSpace || *m_d->cachedColorSpace != *cs ||
+        m_d->cachedSeparateOriginal != needSeparateOriginal()) {
+
+        m_d->dabs.clear();
+        m_d->cachedColorSpace = cs;
+        m_d->cachedSeparateOriginal = needSeparateOriginal();
+    }
+
+    const bool isImageBrush =
+        m_d->brush->brushType() == IMAGE || m_d->brush->brushType() == PIPE_IMAGE;
+
+    if (cachingIsPossible && !isImageBrush) {
         KisFixedPaintDeviceSP cachedDab =
             tryFetchFromCache(newParams, info, dstDabRect);
 
-        if (cachedDab) return cachedDab;
+        if (cachedDab) {
+            m_d->hitCount++;
+            return cachedDab;
+        }
+
+        m_d->missCount++;
     }
 
-    if (m_d->brush->brushType() == IMAGE || m_d->brush->brushType() == PIPE_IMAGE) {
-        m_d->dab = m_d->brush->paintDevice(cs, shape, info,
-                                           position.subPixel.x(),
-                                           position.subPixel.y());
+    KisFixedPaintDeviceSP dab = m_d->dab;
+
+    if (isImageBrush) {
+        dab = m_d->dab = m_d->brush->paintDevice(cs, shape, info,
+                                                 position.subPixel.x(),
+                                                 position.subPixel.y());
     }
     else if (cachingIsPossible) {
-        *m_d->cachedDabParameters = newParams;
-        m_d->brush->mask(m_d->dab, paintColor, shape,
+        dab = new KisFixedPaintDevice(cs);
+        m_d->brush->mask(dab, paintColor, shape,
                          info,
                          position.subPixel.x(), position.subPixel.y(),
                          softnessFactor);
@@ -383,28 +516,34 @@ KisFixedPaintDeviceSP KisDabCache::fetchDabCommon(const KoColorSpace *cs,
         colorSource->colorize(m_d->colorSourceDevice, maskRect, info.pos().toPoint());
         delete m_d->colorSourceDevice->convertTo(cs);
 
-        m_d->brush->mask(m_d->dab, m_d->colorSourceDevice, shape,
+        m_d->brush->mask(dab, m_d->colorSourceDevice, shape,
                          info,
                          position.subPixel.x(), position.subPixel.y(),
                          softnessFactor);
     }
 
     if (!mirrorProperties.isEmpty()) {
-        m_d->dab->mirror(mirrorProperties.horizontalMirror,
-                         mirrorProperties.verticalMirror);
+        dab->mirror(mirrorProperties.horizontalMirror,
+                    mirrorProperties.verticalMirror);
     }
 
-    if (needSeparateOriginal()) {
-        if (!m_d->dabOriginal || *cs != *m_d->dabOriginal->colorSpace()) {
-            m_d->dabOriginal = new KisFixedPaintDevice(cs);
-        }
+    if (cachingIsPossible && !isImageBrush) {
+        Private::CachedDab *cached = new Private::CachedDab;
+        cached->dab = dab;
 
-        *m_d->dabOriginal = *m_d->dab;
+        const QRect bounds = dab->bounds();
+        const int cost = qMax(1, bounds.width() * bounds.height() * cs->pixelSize());
+        m_d->dabs.insert(newParams.key(precisionLevel()), cached, cost);
+
+        if (needSeparateOriginal()) {
+            *m_d->dab = *dab;
+            dab = m_d->dab;
+        }
     }
 
-    postProcessDab(m_d->dab, position.rect.topLeft(), info);
+    postProcessDab(dab, position.rect.topLeft(), info);
 
-    return m_d->dab;
+    return dab;
 }
 
 void KisDabCache::postProcessDab(KisFixedPaintDeviceSP dab,
@@ -48,6 +48,12 @@ struct MirrorProperties;
  *  level.
  *
  *  The texturing and mirroring problems are solved.
+ *
+ *  The cache keeps many dabs at once: the parameters of a dab are
+ *  rounded to the precision level and the result is used as the key of
+ *  a bounded LRU cache, so the strokes with pressure-driven size or
+ *  rotation reuse the dabs generated earlier. The hit and miss counts
+ *  are reported to KisUpdateTimeMonitor when the cache is destroyed.
  */
 class PAINTOP_EXPORT KisDabCache
 {
@@ -70,6 +76,13 @@ public:
 
     bool needSeparateOriginal();
 
+    /**
+     * The number of dabs taken from the cache and generated from
+     * scratch. Only the dabs that can be cached are counted.
+     */
+    int hitCount() const;
+    int missCount() const;
+
     KisFixedPaintDeviceSP fetchDab(const KoColorSpace *cs,
                                    const KisColorSource *colorSource,
                                    const QPointF &cursorPoint,
@@ -103,6 +116,8 @@ private:
                      const KisPaintInformation& info,
                      const MirrorProperties &mirrorProperties);
 
+    inline int precisionLevel() const;
+
     inline
     QRect correctDabRectWhenFetchedFromCache(const QRect &dabRect,
             const QSize &realDabSize);
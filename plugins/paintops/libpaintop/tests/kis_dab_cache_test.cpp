@@ -0,0 +1,119 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_dab_cache_test.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_auto_brush.h>
+#include <kis_mask_generator.h>
+#include <kis_fixed_paint_device.h>
+#include <brushengine/kis_paint_information.h>
+
+#include "kis_dab_cache.h"
+#include "kis_precision_option.h"
+
+
+KisFixedPaintDeviceSP fetchDab(KisDabCache *cache, qreal scale, qreal rotation, QRect *rect)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintInformation info(QPointF(100, 100), 1.0);
+
+    return cache->fetchDab(cs, KoColor(Qt::black, cs), info.pos(),
+                           KisDabShape(scale, 1.0, rotation),
+                           info, 1.0, rect);
+}
+
+bool compareDabs(KisFixedPaintDeviceSP dab1, KisFixedPaintDeviceSP dab2)
+{
+    const QRect bounds = dab1->bounds();
+    const int size = bounds.width() * bounds.height() * dab1->pixelSize();
+
+    return bounds == dab2->bounds() &&
+        !memcmp(dab1->data(), dab2->data(), size);
+}
+
+void KisDabCacheTest::testAlternatingSizes()
+{
+    KisBrushSP brush = new KisAutoBrush(new KisCircleMaskGenerator(20, 1.0, 0.5, 0.5, 2, true), 0.0, 0.0);
+
+    KisPrecisionOption precision;
+    precision.setPrecisionLevel(5);
+
+    KisDabCache cache(brush);
+    cache.setPrecisionOption(&precision);
+
+    QRect rect1;
+    QRect rect2;
+    QRect rect;
+
+    KisFixedPaintDeviceSP dab1 = fetchDab(&cache, 1.0, 0.0, &rect1);
+    KisFixedPaintDeviceSP dab2 = fetchDab(&cache, 0.5, 0.0, &rect2);
+    QCOMPARE(cache.hitCount(), 0);
+    QCOMPARE(cache.missCount(), 2);
+
+    // the dabs are kept in the cache, not regenerated
+    QVERIFY(fetchDab(&cache, 1.0, 0.0, &rect) == dab1);
+    QCOMPARE(rect, rect1);
+
+    QVERIFY(fetchDab(&cache, 0.5, 0.0, &rect) == dab2);
+    QCOMPARE(rect, rect2);
+
+    QCOMPARE(cache.hitCount(), 2);
+    QCOMPARE(cache.missCount(), 2);
+
+    // the cached dab is the same as the generated one
+    KisDabCache uncachedCache(brush);
+    uncachedCache.setPrecisionOption(&precision);
+    QVERIFY(compareDabs(fetchDab(&uncachedCache, 1.0, 0.0, &rect), dab1));
+}
+
+void KisDabCacheTest::testPrecisionLevels()
+{
+    KisBrushSP brush = new KisAutoBrush(new KisCircleMaskGenerator(20, 1.0, 0.5, 0.5, 2, true), 0.0, 0.0);
+
+    // less than a degree
+    const qreal smallRotation = 0.3 * M_PI / 180;
+
+    QRect rect;
+    KisPrecisionOption precision;
+
+    precision.setPrecisionLevel(5);
+    KisDabCache preciseCache(brush);
+    preciseCache.setPrecisionOption(&precision);
+
+    fetchDab(&preciseCache, 1.0, 0.0, &rect);
+    fetchDab(&preciseCache, 1.0, smallRotation, &rect);
+    QCOMPARE(preciseCache.hitCount(), 0);
+    QCOMPARE(preciseCache.missCount(), 2);
+
+    precision.setPrecisionLevel(1);
+    KisDabCache fastCache(brush);
+    fastCache.setPrecisionOption(&precision);
+
+    fetchDab(&fastCache, 1.0, 0.0, &rect);
+    fetchDab(&fastCache, 1.0, smallRotation, &rect);
+    QCOMPARE(fastCache.hitCount(), 1);
+    QCOMPARE(fastCache.missCount(), 1);
+}
+
+QTEST_MAIN(KisDabCacheTest)
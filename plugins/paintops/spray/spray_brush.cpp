@@ -30,6 +30,9 @@
 #include <QHash>
 #include <QTransform>
 #include <QImage>
+#include <QVector>
+#include <QScopedPointer>
+#include <QtConcurrent>
 
 #include <kis_random_accessor_ng.h>
 #include <kis_random_sub_accessor.h>
@@ -105,6 +108,21 @@ qreal SprayBrush::rotationAngle(KisRandomSourceSP randomSource)
 
 
 
+namespace {
+
+/**
+ * Dabs with fewer particles are not worth splitting
+ */
+const quint32 PARALLEL_PARTICLES_THRESHOLD = 1024;
+
+/**
+ * The particles are split into chunks of a fixed size, so the seeds
+ * and therefore the result do not depend on the number of threads
+ */
+const quint32 PARTICLES_PER_CHUNK = 256;
+
+}
+
 void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
                        const KisPaintInformation& info,
                        qreal rotation, qreal scale,
@@ -133,11 +151,9 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
 
     qreal x = info.pos().x();
     qreal y = info.pos().y();
-    KisRandomAccessorSP accessor = dab->createRandomAccessorNG(qRound(x), qRound(y));
 
     Q_ASSERT(color.colorSpace()->pixelSize() == dab->pixelSize());
     m_inkColor = color;
-    KisCrossDeviceColorPicker colorPicker(source, m_inkColor);
 
     // apply size sensor
     m_radius = m_properties->radius() * scale * additionalScale;
@@ -158,6 +174,166 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
         m_particlesCount = m_properties->particleCount;
     }
 
+    if (m_colorProperties->fillBackground) {
+        m_painter->setPaintColor(bgColor);
+        paintCircle(m_painter, x, y, m_radius);
+    }
+
+    QTransform m;
+    m.reset();
+    m.rotateRadians(-rotation + deg2rad(m_properties->brushRotation));
+    m.scale(m_properties->scale, m_properties->scale);
+
+    ParticleParameters parameters;
+    parameters.x = x;
+    parameters.y = y;
+    parameters.transform = m;
+    parameters.additionalScale = additionalScale;
+    parameters.pressure = info.pressure();
+    parameters.drawingAngle =
+        m_shapeDynamicsProperties->enabled && m_shapeDynamicsProperties->followDrawingAngle ?
+        info.drawingAngle() : 0.0;
+
+    if (m_particlesCount >= PARALLEL_PARTICLES_THRESHOLD && canPaintInParallel()) {
+        paintParticlesInParallel(dab, source, info, parameters, color, bgColor);
+    } else {
+        KisCrossDeviceColorPicker colorPicker(source, m_inkColor);
+
+        ParticleContext context;
+        context.randomSource = randomSource;
+        context.painter = m_painter;
+        context.accessor = dab->createRandomAccessorNG(qRound(x), qRound(y));
+        context.colorPicker = &colorPicker;
+        context.transfo = m_transfo;
+        context.imageDevice = m_imageDevice;
+        context.inkColor = m_inkColor;
+
+        paintParticles(context, m_particlesCount, info, parameters, color, bgColor);
+
+        m_inkColor = context.inkColor;
+    }
+
+    // recover from jittering of color,
+    // m_inkColor.opacity is recovered with every paint
+}
+
+bool SprayBrush::canPaintInParallel() const
+{
+    // the brush tips generate their masks in shared buffers
+    if (!m_shapeProperties->enabled) return false;
+
+    /**
+     * The anti-aliased pixel and the pixel shapes overwrite the dab
+     * instead of compositing over it, so merging the chunks with Over
+     * would change their look. They are cheap enough to stay sequential.
+     */
+    if (m_shapeProperties->shape == 2 || m_shapeProperties->shape == 3) {
+        return false;
+    }
+
+    /**
+     * Without color per particle the color of the first particle is
+     * used for the whole dab, so the chunks would depend on each other
+     */
+    if (!m_colorProperties->colorPerParticle &&
+        (m_colorProperties->sampleInputColor ||
+         m_colorProperties->mixBgColor ||
+         m_colorProperties->useRandomHSV ||
+         m_colorProperties->useRandomOpacity)) {
+
+        return false;
+    }
+
+    return true;
+}
+
+void SprayBrush::paintParticlesInParallel(KisPaintDeviceSP dab, KisPaintDeviceSP source,
+                                          const KisPaintInformation& info,
+                                          const ParticleParameters &parameters,
+                                          const KoColor &color, const KoColor &bgColor)
+{
+    const KoColorSpace *cs = dab->colorSpace();
+    const quint32 numChunks = (m_particlesCount + PARTICLES_PER_CHUNK - 1) / PARTICLES_PER_CHUNK;
+
+    // the seeds are taken from the random source of the dab, so the result is reproducible
+    QVector<int> seeds;
+    for (quint32 i = 0; i < numChunks; i++) {
+        seeds.append(int(info.randomSource()->generate()));
+    }
+
+    QVector<KisPaintDeviceSP> chunkDevices;
+    QVector<QFuture<void>> jobs;
+
+    const quint8 initialOpacity = m_painter->opacity();
+    const KoColor initialPaintColor = m_painter->paintColor();
+
+    for (quint32 i = 0; i < numChunks; i++) {
+        const quint32 numParticles = qMin(PARTICLES_PER_CHUNK, m_particlesCount - i * PARTICLES_PER_CHUNK);
+        const int seed = seeds[i];
+
+        KisPaintDeviceSP chunkDevice = new KisPaintDevice(cs);
+        chunkDevices.append(chunkDevice);
+
+        jobs.append(QtConcurrent::run([=, &info, &parameters, &color, &bgColor] () {
+            KisPainter painter(chunkDevice);
+            painter.setFillStyle(KisPainter::FillStyleForegroundColor);
+            painter.setMaskImageSize(m_shapeProperties->width, m_shapeProperties->height);
+            painter.setOpacity(initialOpacity);
+            painter.setPaintColor(initialPaintColor);
+
+            KoColor inkColor(color);
+            KisCrossDeviceColorPicker colorPicker(source, inkColor);
+
+            QScopedPointer<KoColorTransformation> transfo(
+                m_colorProperties->useRandomHSV ?
+                    cs->createColorTransformation("hsv_adjustment", QHash<QString, QVariant>()) : 0);
+
+            ParticleContext context;
+            context.randomSource = new KisRandomSource(seed);
+            context.painter = &painter;
+            context.accessor = chunkDevice->createRandomAccessorNG(qRound(parameters.x), qRound(parameters.y));
+            context.colorPicker = &colorPicker;
+            context.transfo = transfo.data();
+            context.imageDevice = new KisPaintDevice(cs);
+            context.inkColor = inkColor;
+
+            paintParticles(context, numParticles, info, parameters, color, bgColor);
+        }));
+    }
+
+    Q_FOREACH (QFuture<void> job, jobs) {
+        job.waitForFinished();
+    }
+
+    /**
+     * The chunks are composited in the order of their particles, so the
+     * result is close to painting the shapes one by one, but not equal:
+     * the integer Over rounds differently when the particles of a chunk
+     * are blended together first. The result still depends on the seed
+     * only.
+     */
+    KisPainter merger(dab);
+    Q_FOREACH (KisPaintDeviceSP chunkDevice, chunkDevices) {
+        const QRect rc = chunkDevice->extent();
+        merger.bitBlt(rc.topLeft(), chunkDevice, rc);
+    }
+}
+
+void SprayBrush::paintParticles(ParticleContext &context, quint32 numParticles,
+                                const KisPaintInformation& info,
+                                const ParticleParameters &parameters,
+                                const KoColor &color, const KoColor &bgColor)
+{
+    KisRandomSourceSP randomSource = context.randomSource;
+    KisPainter *painter = context.painter;
+    KisRandomAccessorSP accessor = context.accessor;
+    KoColor &inkColor = context.inkColor;
+
+    const qreal x = parameters.x;
+    const qreal y = parameters.y;
+    const qreal additionalScale = parameters.additionalScale;
+    const QTransform &m = parameters.transform;
+
     QHash<QString, QVariant> params;
     qreal nx, ny;
     int ix, iy;
@@ -168,17 +344,8 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
     qreal particleScale = 1.0;
 
     bool shouldColor = true;
-    if (m_colorProperties->fillBackground) {
-        m_painter->setPaintColor(bgColor);
-        paintCircle(m_painter, x, y, m_radius);
-    }
-
-    QTransform m;
-    m.reset();
-    m.rotateRadians(-rotation + deg2rad(m_properties->brushRotation));
-    m.scale(m_properties->scale, m_properties->scale);
 
-    for (quint32 i = 0; i < m_particlesCount; i++) {
+    for (quint32 i = 0; i < numParticles; i++) {
         // generate random angle
         angle = randomSource->generateNormalized() * M_PI * 2;
 
@@ -202,7 +369,7 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
 
             if (m_shapeDynamicsProperties->followDrawingAngle) {
 
-                rotationZ = linearInterpolation(rotationZ, info.drawingAngle(), m_shapeDynamicsProperties->followDrawingAngleWeight);
+                rotationZ = linearInterpolation(rotationZ, parameters.drawingAngle, m_shapeDynamicsProperties->followDrawingAngleWeight);
             }
 
             // random size - scale
@@ -224,47 +391,47 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
 
         if (shouldColor) {
             if (m_colorProperties->sampleInputColor) {
-                colorPicker.pickOldColor(nx + x, ny + y, m_inkColor.data());
+                context.colorPicker->pickOldColor(nx + x, ny + y, inkColor.data());
             }
 
             // mix the color with background color
             if (m_colorProperties->mixBgColor) {
-                KoMixColorsOp * mixOp = dab->colorSpace()->mixColorsOp();
+                KoMixColorsOp * mixOp = painter->device()->colorSpace()->mixColorsOp();
 
                 const quint8 *colors[2];
-                colors[0] = m_inkColor.data();
+                colors[0] = inkColor.data();
                 colors[1] = bgColor.data();
 
                 qint16 colorWeights[2];
                 int MAX_16BIT = 255;
-                qreal blend = info.pressure();
+                qreal blend = parameters.pressure;
 
                 colorWeights[0] = static_cast<quint16>(blend * MAX_16BIT);
                 colorWeights[1] = static_cast<quint16>((1.0 - blend) * MAX_16BIT);
-                mixOp->mixColors(colors, colorWeights, 2, m_inkColor.data());
+                mixOp->mixColors(colors, colorWeights, 2, inkColor.data());
             }
 
-            if (m_colorProperties->useRandomHSV && m_transfo) {
+            if (m_colorProperties->useRandomHSV && context.transfo) {
                 params["h"] = (m_colorProperties->hue / 180.0) * randomSource->generateNormalized();
                 params["s"] = (m_colorProperties->saturation / 100.0) * randomSource->generateNormalized();
                 params["v"] = (m_colorProperties->value / 100.0) * randomSource->generateNormalized();
-                m_transfo->setParameters(params);
-                m_transfo->setParameter(3, 1);//sets the type to HSV. For some reason 0 is not an option.
-                m_transfo->setParameter(4, false);//sets the colorize to false.
-                m_transfo->transform(m_inkColor.data(), m_inkColor.data() , 1);
+                context.transfo->setParameters(params);
+                context.transfo->setParameter(3, 1);//sets the type to HSV. For some reason 0 is not an option.
+                context.transfo->setParameter(4, false);//sets the colorize to false.
+                context.transfo->transform(inkColor.data(), inkColor.data() , 1);
             }
 
             if (m_colorProperties->useRandomOpacity) {
                 quint8 alpha = qRound(randomSource->generateNormalized() * OPACITY_OPAQUE_U8);
-                m_inkColor.setOpacity(alpha);
-                m_painter->setOpacity(alpha);
+                inkColor.setOpacity(alpha);
+                painter->setOpacity(alpha);
             }
 
             if (!m_colorProperties->colorPerParticle) {
                 shouldColor = false;
             }
 
-            m_painter->setPaintColor(m_inkColor);
+            painter->setPaintColor(inkColor);
         }
 
         qreal jitteredWidth = qMax(1.0 * additionalScale, m_shapeProperties->width * particleScale * additionalScale);
@@ -276,22 +443,22 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
             case 0:
             {
                 if (m_shapeProperties->width == m_shapeProperties->height){
-                    paintCircle(m_painter, nx + x, ny + y, jitteredWidth * 0.5);
+                    paintCircle(painter, nx + x, ny + y, jitteredWidth * 0.5);
                 }
                 else {
-                    paintEllipse(m_painter, nx + x, ny + y, jitteredWidth * 0.5 , jitteredHeight * 0.5, rotationZ);
+                    paintEllipse(painter, nx + x, ny + y, jitteredWidth * 0.5 , jitteredHeight * 0.5, rotationZ);
                 }
                 break;
             }
             // rectangle
             case 1:
             {
-                paintRectangle(m_painter, nx + x, ny + y, qRound(jitteredWidth) , qRound(jitteredHeight), rotationZ);
+                paintRectangle(painter, nx + x, ny + y, qRound(jitteredWidth) , qRound(jitteredHeight), rotationZ);
                 break;
             }
             // wu-particle
             case 2: {
-                paintParticle(accessor, m_inkColor, nx + x, ny + y);
+                paintParticle(accessor, inkColor, nx + x, ny + y);
                 break;
             }
             // pixel
@@ -299,7 +466,7 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
                 ix = qRound(nx + x);
                 iy = qRound(ny + y);
                 accessor->moveTo(ix, iy);
-                memcpy(accessor->rawData(), m_inkColor.data(), m_dabPixelSize);
+                memcpy(accessor->rawData(), inkColor.data(), m_dabPixelSize);
                 break;
             }
             case 4: {
@@ -312,25 +479,25 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
                     if (m_shapeDynamicsProperties->randomSize) {
                         m.scale(particleScale, particleScale);
                     }
-                    m_transformed = m_brushQImage.transformed(m, Qt::SmoothTransformation);
-                    m_imageDevice->convertFromQImage(m_transformed, 0);
-                    KisRandomAccessorSP ac = m_imageDevice->createRandomAccessorNG(0, 0);
-                    QRect rc = m_transformed.rect();
+                    const QImage transformed = m_brushQImage.transformed(m, Qt::SmoothTransformation);
+                    context.imageDevice->convertFromQImage(transformed, 0);
+                    KisRandomAccessorSP ac = context.imageDevice->createRandomAccessorNG(0, 0);
+                    QRect rc = transformed.rect();
 
-                    if (m_colorProperties->useRandomHSV && m_transfo) {
+                    if (m_colorProperties->useRandomHSV && context.transfo) {
 
                         for (int y = rc.y(); y < rc.y() + rc.height(); y++) {
                             for (int x = rc.x(); x < rc.x() + rc.width(); x++) {
                                 ac->moveTo(x, y);
-                                m_transfo->transform(ac->rawData(), ac->rawData() , 1);
+                                context.transfo->transform(ac->rawData(), ac->rawData() , 1);
                             }
                         }
                     }
 
                     ix = qRound(nx + x - rc.width() * 0.5);
                     iy = qRound(ny + y - rc.height() * 0.5);
-                    m_painter->bitBlt(QPoint(ix, iy), m_imageDevice, rc);
-                    m_imageDevice->clear();
+                    painter->bitBlt(QPoint(ix, iy), context.imageDevice, rc);
+                    context.imageDevice->clear();
                     break;
                 }
             }
@@ -357,29 +524,25 @@ void SprayBrush::paint(KisPaintDeviceSP dab, KisPaintDeviceSP source,
                 m_fixedDab = m_brush->paintDevice(m_fixedDab->colorSpace(),
                           shape, info, xFraction, yFraction);
 
-                if (m_colorProperties->useRandomHSV && m_transfo) {
+                if (m_colorProperties->useRandomHSV && context.transfo) {
                     quint8 * dabPointer = m_fixedDab->data();
                     int pixelCount = m_fixedDab->bounds().width() * m_fixedDab->bounds().height();
-                    m_transfo->transform(dabPointer, dabPointer, pixelCount);
+                    context.transfo->transform(dabPointer, dabPointer, pixelCount);
                 }
 
             }
             else {
-                m_brush->mask(m_fixedDab, m_inkColor, shape,
+                m_brush->mask(m_fixedDab, inkColor, shape,
                               info, xFraction, yFraction);
             }
-            m_painter->bltFixed(QPoint(ix, iy), m_fixedDab, m_fixedDab->bounds());
+            painter->bltFixed(QPoint(ix, iy), m_fixedDab, m_fixedDab->bounds());
         }
         if (m_colorProperties->colorPerParticle){
-            m_inkColor=color;//reset color//
+            inkColor=color;//reset color//
         }
     }
-    // recover from jittering of color,
-    // m_inkColor.opacity is recovered with every paint
 }
 
-
-
 void SprayBrush::paintParticle(KisRandomAccessorSP &writeAccessor, const KoColor &color, qreal rx, qreal ry)
 {
     // opacity top left, right, bottom left, right
@@ -32,7 +32,9 @@
 
 
 #include <QImage>
+#include <QTransform>
 #include <kis_brush.h>
+#include <kis_cross_device_color_picker.h>
 
 class KisPaintInformation;
 
@@ -61,7 +63,6 @@ private:
     KisPainter * m_painter;
     KisPaintDeviceSP m_imageDevice;
     QImage m_brushQImage;
-    QImage m_transformed;
 
     KoColorTransformation* m_transfo;
 
@@ -74,6 +75,52 @@ private:
     KisFixedPaintDeviceSP m_fixedDab;
 
 private:
+    /**
+     * The state particles are painted with. The sequential path uses
+     * the members of the brush, every parallel chunk has its own.
+     */
+    struct ParticleContext {
+        KisRandomSourceSP randomSource;
+        KisPainter *painter;
+        KisRandomAccessorSP accessor;
+        KisCrossDeviceColorPicker *colorPicker;
+        KoColorTransformation *transfo;
+        KisPaintDeviceSP imageDevice;
+        KoColor inkColor;
+    };
+
+    /**
+     * The parameters of the dab shared by all the particles
+     */
+    struct ParticleParameters {
+        qreal x;
+        qreal y;
+        QTransform transform;
+        qreal additionalScale;
+        qreal pressure;
+        qreal drawingAngle;
+    };
+
+    /// paints \p numParticles particles of the dab
+    void paintParticles(ParticleContext &context, quint32 numParticles,
+                        const KisPaintInformation& info,
+                        const ParticleParameters &parameters,
+                        const KoColor &color, const KoColor &bgColor);
+
+    /// whether the particles may be split into independent chunks
+    bool canPaintInParallel() const;
+
+    /**
+     * Paints the particles in chunks of a fixed size on the global
+     * thread pool. Every chunk has its own random source seeded from
+     * the random source of \p info and its own device, the devices are
+     * merged into \p dab in the order of the chunks.
+     */
+    void paintParticlesInParallel(KisPaintDeviceSP dab, KisPaintDeviceSP source,
+                                  const KisPaintInformation& info,
+                                  const ParticleParameters &parameters,
+                                  const KoColor &color, const KoColor &bgColor);
+
     /// rotation in radians according the settings (gauss distribution, uniform distribution or fixed angle)
     qreal rotationAngle(KisRandomSourceSP randomSource);
     /// Paints Wu Particle
@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2017 The Krita developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+#include "kis_spray_brush_test.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_paint_device.h>
+#include <brushengine/kis_paint_information.h>
+#include <brushengine/kis_random_source.h>
+
+#include "spray_brush.h"
+#include "testutil.h"
+
+
+KisPaintDeviceSP paintSprayDab(int seed)
+{
+    KisSprayProperties properties;
+    properties.diameter = 200;
+    properties.particleCount = 4000;
+    properties.aspect = 1.0;
+    properties.coverage = 0.1;
+    properties.amount = 0.0;
+    properties.spacing = 0.5;
+    properties.scale = 1.0;
+    properties.brushRotation = 0.0;
+    properties.jitterMovement = false;
+    properties.useDensity = false;
+    properties.gaussian = false;
+
+    KisColorProperties colorProperties;
+    colorProperties.useRandomHSV = false;
+    colorProperties.useRandomOpacity = false;
+    colorProperties.sampleInputColor = false;
+    colorProperties.fillBackground = false;
+    colorProperties.colorPerParticle = false;
+    colorProperties.mixBgColor = false;
+    colorProperties.hue = 0;
+    colorProperties.saturation = 0;
+    colorProperties.value = 0;
+
+    KisShapeProperties shapeProperties;
+    shapeProperties.shape = 0; // ellipse
+    shapeProperties.width = 6;
+    shapeProperties.height = 6;
+    shapeProperties.enabled = true;
+    shapeProperties.proportional = false;
+
+    KisShapeDynamicsProperties dynamicsProperties;
+    dynamicsProperties.enabled = false;
+    dynamicsProperties.randomSize = false;
+    dynamicsProperties.fixedRotation = false;
+    dynamicsProperties.randomRotation = false;
+    dynamicsProperties.followCursor = false;
+    dynamicsProperties.followDrawingAngle = false;
+    dynamicsProperties.fixedAngle = 0;
+    dynamicsProperties.randomRotationWeight = 0.0;
+    dynamicsProperties.followCursorWeigth = 0.0;
+    dynamicsProperties.followDrawingAngleWeight = 0.0;
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dab = new KisPaintDevice(cs);
+    KisPaintDeviceSP source = new KisPaintDevice(cs);
+
+    SprayBrush brush;
+    brush.setProperties(&properties, &colorProperties, &shapeProperties, &dynamicsProperties, 0);
+
+    KisPaintInformation info(QPointF(150, 150), 1.0);
+    info.setRandomSource(new KisRandomSource(seed));
+
+    // the number of particles is above the threshold of the parallel path
+    brush.paint(dab, source, info, 0.0, 1.0, 1.0, KoColor(Qt::red, cs), KoColor(Qt::white, cs));
+
+    return dab;
+}
+
+void KisSprayBrushTest::testParallelReproducible()
+{
+    KisPaintDeviceSP dab1 = paintSprayDab(42);
+    KisPaintDeviceSP dab2 = paintSprayDab(42);
+
+    QVERIFY(!dab1->extent().isEmpty());
+
+    QPoint pt;
+    QVERIFY2(TestUtil::comparePaintDevices(pt, dab1, dab2),
+             QString("The dabs differ at %1, %2").arg(pt.x()).arg(pt.y()).toLatin1());
+
+    // a different seed places the particles differently
+    KisPaintDeviceSP dab3 = paintSprayDab(43);
+    QVERIFY(!TestUtil::comparePaintDevices(pt, dab1, dab3));
+}
+
+QTEST_MAIN(KisSprayBrushTest)